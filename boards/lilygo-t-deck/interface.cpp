@@ -1,4 +1,5 @@
 #include "TouchDrvGT911.hpp"
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include "core/utils.h"
 #include <Wire.h>
@@ -24,18 +25,22 @@ int8_t trackball_right_count = 0;
 void IRAM_ATTR ISR_up() {
     trackball_interrupted = true;
     trackball_up_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_down() {
     trackball_interrupted = true;
     trackball_down_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_left() {
     trackball_interrupted = true;
     trackball_left_count = 1;
+    inputWakeFromISR();
 }
 void IRAM_ATTR ISR_right() {
     trackball_interrupted = true;
     trackball_right_count = 1;
+    inputWakeFromISR();
 }
 
 void ISR_rst() {
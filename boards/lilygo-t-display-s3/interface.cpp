@@ -191,6 +191,7 @@ void InputHandler(void) {
 }
 
 void powerOff() {
+    bruceConfig.commit();
 #ifdef T_DISPLAY_S3
     tft.fillScreen(bruceConfig.bgColor);
     digitalWrite(PIN_POWER_ON, LOW);
@@ -1,3 +1,5 @@
+#include "core/input_events.h"
+#include "core/led_control.h"
 #include "core/powerSave.h"
 #include <bq27220.h>
 #include <globals.h>
@@ -7,7 +9,14 @@
 #include <RotaryEncoder.h>
 extern RotaryEncoder *encoder;
 RotaryEncoder *encoder = nullptr;
-IRAM_ATTR void checkPosition() { encoder->tick(); }
+// Each step is queued from here with its own time, a fast turn is not merged into one poll
+IRAM_ATTR void checkPosition() {
+    static int lastPos = 0;
+    encoder->tick();
+    int pos = encoder->getPosition();
+    for (; lastPos < pos; lastPos++) inputPushFromISR(INPUT_KEY_PREV);
+    for (; lastPos > pos; lastPos--) inputPushFromISR(INPUT_KEY_NEXT);
+}
 
 // Battery libs
 #if defined(T_EMBED_1101)
@@ -112,6 +121,12 @@ void _setup_gpio() {
     encoder = new RotaryEncoder(ENCODER_INA, ENCODER_INB, RotaryEncoder::LatchMode::TWO03);
     attachInterrupt(digitalPinToInterrupt(ENCODER_INA), checkPosition, CHANGE);
     attachInterrupt(digitalPinToInterrupt(ENCODER_INB), checkPosition, CHANGE);
+    // every input wakes the input task, it can poll slower when idle
+    inputWakeOnPin(SEL_BTN);
+#ifdef T_EMBED_1101
+    inputWakeOnPin(BK_BTN);
+#endif
+    inputSetInterruptDriven(true);
 }
 
 /***************************************************************************************
@@ -147,15 +162,19 @@ void _setBrightness(uint8_t brightval) {
 void InputHandler(void) {
     static unsigned long tm = millis();  // debauce for buttons
     static unsigned long tm2 = millis(); // delay between Select and encoder (avoid missclick)
-    static int posDifference = 0;
     static int lastPos = 0;
     bool sel = !BTN_ACT;
     bool esc = !BTN_ACT;
 
+    // the turns themselves are queued by checkPosition()
     int newPos = encoder->getPosition();
     if (newPos != lastPos) {
-        posDifference += (newPos - lastPos);
+#ifdef HAS_ENCODER_LED
+        EncoderLedChange = newPos > lastPos ? -1 : 1;
+        ledNotify();
+#endif
         lastPos = newPos;
+        tm2 = millis();
     }
 
     if (millis() - tm > 200 || LongPress) {
@@ -164,29 +183,12 @@ void InputHandler(void) {
         esc = digitalRead(BK_BTN);
 #endif
     }
-    if (posDifference != 0 || sel == BTN_ACT || esc == BTN_ACT) {
+    if (sel == BTN_ACT || esc == BTN_ACT) {
         if (!wakeUpScreen()) AnyKeyPress = true;
         else return;
     }
-    if (posDifference > 0) {
-        PrevPress = true;
-        posDifference--;
-#ifdef HAS_ENCODER_LED
-        EncoderLedChange = -1;
-#endif
-        tm2 = millis();
-    }
-    if (posDifference < 0) {
-        NextPress = true;
-        posDifference++;
-#ifdef HAS_ENCODER_LED
-        EncoderLedChange = 1;
-#endif
-        tm2 = millis();
-    }
 
     if (sel == BTN_ACT && millis() - tm2 > 200) {
-        posDifference = 0;
         SelPress = true;
         tm = millis();
     }
@@ -199,6 +201,7 @@ void InputHandler(void) {
 }
 
 void powerOff() {
+    bruceConfig.commit();
 #ifdef T_EMBED_1101
     PPM.shutdown();
 #endif
@@ -241,6 +244,7 @@ void checkReboot() {
                     tft.fillScreen(bruceConfig.bgColor);
                     while (digitalRead(BK_BTN) == BTN_ACT);
                     delay(200);
+                    bruceConfig.commit();
                     powerDownNFC();
                     powerDownCC1101();
                     tft.sleep(true);
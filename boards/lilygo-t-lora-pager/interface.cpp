@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include "core/utils.h"
 #include <Wire.h>
@@ -9,7 +10,10 @@
 #include <RotaryEncoder.h>
 extern RotaryEncoder *encoder;
 RotaryEncoder *encoder = nullptr;
-IRAM_ATTR void checkPosition() { encoder->tick(); }
+IRAM_ATTR void checkPosition() {
+    encoder->tick();
+    inputWakeFromISR();
+}
 
 // GPIO expander
 #include <ExtensionIOXL9555.hpp>
@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include "core/utils.h"
 #include <Adafruit_TCA8418.h>
@@ -88,6 +89,7 @@ void _setup_gpio() {
 bool kb_interrupt = false;
 void IRAM_ATTR gpio_isr_handler(void *arg) {
     kb_interrupt = true;
+    inputWakeFromISR();
     // static long i = 0;
     // Serial.printf("interrupt %ld\n", i++);
 }
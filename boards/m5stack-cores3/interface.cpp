@@ -71,8 +71,14 @@ void InputHandler(void) {
 ** location: mykeyboard.cpp
 ** Turns off the device (or try to)
 **********************************************************************/
-void powerOff() { M5.Power.powerOff(); }
-void goToDeepSleep() { M5.Power.deepSleep(); }
+void powerOff() {
+    bruceConfig.commit();
+    M5.Power.powerOff();
+}
+void goToDeepSleep() {
+    bruceConfig.commit();
+    M5.Power.deepSleep();
+}
 
 /*********************************************************************
 ** Function: checkReboot
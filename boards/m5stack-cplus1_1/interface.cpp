@@ -57,7 +57,10 @@ void InputHandler(void) {
     SelPress = selPressed;
 }
 
-void powerOff() { axp192.PowerOff(); }
+void powerOff() {
+    bruceConfig.commit();
+    axp192.PowerOff();
+}
 
 void checkReboot() {
     int countDown;
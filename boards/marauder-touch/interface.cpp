@@ -1,3 +1,4 @@
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include "core/utils.h"
 #include <CYD28_TouchscreenR.h>
@@ -7,7 +8,10 @@ CYD28_TouchR touch(320, 240);
 #ifdef WAVESENTRY
 #include <RotaryEncoder.h>
 RotaryEncoder *encoder = nullptr;
-IRAM_ATTR void checkPosition() { encoder->tick(); }
+IRAM_ATTR void checkPosition() {
+    encoder->tick();
+    inputWakeFromISR();
+}
 #endif
 
 /***************************************************************************************
@@ -133,6 +133,7 @@ void InputHandler(void) {
 ** Turns off the device (or try to)
 **********************************************************************/
 void powerOff() {
+    bruceConfig.commit();
     esp_sleep_enable_ext0_wakeup((gpio_num_t)SEL_BTN, BTN_ACT);
     esp_deep_sleep_start();
 }
@@ -51,6 +51,8 @@ const Dialog = {
   hide: function () {
     this._bg(false);
     this.loading.hide();
+    closeScreenMirror();
+    closeSpectrum();
 
     if (currentDrive && currentPath) {
       updateURL(currentDrive, currentPath, null);
@@ -325,25 +327,24 @@ function syncScrolling() {
   lineNumbers.scrollTop = textarea.scrollTop;
 }
 
-function renderFileRow(fileList) {
-  $("table.explorer tbody").innerHTML = "";
-  fileList.split("\n").sort((a, b) => {
-    let [aFirst, ...aRest] = a.split(':');
-    let [bFirst, ...bRest] = b.split(':');
-
-    if (aFirst !== bFirst) {
-      return bFirst.localeCompare(aFirst);
-    }
-
-    let aRestStr = aRest.join(':').toLowerCase();
-    let bRestStr = bRest.join(':').toLowerCase();
-    return aRestStr.localeCompare(bRestStr);
-  }).forEach((line) => {
+const LIST_PAGE_SIZE = 200;
+function renderFileRow(fileList, append = false) {
+  if (!append) $("table.explorer tbody").innerHTML = "";
+  $("table.explorer tbody tr.load-more")?.remove();
+  // the device already sends folders first, sorted by name
+  fileList.split("\n").forEach((line) => {
     let e;
     let [type, name, size] = line.split(":");
     if (size === undefined) return;
     let dPath = ((currentPath.endsWith("/") ? currentPath : currentPath + "/") + name).replace(/\/\//g, "/");
-    if (type === "pa") {
+    if (type === "mo") {
+      e = document.createElement("tbody");
+      // past the first sorted entries the device lists the rest in folder order
+      let label = size === "1" ? "Load more (unsorted)..." : "Load more...";
+      e.innerHTML = `<tr class="load-more"><td colspan="3" class="act-load-more" data-offset="${name}" style="text-align:center;cursor:pointer">${label}</td></tr>`;
+      e = e.firstElementChild;
+    } else if (type === "pa") {
+      if (append) return;
       if (dPath === "/") return;
       e = T.pathRow();
       let preFolder = currentPath.substring(0, currentPath.lastIndexOf('/'));
@@ -423,7 +424,10 @@ async function fetchFiles(drive, path) {
   $(".current-path").textContent = drive + ":/" + path;
   let req = await requestGet("/listfiles", {
     fs: drive,
-    folder: path
+    folder: path,
+    offset: 0,
+    limit: LIST_PAGE_SIZE,
+    sort: "name"
   });
   renderFileRow(req);
   btnRefreshFolder.classList.remove("reloading");
@@ -471,10 +475,123 @@ function isModified(target) {
 
 async function openNavigator() {
   Dialog.show('navigator');
+  if (openScreenMirror()) return;
   await reloadScreen();
   autoReloadScreen();
 }
 
+/// SCREEN MIRROR
+// The device pushes each drawing as it happens, see TFT_MIRROR_HEADER in tftLogger.h.
+// Packets carry the sequence of their first and last entry, a gap asks for a keyframe.
+let SCREEN_WS = null;
+let SCREEN_SEQ = 0;
+let SCREEN_RENDERING = Promise.resolve();
+function screenMirrorActive() {
+  return SCREEN_WS !== null && SCREEN_WS.readyState === WebSocket.OPEN;
+}
+
+function openScreenMirror() {
+  if (SCREEN_WS) return true;
+  if (!("WebSocket" in window)) return false;
+
+  const protocol = location.protocol === "https:" ? "wss" : "ws";
+  const ws = new WebSocket(`${protocol}://${location.host}${IS_DEV ? "/bruce" : ""}/screenws`);
+  ws.binaryType = "arraybuffer";
+  ws.onopen = () => {
+    SCREEN_SEQ = 0; // the device may have restarted, start from a keyframe
+    ws.send("since 0");
+  };
+  ws.onmessage = (e) => {
+    const packet = new Uint8Array(e.data);
+    if (packet.length < 10 || packet[0] !== 0xAB) return;
+    const keyframe = (packet[1] & 0x01) !== 0;
+    const view = new DataView(e.data);
+    const first = view.getUint32(2);
+    const last = view.getUint32(6);
+
+    if (last < SCREEN_SEQ || (!keyframe && last === SCREEN_SEQ)) return; // already drawn
+    if (!keyframe && first !== SCREEN_SEQ + 1) {
+      ws.send(`since ${SCREEN_SEQ}`);
+      return;
+    }
+    SCREEN_SEQ = last;
+    const entries = packet.subarray(10);
+    SCREEN_RENDERING = SCREEN_RENDERING.then(() => renderTFT(entries, keyframe)).catch(console.error);
+  };
+  ws.onclose = () => {
+    if (SCREEN_WS !== ws) return;
+    SCREEN_WS = null;
+    // back to polling, the auto reload setting applies again
+    if ($(".dialog.navigator:not(.hidden)")) {
+      reloadScreen();
+      autoReloadScreen();
+    }
+  };
+  SCREEN_WS = ws;
+  return true;
+}
+
+function closeScreenMirror() {
+  if (!SCREEN_WS) return;
+  const ws = SCREEN_WS;
+  SCREEN_WS = null;
+  ws.close();
+}
+
+/// SPECTRUM
+// Sweeps pushed by the running spectrum tool, see NRF_SPECTRUM_FRAME in nrf_spectrum.h
+let SPECTRUM_WS = null;
+function openSpectrum() {
+  Dialog.show('spectrum');
+  if (SPECTRUM_WS || !("WebSocket" in window)) return;
+
+  const protocol = location.protocol === "https:" ? "wss" : "ws";
+  const ws = new WebSocket(`${protocol}://${location.host}${IS_DEV ? "/bruce" : ""}/spectrumws`);
+  ws.binaryType = "arraybuffer";
+  ws.onmessage = (e) => {
+    const frame = new Uint8Array(e.data);
+    if (frame.length < 10 || frame[0] !== 0xAC) return;
+    const view = new DataView(e.data);
+    const count = view.getUint16(2);
+    if (frame.length < 10 + 2 * count) return;
+    $(".spectrum-status").textContent = `sweep ${view.getUint32(4)}, ${view.getUint16(8)} sweeps/s`;
+    drawSpectrum(frame.subarray(10, 10 + count), frame.subarray(10 + count, 10 + 2 * count));
+  };
+  ws.onclose = () => {
+    if (SPECTRUM_WS === ws) SPECTRUM_WS = null;
+  };
+  SPECTRUM_WS = ws;
+}
+
+function closeSpectrum() {
+  if (!SPECTRUM_WS) return;
+  const ws = SPECTRUM_WS;
+  SPECTRUM_WS = null;
+  ws.close();
+}
+
+function drawSpectrum(levels, peaks) {
+  const canvas = $("#spectrum-canvas");
+  const ctx = canvas.getContext("2d");
+  const labelHeight = 16;
+  const height = canvas.height - labelHeight;
+  const barWidth = canvas.width / levels.length;
+  const scale = height / 125;
+
+  ctx.fillStyle = "#000";
+  ctx.fillRect(0, 0, canvas.width, canvas.height);
+  ctx.font = "11px monospace";
+  ctx.textAlign = "center";
+  for (let i = 0; i < levels.length; i++) {
+    const x = i * barWidth;
+    ctx.fillStyle = i % 2 === 0 ? "#02de02" : "#888";
+    ctx.fillRect(x, height - levels[i] * scale, barWidth - 1, levels[i] * scale);
+    ctx.fillStyle = "#fff";
+    ctx.fillRect(x, height - peaks[i] * scale - 1, barWidth - 1, 2);
+    if (i > 0 && i % 10 === 0) ctx.fillText(`${2400 + i}`, x, canvas.height - 3);
+  }
+}
+
 let SCREEN_NAVIGATING = false;
 async function runNavigation(direction) {
   if (SCREEN_NAVIGATING) return;
@@ -482,7 +599,7 @@ async function runNavigation(direction) {
   try {
     drawCanvasLoading();
     await requestPost("/cm", { cmnd: `nav ${direction.toLowerCase()}` });
-    await reloadScreen();
+    if (!screenMirrorActive()) await reloadScreen();
   } catch (error) {
     alert("Failed to run command: " + error.message);
     console.error(error)
@@ -494,6 +611,10 @@ async function runNavigation(direction) {
 const btnForceReload = $("#force-reload");
 let SCREEN_RELOAD = false;
 async function reloadScreen() {
+  if (screenMirrorActive()) {
+    SCREEN_WS.send("since 0"); // asks for a keyframe
+    return;
+  }
   if (SCREEN_RELOAD) return;
   SCREEN_RELOAD = true;
   btnForceReload.classList.add("reloading");
@@ -516,7 +637,7 @@ let AUTO_RELOAD_SCREEN = null;
 async function taskReloader() {
   let timer = parseInt(eConfigAutoReload.value);
   let navigatorOpen = $(".dialog.navigator:not(.hidden)");
-  if (timer <= 0 || !navigatorOpen) {
+  if (timer <= 0 || !navigatorOpen || screenMirrorActive()) {
     if (AUTO_RELOAD_SCREEN) {
       clearTimeout(AUTO_RELOAD_SCREEN);
       AUTO_RELOAD_SCREEN = null;
@@ -544,7 +665,7 @@ async function autoReloadScreen() {
 /// TFT RENDER
 let loadingDrawn = false;
 const imageCache = {}; // global
-async function renderTFT(data) {
+async function renderTFT(data, clear = true) {
   loadingDrawn = false;
   const canvas = $("#navigator-screen");
   const ctx = canvas.getContext("2d");
@@ -656,7 +777,7 @@ async function renderTFT(data) {
   }
 
   let offset = 0;
-  ctx.clearRect(0, 0, canvas.width, canvas.height);
+  if (clear) ctx.clearRect(0, 0, canvas.width, canvas.height);
   while (offset < data.length) {
     ctx.beginPath();
     if (data[offset] !== 0xAA) {
@@ -906,6 +1027,21 @@ $(".container").addEventListener("click", async (e) => {
     return;
   }
 
+  let loadMoreAction = e.target.closest(".act-load-more");
+  if (loadMoreAction) {
+    e.preventDefault();
+    loadMoreAction.textContent = "Loading...";
+    let req = await requestGet("/listfiles", {
+      fs: currentDrive,
+      folder: currentPath,
+      offset: loadMoreAction.getAttribute("data-offset"),
+      limit: LIST_PAGE_SIZE,
+      sort: "name"
+    });
+    renderFileRow(req, true);
+    return;
+  }
+
   let editFileAction = e.target.closest(".act-edit-file");
   if (editFileAction) {
     e.preventDefault();
@@ -216,27 +216,13 @@ extern volatile int EncoderLedChange;
 #endif
 
 extern TaskHandle_t xHandle;
+bool inputCheck(volatile bool &btn); // core/input_events.h
 extern inline bool check(volatile bool &btn) {
-
-#ifndef USE_TFT_eSPI_TOUCH
-    if (!btn) return false;
-    vTaskSuspend(xHandle);
-    btn = false;
-    AnyKeyPress = false;
-    SerialCmdPress = false;
-    delay(10);
-    vTaskResume(xHandle);
-    return true;
-#else
-
+#ifdef USE_TFT_eSPI_TOUCH
     InputHandler();
-    if (!btn) return false;
-    btn = false;
-    AnyKeyPress = false;
-    SerialCmdPress = false;
-    return true;
-
 #endif
+    // presses are queued by the input task, the flag alone may already be cleared
+    return inputCheck(btn);
 }
 
 extern gpio_num_t mic_bclk_pin; // used to configure Cardputer ADV Microphone
@@ -42,6 +42,47 @@ enum tftFuncs : uint8_t { // DO NOT CHANGE THE ORDER, ADD NEW FUNCTIONS TO THE E
 struct tftLog {
     uint8_t data[MAX_LOG_SIZE];
 };
+
+// Screen mirror packets: AB FL S1 S1 S1 S1 S2 S2 S2 S2 + log entries
+// FL: flags, S1: sequence of the first entry, S2: sequence of the last entry.
+// A keyframe starts with SCREEN_INFO and replaces what the client has drawn.
+#define TFT_MIRROR_HEADER 0xAB
+#define TFT_MIRROR_KEYFRAME 0x01
+#define TFT_MIRROR_HEADER_SIZE 10
+#define TFT_MIRROR_PACKET_SIZE (MAX_LOG_SIZE * 8)
+#ifndef TFT_MIRROR_QUEUE
+#define TFT_MIRROR_QUEUE 32
+#endif
+// Entries drawn within this time are sent in one packet
+#ifndef TFT_MIRROR_BATCH_MS
+#define TFT_MIRROR_BATCH_MS 20
+#endif
+typedef void (*tftMirrorSink)(const uint8_t *packet, size_t len);
+struct tftMirrorItem {
+    uint32_t seq;
+    bool keyframe;
+    tftLog log;
+};
+
+#ifdef HAS_SCREEN
+// Composited mode: primitives draw into a RAM framebuffer and only the damaged
+// areas are pushed to the panel when the outermost frame ends
+#ifndef TFT_COMPOSITE
+#define TFT_COMPOSITE 0
+#endif
+// Push damaged areas with the TFT_eSPI DMA engine (SPI panels on ESP32 targets only)
+#ifndef TFT_COMPOSITE_DMA
+#define TFT_COMPOSITE_DMA 0
+#endif
+// Rows per DMA band when the framebuffer is in PSRAM and goes out through internal RAM
+#ifndef TFT_COMPOSITE_DMA_ROWS
+#define TFT_COMPOSITE_DMA_ROWS 8
+#endif
+#define TFT_MAX_DAMAGE_RECTS 8
+struct tftRect {
+    int32_t x, y, w, h;
+};
+#endif
 class tft_logger : public BRUCE_TFT_DRIVER {
 private:
     tftLog log[MAX_LOG_ENTRIES];
@@ -57,6 +98,35 @@ private:
     QueueHandle_t asyncSerialQueue = NULL;
     static void asyncSerialTaskFunc(void *pv);
 
+    uint32_t logSeq = 0;
+    bool mirrorKeyframe = false;
+    volatile bool mirroring = false;
+    tftMirrorSink mirrorSink = nullptr;
+    TaskHandle_t mirrorTask = NULL;
+    QueueHandle_t mirrorQueue = NULL;
+    static void mirrorTaskFunc(void *pv);
+    void mirrorEntry(const tftLog &l);
+
+    uint8_t frameDepth = 0;
+#ifdef HAS_SCREEN
+    TFT_eSprite *frame = nullptr;
+    uint16_t *dmaBands = nullptr; // two internal RAM bands, see TFT_COMPOSITE_DMA_ROWS
+    int32_t dmaBandSize = 0;
+    tftRect damage[TFT_MAX_DAMAGE_RECTS];
+    uint8_t damageCount = 0;
+    uint32_t statsFrames = 0;
+    uint32_t statsBytes = 0;
+    uint32_t statsStart = 0;
+
+    bool createFrame();
+    void addDamage(int32_t x, int32_t y, int32_t w, int32_t h);
+    void addTextDamage(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t datum);
+    void syncTextState();
+    void pushDamage();
+    size_t composePrint(const String &s);
+    int16_t composeString(const String &string, int32_t x, int32_t y, uint8_t font, uint8_t datum);
+#endif
+
 public:
     tft_logger(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
     virtual ~tft_logger();
@@ -69,9 +139,46 @@ public:
     void inline setSleepMode(bool mode) { isSleeping = mode; }
 
     void getBinLog(uint8_t *outBuffer, size_t &outSize);
+    void getBinLog(Print &out);
+
+    // Push-based mirror: every logged entry is numbered and handed to sink in batches,
+    // from its own task. fillScreen starts a keyframe, see TFT_MIRROR_HEADER.
+    void startMirror(tftMirrorSink sink);
+    void stopMirror();
+    // Whole log as a keyframe packet, for clients that connect or missed a sequence
+    size_t getKeyframe(uint8_t *outBuffer, size_t maxLen);
+    uint32_t inline getLogSeq(void) { return logSeq; }
     bool removeLogEntriesInsideRect(int rx, int ry, int rw, int rh);
     void removeOverlappedImages(int x, int y, int center, int ms);
 
+    // Composited rendering, see TFT_COMPOSITE. Frames nest, drawing done between the
+    // outermost beginFrame() and endFrame() reaches the panel in one push.
+    bool setCompositing(bool enable);
+    bool getCompositing(void);
+    void beginFrame(void);
+    void endFrame(void);
+    // Frames pushed per second and bytes pushed per frame since the previous call
+    void getFrameStats(float &fps, uint32_t &bytesPerFrame);
+#ifdef HAS_SCREEN
+    void setRotation(uint8_t r);
+
+    // Pixel and image primitives also go through the framebuffer when compositing
+    using BRUCE_TFT_DRIVER::drawPixel;
+    using BRUCE_TFT_DRIVER::pushImage;
+    void drawPixel(int32_t x, int32_t y, uint32_t color) override;
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data);
+    void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data);
+    void drawXBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+    void drawXBitmap(
+        int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bgcolor
+    );
+    // TFT_eSprite::pushSprite() writes to the panel directly, push sprites drawn on screen here
+    void pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y);
+#else
+    using BRUCE_TFT_DRIVER::pushSprite;
+    void pushSprite(BRUCE_TFT_DRIVER &sprite, int32_t x, int32_t y) { sprite.pushSprite(x, y); }
+#endif
+
     void fillScreen(int32_t color);
     void startAsyncSerial();
     void stopAsyncSerial();
@@ -150,9 +257,14 @@ protected:
         logging = false;
     }
     void restoreLogger();
+    BRUCE_TFT_DRIVER &canvas(int32_t x, int32_t y, int32_t w, int32_t h);
+    void present();
     void addLogEntry(const uint8_t *buffer, uint8_t size);
     void logWriteHeader(uint8_t *buffer, uint8_t &pos, tftFuncs fn);
     void writeUint16(uint8_t *buffer, uint8_t &pos, uint16_t value);
+    size_t writeTftInfo(uint8_t *out);
+    size_t writeEntry(const tftLog &l, uint8_t *out);
+    size_t writeBinLog(uint8_t *outBuffer, size_t maxLen);
 };
 
 #endif //__DISPLAY_LOGER
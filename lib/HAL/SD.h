@@ -71,14 +71,15 @@ public:
     );
 #endif
     void end();
+    uint8_t pdrv() const { return _pdrv; } // FatFs drive number, 0xFF when not mounted
     sdcard_type_t cardType();
     uint64_t cardSize();
     size_t numSectors();
     size_t sectorSize();
     uint64_t totalBytes();
     uint64_t usedBytes();
-    bool readRAW(uint8_t *buffer, uint32_t sector);
-    bool writeRAW(uint8_t *buffer, uint32_t sector);
+    bool readRAW(uint8_t *buffer, uint32_t sector, uint32_t count = 1);
+    bool writeRAW(const uint8_t *buffer, uint32_t sector, uint32_t count = 1);
 };
 
 } // namespace fs
@@ -654,12 +654,13 @@ DRESULT ff_sd_ioctl(uint8_t pdrv, uint8_t cmd, void *buff) {
   return RES_PARERR;
 }
 
-bool sd_read_raw(uint8_t pdrv, uint8_t *buffer, DWORD sector) {
-  return ff_sd_read(pdrv, buffer, sector, 1) == ESP_OK;
+// count > 1 uses CMD18/CMD25 multi-block transfers
+bool sd_read_raw(uint8_t pdrv, uint8_t *buffer, uint32_t sector, uint32_t count) {
+  return ff_sd_read(pdrv, buffer, sector, count) == ESP_OK;
 }
 
-bool sd_write_raw(uint8_t pdrv, uint8_t *buffer, DWORD sector) {
-  return ff_sd_write(pdrv, buffer, sector, 1) == ESP_OK;
+bool sd_write_raw(uint8_t pdrv, const uint8_t *buffer, uint32_t sector, uint32_t count) {
+  return ff_sd_write(pdrv, buffer, sector, count) == ESP_OK;
 }
 
 /*
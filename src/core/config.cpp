@@ -1,5 +1,6 @@
 #include "config.h"
 #include "sd_functions.h"
+#include <esp_system.h>
 
 JsonDocument BruceConfig::toJson() const {
     JsonDocument jsonDoc;
@@ -383,29 +384,134 @@ void BruceConfig::fromFile(bool checkFS) {
     log_i("Using config from file");
 }
 
+static BruceConfig *shutdownConfig = nullptr;
+
+// Runs from esp_restart(), makes sure debounced changes are not lost on ESP.restart()
+static void configShutdownHandler() {
+    if (shutdownConfig) shutdownConfig->flushPending();
+}
+
 void BruceConfig::saveFile() {
-    FS *fs = &LittleFS;
-    JsonDocument jsonDoc = toJson();
+    if (_saveLock == NULL) {
+        SemaphoreHandle_t saveLock = xSemaphoreCreateMutex();
+        SemaphoreHandle_t writeLock = xSemaphoreCreateMutex();
+        if (saveLock == NULL || writeLock == NULL) {
+            // both or neither, the other functions only look at _saveLock
+            if (saveLock != NULL) vSemaphoreDelete(saveLock);
+            if (writeLock != NULL) vSemaphoreDelete(writeLock);
+            log_e("Failed to create config save lock");
+            return;
+        }
+        _writeLock = writeLock;
+        _saveLock = saveLock;
+    }
+
+    // Serialize on the caller's task so the writer never reads the containers while they change
+    String json;
+    serializeJsonPretty(toJson(), json);
+
+    xSemaphoreTake(_saveLock, portMAX_DELAY);
+    if (_dirty) _savesCoalesced++;
+    _pendingJson = json;
+    _saveGeneration++;
+    _dirty = true;
+    bool hasTask = _saveTask != NULL || _startSaveTask();
+    xSemaphoreGive(_saveLock);
 
-    // Open file for writing
-    File file = fs->open(filepath, FILE_WRITE);
+    if (hasTask) xTaskNotifyGive(_saveTask);
+    else flushPending(); // no task available, write synchronously as before
+}
+
+bool BruceConfig::_startSaveTask() {
+    if (xTaskCreate(_saveTaskLoop, "configSave", 4096, this, 1, &_saveTask) != pdPASS) {
+        _saveTask = NULL;
+        log_e("Failed to create config save task");
+        return false;
+    }
+    shutdownConfig = this;
+    esp_register_shutdown_handler(configShutdownHandler);
+    return true;
+}
+
+void BruceConfig::_saveTaskLoop(void *param) {
+    BruceConfig *config = static_cast<BruceConfig *>(param);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Wait until changes stop for CONFIG_SAVE_DELAY_MS, but never hold them longer than the max delay
+        TickType_t firstChange = xTaskGetTickCount();
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_SAVE_DELAY_MS)) > 0) {
+            if (xTaskGetTickCount() - firstChange >= pdMS_TO_TICKS(CONFIG_SAVE_MAX_DELAY_MS)) break;
+        }
+        config->flushPending();
+    }
+}
+
+bool BruceConfig::flushPending() {
+    if (_saveLock == NULL) return false;
+    if (xSemaphoreTake(_writeLock, pdMS_TO_TICKS(1000)) != pdTRUE) return false;
+
+    // Take a copy and let go of the lock, saveFile() on the UI task never waits for the flash
+    xSemaphoreTake(_saveLock, portMAX_DELAY);
+    if (!_dirty) {
+        xSemaphoreGive(_saveLock);
+        xSemaphoreGive(_writeLock);
+        return false;
+    }
+    String json = _pendingJson;
+    uint32_t generation = _saveGeneration;
+    xSemaphoreGive(_saveLock);
+
+    // Write to a temp file and rename it over the config, a power loss never leaves a truncated file
+    String tmpPath = String(filepath) + ".tmp";
+    bool result = false;
+    File file = LittleFS.open(tmpPath, FILE_WRITE);
     if (!file) {
         log_e("Failed to open config file");
+    } else {
+        size_t written = file.print(json);
         file.close();
-        return;
-    };
-
-    // Serialize JSON to file
-    serializeJsonPretty(jsonDoc, Serial);
-    if (serializeJsonPretty(jsonDoc, file) < 5) log_e("Failed to write config file");
-    else log_i("config file written successfully");
+        if (written != json.length()) {
+            log_e("Failed to write config file");
+            LittleFS.remove(tmpPath);
+        } else if (!LittleFS.rename(tmpPath, filepath)) {
+            log_e("Failed to replace config file");
+            LittleFS.remove(tmpPath);
+        } else {
+            result = true;
+        }
+    }
 
-    file.close();
+    if (result) {
+        xSemaphoreTake(_saveLock, portMAX_DELAY);
+        // A save that came in during the write stays pending for the next flush
+        if (generation == _saveGeneration) {
+            _dirty = false;
+            _pendingJson = "";
+        }
+        _sdDirty = true;
+        _flushCount++;
+        xSemaphoreGive(_saveLock);
+        log_i("config file written (%u writes, %u saves coalesced)", _flushCount, _savesCoalesced);
+    }
+    xSemaphoreGive(_writeLock);
+    return result;
+}
 
-    if (setupSdCard()) copyToFs(LittleFS, SD, filepath, false);
+void BruceConfig::commit() {
+    flushPending();
+    // SD copy is only refreshed on commit, SD shares the SPI bus with display and radios
+    if (_sdDirty && setupSdCard() && copyToFs(LittleFS, SD, filepath, false)) _sdDirty = false;
 }
 
 void BruceConfig::factoryReset() {
+    // drop pending changes, otherwise the shutdown handler would write the config back
+    if (_saveLock != NULL) {
+        xSemaphoreTake(_writeLock, portMAX_DELAY); // and wait for a flush already running
+        xSemaphoreTake(_saveLock, portMAX_DELAY);
+        _dirty = false;
+        xSemaphoreGive(_saveLock);
+        xSemaphoreGive(_writeLock);
+    }
     FS *fs = &LittleFS;
     fs->rename(String(filepath), "/bak." + String(filepath).substring(1));
     if (setupSdCard()) SD.rename(String(filepath), "/bak." + String(filepath).substring(1));
@@ -9,6 +9,13 @@
 #include <set>
 #include <vector>
 
+#ifndef CONFIG_SAVE_DELAY_MS // quiet period before pending changes are written to flash
+#define CONFIG_SAVE_DELAY_MS 2000
+#endif
+#ifndef CONFIG_SAVE_MAX_DELAY_MS // upper bound when changes keep coming (e.g. sliders)
+#define CONFIG_SAVE_MAX_DELAY_MS 10000
+#endif
+
 enum EvilPortalPasswordMode { FULL_PASSWORD = 0, FIRST_LAST_CHAR = 1, HIDE_PASSWORD = 2, SAVE_LENGTH = 3 };
 
 class BruceConfig : public BruceTheme {
@@ -100,7 +107,13 @@ public:
     /////////////////////////////////////////////////////////////////////////////////////
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
+    // Marks the config dirty, it is written to LittleFS after CONFIG_SAVE_DELAY_MS without changes
     void saveFile();
+    // Writes pending changes now and syncs the SD copy, call before reboot/sleep/power off
+    void commit();
+    bool flushPending();
+    uint32_t flushCount() const { return _flushCount; }
+    uint32_t savesCoalesced() const { return _savesCoalesced; }
     void fromFile(bool checkFS = true);
     void factoryReset();
     void validateConfig();
@@ -179,6 +192,20 @@ public:
     void addWebUISession(const String &token);
     void removeWebUISession(const String &token);
     bool isValidWebUISession(const String &token);
+
+private:
+    SemaphoreHandle_t _saveLock = NULL;  // _pendingJson and the flags, never held during flash I/O
+    SemaphoreHandle_t _writeLock = NULL; // one flush at a time
+    TaskHandle_t _saveTask = NULL;
+    String _pendingJson = "";
+    uint32_t _saveGeneration = 0; // bumped by every saveFile()
+    bool _dirty = false;
+    bool _sdDirty = false;
+    uint32_t _flushCount = 0;
+    uint32_t _savesCoalesced = 0;
+
+    bool _startSaveTask();
+    static void _saveTaskLoop(void *param);
 };
 
 #endif
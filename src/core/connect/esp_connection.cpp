@@ -1,5 +1,6 @@
 #include "esp_connection.h"
 #include "core/display.h"
+#include "espnow_xfer.h"
 #include <WiFi.h>
 
 // Initialize the static instance pointer
@@ -13,6 +14,12 @@ EspConnection::~EspConnection() {
     esp_now_unregister_recv_cb();
 
     esp_now_deinit();
+
+    if (xferQueue) {
+        XferPacket packet;
+        while (xQueueReceive(xferQueue, &packet, 0) == pdTRUE) free(packet.data);
+        vQueueDelete(xferQueue);
+    }
 }
 
 bool EspConnection::beginSend() {
@@ -50,12 +57,24 @@ bool EspConnection::beginEspnow() {
         return false;
     }
 
+    if (!xferQueue) xferQueue = xQueueCreate(ESP_XFER_QUEUE_DEPTH, sizeof(XferPacket));
+
     esp_now_register_send_cb(onDataSentStatic);
     esp_now_register_recv_cb(onDataRecvStatic);
 
     return true;
 }
 
+bool EspConnection::xferSend(const uint8_t *packet, size_t len) {
+    // ESP_ERR_ESPNOW_NO_MEM while the WiFi queue is full, the transfer sends it again later
+    return esp_now_send(dstAddress, packet, len) == ESP_OK;
+}
+
+bool EspConnection::xferReceive(XferPacket &packet, uint32_t waitMs) {
+    if (!xferQueue) return false;
+    return xQueueReceive(xferQueue, &packet, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+}
+
 EspConnection::Message EspConnection::createMessage(String text) {
     Message message;
 
@@ -69,19 +88,6 @@ EspConnection::Message EspConnection::createMessage(String text) {
     return message;
 }
 
-EspConnection::Message EspConnection::createFileMessage(File file) {
-    Message message;
-    String path = String(file.path());
-
-    message.isFile = true;
-    message.totalBytes = file.size();
-
-    strncpy(message.filename, file.name(), ESP_FILENAME_SIZE);
-    strncpy(message.filepath, path.substring(0, path.lastIndexOf("/")).c_str(), ESP_FILEPATH_SIZE);
-
-    return message;
-}
-
 EspConnection::Message EspConnection::createPingMessage() {
     Message message;
     message.ping = true;
@@ -178,6 +184,8 @@ void EspConnection::appendPeerToList(const uint8_t *mac) {
 }
 
 void EspConnection::onDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
+    if (xferActive) return; // the transfer acks its own packets
+
     if (status == ESP_NOW_SEND_SUCCESS) {
         sendStatus = SUCCESS;
         Serial.println("ESPNOW send success");
@@ -188,6 +196,19 @@ void EspConnection::onDataSent(const uint8_t *mac_addr, esp_now_send_status_t st
 }
 
 void EspConnection::onDataRecv(const uint8_t *mac, const uint8_t *incomingData, int len) {
+    if (len >= ESPNOW_XFER_HEADER && incomingData[0] == ESPNOW_XFER_MAGIC) {
+        // Runs in the WiFi task, only copy it out. A full queue drops it, the sender resends
+        if (!xferQueue) return;
+        XferPacket packet;
+        packet.data = (uint8_t *)malloc(len);
+        if (!packet.data) return;
+        memcpy(packet.mac, mac, 6);
+        memcpy(packet.data, incomingData, len);
+        packet.len = len;
+        if (xQueueSend(xferQueue, &packet, 0) != pdTRUE) free(packet.data);
+        return;
+    }
+
     Message recvMessage;
 
     // Use reinterpret_cast and copy assignment
@@ -2,6 +2,7 @@
 #define __ESP_CONNECTION_H__
 
 #include <esp_now.h>
+#include <freertos/queue.h>
 #include <globals.h>
 #include <vector>
 
@@ -9,6 +10,17 @@
 #define ESP_FILEPATH_SIZE 50
 #define ESP_DATA_SIZE 150
 
+// Largest ESP-NOW payload, v2 when the IDF has it
+#ifdef ESP_NOW_MAX_DATA_LEN_V2
+#define ESP_XFER_PACKET_SIZE ESP_NOW_MAX_DATA_LEN_V2
+#else
+#define ESP_XFER_PACKET_SIZE ESP_NOW_MAX_DATA_LEN
+#endif
+// Transfer packets waiting for the loop, a full window plus its acks
+#ifndef ESP_XFER_QUEUE_DEPTH
+#define ESP_XFER_QUEUE_DEPTH 48
+#endif
+
 class EspConnection {
 public:
     enum Status {
@@ -39,6 +51,13 @@ public:
         }
     };
 
+    // Transfer packet copied out of the receive callback, the reader frees data
+    struct XferPacket {
+        uint8_t mac[6];
+        uint8_t *data;
+        uint16_t len;
+    };
+
     EspConnection();
     ~EspConnection();
 
@@ -53,12 +72,16 @@ protected:
     uint8_t dstAddress[6];
     uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
     std::vector<Message> recvQueue;
+    QueueHandle_t xferQueue = nullptr;
+    bool xferActive = false; // no per packet logging while a transfer runs
 
     bool beginSend();
     bool beginEspnow();
 
+    bool xferSend(const uint8_t *packet, size_t len);
+    bool xferReceive(XferPacket &packet, uint32_t waitMs);
+
     Message createMessage(String text);
-    Message createFileMessage(File file);
     Message createPingMessage();
     Message createPongMessage();
 
@@ -0,0 +1,426 @@
+/**
+ * @file espnow_xfer.cpp
+ * @brief Windowed, acknowledged file transfer over ESP-NOW packets
+ */
+
+#include "espnow_xfer.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_rom_crc.h>
+#endif
+
+static void putLE(uint8_t *p, uint32_t value, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++) p[i] = value >> (8 * i);
+}
+
+static uint32_t getLE(const uint8_t *p, uint8_t bytes) {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++) value |= (uint32_t)p[i] << (8 * i);
+    return value;
+}
+
+static size_t putHeader(uint8_t *p, EspXferType type, uint16_t id, uint32_t seq) {
+    p[0] = ESPNOW_XFER_MAGIC;
+    p[1] = type;
+    putLE(p + 2, id, 2);
+    putLE(p + 4, seq, 4);
+    return ESPNOW_XFER_HEADER;
+}
+
+// zlib CRC-32, chained like esp_rom_crc32_le
+uint32_t espXferCrc32(uint32_t crc, const uint8_t *data, size_t len) {
+#ifdef ARDUINO
+    return esp_rom_crc32_le(crc, data, len);
+#else
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Sender
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool EspXferSender::begin(
+    const char *path, const char *name, uint32_t size, uint16_t maxPacket, uint32_t now
+) {
+    const size_t pathLen = strlen(path) + 1;
+    const size_t nameLen = strlen(name) + 1;
+    if (pathLen + nameLen > sizeof(_names) || maxPacket <= ESPNOW_XFER_HEADER) return false;
+    if (maxPacket > ESPNOW_XFER_MAX_PACKET) maxPacket = ESPNOW_XFER_MAX_PACKET;
+
+    memcpy(_names, path, pathLen);
+    memcpy(_names + pathLen, name, nameLen);
+    _namesLen = pathLen + nameLen;
+    _id = (uint16_t)(now ^ (now >> 16) ^ size ^ (size >> 16)) | 1;
+    _size = size;
+    _maxPacket = maxPacket;
+    _chunk = 0;
+    _window = 0;
+    _chunks = 0;
+    _base = 0;
+    _next = 0;
+    _crc = 0;
+    _packetsSent = 0;
+    _retransmits = 0;
+    _error = ESPNOW_XFER_OK;
+    _state = ESPNOW_XFER_CONNECTING;
+    _controlTries = 0;
+    sendStart(now);
+    return true;
+}
+
+bool EspXferSender::sendStart(uint32_t now) {
+    size_t len = putHeader(_packet, ESPNOW_XFER_START, _id, 0);
+    putLE(_packet + len, _size, 4);
+    putLE(_packet + len + 4, _maxPacket, 2);
+    len += 6;
+    memcpy(_packet + len, _names, _namesLen);
+    len += _namesLen;
+
+    _lastControl = now;
+    _controlTries++;
+    return _link.send(_packet, len);
+}
+
+bool EspXferSender::sendEnd(uint32_t now) {
+    size_t len = putHeader(_packet, ESPNOW_XFER_END, _id, _chunks);
+    putLE(_packet + len, _size, 4);
+    putLE(_packet + len + 4, _crc, 4);
+
+    _lastControl = now;
+    _controlTries++;
+    return _link.send(_packet, len + 8);
+}
+
+bool EspXferSender::sendChunk(uint32_t seq, uint32_t now) {
+    const uint32_t offset = seq * _chunk;
+    const size_t want = _size - offset < _chunk ? _size - offset : _chunk;
+    const size_t len = putHeader(_packet, ESPNOW_XFER_DATA, _id, seq);
+    if (_link.read(offset, _packet + len, want) != want) {
+        fail(ESPNOW_XFER_IO_ERROR, true);
+        return false;
+    }
+    if (!_link.send(_packet, len + want)) return false;
+
+    const uint8_t slot = seq % ESPNOW_XFER_MAX_WINDOW;
+    if (seq == _next) {
+        _crc = espXferCrc32(_crc, _packet + len, want);
+        _tries[slot] = 0;
+        _acked[slot] = false;
+        _next++;
+    } else {
+        _retransmits++;
+    }
+    _sentAt[slot] = now;
+    _tries[slot]++;
+    _packetsSent++;
+    return true;
+}
+
+void EspXferSender::onPacket(const uint8_t *packet, size_t len, uint32_t now) {
+    if (len < ESPNOW_XFER_HEADER || packet[0] != ESPNOW_XFER_MAGIC) return;
+    if (getLE(packet + 2, 2) != _id) return;
+    const uint8_t type = packet[1];
+    const uint32_t seq = getLE(packet + 4, 4);
+    const uint8_t *payload = packet + ESPNOW_XFER_HEADER;
+    len -= ESPNOW_XFER_HEADER;
+
+    if (type == ESPNOW_XFER_ABORT) {
+        if (_state != ESPNOW_XFER_DONE) fail(ESPNOW_XFER_CANCELLED, false);
+        return;
+    }
+
+    if (type == ESPNOW_XFER_READY && _state == ESPNOW_XFER_CONNECTING && len >= 4) {
+        uint16_t packetSize = getLE(payload, 2);
+        uint16_t window = getLE(payload + 2, 2);
+        if (packetSize > _maxPacket) packetSize = _maxPacket;
+        if (window > ESPNOW_XFER_MAX_WINDOW) window = ESPNOW_XFER_MAX_WINDOW;
+        if (packetSize <= ESPNOW_XFER_HEADER || window == 0) return fail(ESPNOW_XFER_IO_ERROR, true);
+
+        _chunk = packetSize - ESPNOW_XFER_HEADER;
+        _window = window;
+        _chunks = (_size + _chunk - 1) / _chunk;
+        _state = ESPNOW_XFER_SENDING;
+        _controlTries = 0;
+        poll(now);
+        return;
+    }
+
+    if (type == ESPNOW_XFER_ACK && _state == ESPNOW_XFER_SENDING && len >= 4) {
+        // Cumulative part
+        const uint32_t upTo = seq < _next ? seq : _next;
+        while (_base < upTo) _acked[_base++ % ESPNOW_XFER_MAX_WINDOW] = true;
+
+        // Selective part, chunks after the first hole
+        const uint32_t bitmap = getLE(payload, 4);
+        uint32_t highest = _base;
+        for (uint8_t i = 0; i < 32; i++) {
+            if (!(bitmap & (1UL << i))) continue;
+            const uint32_t s = seq + 1 + i;
+            if (s < _base || s >= _next) continue;
+            _acked[s % ESPNOW_XFER_MAX_WINDOW] = true;
+            highest = s;
+        }
+        // Holes below a chunk that arrived are lost, resend them now
+        for (uint32_t s = _base; s < highest; s++) {
+            const uint8_t slot = s % ESPNOW_XFER_MAX_WINDOW;
+            if (_acked[slot] || now - _sentAt[slot] < ESPNOW_XFER_NACK_MS) continue;
+            if (!sendChunk(s, now)) break;
+        }
+        poll(now);
+        return;
+    }
+
+    if (type == ESPNOW_XFER_FINISHED && _state == ESPNOW_XFER_ENDING && len >= 1) {
+        if (payload[0] == ESPNOW_XFER_OK) _state = ESPNOW_XFER_DONE;
+        else fail((EspXferError)payload[0], false);
+    }
+}
+
+void EspXferSender::poll(uint32_t now) {
+    switch (_state) {
+        case ESPNOW_XFER_CONNECTING:
+        case ESPNOW_XFER_ENDING:
+            if (now - _lastControl < ESPNOW_XFER_RTO_MS) return;
+            if (_controlTries >= ESPNOW_XFER_MAX_RETRIES) return fail(ESPNOW_XFER_TIMEOUT, true);
+            if (_state == ESPNOW_XFER_CONNECTING) sendStart(now);
+            else sendEnd(now);
+            return;
+
+        case ESPNOW_XFER_SENDING: break;
+
+        default: return;
+    }
+
+    // Timeouts first, the oldest chunks block the window
+    for (uint32_t s = _base; s < _next && _state == ESPNOW_XFER_SENDING; s++) {
+        const uint8_t slot = s % ESPNOW_XFER_MAX_WINDOW;
+        if (_acked[slot] || now - _sentAt[slot] < ESPNOW_XFER_RTO_MS) continue;
+        if (_tries[slot] > ESPNOW_XFER_MAX_RETRIES) return fail(ESPNOW_XFER_TIMEOUT, true);
+        if (!sendChunk(s, now)) return;
+    }
+
+    while (_state == ESPNOW_XFER_SENDING && _next < _chunks && _next - _base < _window) {
+        if (!sendChunk(_next, now)) return;
+    }
+
+    if (_state == ESPNOW_XFER_SENDING && _base == _chunks) {
+        _state = ESPNOW_XFER_ENDING;
+        _controlTries = 0;
+        sendEnd(now);
+    }
+}
+
+uint32_t EspXferSender::bytesAcked() const {
+    const uint32_t bytes = _base * _chunk;
+    return bytes < _size ? bytes : _size;
+}
+
+void EspXferSender::abort() {
+    if (_state == ESPNOW_XFER_IDLE || _state == ESPNOW_XFER_DONE || _state == ESPNOW_XFER_FAILED) return;
+    fail(ESPNOW_XFER_CANCELLED, true);
+}
+
+void EspXferSender::fail(EspXferError error, bool notify) {
+    _state = ESPNOW_XFER_FAILED;
+    _error = error;
+    if (!notify) return;
+    size_t len = putHeader(_packet, ESPNOW_XFER_ABORT, _id, 0);
+    _packet[len++] = error;
+    _link.send(_packet, len);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Receiver
+/////////////////////////////////////////////////////////////////////////////////////
+
+static uint8_t *allocBuffer(size_t size) {
+#ifdef ARDUINO
+    if (psramFound()) return (uint8_t *)ps_malloc(size);
+#endif
+    return (uint8_t *)malloc(size);
+}
+
+EspXferReceiver::~EspXferReceiver() { free(_buffer); }
+
+void EspXferReceiver::begin(uint16_t maxPacket) {
+    if (maxPacket > ESPNOW_XFER_MAX_PACKET) maxPacket = ESPNOW_XFER_MAX_PACKET;
+    _maxPacket = maxPacket;
+    _state = ESPNOW_XFER_IDLE;
+    _error = ESPNOW_XFER_OK;
+    _name[0] = '\0';
+}
+
+void EspXferReceiver::onPacket(const uint8_t *packet, size_t len, uint32_t now) {
+    if (len < ESPNOW_XFER_HEADER || packet[0] != ESPNOW_XFER_MAGIC) return;
+    const uint8_t type = packet[1];
+    const uint16_t id = getLE(packet + 2, 2);
+
+    if (type == ESPNOW_XFER_START) {
+        if (_state == ESPNOW_XFER_IDLE) return onStart(packet, len, now);
+        if (id == _id && _state == ESPNOW_XFER_SENDING) sendReady(); // the ready got lost
+        return;
+    }
+    if (id != _id || _state == ESPNOW_XFER_IDLE) return;
+    _lastPacket = now;
+
+    switch (type) {
+        case ESPNOW_XFER_DATA:
+            if (_state == ESPNOW_XFER_SENDING) {
+                onData(getLE(packet + 4, 4), packet + ESPNOW_XFER_HEADER, len - ESPNOW_XFER_HEADER, now);
+            }
+            break;
+        case ESPNOW_XFER_END: onEnd(packet, len); break;
+        case ESPNOW_XFER_ABORT:
+            if (_state == ESPNOW_XFER_SENDING) finish(ESPNOW_XFER_CANCELLED);
+            break;
+        default: break;
+    }
+}
+
+void EspXferReceiver::onStart(const uint8_t *packet, size_t len, uint32_t now) {
+    if (len < ESPNOW_XFER_HEADER + 8) return;
+    const uint8_t *payload = packet + ESPNOW_XFER_HEADER;
+    const char *path = (const char *)payload + 6;
+    const char *end = (const char *)packet + len;
+    const char *name = (const char *)memchr(path, '\0', end - path);
+    if (!name) return;
+    name++;
+    if (!memchr(name, '\0', end - name)) return;
+
+    _id = getLE(packet + 2, 2);
+    _size = getLE(payload, 4);
+    uint16_t packetSize = getLE(payload + 4, 2);
+    if (packetSize > _maxPacket) packetSize = _maxPacket;
+    if (packetSize <= ESPNOW_XFER_HEADER) return;
+    _chunk = packetSize - ESPNOW_XFER_HEADER;
+    _window = ESPNOW_XFER_WINDOW_BYTES / _chunk;
+    if (_window > ESPNOW_XFER_MAX_WINDOW) _window = ESPNOW_XFER_MAX_WINDOW;
+    if (_window == 0) _window = 1;
+    _chunks = (_size + _chunk - 1) / _chunk;
+    _expected = 0;
+    _bytes = 0;
+    _crc = 0;
+    _unacked = 0;
+    _duplicates = 0;
+    _lastPacket = now;
+    memset(_have, 0, sizeof(_have));
+    strncpy(_name, name, sizeof(_name) - 1);
+    _name[sizeof(_name) - 1] = '\0';
+
+    free(_buffer);
+    _buffer = allocBuffer((size_t)_window * _chunk);
+    _state = ESPNOW_XFER_SENDING;
+    if (!_buffer || !_link.open(path, name, _size)) return cancel(ESPNOW_XFER_IO_ERROR);
+    sendReady();
+}
+
+uint32_t EspXferReceiver::chunkLength(uint32_t seq) const {
+    return seq + 1 < _chunks ? _chunk : _size - seq * _chunk;
+}
+
+void EspXferReceiver::onData(uint32_t seq, const uint8_t *data, size_t len, uint32_t now) {
+    if (seq >= _chunks || len != chunkLength(seq)) return;
+    if (seq < _expected || seq >= _expected + _window) {
+        // Already written, our ack got lost. Or too far ahead to keep
+        _duplicates++;
+        sendAck();
+        return;
+    }
+
+    const uint8_t slot = seq % _window;
+    if (_have[slot]) {
+        _duplicates++;
+        sendAck();
+        return;
+    }
+    memcpy(_buffer + slot * _chunk, data, len);
+    _length[slot] = len;
+    _have[slot] = true;
+    const bool inOrder = seq == _expected;
+
+    // Write out everything that is now in order
+    for (uint8_t s = _expected % _window; _have[s]; s = _expected % _window) {
+        if (!_link.write(_buffer + s * _chunk, _length[s])) return cancel(ESPNOW_XFER_IO_ERROR);
+        _crc = espXferCrc32(_crc, _buffer + s * _chunk, _length[s]);
+        _bytes += _length[s];
+        _have[s] = false;
+        _expected++;
+    }
+
+    // A chunk ahead of a hole acks at once, that ack is the NACK for the hole
+    if (!inOrder || _expected == _chunks) return sendAck();
+    if (_unacked++ == 0) _firstUnacked = now;
+    if (_unacked >= ESPNOW_XFER_ACK_EVERY) sendAck();
+}
+
+void EspXferReceiver::onEnd(const uint8_t *packet, size_t len) {
+    if (len < ESPNOW_XFER_HEADER + 8) return;
+    if (_state == ESPNOW_XFER_DONE || _state == ESPNOW_XFER_FAILED) return sendFinished();
+    if (_expected < _chunks) return sendAck(); // still missing chunks, tell what
+
+    const uint32_t size = getLE(packet + ESPNOW_XFER_HEADER, 4);
+    const uint32_t crc = getLE(packet + ESPNOW_XFER_HEADER + 4, 4);
+    finish(size == _size && _bytes == _size && crc == _crc ? ESPNOW_XFER_OK : ESPNOW_XFER_CORRUPT);
+    sendFinished();
+}
+
+void EspXferReceiver::poll(uint32_t now) {
+    if (_state != ESPNOW_XFER_SENDING) return;
+    if (_unacked && now - _firstUnacked >= ESPNOW_XFER_ACK_DELAY_MS) sendAck();
+    if (now - _lastPacket >= ESPNOW_XFER_IDLE_MS) finish(ESPNOW_XFER_TIMEOUT);
+}
+
+void EspXferReceiver::abort() {
+    if (_state == ESPNOW_XFER_SENDING) cancel(ESPNOW_XFER_CANCELLED);
+}
+
+// Ends the transfer here and tells the sender why
+void EspXferReceiver::cancel(EspXferError error) {
+    finish(error);
+    uint8_t packet[ESPNOW_XFER_HEADER + 1];
+    putHeader(packet, ESPNOW_XFER_ABORT, _id, 0);
+    packet[ESPNOW_XFER_HEADER] = error;
+    _link.send(packet, sizeof(packet));
+}
+
+void EspXferReceiver::sendReady() {
+    uint8_t packet[ESPNOW_XFER_HEADER + 4];
+    putHeader(packet, ESPNOW_XFER_READY, _id, 0);
+    putLE(packet + ESPNOW_XFER_HEADER, _chunk + ESPNOW_XFER_HEADER, 2);
+    putLE(packet + ESPNOW_XFER_HEADER + 2, _window, 2);
+    _link.send(packet, sizeof(packet));
+}
+
+void EspXferReceiver::sendAck() {
+    uint32_t bitmap = 0;
+    for (uint8_t i = 0; i < 32 && _expected + 1 + i < _expected + _window; i++) {
+        if (_have[(_expected + 1 + i) % _window]) bitmap |= 1UL << i;
+    }
+    uint8_t packet[ESPNOW_XFER_HEADER + 4];
+    putHeader(packet, ESPNOW_XFER_ACK, _id, _expected);
+    putLE(packet + ESPNOW_XFER_HEADER, bitmap, 4);
+    if (_link.send(packet, sizeof(packet))) _unacked = 0;
+}
+
+void EspXferReceiver::sendFinished() {
+    uint8_t packet[ESPNOW_XFER_HEADER + 1];
+    putHeader(packet, ESPNOW_XFER_FINISHED, _id, _chunks);
+    packet[ESPNOW_XFER_HEADER] = _error;
+    _link.send(packet, sizeof(packet));
+}
+
+void EspXferReceiver::finish(EspXferError error) {
+    _error = error;
+    _state = error == ESPNOW_XFER_OK ? ESPNOW_XFER_DONE : ESPNOW_XFER_FAILED;
+    _link.close(error == ESPNOW_XFER_OK);
+    free(_buffer);
+    _buffer = nullptr;
+}
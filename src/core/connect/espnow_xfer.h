@@ -0,0 +1,228 @@
+/**
+ * @file espnow_xfer.h
+ * @brief Windowed, acknowledged file transfer over ESP-NOW packets
+ *
+ * No Arduino dependencies, the state machines only see packets, the
+ * file and the time they are given, so they run on the host over a
+ * simulated link.
+ */
+
+#ifndef __ESPNOW_XFER_H__
+#define __ESPNOW_XFER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  packet: 0xF7 | type | transfer id (2) | seq (4) | payload, little endian
+
+  'S' start, seq 0: size (4), payload size (2), path\0 name\0    sender -> receiver
+  'R' ready: payload size (2), window (2), both the receiver max  receiver -> sender
+  'D' data, seq is the chunk index                               sender -> receiver
+  'A' ack, seq is the next chunk expected. bitmap (4), bit i set  receiver -> sender
+      when chunk seq + 1 + i already arrived. The holes below the
+      highest bit set are resent right away (selective NACK)
+  'E' end, seq is the chunk count: size (4), crc32 (4)            sender -> receiver
+  'F' finished: status (1), 0 when size and CRC matched           receiver -> sender
+  'X' abort: reason (1)                                           both ways
+
+  The first byte is never a valid first byte of the old EspConnection
+  Message, which starts with the filename or zeros.
+*/
+#define ESPNOW_XFER_MAGIC 0xF7
+#define ESPNOW_XFER_HEADER 8
+
+// Largest packet, ESP-NOW v2. The sender uses what both ends support
+#ifndef ESPNOW_XFER_MAX_PACKET
+#define ESPNOW_XFER_MAX_PACKET 1470
+#endif
+// Chunks in flight, the ack bitmap covers 32
+#ifndef ESPNOW_XFER_MAX_WINDOW
+#define ESPNOW_XFER_MAX_WINDOW 32
+#endif
+// Receiver reorder buffer, bounds the window for large packets
+#ifndef ESPNOW_XFER_WINDOW_BYTES
+#define ESPNOW_XFER_WINDOW_BYTES (16 * 1024)
+#endif
+#ifndef ESPNOW_XFER_RTO_MS
+#define ESPNOW_XFER_RTO_MS 250
+#endif
+// A hole reported by an ack is not resent again before this
+#ifndef ESPNOW_XFER_NACK_MS
+#define ESPNOW_XFER_NACK_MS 30
+#endif
+// The receiver acks every few in order chunks, or after this delay
+#ifndef ESPNOW_XFER_ACK_EVERY
+#define ESPNOW_XFER_ACK_EVERY 4
+#endif
+#ifndef ESPNOW_XFER_ACK_DELAY_MS
+#define ESPNOW_XFER_ACK_DELAY_MS 20
+#endif
+#ifndef ESPNOW_XFER_MAX_RETRIES
+#define ESPNOW_XFER_MAX_RETRIES 12
+#endif
+#ifndef ESPNOW_XFER_IDLE_MS
+#define ESPNOW_XFER_IDLE_MS 5000
+#endif
+#define ESPNOW_XFER_NAME_SIZE 128
+
+enum EspXferType : uint8_t {
+    ESPNOW_XFER_START = 'S',
+    ESPNOW_XFER_READY = 'R',
+    ESPNOW_XFER_DATA = 'D',
+    ESPNOW_XFER_ACK = 'A',
+    ESPNOW_XFER_END = 'E',
+    ESPNOW_XFER_FINISHED = 'F',
+    ESPNOW_XFER_ABORT = 'X',
+};
+
+enum EspXferState : uint8_t {
+    ESPNOW_XFER_IDLE,
+    ESPNOW_XFER_CONNECTING, // start sent, waiting for ready
+    ESPNOW_XFER_SENDING,
+    ESPNOW_XFER_ENDING, // everything acked, end sent
+    ESPNOW_XFER_DONE,
+    ESPNOW_XFER_FAILED,
+};
+
+enum EspXferError : uint8_t {
+    ESPNOW_XFER_OK,
+    ESPNOW_XFER_CORRUPT,   // size or CRC did not match
+    ESPNOW_XFER_IO_ERROR,  // the file could not be read or written
+    ESPNOW_XFER_TIMEOUT,   // the other end stopped answering
+    ESPNOW_XFER_CANCELLED, // aborted by either end
+};
+
+/*********************************************************************
+**  Class: EspXferLink
+**  What the state machines need from the outside: a way to send a
+**  packet and the file. send() returns false when the packet could not
+**  be queued; it is sent again on a later poll.
+**********************************************************************/
+class EspXferLink {
+public:
+    virtual ~EspXferLink() {}
+    virtual bool send(const uint8_t *packet, size_t len) = 0;
+    // Sender: bytes of the file at offset
+    virtual size_t read(uint32_t offset, uint8_t *buffer, size_t len) { return 0; }
+    // Receiver: creates the file, then gets its bytes in order
+    virtual bool open(const char *path, const char *name, uint32_t size) { return false; }
+    virtual bool write(const uint8_t *data, size_t len) { return false; }
+    // Receiver: the transfer ended, ok is false when the file is incomplete or corrupt
+    virtual void close(bool ok) {}
+};
+
+uint32_t espXferCrc32(uint32_t crc, const uint8_t *data, size_t len);
+
+/*********************************************************************
+**  Class: EspXferSender
+**  Sends one file with up to window chunks in flight. A chunk is
+**  resent when an ack shows a hole below a later chunk, or when it is
+**  not acked within ESPNOW_XFER_RTO_MS.
+**********************************************************************/
+class EspXferSender {
+public:
+    explicit EspXferSender(EspXferLink &link) : _link(link) {}
+
+    // maxPacket is the largest packet this side can send
+    bool begin(const char *path, const char *name, uint32_t size, uint16_t maxPacket, uint32_t now);
+    void onPacket(const uint8_t *packet, size_t len, uint32_t now);
+    void poll(uint32_t now);
+    void abort();
+
+    EspXferState state() const { return _state; }
+    EspXferError error() const { return _error; }
+    uint32_t size() const { return _size; }
+    uint32_t bytesAcked() const;
+    uint32_t packetsSent() const { return _packetsSent; }
+    uint32_t retransmits() const { return _retransmits; }
+    uint16_t chunkSize() const { return _chunk; }
+    uint16_t window() const { return _window; }
+
+private:
+    EspXferLink &_link;
+    EspXferState _state = ESPNOW_XFER_IDLE;
+    EspXferError _error = ESPNOW_XFER_OK;
+    uint16_t _id = 0;
+    uint32_t _size = 0;
+    uint16_t _maxPacket = 0;
+    uint16_t _chunk = 0;
+    uint16_t _window = 0;
+    uint32_t _chunks = 0;
+    uint32_t _base = 0; // first chunk not acked
+    uint32_t _next = 0; // first chunk never sent
+    uint32_t _crc = 0;  // of the chunks sent so far, in order
+    uint32_t _sentAt[ESPNOW_XFER_MAX_WINDOW];
+    uint8_t _tries[ESPNOW_XFER_MAX_WINDOW];
+    bool _acked[ESPNOW_XFER_MAX_WINDOW];
+    uint32_t _lastControl = 0; // start or end sent
+    uint8_t _controlTries = 0;
+    uint32_t _packetsSent = 0;
+    uint32_t _retransmits = 0;
+    char _names[ESPNOW_XFER_NAME_SIZE];
+    size_t _namesLen = 0;
+    uint8_t _packet[ESPNOW_XFER_MAX_PACKET];
+
+    bool sendStart(uint32_t now);
+    bool sendEnd(uint32_t now);
+    bool sendChunk(uint32_t seq, uint32_t now);
+    void fail(EspXferError error, bool notify);
+};
+
+/*********************************************************************
+**  Class: EspXferReceiver
+**  Receives one file. Chunks that arrive ahead of a hole wait in a
+**  reorder buffer of window chunks, the file only gets bytes in order.
+**********************************************************************/
+class EspXferReceiver {
+public:
+    explicit EspXferReceiver(EspXferLink &link) : _link(link) {}
+    ~EspXferReceiver();
+
+    // maxPacket is the largest packet this side can receive
+    void begin(uint16_t maxPacket);
+    void onPacket(const uint8_t *packet, size_t len, uint32_t now);
+    void poll(uint32_t now);
+    void abort();
+
+    EspXferState state() const { return _state; }
+    EspXferError error() const { return _error; }
+    uint32_t size() const { return _size; }
+    uint32_t bytesReceived() const { return _bytes; }
+    uint32_t duplicates() const { return _duplicates; }
+    const char *name() const { return _name; }
+
+private:
+    EspXferLink &_link;
+    EspXferState _state = ESPNOW_XFER_IDLE;
+    EspXferError _error = ESPNOW_XFER_OK;
+    uint16_t _id = 0;
+    uint16_t _maxPacket = 0;
+    uint32_t _size = 0;
+    uint16_t _chunk = 0;
+    uint16_t _window = 0;
+    uint32_t _chunks = 0;
+    uint32_t _expected = 0; // next chunk to write
+    uint32_t _bytes = 0;
+    uint32_t _crc = 0;
+    uint8_t *_buffer = nullptr; // window chunks
+    uint16_t _length[ESPNOW_XFER_MAX_WINDOW];
+    bool _have[ESPNOW_XFER_MAX_WINDOW];
+    uint8_t _unacked = 0;
+    uint32_t _firstUnacked = 0;
+    uint32_t _lastPacket = 0;
+    uint32_t _duplicates = 0;
+    char _name[ESPNOW_XFER_NAME_SIZE];
+
+    void onStart(const uint8_t *packet, size_t len, uint32_t now);
+    void onData(uint32_t seq, const uint8_t *data, size_t len, uint32_t now);
+    void onEnd(const uint8_t *packet, size_t len);
+    uint32_t chunkLength(uint32_t seq) const;
+    void sendReady();
+    void sendAck();
+    void sendFinished();
+    void finish(EspXferError error);
+    void cancel(EspXferError error);
+};
+
+#endif
@@ -15,46 +15,57 @@ void FileSharing::sendFile() {
         return;
     }
 
-    Message message = createFileMessage(file);
-
-    esp_err_t response;
-    sendStatus = STARTED;
+    String path = String(file.path());
+    path = path.substring(0, path.lastIndexOf("/"));
+    xferFile = file;
 
     drawMainBorderWithTitle("SEND FILE");
     padprintln("");
-    padprintln("Sending...");
-
-    delay(100);
-
-    while (file.available()) {
-        if (check(EscPress)) sendStatus = ABORTED;
+    padprintln("Connecting...");
+
+    EspXferSender sender(*this);
+    xferActive = true;
+    uint32_t start = millis();
+    if (!sender.begin(path.c_str(), file.name(), file.size(), ESP_XFER_PACKET_SIZE, start)) {
+        xferActive = false;
+        file.close();
+        displayError("File name too long");
+        delay(1000);
+        return;
+    }
 
-        if (sendStatus == ABORTED || sendStatus == FAILED) {
-            message.done = true;
-            message.dataSize = 0;
-            esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-            displayError("Error sending file");
-            break;
+    uint32_t lastDraw = 0;
+    while (sender.state() != ESPNOW_XFER_DONE && sender.state() != ESPNOW_XFER_FAILED) {
+        if (check(EscPress)) sender.abort();
+
+        // Wait for the first packet, then take whatever else is queued
+        XferPacket packet;
+        uint32_t waitMs = 2;
+        while (xferReceive(packet, waitMs)) {
+            sender.onPacket(packet.data, packet.len, millis());
+            free(packet.data);
+            waitMs = 0;
         }
+        sender.poll(millis());
 
-        size_t bytesRead = file.readBytes(message.data, ESP_DATA_SIZE);
-        message.dataSize = bytesRead;
-        message.bytesSent = min(message.bytesSent + bytesRead, message.totalBytes);
-        message.done = message.bytesSent == message.totalBytes;
-
-        response = esp_now_send(dstAddress, (uint8_t *)&message, sizeof(message));
-        if (response != ESP_OK) {
-            Serial.printf("Send file response: %s\n", esp_err_to_name(response));
-            sendStatus = FAILED;
+        if (sender.state() == ESPNOW_XFER_SENDING && millis() - lastDraw > 250) {
+            lastDraw = millis();
+            progressHandler(sender.bytesAcked(), sender.size(), "Sending...");
         }
-
-        progressHandler(file.position(), file.size(), "Sending...");
-        delay(100);
     }
+    uint32_t elapsed = millis() - start;
+    xferActive = false;
+    file.close();
 
-    if (message.bytesSent == message.totalBytes) displaySuccess("File sent");
+    printStats(sender.size(), elapsed, sender.packetsSent(), sender.retransmits());
+    if (sender.state() != ESPNOW_XFER_DONE) {
+        Serial.printf("Send file failed, error %d\n", sender.error());
+        displayError(sender.error() == ESPNOW_XFER_CORRUPT ? "File corrupted" : "Error sending file");
+        delay(1000);
+        return;
+    }
 
-    file.close();
+    displaySuccess("File sent");
     delay(1000);
 }
 
@@ -69,37 +80,54 @@ void FileSharing::receiveFile() {
 
     if (!beginEspnow()) return;
 
-    delay(100);
+    EspXferReceiver receiver(*this);
+    receiver.begin(ESP_XFER_PACKET_SIZE);
+    xferActive = true;
 
+    uint32_t start = 0;
+    uint32_t doneAt = 0;
+    uint32_t lastDraw = 0;
     while (1) {
-        if (check(EscPress)) recvStatus = ABORTED;
-
-        if (recvStatus == ABORTED || recvStatus == FAILED) {
-            displayError("Error receiving file");
-            break;
-        }
-        if (recvStatus == SUCCESS) {
-            displaySuccess("File received");
-            break;
+        if (check(EscPress)) {
+            if (receiver.state() == ESPNOW_XFER_IDLE) break;
+            receiver.abort();
         }
 
-        if (!recvQueue.empty()) {
-            Message recvFileMessage = recvQueue.front();
-            recvQueue.erase(recvQueue.begin());
+        XferPacket packet;
+        uint32_t waitMs = 2;
+        while (xferReceive(packet, waitMs)) {
+            // Answers go to whoever started the transfer
+            if (receiver.state() == ESPNOW_XFER_IDLE && setupPeer(packet.mac)) setDstAddress(packet.mac);
+            receiver.onPacket(packet.data, packet.len, millis());
+            free(packet.data);
+            waitMs = 0;
+        }
+        receiver.poll(millis());
 
-            progressHandler(recvFileMessage.bytesSent, recvFileMessage.totalBytes, "Receiving...");
+        if (receiver.state() == ESPNOW_XFER_IDLE) continue;
+        if (!start) start = millis();
 
-            if (!appendToFile(recvFileMessage)) {
-                recvStatus = FAILED;
-                Serial.println("Failed appending to file");
-            }
-            if (recvFileMessage.done) {
-                Serial.println("Recv done");
-                recvStatus = recvFileMessage.bytesSent == recvFileMessage.totalBytes ? SUCCESS : FAILED;
+        if (receiver.state() == ESPNOW_XFER_SENDING) {
+            if (millis() - lastDraw > 250) {
+                lastDraw = millis();
+                progressHandler(receiver.bytesReceived(), receiver.size(), "Receiving...");
             }
+        } else if (!doneAt) {
+            doneAt = millis();
+        } else if (millis() - doneAt >= 4 * ESPNOW_XFER_RTO_MS) {
+            break; // stayed to answer the end again in case our finish got lost
         }
-
-        delay(100);
+    }
+    xferActive = false;
+
+    if (receiver.state() == ESPNOW_XFER_DONE) {
+        recvStatus = SUCCESS;
+        printStats(receiver.size(), doneAt - start, 0, 0);
+        Serial.printf("Duplicates: %lu\n", (unsigned long)receiver.duplicates());
+        displaySuccess("File received");
+    } else {
+        recvStatus = receiver.state() == ESPNOW_XFER_IDLE ? ABORTED : FAILED;
+        displayError(receiver.error() == ESPNOW_XFER_CORRUPT ? "File corrupted" : "Error receiving file");
     }
 
     delay(1000);
@@ -133,25 +161,74 @@ File FileSharing::selectFile() {
     return file;
 }
 
-bool FileSharing::appendToFile(FileSharing::Message fileMessage) {
-    FS *fs;
-    if (!getFsStorage(fs)) return false;
+size_t FileSharing::read(uint32_t offset, uint8_t *buffer, size_t len) {
+    // Chunks are read in order, a seek is only needed for a resend
+    if (xferFile.position() != offset && !xferFile.seek(offset)) return 0;
+    return xferFile.read(buffer, len);
+}
 
-    if (recvFileName == "") createFilename(fs, fileMessage);
+bool FileSharing::open(const char *path, const char *name, uint32_t size) {
+    if (!getFsStorage(recvFs)) return false;
 
-    File file = (*fs).open(recvFileName, FILE_APPEND);
-    if (!file) return false;
+    createFilename(recvFs, path, name);
+    Serial.printf("Receiving %s, %lu bytes\n", recvFileName.c_str(), (unsigned long)size);
 
-    file.write((const uint8_t *)fileMessage.data, fileMessage.dataSize);
-    file.close();
+    writeLen = 0;
+    writeBuffer = (uint8_t *)malloc(ESP_XFER_WRITE_BUFFER);
+    xferFile = recvFs->open(recvFileName, FILE_WRITE);
+    if (!xferFile || !writeBuffer) {
+        close(false);
+        return false;
+    }
+    return true;
+}
+
+bool FileSharing::flushWrite() {
+    if (!writeLen) return true;
+    bool ok = xferFile.write(writeBuffer, writeLen) == writeLen;
+    writeLen = 0;
+    return ok;
+}
 
+bool FileSharing::write(const uint8_t *data, size_t len) {
+    while (len) {
+        size_t n = min(len, (size_t)ESP_XFER_WRITE_BUFFER - writeLen);
+        memcpy(writeBuffer + writeLen, data, n);
+        writeLen += n;
+        data += n;
+        len -= n;
+        if (writeLen == ESP_XFER_WRITE_BUFFER && !flushWrite()) return false;
+    }
     return true;
 }
 
-void FileSharing::createFilename(FS *fs, FileSharing::Message fileMessage) {
-    String messageFilename = String(fileMessage.filename);
-    String messageFilepath = String(fileMessage.filepath);
+void FileSharing::close(bool ok) {
+    if (xferFile) {
+        if (ok) ok = flushWrite();
+        xferFile.close();
+    }
+    free(writeBuffer);
+    writeBuffer = nullptr;
+    writeLen = 0;
+
+    // An incomplete file is worse than none
+    if (!ok && recvFs && recvFileName != "") recvFs->remove(recvFileName);
+}
+
+void FileSharing::printStats(uint32_t bytes, uint32_t elapsed, uint32_t packets, uint32_t retransmits) {
+    float kbps = elapsed ? bytes / 1.024f / elapsed : 0;
+    Serial.printf("%lu bytes in %lu ms, %.1f KB/s\n", (unsigned long)bytes, (unsigned long)elapsed, kbps);
+    if (packets) {
+        Serial.printf("Packets: %lu, retransmits: %lu\n", (unsigned long)packets, (unsigned long)retransmits);
+    }
+
+    padprintln("");
+    padprintln(String(kbps, 1) + " KB/s");
+    if (packets) padprintln("Retransmits: " + String(retransmits) + "/" + String(packets));
+    delay(1000);
+}
 
+void FileSharing::createFilename(FS *fs, String messageFilepath, String messageFilename) {
     String filename = messageFilename.substring(0, messageFilename.lastIndexOf("."));
     String ext = messageFilename.substring(messageFilename.lastIndexOf("."));
 
@@ -2,8 +2,14 @@
 #define __ESP_FILE_SHARING_H__
 
 #include "esp_connection.h"
+#include "espnow_xfer.h"
 
-class FileSharing : public EspConnection {
+// Received bytes are written to the file in blocks this size
+#ifndef ESP_XFER_WRITE_BUFFER
+#define ESP_XFER_WRITE_BUFFER 4096
+#endif
+
+class FileSharing : public EspConnection, public EspXferLink {
 public:
     /////////////////////////////////////////////////////////////////////////////////////
     // Constructor
@@ -16,15 +22,29 @@ public:
     void sendFile();
     void receiveFile();
 
+    /////////////////////////////////////////////////////////////////////////////////////
+    // EspXferLink
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool send(const uint8_t *packet, size_t len) override { return xferSend(packet, len); }
+    size_t read(uint32_t offset, uint8_t *buffer, size_t len) override;
+    bool open(const char *path, const char *name, uint32_t size) override;
+    bool write(const uint8_t *data, size_t len) override;
+    void close(bool ok) override;
+
 private:
     String recvFileName;
+    FS *recvFs = nullptr;
+    File xferFile; // the file sent, or the one written while receiving
+    uint8_t *writeBuffer = nullptr;
+    size_t writeLen = 0;
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Helpers
     /////////////////////////////////////////////////////////////////////////////////////
     File selectFile();
-    bool appendToFile(Message fileMessage);
-    void createFilename(FS *fs, Message fileMessage);
+    bool flushWrite();
+    void createFilename(FS *fs, String messageFilepath, String messageFilename);
+    void printStats(uint32_t bytes, uint32_t elapsed, uint32_t packets, uint32_t retransmits);
 };
 
 #endif
@@ -0,0 +1,129 @@
+#include "digest.h"
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+static String toHex(const uint8_t *data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    String out;
+    out.reserve(len * 2);
+    for (size_t i = 0; i < len; i++) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+    return out;
+}
+
+FileDigest::FileDigest(uint8_t algos) : _algos(algos) {
+    mbedtls_md5_init(&_md5);
+    mbedtls_sha1_init(&_sha1);
+    mbedtls_sha256_init(&_sha256);
+    if (_algos & DIGEST_MD5) mbedtls_md5_starts(&_md5);
+    if (_algos & DIGEST_SHA1) mbedtls_sha1_starts(&_sha1);
+    if (_algos & DIGEST_SHA256) mbedtls_sha256_starts(&_sha256, 0);
+    memset(_md5Out, 0, sizeof(_md5Out));
+    memset(_sha1Out, 0, sizeof(_sha1Out));
+    memset(_sha256Out, 0, sizeof(_sha256Out));
+}
+
+FileDigest::~FileDigest() {
+    mbedtls_md5_free(&_md5);
+    mbedtls_sha1_free(&_sha1);
+    mbedtls_sha256_free(&_sha256);
+}
+
+void FileDigest::update(const uint8_t *data, size_t len) {
+    if (_algos & DIGEST_MD5) mbedtls_md5_update(&_md5, data, len);
+    if (_algos & DIGEST_SHA1) mbedtls_sha1_update(&_sha1, data, len);
+    if (_algos & DIGEST_SHA256) mbedtls_sha256_update(&_sha256, data, len);
+    if (_algos & DIGEST_CRC32) _crc = esp_rom_crc32_le(_crc, data, len);
+    _bytes += len;
+}
+
+void FileDigest::finish() {
+    if (_algos & DIGEST_MD5) mbedtls_md5_finish(&_md5, _md5Out);
+    if (_algos & DIGEST_SHA1) mbedtls_sha1_finish(&_sha1, _sha1Out);
+    if (_algos & DIGEST_SHA256) mbedtls_sha256_finish(&_sha256, _sha256Out);
+}
+
+bool FileDigest::digestFile(FS &fs, const String &path) {
+    File file = fs.open(path, FILE_READ);
+    if (!file || file.isDirectory()) return false;
+
+    // SD reads skip the driver bounce buffer when the block is in internal RAM
+    size_t blockSize = DIGEST_BLOCK_SIZE;
+    uint8_t *buf = nullptr;
+    while (!buf && blockSize >= 1024) {
+        buf = (uint8_t *)heap_caps_malloc(blockSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!buf) blockSize /= 2;
+    }
+    if (!buf) {
+        file.close();
+        return false;
+    }
+
+    uint32_t start = millis();
+    size_t left = file.size();
+    bool ok = true;
+    while (left > 0) {
+        size_t n = file.read(buf, min(left, blockSize));
+        if (n == 0) {
+            ok = false;
+            break;
+        }
+        update(buf, n);
+        left -= n;
+    }
+    finish();
+    _ms = millis() - start;
+    free(buf);
+    file.close();
+    return ok;
+}
+
+String FileDigest::hex(uint8_t algo) const {
+    switch (algo) {
+        case DIGEST_MD5: return toHex(_md5Out, sizeof(_md5Out));
+        case DIGEST_SHA1: return toHex(_sha1Out, sizeof(_sha1Out));
+        case DIGEST_SHA256: return toHex(_sha256Out, sizeof(_sha256Out));
+        case DIGEST_CRC32: {
+            char s[9];
+            snprintf(s, sizeof(s), "%08lX", (unsigned long)_crc);
+            return String(s);
+        }
+        default: return "";
+    }
+}
+
+float FileDigest::mbPerSec() const {
+    if (_ms == 0) return 0;
+    return (float)_bytes / _ms / 1000.0f;
+}
+
+uint8_t FileDigest::parseAlgos(const String &list) {
+    uint8_t algos = 0;
+    int start = 0;
+    while (start <= (int)list.length()) {
+        int end = list.indexOf(',', start);
+        if (end < 0) end = list.length();
+        String item = list.substring(start, end);
+        item.trim();
+        item.toLowerCase();
+        if (item == "md5") algos |= DIGEST_MD5;
+        else if (item == "crc32") algos |= DIGEST_CRC32;
+        else if (item == "sha1") algos |= DIGEST_SHA1;
+        else if (item == "sha256") algos |= DIGEST_SHA256;
+        else return 0;
+        start = end + 1;
+    }
+    return algos;
+}
+
+const char *FileDigest::name(uint8_t algo) {
+    switch (algo) {
+        case DIGEST_MD5: return "md5";
+        case DIGEST_CRC32: return "crc32";
+        case DIGEST_SHA1: return "sha1";
+        case DIGEST_SHA256: return "sha256";
+        default: return "";
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef __DIGEST_H__
+#define __DIGEST_H__
+
+#include <Arduino.h>
+#include <FS.h>
+#include <mbedtls/md5.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/sha256.h>
+
+#define DIGEST_MD5 (1 << 0)
+#define DIGEST_CRC32 (1 << 1)
+#define DIGEST_SHA1 (1 << 2)
+#define DIGEST_SHA256 (1 << 3)
+
+// Files are read in blocks of this size, a smaller block is used when it can't be allocated
+#ifndef DIGEST_BLOCK_SIZE
+#define DIGEST_BLOCK_SIZE (16 * 1024)
+#endif
+
+/*********************************************************************
+**  Class: FileDigest
+**  Computes any of MD5, CRC32, SHA-1 and SHA-256 in one pass over the
+**  data. CRC32 uses the ROM routine, SHA goes through mbedTLS which
+**  uses the SHA peripheral when the chip has one.
+**********************************************************************/
+class FileDigest {
+public:
+    explicit FileDigest(uint8_t algos);
+    ~FileDigest();
+
+    void update(const uint8_t *data, size_t len);
+    void finish();
+    // Streams a whole file, false when it can't be opened or read
+    bool digestFile(FS &fs, const String &path);
+
+    // Lowercase hex, CRC32 in uppercase like the previous md5/crc32 commands
+    String hex(uint8_t algo) const;
+    uint64_t bytes() const { return _bytes; }
+    uint32_t ms() const { return _ms; }
+    float mbPerSec() const;
+
+    // "md5,sha256" -> DIGEST_MD5 | DIGEST_SHA256, 0 when a name is unknown
+    static uint8_t parseAlgos(const String &list);
+    static const char *name(uint8_t algo);
+
+private:
+    uint8_t _algos;
+    mbedtls_md5_context _md5;
+    mbedtls_sha1_context _sha1;
+    mbedtls_sha256_context _sha256;
+    uint32_t _crc = 0;
+    uint8_t _md5Out[16];
+    uint8_t _sha1Out[20];
+    uint8_t _sha256Out[32];
+    uint64_t _bytes = 0;
+    uint32_t _ms = 0;
+};
+
+#endif
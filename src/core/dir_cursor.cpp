@@ -0,0 +1,188 @@
+#include "dir_cursor.h"
+#include "dir_reader.h"
+#include <algorithm>
+
+#define DIR_CURSOR_FOLDER 0x80000000u
+#define DIR_CURSOR_NAMES_BLOCK 1024
+
+// Same order as comparing upper-cased copies, without making them
+static int compareNoCase(const char *a, const char *b) {
+    while (*a && toupper((uint8_t)*a) == toupper((uint8_t)*b)) {
+        a++;
+        b++;
+    }
+    return toupper((uint8_t)*a) - toupper((uint8_t)*b);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ExtFilter
+/////////////////////////////////////////////////////////////////////////////////////
+
+ExtFilter::ExtFilter(const String &pattern) {
+    if (pattern == "*") {
+        _all = true;
+        return;
+    }
+    int start = 0;
+    int end;
+    while ((end = pattern.indexOf('|', start)) != -1) {
+        _exts.push_back(pattern.substring(start, end));
+        start = end + 1;
+    }
+    _exts.push_back(pattern.substring(start));
+}
+
+bool ExtFilter::match(const char *filename) const {
+    if (_all) return true;
+    const char *dot = strrchr(filename, '.');
+    const char *ext = dot ? dot + 1 : "";
+    for (const String &e : _exts) {
+        if (strcasecmp(ext, e.c_str()) == 0) return true;
+    }
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// DirCursor
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool DirCursor::open(FS &fs, const String &folder, const String &allowedExt) {
+    _windowFirst = -1;
+    _current = nullptr;
+
+    File dir = fs.open(folder);
+    if (!dir || !dir.isDirectory()) return false;
+    time_t mtime = dir.getLastWrite();
+    dir.close();
+
+    for (Listing *l : _cache) {
+        if (l->fs == &fs && l->folder == folder && l->ext == allowedExt) {
+            _current = l;
+            break;
+        }
+    }
+    if (_current && _current->mtime == mtime) {
+        _current->lastUse = ++_useCount;
+        return true;
+    }
+
+    if (!_current) _current = reuseSlot();
+    _current->fs = &fs;
+    _current->folder = folder;
+    _current->ext = allowedExt;
+    _current->mtime = mtime;
+    _current->lastUse = ++_useCount;
+    if (read(*_current)) return true;
+
+    invalidate();
+    return false;
+}
+
+DirCursor::Listing *DirCursor::reuseSlot() {
+    if (_cache.size() < DIR_CURSOR_CACHE_FOLDERS) {
+        _cache.push_back(new Listing());
+        return _cache.back();
+    }
+    Listing *oldest = _cache[0];
+    for (Listing *l : _cache) {
+        if (l->lastUse < oldest->lastUse) oldest = l;
+    }
+    return oldest;
+}
+
+bool DirCursor::addName(Listing &listing, const char *name, bool isDir) {
+    size_t len = strlen(name) + 1;
+    if (listing.used + len > listing.capacity) {
+        size_t size = listing.capacity ? listing.capacity * 2 : DIR_CURSOR_NAMES_BLOCK;
+        while (size < listing.used + len) size *= 2;
+        char *names =
+            (char *)(psramFound() ? ps_realloc(listing.names, size) : realloc(listing.names, size));
+        if (!names) return false;
+        listing.names = names;
+        listing.capacity = size;
+    }
+    memcpy(listing.names + listing.used, name, len);
+    listing.order.push_back(listing.used | (isDir ? DIR_CURSOR_FOLDER : 0));
+    listing.used += len;
+    return true;
+}
+
+bool DirCursor::read(Listing &listing) {
+    listing.used = 0;
+    listing.order.clear();
+
+    DirReader reader;
+    if (!reader.open(*listing.fs, listing.folder)) return false;
+
+    ExtFilter filter(listing.ext);
+    DirEntry entry;
+    while (reader.next(entry)) {
+        if (!entry.isDir && !filter.match(entry.name)) continue;
+        if (!addName(listing, entry.name, entry.isDir)) {
+            log_w("DirCursor: out of memory, listing truncated");
+            break;
+        }
+    }
+    reader.close();
+
+    // Folders first, then alphabetically
+    const char *names = listing.names;
+    std::sort(listing.order.begin(), listing.order.end(), [names](uint32_t a, uint32_t b) {
+        if ((a ^ b) & DIR_CURSOR_FOLDER) return (a & DIR_CURSOR_FOLDER) != 0;
+        return compareNoCase(names + (a & ~DIR_CURSOR_FOLDER), names + (b & ~DIR_CURSOR_FOLDER)) < 0;
+    });
+
+    Serial.println("Files listed with: " + String(listing.order.size()) + " files/folders found");
+    return true;
+}
+
+void DirCursor::freeListing(Listing *listing) {
+    free(listing->names);
+    delete listing;
+}
+
+void DirCursor::invalidate() {
+    if (!_current) return;
+    _cache.erase(std::find(_cache.begin(), _cache.end(), _current));
+    freeListing(_current);
+    _current = nullptr;
+    _windowFirst = -1;
+}
+
+void DirCursor::clear() {
+    for (Listing *l : _cache) freeListing(l);
+    _cache.clear();
+    _current = nullptr;
+    _window.clear();
+    _window.shrink_to_fit();
+    _windowFirst = -1;
+}
+
+const char *DirCursor::name(int i) const {
+    if (i < 0 || i >= count()) return "";
+    if (isOperation(i)) return "> Back";
+    return _current->names + (_current->order[i] & ~DIR_CURSOR_FOLDER);
+}
+
+bool DirCursor::isFolder(int i) const {
+    if (i < 0 || i >= count() - 1) return false;
+    return _current->order[i] & DIR_CURSOR_FOLDER;
+}
+
+const std::vector<FileList> &DirCursor::window(int first, int size) {
+    if (first < 0) first = 0;
+    if (first + size > count()) size = count() - first;
+    if (size < 0) size = 0;
+    if (first == _windowFirst && size == (int)_window.size()) return _window;
+
+    _window.clear();
+    for (int i = first; i < first + size; i++) {
+        FileList item;
+        item.filename = name(i);
+        item.folder = isFolder(i);
+        item.operation = isOperation(i);
+        _window.push_back(item);
+    }
+    _windowFirst = first;
+    return _window;
+}
@@ -0,0 +1,79 @@
+#ifndef __DIR_CURSOR_H__
+#define __DIR_CURSOR_H__
+
+#include "sd_functions.h"
+#include <vector>
+
+// Folder listings kept while browsing, so going back up does not read the folder again
+#ifndef DIR_CURSOR_CACHE_FOLDERS
+#define DIR_CURSOR_CACHE_FOLDERS 3
+#endif
+
+/*********************************************************************
+**  Class: ExtFilter
+**  Extension filter like "*" or "sub|ir|txt". The pattern is split
+**  once, file names are then matched case-insensitively in place.
+**********************************************************************/
+class ExtFilter {
+public:
+    explicit ExtFilter(const String &pattern = "*");
+
+    bool match(const char *filename) const;
+
+private:
+    bool _all = false;
+    std::vector<String> _exts;
+};
+
+/*********************************************************************
+**  Class: DirCursor
+**  Sorted listing of a folder for the file browser. Names are packed
+**  in a single buffer and sorted through an index of offsets, only the
+**  entries on screen are turned into FileList items. The last listings
+**  are cached, keyed by folder, filter and folder mtime.
+**********************************************************************/
+class DirCursor {
+public:
+    ~DirCursor() { clear(); }
+
+    bool open(FS &fs, const String &folder, const String &allowedExt = "*");
+    // Forgets the listing of the open folder, the next open() reads it again.
+    // FAT does not update folder mtimes, so call it after changing the folder.
+    void invalidate();
+    // Frees all listings
+    void clear();
+
+    // Entries plus the "> Back" item at the end
+    int count() const { return (_current ? _current->order.size() : 0) + 1; }
+    const char *name(int i) const;
+    bool isFolder(int i) const;
+    bool isOperation(int i) const { return i == count() - 1; }
+    // FileList items from first to first + size, or less at the end of the folder
+    const std::vector<FileList> &window(int first, int size);
+
+private:
+    struct Listing {
+        FS *fs = nullptr;
+        String folder;
+        String ext;
+        time_t mtime = 0;
+        char *names = nullptr;
+        size_t used = 0;
+        size_t capacity = 0;
+        std::vector<uint32_t> order; // offsets in names, DIR_CURSOR_FOLDER set for folders
+        uint32_t lastUse = 0;
+    };
+
+    std::vector<Listing *> _cache;
+    Listing *_current = nullptr;
+    uint32_t _useCount = 0;
+    std::vector<FileList> _window;
+    int _windowFirst = -1;
+
+    bool read(Listing &listing);
+    bool addName(Listing &listing, const char *name, bool isDir);
+    Listing *reuseSlot();
+    static void freeListing(Listing *listing);
+};
+
+#endif
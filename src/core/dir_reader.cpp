@@ -0,0 +1,109 @@
+#include "dir_reader.h"
+#include <LittleFS.h>
+#include <SD.h>
+#include <sys/stat.h>
+
+static void copyName(DirEntry &entry, const char *name) {
+    strncpy(entry.name, name, sizeof(entry.name) - 1);
+    entry.name[sizeof(entry.name) - 1] = '\0';
+}
+
+static bool isDotEntry(const char *name) {
+    return name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+bool DirReader::open(FS &fs, const String &folder) {
+    close();
+    _fs = &fs;
+    _folder = folder;
+    if (!_folder.startsWith("/")) _folder = "/" + _folder;
+
+    if (&fs == &SD && SD.pdrv() != 0xFF) {
+        String path = String((char)('0' + SD.pdrv())) + ":" + _folder;
+        _fatDir = (FF_DIR *)malloc(sizeof(FF_DIR));
+        if (_fatDir && f_opendir(_fatDir, path.c_str()) == FR_OK) return true;
+        free(_fatDir);
+        _fatDir = nullptr;
+        return false;
+    }
+    if (&fs == &LittleFS) {
+        _vfsPath = String(LITTLEFS_MOUNTPOINT) + _folder;
+        if (!_vfsPath.endsWith("/")) _vfsPath += "/";
+        _vfsDir = opendir(_vfsPath.c_str());
+        return _vfsDir != nullptr;
+    }
+    _root = fs.open(_folder);
+    if (_root && _root.isDirectory()) return true;
+    _root.close();
+    return false;
+}
+
+bool DirReader::next(DirEntry &entry) {
+    if (_fatDir) {
+        FILINFO info;
+        while (f_readdir(_fatDir, &info) == FR_OK && info.fname[0] != '\0') {
+            if (isDotEntry(info.fname)) continue;
+            copyName(entry, info.fname);
+            entry.isDir = info.fattrib & AM_DIR;
+            entry.size = entry.isDir ? 0 : info.fsize;
+            return true;
+        }
+        return false;
+    }
+    if (_vfsDir) {
+        struct dirent *de;
+        while ((de = readdir(_vfsDir)) != nullptr) {
+            if (isDotEntry(de->d_name)) continue;
+            copyName(entry, de->d_name);
+            entry.isDir = de->d_type == DT_DIR;
+            entry.size = 0;
+            if (!entry.isDir) {
+                // metadata lookup only, no file handle or cache is allocated
+                struct stat st;
+                String path = _vfsPath + de->d_name;
+                if (stat(path.c_str(), &st) == 0) entry.size = st.st_size;
+            }
+            return true;
+        }
+        return false;
+    }
+    if (_root) {
+        File file = _root.openNextFile();
+        if (!file) return false;
+        const char *name = file.name();
+        const char *slash = strrchr(name, '/');
+        copyName(entry, slash ? slash + 1 : name);
+        entry.isDir = file.isDirectory();
+        entry.size = entry.isDir ? 0 : file.size();
+        file.close();
+        return true;
+    }
+    return false;
+}
+
+bool DirReader::rewind() {
+    if (_fatDir) return f_readdir(_fatDir, nullptr) == FR_OK;
+    if (_vfsDir) {
+        rewinddir(_vfsDir);
+        return true;
+    }
+    if (_root) {
+        _root.rewindDirectory();
+        return true;
+    }
+    return false;
+}
+
+void DirReader::close() {
+    if (_fatDir) {
+        f_closedir(_fatDir);
+        free(_fatDir);
+        _fatDir = nullptr;
+    }
+    if (_vfsDir) {
+        closedir(_vfsDir);
+        _vfsDir = nullptr;
+    }
+    if (_root) _root.close();
+    _fs = nullptr;
+}
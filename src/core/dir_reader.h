@@ -0,0 +1,45 @@
+#ifndef __DIR_READER_H__
+#define __DIR_READER_H__
+
+#include <FS.h>
+#include <dirent.h>
+#include <ff.h>
+
+#define DIR_NAME_MAX 256
+
+#ifndef LITTLEFS_MOUNTPOINT
+#define LITTLEFS_MOUNTPOINT "/littlefs"
+#endif
+
+struct DirEntry {
+    char name[DIR_NAME_MAX];
+    uint64_t size;
+    bool isDir;
+};
+
+/*********************************************************************
+**  Class: DirReader
+**  Reads a directory one entry at a time. The size comes from the
+**  directory entry itself, files are never opened: SD cards are read
+**  with FatFs f_readdir, LittleFS through the VFS. Other filesystems
+**  fall back to File::openNextFile().
+**********************************************************************/
+class DirReader {
+public:
+    ~DirReader() { close(); }
+
+    bool open(FS &fs, const String &folder);
+    bool next(DirEntry &entry);
+    bool rewind();
+    void close();
+
+private:
+    FS *_fs = nullptr;
+    String _folder;
+    FF_DIR *_fatDir = nullptr;
+    DIR *_vfsDir = nullptr;
+    String _vfsPath;
+    File _root;
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "display.h"
+#include "core/input_events.h"
 #include "core/wifi/webInterface.h" // for server
 #include "core/wifi/wg.h"           //for isConnectedWireguard to print wireguard lock
 #include "mykeyboard.h"
@@ -133,6 +134,7 @@ void displayRedStripe(String text, uint16_t fgcolor, uint16_t bgcolor) {
 
     int size;
     if (fgcolor == bgcolor && fgcolor == TFT_WHITE) fgcolor = TFT_BLACK;
+    tft.beginFrame();
     if (text.length() * LW * FM < (tftWidth - 2 * FM * LW)) size = FM;
     else size = FP;
     tft.drawPixel(0, 0, 0);
@@ -151,6 +153,7 @@ void displayRedStripe(String text, uint16_t fgcolor, uint16_t bgcolor) {
             tft.drawCentreString(text.substring(text_size / 2), tftWidth / 2, tftHeight / 2 + 1);
         }
     }
+    tft.endFrame();
 }
 
 void drawButton(
@@ -485,6 +488,7 @@ int loopOptions(
         }
 
         if (redraw) {
+            tft.beginFrame(); // the whole menu reaches the screen at once
             menuOptionType = menuType; // updates menutype to the remote controller
             menuOptionLabel = subText;
             // update the hovered
@@ -509,6 +513,7 @@ int loopOptions(
             }
             firstRender = false;
             redraw = false;
+            tft.endFrame();
         }
 
         // handleSerialCommands(); // always use serial task for it
@@ -571,7 +576,8 @@ int loopOptions(
             }
             redraw = true;
         }
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        // returns as soon as a key is pressed, the scrolling label still gets its turn
+        if (!redraw) inputWait(pdMS_TO_TICKS(menuType == MENU_TYPE_REGULAR ? 20 : 50));
 
         /* Select and run function
         forceMenuOption is set by a SerialCommand to force a selection within the menu
@@ -624,12 +630,14 @@ int loopOptions(
 ***************************************************************************************/
 void progressHandler(int progress, size_t total, String message) {
     int barWidth = map(progress, 0, total, 0, tftWidth - 40);
+    tft.beginFrame();
     if (barWidth < 3) {
         tft.fillRect(6, 27, tftWidth - 12, tftHeight - 33, bruceConfig.bgColor);
         tft.drawRect(18, tftHeight - 47, tftWidth - 36, 17, bruceConfig.priColor);
         displayRedStripe(message, TFT_WHITE, bruceConfig.priColor);
     }
     tft.fillRect(20, tftHeight - 45, barWidth, 13, bruceConfig.priColor);
+    tft.endFrame();
 }
 
 /***************************************************************************************
@@ -648,6 +656,7 @@ Opt_Coord drawOptions(
     // drawStatusBar();
 
     int32_t optionsTopY = tftHeight / 2 - menuSize * (FM * 8 + 4) / 2 - 5;
+    tft.beginFrame();
     tft.drawPixel(0, 0, bruceConfig.bgColor);
     if (firstRender) {
         tft.fillRoundRect(
@@ -698,6 +707,7 @@ Exit:
 #if defined(HAS_TOUCH)
     TouchFooter();
 #endif
+    tft.endFrame();
     return coord;
 }
 
@@ -706,6 +716,7 @@ Exit:
 ** Description:   Função para desenhar e mostrar as opçoes de contexto
 ***************************************************************************************/
 void drawSubmenu(int index, std::vector<Option> &options, const char *title) {
+    tft.beginFrame();
     drawStatusBar();
     int menuSize = options.size();
     tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
@@ -761,6 +772,7 @@ void drawSubmenu(int index, std::vector<Option> &options, const char *title) {
     tft.drawString("[ x ]", 7, 7, 1);
     TouchFooter();
 #endif
+    tft.endFrame();
 }
 
 void drawStatusBar() {
@@ -821,6 +833,7 @@ void drawStatusBar() {
 }
 
 void drawMainBorder(bool clear) {
+    tft.beginFrame();
     if (clear) {
         tft.drawPixel(0, 0, 0);
         tft.fillScreen(bruceConfig.bgColor);
@@ -835,6 +848,7 @@ void drawMainBorder(bool clear) {
 #if defined(HAS_TOUCH)
     TouchFooter();
 #endif
+    tft.endFrame();
 }
 
 void drawMainBorderWithTitle(String title, bool clear) {
@@ -926,7 +940,7 @@ void drawWireguardStatus(int x, int y) {
 ** Description:   Função para desenhar e mostrar o menu principal
 ***************************************************************************************/
 #define MAX_ITEMS (int)(tftHeight - 20) / (LH * FM)
-Opt_Coord listFiles(int index, std::vector<FileList> fileList) {
+Opt_Coord listFiles(int index, DirCursor &files) {
     Opt_Coord coord;
     tft.drawPixel(0, 0, bruceConfig.bgColor);
     if (index == 0) {
@@ -935,37 +949,34 @@ Opt_Coord listFiles(int index, std::vector<FileList> fileList) {
     }
     tft.setCursor(10, 10);
     tft.setTextSize(FM);
-    int i = 0;
-    int arraySize = fileList.size();
     int start = 0;
     if (index >= MAX_ITEMS) {
         start = index - MAX_ITEMS + 1;
         if (start < 0) start = 0;
     }
+    // only the visible entries are loaded
+    const std::vector<FileList> &fileList = files.window(start, MAX_ITEMS);
     int nchars = (tftWidth - 20) / (6 * tft.textsize);
     String txt = ">";
-    while (i < arraySize) {
-        if (i >= start) {
-            tft.setCursor(10, tft.getCursorY());
-            if (fileList[i].folder == true)
-                tft.setTextColor(getColorVariation(bruceConfig.priColor), bruceConfig.bgColor);
-            else if (fileList[i].operation == true) tft.setTextColor(ALCOLOR, bruceConfig.bgColor);
-            else { tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor); }
-
-            if (index == i) {
-                txt = ">";
-                coord.x = 10 + FM * LW;
-                coord.y = tft.getCursorY();
-                coord.size = nchars;
-                coord.fgcolor =
-                    fileList[i].folder ? getColorVariation(bruceConfig.priColor) : bruceConfig.priColor;
-                coord.bgcolor = bruceConfig.bgColor;
-            } else txt = " ";
-            txt += fileList[i].filename + "                 ";
-            tft.println(txt.substring(0, nchars));
-        }
-        i++;
-        if (i == (start + MAX_ITEMS) || i == arraySize) break;
+    for (int n = 0; n < (int)fileList.size(); n++) {
+        int i = start + n;
+        tft.setCursor(10, tft.getCursorY());
+        if (fileList[n].folder == true)
+            tft.setTextColor(getColorVariation(bruceConfig.priColor), bruceConfig.bgColor);
+        else if (fileList[n].operation == true) tft.setTextColor(ALCOLOR, bruceConfig.bgColor);
+        else { tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor); }
+
+        if (index == i) {
+            txt = ">";
+            coord.x = 10 + FM * LW;
+            coord.y = tft.getCursorY();
+            coord.size = nchars;
+            coord.fgcolor =
+                fileList[n].folder ? getColorVariation(bruceConfig.priColor) : bruceConfig.priColor;
+            coord.bgcolor = bruceConfig.bgColor;
+        } else txt = " ";
+        txt += fileList[n].filename + "                 ";
+        tft.println(txt.substring(0, nchars));
     }
     return coord;
 }
@@ -2,7 +2,7 @@
 #define __DISPLAY_H__
 
 #include "core/serialcmds.h"
-#include "sd_functions.h" // to catch FileList Struct
+#include "dir_cursor.h" // to catch FileList Struct and DirCursor
 #include <FS.h>
 #include <LittleFS.h>
 #include <SD.h>
@@ -182,7 +182,7 @@ void printSubtitle(String subtitle, bool withLine = true);
 void printFootnote(String text);
 void printCenterFootnote(String text);
 
-Opt_Coord listFiles(int index, std::vector<FileList> fileList);
+Opt_Coord listFiles(int index, DirCursor &files);
 
 void drawWireguardStatus(int x, int y);
 
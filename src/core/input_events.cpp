@@ -0,0 +1,297 @@
+#include "input_events.h"
+#include "display.h"
+#include <atomic>
+#include <globals.h>
+
+static_assert((INPUT_QUEUE_SIZE & (INPUT_QUEUE_SIZE - 1)) == 0, "INPUT_QUEUE_SIZE must be a power of two");
+static_assert(
+    (INPUT_ISR_QUEUE_SIZE & (INPUT_ISR_QUEUE_SIZE - 1)) == 0, "INPUT_ISR_QUEUE_SIZE must be a power of two"
+);
+
+// Input task -> UI
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static std::atomic<uint16_t> head{0}; // written by the input task
+static std::atomic<uint16_t> tail{0}; // written by the UI
+static std::atomic<TaskHandle_t> waiting{nullptr};
+static uint32_t dropped = 0;
+
+// Interrupts -> input task
+static InputEvent isrQueue[INPUT_ISR_QUEUE_SIZE];
+static std::atomic<uint16_t> isrHead{0};
+static std::atomic<uint16_t> isrTail{0};
+static volatile uint32_t isrDropped = 0;
+
+// The flags and the events are changed together, a press is never counted from both
+static portMUX_TYPE inputMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Input task side
+struct KeyRun {
+    bool active;
+    bool longSent;
+    uint32_t down; // first press of the hold
+    uint32_t last; // last press, or last poll that saw the flag still set
+};
+static KeyRun runs[INPUT_KEY_COUNT];
+static uint16_t held = 0; // flags published and not cleared since, one bit per key
+static bool interruptDriven = false;
+
+// UI side, presses taken from the queue and not checked yet
+struct Pending {
+    uint8_t presses;
+    uint8_t longs;
+    uint32_t time; // newest press
+    uint32_t longTime;
+};
+static Pending pending[INPUT_KEY_COUNT];
+static InputEvent newest;
+static uint32_t received = 0; // events taken from the queue
+static uint32_t seen = 0;     // received at the last inputWait()
+
+static volatile bool *const keyFlags[INPUT_KEY_TOUCH] = {
+    &NextPress, &PrevPress, &UpPress, &DownPress, &SelPress, &EscPress, &NextPagePress, &PrevPagePress
+};
+
+static int keyOf(volatile bool *flag) {
+    for (int k = 0; k < INPUT_KEY_TOUCH; k++) {
+        if (keyFlags[k] == flag) return k;
+    }
+    return -1;
+}
+
+// inputMux held from here on
+
+static bool push(const InputEvent &event) {
+    uint16_t h = head.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - tail.load(std::memory_order_acquire)) >= INPUT_QUEUE_SIZE) {
+        dropped++;
+        return false;
+    }
+    queue[h & (INPUT_QUEUE_SIZE - 1)] = event;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+static bool pressed(uint8_t key, uint32_t time, int16_t x, int16_t y) {
+    KeyRun &run = runs[key];
+    const bool again = run.active && time - run.last <= INPUT_REPEAT_GAP_MS;
+    if (!again) {
+        run.down = time;
+        run.longSent = false;
+    }
+    run.active = true;
+    run.last = time;
+    return push({time, key, (uint8_t)(again ? INPUT_EVENT_REPEAT : 0), x, y});
+}
+
+static bool publishFlags(uint32_t now) {
+    bool pushed = false;
+    for (uint8_t k = 0; k < INPUT_KEY_COUNT; k++) {
+        const bool on = k == INPUT_KEY_TOUCH ? touchPoint.pressed : *keyFlags[k];
+        const uint16_t bit = 1 << k;
+        if (!on) {
+            held &= ~bit;
+            continue;
+        }
+        if (held & bit) runs[k].last = now; // still set, the hold goes on
+        else if (k == INPUT_KEY_TOUCH) pushed |= pressed(k, now, touchPoint.x, touchPoint.y);
+        else pushed |= pressed(k, now, 0, 0);
+        held |= bit;
+    }
+    return pushed;
+}
+
+static void drain() {
+    uint16_t t = tail.load(std::memory_order_relaxed);
+    const uint16_t h = head.load(std::memory_order_acquire);
+    for (; t != h; t++) {
+        const InputEvent &e = queue[t & (INPUT_QUEUE_SIZE - 1)];
+        Pending &p = pending[e.key];
+        if (e.flags & INPUT_EVENT_LONG) {
+            if (p.longs < UINT8_MAX) p.longs++;
+            p.longTime = e.time;
+        } else {
+            if (p.presses < UINT8_MAX) p.presses++;
+            p.time = e.time;
+        }
+        newest = e;
+        received++;
+    }
+    tail.store(t, std::memory_order_release);
+}
+
+static void forget(Pending &p, uint32_t now) {
+    if (p.presses && now - p.time > INPUT_EVENT_MAX_AGE_MS) p.presses = 0;
+    if (p.longs && now - p.longTime > INPUT_EVENT_MAX_AGE_MS) p.longs = 0;
+}
+
+// inputMux not held from here on
+
+static void notifyWaiting() {
+    TaskHandle_t task = waiting.load(std::memory_order_acquire);
+    if (task) xTaskNotifyGive(task);
+}
+
+bool inputCheck(volatile bool &btn) {
+    const int key = keyOf(&btn);
+    const uint32_t now = millis();
+    bool found;
+    portENTER_CRITICAL(&inputMux);
+    drain();
+    if (key >= 0) {
+        Pending &p = pending[key];
+        const uint16_t bit = 1 << key;
+        forget(p, now);
+        // a flag set after the last publish is a press of its own, the next publish queues it
+        const bool unpublished = btn && !(held & bit);
+        found = p.presses > 0 || btn;
+        if (p.presses) {
+            p.presses--;
+            if (!unpublished) btn = false;
+        } else {
+            btn = false;
+        }
+        if (!btn) held &= ~bit;
+    } else {
+        found = btn;
+        btn = false;
+        if (&btn == &AnyKeyPress) {
+            // any key takes them all, like the flags cleared on the next poll did
+            for (uint8_t k = 0; k < INPUT_KEY_COUNT; k++) {
+                forget(pending[k], now);
+                found |= pending[k].presses > 0;
+                pending[k] = Pending();
+                if (k < INPUT_KEY_TOUCH) *keyFlags[k] = false;
+            }
+            held = 0;
+        }
+    }
+    if (found) {
+        AnyKeyPress = false;
+        SerialCmdPress = false;
+    }
+    portEXIT_CRITICAL(&inputMux);
+    return found;
+}
+
+bool inputCheckLong(volatile bool &btn) {
+    const int key = keyOf(&btn);
+    if (key < 0) return false;
+    bool found;
+    portENTER_CRITICAL(&inputMux);
+    drain();
+    Pending &p = pending[key];
+    forget(p, millis());
+    found = p.longs > 0;
+    if (found) p.longs--;
+    portEXIT_CRITICAL(&inputMux);
+    return found;
+}
+
+bool inputWait(TickType_t timeout, InputEvent *event) {
+    // register before looking at the queue, a push in between still notifies
+    waiting.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+    if (tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire)) {
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+    waiting.store(nullptr, std::memory_order_release);
+
+    portENTER_CRITICAL(&inputMux);
+    drain();
+    const bool got = received != seen;
+    seen = received;
+    if (got && event) *event = newest;
+    portEXIT_CRITICAL(&inputMux);
+    return got;
+}
+
+bool inputPush(uint8_t key, int16_t x, int16_t y) {
+    if (key >= INPUT_KEY_COUNT) return false;
+    portENTER_CRITICAL(&inputMux);
+    const bool pushed = pressed(key, millis(), x, y);
+    if (key < INPUT_KEY_TOUCH) *keyFlags[key] = true;
+    held |= 1 << key;
+    AnyKeyPress = true;
+    portEXIT_CRITICAL(&inputMux);
+    if (pushed) notifyWaiting();
+    return pushed;
+}
+
+void IRAM_ATTR inputPushFromISR(uint8_t key) {
+    uint16_t h = isrHead.load(std::memory_order_relaxed);
+    if ((uint16_t)(h - isrTail.load(std::memory_order_acquire)) >= INPUT_ISR_QUEUE_SIZE) {
+        isrDropped = isrDropped + 1;
+    } else {
+        isrQueue[h & (INPUT_ISR_QUEUE_SIZE - 1)] = {(uint32_t)millis(), key, 0, 0, 0};
+        isrHead.store(h + 1, std::memory_order_release);
+    }
+    inputWakeFromISR();
+}
+
+void inputPublish() {
+    const uint32_t now = millis();
+    uint16_t t = isrTail.load(std::memory_order_relaxed);
+    const uint16_t h = isrHead.load(std::memory_order_acquire);
+    // a turn or press that wakes the screen only wakes it, as the boards do for theirs
+    if (t != h && wakeUpScreen()) t = h;
+
+    bool pushed = false;
+    portENTER_CRITICAL(&inputMux);
+    for (; t != h; t++) {
+        const InputEvent &e = isrQueue[t & (INPUT_ISR_QUEUE_SIZE - 1)];
+        if (e.key >= INPUT_KEY_COUNT) continue;
+        pushed |= pressed(e.key, e.time, 0, 0);
+        if (e.key < INPUT_KEY_TOUCH) *keyFlags[e.key] = true;
+        held |= 1 << e.key;
+        AnyKeyPress = true;
+    }
+    pushed |= publishFlags(now);
+
+    // a hold that went on for INPUT_LONG_PRESS_MS, presses further apart than the gap end it
+    for (uint8_t k = 0; k < INPUT_KEY_COUNT; k++) {
+        KeyRun &run = runs[k];
+        if (!run.active) continue;
+        if (now - run.last > INPUT_REPEAT_GAP_MS) {
+            run.active = false;
+        } else if (!run.longSent && now - run.down >= INPUT_LONG_PRESS_MS) {
+            run.longSent = true;
+            pushed |= push({now, k, INPUT_EVENT_LONG, 0, 0});
+        }
+    }
+    portEXIT_CRITICAL(&inputMux);
+    isrTail.store(t, std::memory_order_release);
+    if (pushed) notifyWaiting();
+}
+
+void inputClearFlags() {
+    portENTER_CRITICAL(&inputMux);
+    const bool pushed = publishFlags(millis());
+    for (volatile bool *flag : keyFlags) *flag = false;
+    AnyKeyPress = false;
+    SerialCmdPress = false;
+    touchPoint.Clear();
+    held = 0;
+    portEXIT_CRITICAL(&inputMux);
+    if (pushed) notifyWaiting();
+}
+
+uint32_t inputPollInterval() {
+    if (!interruptDriven || held) return INPUT_POLL_MS;
+    // holds are timed by polling
+    for (const KeyRun &run : runs) {
+        if (run.active) return INPUT_POLL_MS;
+    }
+    return INPUT_IDLE_POLL_MS;
+}
+
+void IRAM_ATTR inputWakeFromISR() {
+    if (!xHandle) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(xHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void inputWakeOnPin(uint8_t pin) { attachInterrupt(digitalPinToInterrupt(pin), inputWakeFromISR, CHANGE); }
+
+void inputSetInterruptDriven(bool enabled) { interruptDriven = enabled; }
+
+uint32_t inputDropped() { return dropped + isrDropped; }
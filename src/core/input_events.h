@@ -0,0 +1,149 @@
+#ifndef __INPUT_EVENTS_H__
+#define __INPUT_EVENTS_H__
+
+#include <Arduino.h>
+
+/*
+  Input events, from the input task (single producer) to the UI.
+
+  Every press becomes a timestamped event in a lock-free ring. Boards
+  keep setting NextPress, SelPress, ... from InputHandler(), and
+  inputPublish() turns each new flag into an event. Interrupts push
+  their own events through inputPushFromISR(), the input task moves
+  them to the ring and sets the matching flag. check() takes presses
+  from the events, so a press the input task cleared before anyone
+  looked is still there; the flags stay as a mirror for code that reads
+  them directly. Long press and repeat are marked here for every board.
+*/
+
+// Poll interval while a key is held or the board has inputs without interrupts
+#ifndef INPUT_POLL_MS
+#define INPUT_POLL_MS 10
+#endif
+// Poll interval when idle, for boards whose inputs all wake the input task
+#ifndef INPUT_IDLE_POLL_MS
+#define INPUT_IDLE_POLL_MS 50
+#endif
+// Boards report a held key as presses a debounce apart (around 200ms), closer than this is a hold
+#ifndef INPUT_REPEAT_GAP_MS
+#define INPUT_REPEAT_GAP_MS 250
+#endif
+#ifndef INPUT_LONG_PRESS_MS
+#define INPUT_LONG_PRESS_MS 700
+#endif
+// Presses nobody checked for this long are dropped, a menu opened later does not act on them
+#ifndef INPUT_EVENT_MAX_AGE_MS
+#define INPUT_EVENT_MAX_AGE_MS 500
+#endif
+// Must be powers of two
+#ifndef INPUT_QUEUE_SIZE
+#define INPUT_QUEUE_SIZE 32
+#endif
+#ifndef INPUT_ISR_QUEUE_SIZE
+#define INPUT_ISR_QUEUE_SIZE 16
+#endif
+
+enum InputKey : uint8_t {
+    INPUT_KEY_NEXT,
+    INPUT_KEY_PREV,
+    INPUT_KEY_UP,
+    INPUT_KEY_DOWN,
+    INPUT_KEY_SEL,
+    INPUT_KEY_ESC,
+    INPUT_KEY_NEXT_PAGE,
+    INPUT_KEY_PREV_PAGE,
+    INPUT_KEY_TOUCH,
+    INPUT_KEY_COUNT
+};
+
+#define INPUT_EVENT_LONG 0x01   // held for INPUT_LONG_PRESS_MS, once per hold
+#define INPUT_EVENT_REPEAT 0x02 // a press that goes on with a hold
+
+struct InputEvent {
+    uint32_t time; // millis() of the press, of the interrupt for inputPushFromISR()
+    uint8_t key;   // InputKey
+    uint8_t flags;
+    int16_t x; // touch only
+    int16_t y;
+};
+
+/*********************************************************************
+**  Function: inputCheck
+**  Body of check(): takes one press of the key behind btn, from the
+**  events or from the flag when it was set after the last publish.
+**  Clears the flag. check(AnyKeyPress) takes every pending press.
+**********************************************************************/
+bool inputCheck(volatile bool &btn);
+
+/*********************************************************************
+**  Function: inputCheckLong
+**  Takes a pending long press of the key behind btn
+**********************************************************************/
+bool inputCheckLong(volatile bool &btn);
+
+/*********************************************************************
+**  Function: inputWait
+**  Sleeps until an event is queued or timeout runs out, true when
+**  events came since the previous call, the newest goes to event.
+**  The presses stay for check(). Use instead of a delay in loops that
+**  poll check(), they wake as soon as a key is pressed.
+**********************************************************************/
+bool inputWait(TickType_t timeout, InputEvent *event = nullptr);
+
+/*********************************************************************
+**  Function: inputPush
+**  Input task only. Queues a press and sets its flag, for boards that
+**  read a key without going through the flags
+**********************************************************************/
+bool inputPush(uint8_t key, int16_t x = 0, int16_t y = 0);
+
+/*********************************************************************
+**  Function: inputPushFromISR
+**  Queues a press from an interrupt and wakes the input task. All the
+**  interrupts that push must run on one core.
+**********************************************************************/
+void inputPushFromISR(uint8_t key);
+
+/*********************************************************************
+**  Function: inputPublish
+**  Input task, after InputHandler(): moves the interrupt events to the
+**  queue, turns new flags into events and marks long presses
+**********************************************************************/
+void inputPublish();
+
+/*********************************************************************
+**  Function: inputClearFlags
+**  Input task, before InputHandler(): clears the flags and the touch
+**  point, publishing first what was set since the last poll
+**********************************************************************/
+void inputClearFlags();
+
+/*********************************************************************
+**  Function: inputPollInterval
+**  How long the input task may sleep before polling again
+**********************************************************************/
+uint32_t inputPollInterval();
+
+/*********************************************************************
+**  Function: inputWakeFromISR
+**  Call from input interrupts to run the input task immediately
+**********************************************************************/
+void inputWakeFromISR();
+
+/*********************************************************************
+**  Function: inputWakeOnPin
+**  Attaches inputWakeFromISR to a button pin
+**********************************************************************/
+void inputWakeOnPin(uint8_t pin);
+
+/*********************************************************************
+**  Function: inputSetInterruptDriven
+**  Boards whose inputs all wake the input task let it poll slower
+**  when idle, INPUT_IDLE_POLL_MS instead of INPUT_POLL_MS
+**********************************************************************/
+void inputSetInterruptDriven(bool enabled);
+
+// Events lost to a full queue, from the task and from interrupts
+uint32_t inputDropped();
+
+#endif
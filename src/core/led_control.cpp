@@ -80,117 +80,183 @@ uint32_t alterOneColorChannel(uint32_t color, uint16_t newR, uint16_t newG, uint
 
 TaskHandle_t ledEffectTaskHandle = NULL;
 
-void ledEffectTask(void *pvParameters) {
-    short hueStep = 360 / LED_COUNT;
-    short offset = 0;
-    int currentLED = 0;
-    int frame = 0;
-    uint64_t start_time = esp_timer_get_time() / 1000;
-    while (1) {
-        CRGB baseColor = isPreviewLed ? previewLedColor : bruceConfig.ledColor;
-        int ledEffect = isPreviewLed ? previewLedEffect : bruceConfig.ledEffect;
-        int ledEffectSpeed = isPreviewLed ? previewLedEffectSpeed : bruceConfig.ledEffectSpeed;
-        int ledEffectDirection = isPreviewLed ? previewLedEffectDirection : bruceConfig.ledEffectDirection;
-
-        if (ledEffect == LED_EFFECT_COLOR_CYCLE || ledEffect == LED_EFFECT_COLOR_WHEEL) {
-            short delayMs = 50;
-
-#ifdef HAS_ENCODER_LED
-            if ((ledEffectSpeed == 11 && EncoderLedChange != 0)) {
-                offset = (offset + (static_cast<short>(20 / 1000.0f * 360.0f)) * EncoderLedChange) % 360;
-                EncoderLedChange = 0;
-            } else if (ledEffectSpeed < 11) {
-                float speed = 0.2f * ledEffectSpeed;
-                offset = (offset + static_cast<short>(speed * delayMs / 1000.0f * 360.0f)) % 360;
-            }
-#else
-            float speed = 0.2f * ledEffectSpeed;
-            offset = (offset + static_cast<short>(speed * delayMs / 1000.0f * 360.0f)) % 360;
+// Effects are tables built when the parameters change, the task sleeps until the next frame is due
+#define LED_FRAME_MS 50
+#define LED_BREATHE_FRAMES 200     // one breathe period at speed 1
+#define LED_BREATHE_SYNC_FRAMES 40 // encoder steps per breathe period
+#define LED_SYNC_HUE_STEP 7        // degrees per encoder step
+
+struct LedParams {
+    CRGB color;
+    int effect;
+    int speed;
+    int direction;
+};
+
+struct LedFrame {
+    CRGB color;
+    uint16_t ms;
+};
+
+static CRGB hueTable[256];
+static LedFrame breatheFrames[LED_BREATHE_FRAMES];
+static uint16_t breatheCount = 0;
+#if LED_COUNT > 1
+static uint8_t chaseFade[LED_COUNT];
 #endif
-            if (ledEffect == LED_EFFECT_COLOR_CYCLE) {
-                short hue = ((offset * -ledEffectDirection) % 360 + 360) % 360;
-                // Serial.printf("LED Effect Cycle: hue=%d, offset=%d", hue, offset);
-                fill_solid(leds, LED_COUNT, hsvToRgb(hue, 255, 255));
-            } else if (ledEffect == LED_EFFECT_COLOR_WHEEL) {
-                for (uint16_t i = 0; i < LED_COUNT; ++i) {
-                    short hue = ((offset + i * -ledEffectDirection * hueStep) % 360 + 360) % 360;
-                    // Serial.printf("LED Effect Wheel: i=%d, hue=%d\n", i, hue);
-                    leds[i] = hsvToRgb(hue, 255, 255);
-                }
-            }
 
-        } else if (ledEffect == LED_COLOR_BREATHE) {
+static LedParams readLedParams() {
+    if (isPreviewLed)
+        return {previewLedColor, previewLedEffect, previewLedEffectSpeed, previewLedEffectDirection};
+    return {
+        CRGB(bruceConfig.ledColor),
+        bruceConfig.ledEffect,
+        bruceConfig.ledEffectSpeed,
+        bruceConfig.ledEffectDirection
+    };
+}
 
-            float phase;
+// speed 11 moves the effect with the encoder instead of the clock
+static bool encoderSynced(const LedParams &p) {
 #ifdef HAS_ENCODER_LED
-            if ((ledEffectSpeed == 11 && EncoderLedChange != 0) || (ledEffectSpeed < 11)) {
-                if ((ledEffectSpeed == 11 && EncoderLedChange != 0)) {
-                    phase = sinf(frame / 20.0f * PI);
-                    frame += EncoderLedChange;
-                    EncoderLedChange = 0;
-                } else {
-                    float time = millis() / 1000.0f;
-                    float speed = 0.2f * ledEffectSpeed;
-                    phase = sinf(time * speed * PI);
-                }
+    return p.speed == 11;
 #else
-            float time = millis() / 1000.0f;
-            float speed = 0.2f * ledEffectSpeed;
-            phase = sinf(time * speed * PI);
+    return false;
 #endif
-                uint8_t value = (uint8_t)((phase + 1.0f) * 127.5f);
+}
 
-                for (int i = 0; i < LED_COUNT; i++) {
-                    leds[i] = CRGB(
-                        (baseColor.r * value) / 255, (baseColor.g * value) / 255, (baseColor.b * value) / 255
-                    );
-                }
-#ifdef HAS_ENCODER_LED
+static void buildLedTables(const LedParams &p) {
+    if (p.effect == LED_COLOR_BREATHE) {
+        const bool synced = encoderSynced(p);
+        // speed 0 holds the colour at half brightness, one frame
+        const int frames = synced ? LED_BREATHE_SYNC_FRAMES : p.speed > 0 ? LED_BREATHE_FRAMES / p.speed : 1;
+        breatheCount = 0;
+        for (int f = 0; f < frames; f++) {
+            float phase = synced ? sinf(f / 20.0f * PI)
+                                 : sinf(f * LED_FRAME_MS / 1000.0f * 0.2f * p.speed * PI);
+            uint8_t value = (uint8_t)((phase + 1.0f) * 127.5f);
+            CRGB c((p.color.r * value) / 255, (p.color.g * value) / 255, (p.color.b * value) / 255);
+            // equal frames become one longer frame, except when each encoder step is a frame
+            if (!synced && breatheCount && breatheFrames[breatheCount - 1].color == c) {
+                breatheFrames[breatheCount - 1].ms += LED_FRAME_MS;
+            } else {
+                breatheFrames[breatheCount++] = {c, LED_FRAME_MS};
             }
+        }
+    }
+#if LED_COUNT > 1
+    for (int i = 0; i < LED_COUNT; i++) chaseFade[i] = 255 * powf(0.6f, i);
 #endif
+}
 
+static void renderLedFrame(const LedParams &p, uint16_t hue, int frame, int currentLED) {
+    if (p.effect == LED_EFFECT_COLOR_CYCLE) {
+        fill_solid(leds, LED_COUNT, hueTable[(uint16_t)(hue * -p.direction) >> 8]);
+    } else if (p.effect == LED_EFFECT_COLOR_WHEEL) {
+        for (int i = 0; i < LED_COUNT; i++) {
+            leds[i] = hueTable[(uint16_t)(hue - p.direction * i * (65536 / LED_COUNT)) >> 8];
+        }
+    } else if (p.effect == LED_COLOR_BREATHE) {
+        fill_solid(leds, LED_COUNT, breatheFrames[frame].color);
 #if LED_COUNT > 1
-        } else if (ledEffect == LED_EFFECT_CHASE || ledEffect == LED_EFFECT_CHASE_TAIL) {
-            uint8_t cycleFrames = 11 - ledEffectSpeed;
+    } else if (p.effect == LED_EFFECT_CHASE || p.effect == LED_EFFECT_CHASE_TAIL) {
+        fill_solid(leds, LED_COUNT, CRGB::Black);
+        if (p.effect == LED_EFFECT_CHASE) {
+            leds[currentLED] = p.color;
+        } else {
+            for (int i = 1; i < LED_COUNT; ++i) {
+                int index = (currentLED - p.direction * i + LED_COUNT) % LED_COUNT;
+                leds[index] = p.color;
+                leds[index].nscale8(chaseFade[i]);
+            }
+        }
+#endif
+    }
+}
 
-#ifdef HAS_ENCODER_LED
-            if ((ledEffectSpeed == 11 && EncoderLedChange != 0) ||
-                (ledEffectSpeed < 11 && frame % cycleFrames == 0)) {
-                if ((ledEffectSpeed == 11 && EncoderLedChange != 0)) {
-                    currentLED = (currentLED + EncoderLedChange + LED_COUNT) % LED_COUNT;
-                    EncoderLedChange = 0;
-                } else {
-                    currentLED = (currentLED + ledEffectDirection + LED_COUNT) % LED_COUNT;
-                }
-#else
-            if (frame % cycleFrames == 0) {
-                currentLED = (currentLED + ledEffectDirection + LED_COUNT) % LED_COUNT;
+// Ticks until the next frame, portMAX_DELAY when nothing moves until a notification
+static TickType_t nextLedFrame(const LedParams &p, int frame) {
+    if (FastLED.getBrightness() == 0 || encoderSynced(p)) return portMAX_DELAY;
+    switch (p.effect) {
+        case LED_EFFECT_COLOR_CYCLE:
+        case LED_EFFECT_COLOR_WHEEL: return p.speed > 0 ? pdMS_TO_TICKS(LED_FRAME_MS) : portMAX_DELAY;
+        case LED_COLOR_BREATHE:
+            if (!p.color || p.speed == 0) return portMAX_DELAY;
+            return pdMS_TO_TICKS(breatheFrames[frame].ms);
+#if LED_COUNT > 1
+        case LED_EFFECT_CHASE:
+        case LED_EFFECT_CHASE_TAIL:
+            if (!p.color) return portMAX_DELAY;
+            return pdMS_TO_TICKS((11 - min(p.speed, 10)) * LED_FRAME_MS);
 #endif
+        default: return portMAX_DELAY;
+    }
+}
 
-                fill_solid(leds, LED_COUNT, CRGB::Black);
+void ledEffectTask(void *pvParameters) {
+    for (int i = 0; i < 256; i++) hueTable[i] = hsvToRgb(i * 360 / 256, 255, 255);
+    LedParams p = readLedParams();
+    buildLedTables(p);
 
-                if (ledEffect == LED_EFFECT_CHASE) {
-                    leds[currentLED] = baseColor;
-                } else {
-                    for (int i = 1; i < LED_COUNT; ++i) {
-                        int index = (currentLED - ledEffectDirection * i + LED_COUNT) % LED_COUNT;
+    uint16_t hue = 0; // 8.8 fixed point index into hueTable
+    int frame = 0;
+    int currentLED = 0;
+    CRGB shown[LED_COUNT];
+    bool showAnyway = true;
+    TickType_t period = nextLedFrame(p, frame);
+    TickType_t due = xTaskGetTickCount() + period;
+    while (1) {
+        renderLedFrame(p, hue, frame, currentLED);
+        if (showAnyway || memcmp(shown, leds, sizeof(shown)) != 0) {
+            memcpy(shown, leds, sizeof(shown));
+            FastLED.show();
+            showAnyway = false;
+        }
 
-                        float fade = powf(0.6f, i);
-                        leds[index].r = baseColor.r * fade;
-                        leds[index].g = baseColor.g * fade;
-                        leds[index].b = baseColor.b * fade;
-                    }
-                }
-            }
-            frame++;
+        TickType_t wait = portMAX_DELAY;
+        if (period != portMAX_DELAY) {
+            TickType_t now = xTaskGetTickCount();
+            wait = (int32_t)(due - now) > 0 ? due - now : 0;
+        }
+        int steps = 1;
+        if (ulTaskNotifyTake(pdTRUE, wait)) {
+            // parameters or brightness changed, or the encoder moved, the frame clock keeps running
+            p = readLedParams();
+            buildLedTables(p);
+            if (frame >= breatheCount) frame = 0;
+            showAnyway = true;
+            steps = 0;
+#ifdef HAS_ENCODER_LED
+            if (encoderSynced(p)) steps = EncoderLedChange;
+            EncoderLedChange = 0;
 #endif
+            TickType_t next = nextLedFrame(p, frame);
+            if (period == portMAX_DELAY && next != portMAX_DELAY) due = xTaskGetTickCount() + next;
+            period = next;
+        }
+        if (steps == 0) continue;
+
+        if (p.effect == LED_EFFECT_COLOR_CYCLE || p.effect == LED_EFFECT_COLOR_WHEEL) {
+            int degrees = LED_SYNC_HUE_STEP;
+            if (!encoderSynced(p)) degrees = (short)(0.2f * p.speed * LED_FRAME_MS / 1000.0f * 360.0f);
+            hue += steps * degrees * 65536 / 360;
+        } else if (p.effect == LED_COLOR_BREATHE && breatheCount) {
+            frame = ((frame + steps) % breatheCount + breatheCount) % breatheCount;
+        } else {
+            int move = encoderSynced(p) ? steps : p.direction * steps;
+            currentLED = ((currentLED + move) % LED_COUNT + LED_COUNT) % LED_COUNT;
+        }
+        if (!encoderSynced(p)) {
+            period = nextLedFrame(p, frame);
+            due += period;
         }
-
-        FastLED.show();
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
 }
 
+void ledNotify() {
+    if (ledEffectTaskHandle != NULL) xTaskNotifyGive(ledEffectTaskHandle);
+}
+
 void beginLed() {
 #ifdef RGB_LED_CLK
     FastLED.addLeds<LED_TYPE, RGB_LED, RGB_LED_CLK, LED_ORDER>(leds, LED_COUNT);
@@ -258,9 +324,7 @@ void blinkLed(int blinkTime) {
 void setLedColor(CRGB color) {
     if (isPreviewLed && previewLedEffect != LED_EFFECT_SOLID) {
         previewLedColor = color;
-#ifdef HAS_ENCODER_LED
-        EncoderLedChange = 1;
-#endif
+        ledNotify();
     } else {
         for (int i = 0; i < LED_COUNT; i++) leds[i] = color;
         FastLED.show();
@@ -269,9 +333,7 @@ void setLedColor(CRGB color) {
 
 void setLedEffect(int effect) {
     previewLedEffect = effect;
-#ifdef HAS_ENCODER_LED
-    if (isPreviewLed && previewLedEffect != LED_EFFECT_SOLID) { EncoderLedChange = 1; }
-#endif
+    ledNotify();
 }
 
 void setLedBrightness(int value) {
@@ -279,6 +341,7 @@ void setLedBrightness(int value) {
     int bright = 255 * value / 100;
     FastLED.setBrightness(bright);
     FastLED.show();
+    ledNotify(); // a dark strip stops the effect task, a lit one restarts it
 }
 
 #define BrucePurple 9830500 // Custom purple color for Bruce
@@ -378,6 +441,7 @@ void setCustomColorSettingMenu(int rgb, std::function<uint32_t(uint32_t, int)> c
         uint32_t colorToSet = *static_cast<uint32_t *>(pointer);
         setLedColor(colorToSet);
         previewLedColor = CRGB(colorToSet);
+        ledNotify();
         return false;
     };
 
@@ -498,12 +562,14 @@ void setLedEffectConfig() {
                  previewLedEffect = bruceConfig.ledEffect;
                  previewLedEffectSpeed = bruceConfig.ledEffectSpeed;
                  previewLedEffectDirection = bruceConfig.ledEffectDirection;
+                 ledNotify();
                  return false;
              }                                                                    },
             {"Config - Direction", setLedEffectDirectionConfig,           false, [](void *pointer, bool shouldRender) {
                  previewLedEffect = bruceConfig.ledEffect;
                  previewLedEffectSpeed = bruceConfig.ledEffectSpeed;
                  previewLedEffectDirection = bruceConfig.ledEffectDirection;
+                 ledNotify();
                  return false;
              }},
         };
@@ -525,6 +591,7 @@ void setLedEffectSpeedConfig() {
     static auto hoverFunction = [](void *pointer, bool shouldRender) -> bool {
         int speedToSet = *static_cast<int *>(pointer);
         previewLedEffectSpeed = speedToSet + 1;
+        ledNotify();
         return false;
     };
 
@@ -566,6 +633,7 @@ void setLedEffectSpeedConfig() {
     int selectedOption = loopOptions(options, bruceConfig.ledEffectSpeed - 1);
     if (selectedOption == -1 || selectedOption == options.size() - 1) {
         previewLedEffectSpeed = bruceConfig.ledEffectSpeed;
+        ledNotify();
         return;
     }
 }
@@ -577,6 +645,7 @@ void setLedEffectDirectionConfig() {
          bruceConfig.ledEffectDirection == 1,
          [](void *pointer, bool shouldRender) {
              previewLedEffectDirection = 1;
+             ledNotify();
              return false;
          }},
         {"Anti-Clockwise",
@@ -584,6 +653,7 @@ void setLedEffectDirectionConfig() {
          bruceConfig.ledEffectDirection == -1,
          [](void *pointer, bool shouldRender) {
              previewLedEffectDirection = -1;
+             ledNotify();
              return false;
          }},
     };
@@ -593,6 +663,7 @@ void setLedEffectDirectionConfig() {
     int selectedOption = loopOptions(options, (bruceConfig.ledEffectDirection == 1) ? 0 : 1);
     if (selectedOption == -1 || selectedOption == options.size() - 1) {
         previewLedEffectDirection = bruceConfig.ledEffectDirection;
+        ledNotify();
         return;
     }
 }
@@ -602,6 +673,7 @@ void ledSetup() {
 
     if (bruceConfig.ledEffect > LED_EFFECT_SOLID) {
         ledEffects(true);
+        ledNotify(); // a running task picks up the new config
     } else setLedColor(bruceConfig.ledColor);
 }
 
@@ -31,6 +31,8 @@ void setLedEffectSpeedConfig();
 void setLedEffectDirectionConfig();
 void ledSetup();
 void ledEffects(bool enable);
+// Wakes the effect task after a change of the LED config, the preview or EncoderLedChange
+void ledNotify();
 void ledPreviewMode(bool enable);
 void setLedBrightness(int value);
 void setLedBrightnessConfig();
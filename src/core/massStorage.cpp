@@ -7,9 +7,49 @@
 bool MassStorage::shouldStop = false;
 int32_t MassStorage::status = -1;
 
+// Card geometry, read once per mount instead of on every USB transfer
+static uint32_t mscSectorSize = 0;
+static uint32_t mscNumSectors = 0;
+
+// Single cache shared by read-ahead and write coalescing.
+// It holds mscCacheCount sectors starting at mscCacheLba, dirty when they still need to reach the card
+static SemaphoreHandle_t mscLock = NULL;
+static uint8_t *mscCache = nullptr;
+static uint32_t mscCacheLba = 0;
+static uint32_t mscCacheCount = 0;
+static bool mscCacheDirty = false;
+static uint32_t mscLastWrite = 0;
+
 MassStorage::MassStorage() { setup(); }
 
+// Geometry and cache for the card just mounted
+static void mscAttach() {
+    mscSectorSize = SD.sectorSize();
+    mscNumSectors = SD.numSectors();
+    if (mscLock == NULL) mscLock = xSemaphoreCreateMutex();
+    mscCacheCount = 0;
+    mscCacheDirty = false;
+#if MSC_CACHE_SECTORS > 0
+    if (mscCache == nullptr && mscSectorSize > 0) {
+        mscCache = (uint8_t *)malloc(MSC_CACHE_SECTORS * mscSectorSize);
+    }
+    if (mscCache == nullptr) log_w("MSC cache not allocated, running uncached");
+#endif
+}
+
+static void mscDetach() {
+    if (mscLock) xSemaphoreTake(mscLock, portMAX_DELAY);
+    mscFlushCache();
+    free(mscCache);
+    mscCache = nullptr;
+    mscCacheCount = 0;
+    mscSectorSize = 0;
+    if (mscLock) xSemaphoreGive(mscLock);
+}
+
 MassStorage::~MassStorage() {
+    mscDetach();
+
     msc.end();
     USB.~ESPUSB();
 
@@ -48,6 +88,12 @@ void MassStorage::loop() {
             }
             prev_status = status;
         } else vTaskDelay(20 / portTICK_PERIOD_MS);
+
+        if (mscCacheDirty && millis() - mscLastWrite > MSC_FLUSH_IDLE_MS &&
+            xSemaphoreTake(mscLock, 0) == pdTRUE) {
+            mscFlushCache();
+            xSemaphoreGive(mscLock);
+        }
     }
 }
 
@@ -59,8 +105,8 @@ void MassStorage::beginUsb() {
 }
 
 void MassStorage::setupUsbCallback() {
-    uint32_t secSize = SD.sectorSize();
-    uint32_t numSectors = SD.numSectors();
+    mscAttach();
+    log_i("MSC: %u sectors of %u bytes", mscNumSectors, mscSectorSize);
 
     msc.vendorID("ESP32");
     msc.productID("BRUCE");
@@ -71,7 +117,7 @@ void MassStorage::setupUsbCallback() {
     msc.onStartStop(usbStartStopCallback);
 
     msc.mediaPresent(true);
-    msc.begin(numSectors, secSize);
+    msc.begin(mscNumSectors, mscSectorSize);
 }
 
 void MassStorage::setupUsbEvent() {
@@ -80,50 +126,174 @@ void MassStorage::setupUsbEvent() {
     });
 }
 
+/*********************************************************************
+**  Function: benchmark
+**  Measures what a host gets from the MSC read callback, read-ahead
+**  cache included: 4KB transfers (the usual TinyUSB MSC size) and
+**  single sectors, in order and at random. Read only, writing through
+**  the callback would touch sectors the mounted filesystem owns.
+**********************************************************************/
+void MassStorage::benchmark() {
+    const uint32_t chunkSectors = 8;   // 4KB
+    const uint32_t seqBytes = 1 << 20; // 1MB per pass
+    const uint32_t randChunks = 64;
+
+    displayMessage("Benchmarking...");
+    if (!setupSdCard()) {
+        displayError("SD card not found.", true);
+        return;
+    }
+    mscAttach();
+    if (mscSectorSize == 0 || mscNumSectors < 2 * seqBytes / mscSectorSize) {
+        mscDetach();
+        displayError("SD card error.", true);
+        return;
+    }
+    const uint32_t chunkBytes = chunkSectors * mscSectorSize;
+    uint8_t *buf = (uint8_t *)malloc(chunkBytes);
+    if (!buf) {
+        mscDetach();
+        displayError("Out of memory.", true);
+        return;
+    }
+
+    // seq 4KB, seq 1 sector, random 4KB
+    const uint32_t sizes[3] = {chunkSectors, 1, chunkSectors};
+    const uint32_t seqStart = (mscNumSectors / 2) & ~(chunkSectors - 1);
+    float results[3] = {0};
+    bool ok = true;
+
+    for (uint32_t pass = 0; pass < 3 && ok; pass++) {
+        const bool random = pass == 2;
+        const uint32_t sectors = sizes[pass];
+        const uint32_t reads = random ? randChunks : seqBytes / (sectors * mscSectorSize);
+        mscCacheCount = 0; // every pass starts cold
+        uint32_t t = micros();
+        for (uint32_t i = 0; i < reads && ok; i++) {
+            uint32_t lba = random ? (esp_random() % (mscNumSectors - sectors)) & ~(chunkSectors - 1)
+                                  : seqStart + i * sectors;
+            ok = usbReadCallback(lba, 0, buf, sectors * mscSectorSize) > 0;
+        }
+        uint32_t us = micros() - t;
+        results[pass] = us ? (float)reads * sectors * mscSectorSize / us : 0; // bytes/us == MB/s
+    }
+    free(buf);
+    mscDetach();
+
+    if (!ok) {
+        displayError("SD read failed.", true);
+        return;
+    }
+
+    drawMainBorderWithTitle("MSC Benchmark");
+    padprintln("");
+    padprintf("Seq read 4KB:  %.2f MB/s\n", results[0]);
+    padprintf("Seq read 512B: %.2f MB/s\n", results[1]);
+    padprintf("Rnd read 4KB:  %.2f MB/s\n", results[2]);
+    Serial.printf(
+        "MSC benchmark: seq read %.2f MB/s (%u B), %.2f MB/s (%u B), rnd read %.2f MB/s (%u B)\n",
+        results[0],
+        chunkBytes,
+        results[1],
+        mscSectorSize,
+        results[2],
+        chunkBytes
+    );
+    while (!check(AnyKeyPress)) vTaskDelay(50 / portTICK_PERIOD_MS);
+}
+
 void MassStorage::displayMessage(String message) {
     drawMainBorderWithTitle("Mass Storage");
     padprintln("");
     padprintln(message);
 }
 
-int32_t usbWriteCallback(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
-    // Verify freespace
-    uint64_t freeSpace = SD.totalBytes() - SD.usedBytes();
-    if (bufsize > freeSpace) {
-        return -1; // no space available
-    }
+static bool mscCacheHit(uint32_t lba, uint32_t count) {
+    return mscCacheCount > 0 && lba >= mscCacheLba && lba + count <= mscCacheLba + mscCacheCount;
+}
 
-    // Verify sector size
-    const uint32_t secSize = SD.sectorSize();
-    if (secSize == 0) return -1; // disk error
+static bool mscCacheOverlaps(uint32_t lba, uint32_t count) {
+    return mscCacheCount > 0 && lba < mscCacheLba + mscCacheCount && mscCacheLba < lba + count;
+}
 
-    // Write blocs
-    for (uint32_t x = 0; x < bufsize / secSize; ++x) {
-        uint8_t blkBuffer[secSize];
-        memcpy(blkBuffer, buffer + secSize * x, secSize);
-        if (!SD.writeRAW(blkBuffer, lba + x)) {
-            return -1; // write error
+// Must be called with mscLock held
+bool mscFlushCache() {
+    if (!mscCacheDirty) return true;
+    if (!SD.writeRAW(mscCache, mscCacheLba, mscCacheCount)) return false;
+    mscCacheDirty = false;
+    return true;
+}
+
+int32_t usbWriteCallback(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    if (mscSectorSize == 0) return -1; // disk error
+    const uint32_t count = bufsize / mscSectorSize;
+    if (lba + count > mscNumSectors) return -1; // out of range
+
+    int32_t result = bufsize;
+    xSemaphoreTake(mscLock, portMAX_DELAY);
+    if (mscCache && count < MSC_CACHE_SECTORS) {
+        // Coalesce small sequential writes into one multi-block write
+        if (!(mscCacheDirty && lba == mscCacheLba + mscCacheCount &&
+              mscCacheCount + count <= MSC_CACHE_SECTORS)) {
+            if (mscFlushCache()) {
+                mscCacheLba = lba;
+                mscCacheCount = 0;
+            } else {
+                result = -1; // keep the sectors not on the card yet, the host sees the error
+            }
+        }
+        if (result > 0) {
+            memcpy(mscCache + mscCacheCount * mscSectorSize, buffer, bufsize);
+            mscCacheCount += count;
+            mscCacheDirty = true;
+            mscLastWrite = millis();
+            if (mscCacheCount == MSC_CACHE_SECTORS && !mscFlushCache()) result = -1;
         }
+    } else {
+        if (!mscFlushCache()) result = -1;
+        else if (mscCacheOverlaps(lba, count)) mscCacheCount = 0; // drop stale read-ahead
+        // Multi-block write straight from the TinyUSB buffer
+        if (result > 0 && !SD.writeRAW(buffer, lba, count)) result = -1;
     }
-    return bufsize;
+    xSemaphoreGive(mscLock);
+    return result;
 }
 
 int32_t usbReadCallback(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
-    // Verify sector size
-    const uint32_t secSize = SD.sectorSize();
-    if (secSize == 0) return -1; // disk error
-
-    // Read blocs
-    for (uint32_t x = 0; x < bufsize / secSize; ++x) {
-        if (!SD.readRAW(reinterpret_cast<uint8_t *>(buffer) + (x * secSize), lba + x)) {
-            return -1; // read error
+    if (mscSectorSize == 0) return -1; // disk error
+    const uint32_t count = bufsize / mscSectorSize;
+    if (lba + count > mscNumSectors) return -1; // out of range
+
+    int32_t result = bufsize;
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buffer);
+    xSemaphoreTake(mscLock, portMAX_DELAY);
+    if (mscCacheHit(lba, count)) {
+        memcpy(dst, mscCache + (lba - mscCacheLba) * mscSectorSize, bufsize);
+    } else if (!mscFlushCache()) {
+        result = -1;
+    } else if (mscCache && count < MSC_CACHE_SECTORS) {
+        // Read ahead a full cache worth of sectors, hosts mostly read sequentially
+        uint32_t n = min<uint32_t>(MSC_CACHE_SECTORS, mscNumSectors - lba);
+        mscCacheCount = 0;
+        if (SD.readRAW(mscCache, lba, n)) {
+            mscCacheLba = lba;
+            mscCacheCount = n;
+            memcpy(dst, mscCache, bufsize);
+        } else {
+            result = -1;
         }
+    } else if (!SD.readRAW(dst, lba, count)) {
+        result = -1; // read error
     }
-    return bufsize;
+    xSemaphoreGive(mscLock);
+    return result;
 }
 
 bool usbStartStopCallback(uint8_t power_condition, bool start, bool load_eject) {
     if (!start && load_eject) {
+        xSemaphoreTake(mscLock, portMAX_DELAY);
+        mscFlushCache();
+        xSemaphoreGive(mscLock);
         MassStorage::setShouldStop(true);
         return false;
     }
@@ -5,6 +5,13 @@
 #if defined(SOC_USB_OTG_SUPPORTED)
 #include <USBMSC.h>
 
+#ifndef MSC_CACHE_SECTORS // read-ahead / write-coalescing cache size, 0 disables the cache
+#define MSC_CACHE_SECTORS 16
+#endif
+#ifndef MSC_FLUSH_IDLE_MS // coalesced writes are flushed after this long without new writes
+#define MSC_FLUSH_IDLE_MS 50
+#endif
+
 class MassStorage {
 public:
     static bool shouldStop;
@@ -26,6 +33,7 @@ public:
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
     static void setShouldStop(bool value) { shouldStop = value; }
+    static void benchmark();
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Display functions
@@ -43,6 +51,8 @@ private:
     void setupUsbEvent(void);
 };
 
+bool mscFlushCache(void);
+
 int32_t usbWriteCallback(uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize);
 int32_t usbReadCallback(uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize);
 bool usbStartStopCallback(uint8_t power_condition, bool start, bool load_eject);
@@ -54,11 +54,21 @@ void ConfigMenu::optionsMenu() {
         {"Clock", setClock},
         {"Sleep", setSleepMode},
         {"Factory Reset", [=]() { bruceConfig.factoryReset(); }},
-        {"Restart", [=]() { ESP.restart(); }},
+        {"Restart",
+         [=]() {
+             bruceConfig.commit();
+             ESP.restart();
+         }},
     };
 
-    options.push_back({"Turn-off", powerOff});
-    options.push_back({"Deep Sleep", goToDeepSleep});
+    options.push_back({"Turn-off", [=]() {
+                           bruceConfig.commit();
+                           powerOff();
+                       }});
+    options.push_back({"Deep Sleep", [=]() {
+                           bruceConfig.commit();
+                           goToDeepSleep();
+                       }});
 
     if (bruceConfig.devMode) options.push_back({"Dev Mode", [this]() { devMenu(); }});
 
@@ -66,6 +76,7 @@ void ConfigMenu::optionsMenu() {
     addOptionToMainMenu();
 
     loopOptions(options, MENU_TYPE_SUBMENU, "Config");
+    bruceConfig.commit();
 }
 
 void ConfigMenu::devMenu() {
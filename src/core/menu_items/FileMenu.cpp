@@ -13,6 +13,7 @@ void FileMenu::optionsMenu() {
 
 #if defined(SOC_USB_OTG_SUPPORTED)
     options.push_back({"Mass Storage", [=]() { MassStorage(); }});
+    options.push_back({"MSC Benchmark", MassStorage::benchmark});
 #endif
     addOptionToMainMenu();
 
@@ -983,6 +983,7 @@ void goToDeepSleep() {
 #elif SOC_PM_SUPPORT_EXT1_WAKEUP
     esp_sleep_enable_ext1_wakeup((gpio_num_t)DEEPSLEEP_WAKEUP_PIN, ESP_EXT1_WAKEUP_ANY_LOW);
 #endif
+    bruceConfig.commit();
     esp_deep_sleep_start();
 #else
     displayWarning("Not available", true);
@@ -1,5 +1,5 @@
 #include "net_utils.h"
-#include <HTTPClient.h>
+#include "oui_db.h"
 #include <WiFi.h>
 #include <sstream>
 
@@ -15,27 +15,11 @@ bool internetConnection() {
 }
 
 String getManufacturer(const String &mac) {
-    if (!internetConnection()) { return "NO_INTERNET_ACCESS"; }
+    // looked up in the offline IEEE registry, see tools/oui_gen.py
+    if (!ouiDb.available()) return "NO_OUI_DB";
+    if (strtol(mac.substring(0, 2).c_str(), nullptr, 16) & 0x02) return "PRIVATE";
 
-    // there is an official(IEEE) doc that contains all registered mac prefixes
-    // but it is around 700kb and i don't know a way to get specific part
-    // without downloading the whole txt
-    HTTPClient http;
-    http.begin("http://api.maclookup.app/v2/macs/" + mac);
-    int httpCode = http.GET(); // Send the request
-    if (httpCode != 200) {
-        http.end();
-        return "GET failed";
-    }
-
-    // payload is a json of the format
-    // {"success":true,"found":true,"macPrefix":"2C3358","company":"Intel Corporate","address":"Lot 8, Jalan
-    // Hi-Tech 2/3, Kulim Kedah 09000,
-    // MY","country":"MY","blockStart":"2C3358000000","blockEnd":"2C3358FFFFFF","blockSize":16777215,"blockType":"MA-L","updated":"2021-10-13","isRand":false,"isPrivate":false}
-    // company field is going to be empty if none found
-    String payload{http.getString()};
-    size_t company_start_idx = payload.indexOf("company") + 10; // + 7(company) + 3(":")
-    String manufacturer = payload.substring(company_start_idx, payload.indexOf('"', company_start_idx));
+    String manufacturer = ouiDb.lookup(mac);
     if (manufacturer.isEmpty()) return "UNKNOWN";
 
     return manufacturer;
@@ -1,4 +1,3 @@
-#include <HTTPClient.h>
 #include <WiFi.h>
 
 bool internetConnection();
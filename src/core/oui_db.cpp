@@ -0,0 +1,231 @@
+#include "oui_db.h"
+#include "sd_functions.h"
+#include <LittleFS.h>
+#include <SD.h>
+
+#define OUI_HEADER_SIZE 32
+#define OUI_ENTRY_SIZE 8
+#define OUI_KEY_SIZE 5
+#define OUI_SPLIT_FLAG 0x800000
+#define OUI_NAME_MAX 96
+
+OuiDb ouiDb;
+
+static const uint8_t tableBits[] = {24, 28, 36};
+
+static uint32_t getLE32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t getKey(const uint8_t *p) {
+    uint64_t key = 0;
+    for (int i = 0; i < OUI_KEY_SIZE; i++) key = (key << 8) | p[i];
+    return key;
+}
+
+static uint64_t prefixKey(uint64_t mac40, uint8_t bits) { return mac40 & ~((1ULL << (40 - bits)) - 1); }
+
+// The card was mounted by load(), lookups don't probe it again
+File OuiDb::openFile() {
+    if (_onSD) return SD.open(OUI_DB_PATH, FILE_READ);
+    return LittleFS.open(OUI_DB_PATH, FILE_READ);
+}
+
+bool OuiDb::load() {
+    if (_tried) return _loaded;
+    _tried = true;
+
+    _onSD = setupSdCard() && SD.exists(OUI_DB_PATH);
+    if (!_onSD && !LittleFS.exists(OUI_DB_PATH)) return false;
+    File file = openFile();
+    if (!file) return false;
+
+    uint8_t header[OUI_HEADER_SIZE];
+    if (file.read(header, sizeof(header)) != sizeof(header) || memcmp(header, "OUI1", 4) != 0) {
+        log_e("%s is not an OUI database", OUI_DB_PATH);
+        file.close();
+        return false;
+    }
+    _page = getLE32(header + 16);
+    _strings = getLE32(header + 20);
+    _stringsSize = getLE32(header + 24);
+
+    uint32_t pages = 0;
+    for (int t = 0; t < TABLES; t++) {
+        _tables[t].count = getLE32(header + 4 + 4 * t);
+        _tables[t].pages = _page ? (_tables[t].count + _page - 1) / _page : 0;
+        pages += _tables[t].pages;
+    }
+    uint32_t offset = OUI_HEADER_SIZE + pages * OUI_KEY_SIZE;
+    for (int t = 0; t < TABLES; t++) {
+        _tables[t].offset = offset;
+        offset += _tables[t].count * OUI_ENTRY_SIZE;
+    }
+    if (_page == 0 || _page > OUI_DB_MAX_PAGE || _strings != offset ||
+        _strings + _stringsSize != file.size()) {
+        log_e("%s is damaged or from a newer generator", OUI_DB_PATH);
+        file.close();
+        return false;
+    }
+
+    _index = (uint8_t *)malloc(pages * OUI_KEY_SIZE);
+    if (!_index || file.read(_index, pages * OUI_KEY_SIZE) != pages * OUI_KEY_SIZE) {
+        log_e("Could not load the OUI page index");
+        free(_index);
+        _index = nullptr;
+        file.close();
+        return false;
+    }
+    const uint8_t *p = _index;
+    for (int t = 0; t < TABLES; t++) {
+        _tables[t].index = p;
+        p += _tables[t].pages * OUI_KEY_SIZE;
+    }
+    file.close();
+    _loaded = true;
+    return true;
+}
+
+bool OuiDb::available() { return load(); }
+
+void OuiDb::end() {
+    free(_index);
+    _index = nullptr;
+    for (int t = 0; t < TABLES; t++) _tables[t] = Table();
+    for (auto &entry : _cache) entry = CacheEntry();
+    _tried = false;
+    _loaded = false;
+}
+
+bool OuiDb::find(File &file, int table, uint64_t key, uint32_t &nameOffset) {
+    const Table &t = _tables[table];
+    // last page whose first key is <= key
+    int lo = 0, hi = (int)t.pages - 1, page = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (getKey(t.index + mid * OUI_KEY_SIZE) <= key) {
+            page = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (page < 0) return false;
+
+    uint8_t buf[OUI_DB_MAX_PAGE * OUI_ENTRY_SIZE];
+    uint32_t entries = min(_page, t.count - page * _page);
+    if (!file.seek(t.offset + page * _page * OUI_ENTRY_SIZE) ||
+        file.read(buf, entries * OUI_ENTRY_SIZE) != entries * OUI_ENTRY_SIZE) {
+        return false;
+    }
+    lo = 0;
+    hi = (int)entries - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const uint8_t *e = buf + mid * OUI_ENTRY_SIZE;
+        uint64_t k = getKey(e);
+        if (k == key) {
+            nameOffset = e[5] | (e[6] << 8) | (e[7] << 16);
+            return true;
+        }
+        if (k < key) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return false;
+}
+
+String OuiDb::readName(File &file, uint32_t nameOffset) {
+    char name[OUI_NAME_MAX + 1];
+    if (nameOffset >= _stringsSize || !file.seek(_strings + nameOffset)) return "";
+    size_t n = file.read((uint8_t *)name, min((uint32_t)OUI_NAME_MAX, _stringsSize - nameOffset));
+    name[n] = '\0';
+    return String(name);
+}
+
+String OuiDb::lookup(const uint8_t mac[6]) {
+    const CacheEntry *entry = resolve(mac);
+    return entry ? entry->name : "";
+}
+
+uint32_t OuiDb::vendorId(const uint8_t mac[6]) {
+    const CacheEntry *entry = resolve(mac);
+    return entry ? entry->id : OUI_DB_UNKNOWN;
+}
+
+String OuiDb::vendorName(uint32_t id) {
+    if (id == OUI_DB_UNKNOWN || !load()) return "";
+    File file = openFile();
+    if (!file) return "";
+    String name = readName(file, id);
+    file.close();
+    return name;
+}
+
+const OuiDb::CacheEntry *OuiDb::resolve(const uint8_t mac[6]) {
+    // randomized and locally assigned addresses have no vendor
+    if (mac[0] & 0x02) return nullptr;
+
+    uint64_t mac40 = 0;
+    for (int i = 0; i < 5; i++) mac40 = (mac40 << 8) | mac[i];
+
+    for (auto &entry : _cache) {
+        if (entry.bits && prefixKey(mac40, entry.bits) == entry.key) {
+            entry.used = ++_tick;
+            return &entry;
+        }
+    }
+    if (!load()) return nullptr;
+
+    File file = openFile();
+    if (!file) return nullptr;
+
+    String name;
+    uint32_t id = OUI_DB_UNKNOWN;
+    uint8_t bits = tableBits[MA_L];
+    uint32_t offset;
+    if (find(file, MA_L, prefixKey(mac40, 24), offset)) {
+        if (offset & OUI_SPLIT_FLAG) {
+            // the OUI is split between owners, the block decides, the MA-L owner is the fallback
+            bits = tableBits[MA_S];
+            uint32_t sub;
+            if (find(file, MA_M, prefixKey(mac40, 28), sub)) {
+                offset = sub;
+                bits = tableBits[MA_M];
+            } else if (find(file, MA_S, prefixKey(mac40, 36), sub)) {
+                offset = sub;
+            }
+        }
+        id = offset & ~OUI_SPLIT_FLAG;
+        name = readName(file, id);
+    }
+    file.close();
+
+    // unknown prefixes are cached too, scans see the same ones over and over
+    CacheEntry *slot = &_cache[0];
+    for (auto &entry : _cache) {
+        if (entry.used < slot->used) slot = &entry;
+    }
+    slot->key = prefixKey(mac40, bits);
+    slot->bits = bits;
+    slot->used = ++_tick;
+    slot->id = name.isEmpty() ? OUI_DB_UNKNOWN : id;
+    slot->name = name;
+    return slot;
+}
+
+String OuiDb::lookup(const String &mac) {
+    uint8_t bytes[6] = {0};
+    int nibbles = 0;
+    for (size_t i = 0; i < mac.length() && nibbles < 12; i++) {
+        char c = mac[i];
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else continue;
+        bytes[nibbles / 2] = (bytes[nibbles / 2] << 4) | v;
+        nibbles++;
+    }
+    if (nibbles < 6) return "";
+    return lookup(bytes);
+}
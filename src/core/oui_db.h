@@ -0,0 +1,90 @@
+#ifndef __OUI_DB_H__
+#define __OUI_DB_H__
+
+#include <Arduino.h>
+#include <FS.h>
+
+/*
+  Offline MAC vendor database, built by tools/oui_gen.py from the IEEE
+  registries (MA-L, MA-M and MA-S CSV files).
+
+  header (32 bytes, LE): "OUI1" | count MA-L | count MA-M | count MA-S |
+                         page size | strings offset | strings size | reserved
+  then the page index (the first key of every page of each table), the
+  three tables, each sorted by key, and the string table.
+
+  entry (8 bytes): key (5 bytes, BE) | name offset (3 bytes, LE)
+  The key is the MAC prefix (24, 28 or 36 bits) left aligned in 40 bits.
+  In MA-L entries the top bit of the name offset flags an OUI that is
+  split into MA-M / MA-S blocks. Names are NUL terminated.
+*/
+#ifndef OUI_DB_PATH
+#define OUI_DB_PATH "/oui.bin"
+#endif
+// Largest page the reader accepts, a page is read into an 8 * page stack buffer
+#define OUI_DB_MAX_PAGE 128
+#ifndef OUI_DB_CACHE
+#define OUI_DB_CACHE 16
+#endif
+// vendorId() of an address without a known vendor
+#define OUI_DB_UNKNOWN 0xFFFFFFFF
+
+/*********************************************************************
+**  Class: OuiDb
+**  Vendor lookups against OUI_DB_PATH on the SD card or LittleFS.
+**  The page index is loaded on the first lookup, after that a miss
+**  reads one page per table and the name. Recent answers are kept in
+**  a small LRU cache.
+**********************************************************************/
+class OuiDb {
+public:
+    // "" when the vendor is unknown or the address is locally administered
+    String lookup(const uint8_t mac[6]);
+    // Accepts "aa:bb:cc:dd:ee:ff", "AA-BB-CC..." or plain hex
+    String lookup(const String &mac);
+    // Offset of the vendor name in the string table: one id per vendor, whichever of its
+    // prefixes the address is from. OUI_DB_UNKNOWN when lookup() would give ""
+    uint32_t vendorId(const uint8_t mac[6]);
+    // Name of a vendorId(), read from the file
+    String vendorName(uint32_t id);
+    bool available();
+    // Drops the page index and the cache, the next lookup loads the file again
+    void end();
+
+private:
+    enum { MA_L, MA_M, MA_S, TABLES };
+    struct Table {
+        uint32_t count = 0;
+        uint32_t offset = 0;
+        uint32_t pages = 0;
+        const uint8_t *index = nullptr; // 5-byte keys, one per page
+    };
+    struct CacheEntry {
+        uint64_t key = 0;
+        uint8_t bits = 0;
+        uint32_t used = 0;
+        uint32_t id = OUI_DB_UNKNOWN;
+        String name;
+    };
+
+    bool load();
+    const CacheEntry *resolve(const uint8_t mac[6]);
+    File openFile();
+    bool find(File &file, int table, uint64_t key, uint32_t &nameOffset);
+    String readName(File &file, uint32_t nameOffset);
+
+    bool _tried = false;
+    bool _loaded = false;
+    bool _onSD = false;
+    uint32_t _page = 0;
+    uint8_t *_index = nullptr;
+    Table _tables[TABLES];
+    uint32_t _strings = 0;
+    uint32_t _stringsSize = 0;
+    CacheEntry _cache[OUI_DB_CACHE];
+    uint32_t _tick = 0;
+};
+
+extern OuiDb ouiDb;
+
+#endif
@@ -1,25 +1,25 @@
 #include "sd_functions.h"
+#include "digest.h"
+#include "dir_cursor.h"
 #include "display.h" // using displayRedStripe as error msg
 #include "modules/badusb_ble/ducky_typer.h"
 #include "modules/bjs_interpreter/interpreter.h"
+#include "modules/gps/track_logger.h"
 #include "modules/gps/wigle.h"
 #include "modules/ir/TV-B-Gone.h"
 #include "modules/ir/custom_ir.h"
 #include "modules/others/audio.h"
 #include "modules/others/qrcode_menu.h"
 #include "modules/rf/rf_send.h"
+#include "modules/rf/rf_sub_decode.h"
 #include "mykeyboard.h" // using keyboard when calling rename
 #include "passwords.h"
 #include "scrollableTextArea.h"
 #include <globals.h>
 
-#include <MD5Builder.h>
-#include <algorithm> // for std::sort
-#include <esp_rom_crc.h>
 
 // SPIClass sdcardSPI;
 String fileToCopy;
-std::vector<FileList> fileList;
 
 /***************************************************************************************
 ** Function name: setupSdCard
@@ -413,119 +413,38 @@ size_t getFileSize(FS &fs, String filepath) {
     return fileSize;
 }
 
-String md5File(FS &fs, String filepath) {
-    if (!fs.exists(filepath)) return "";
-    String txt = readSmallFile(fs, filepath);
-    MD5Builder md5;
-    md5.begin();
-    md5.add(txt);
-    md5.calculate();
-    return (md5.toString());
-}
-
-String crc32File(FS &fs, String filepath) {
-    if (!fs.exists(filepath)) return "";
-    String txt = readSmallFile(fs, filepath);
-    // derived from
-    // https://techoverflow.net/2022/08/05/how-to-compute-crc32-with-ethernet-polynomial-0x04c11db7-on-esp32-crc-h/
-    uint32_t romCRC =
-        (~esp_rom_crc32_le((uint32_t)~(0xffffffff), (const uint8_t *)txt.c_str(), txt.length())) ^ 0xffffffff;
-
-    char s[18] = {0};
-    char crcBytes[4] = {0};
-    memcpy(crcBytes, &romCRC, sizeof(uint32_t));
-    snprintf(s, sizeof(s), "%02X%02X%02X%02X\n", crcBytes[3], crcBytes[2], crcBytes[1], crcBytes[0]);
-    return (String(s));
-}
-
-/***************************************************************************************
-** Function name: sortList
-** Description:   sort files/folders by name
-***************************************************************************************/
-bool sortList(const FileList &a, const FileList &b) {
-    if (a.folder != b.folder) {
-        return a.folder > b.folder; // true if a is a folder and b is not
-    }
-    // Order items alphabetically
-    String fa = a.filename.c_str();
-    fa.toUpperCase();
-    String fb = b.filename.c_str();
-    fb.toUpperCase();
-    return fa < fb;
-}
-
-/***************************************************************************************
-** Function name: checkExt
-** Description:   check file extension
-***************************************************************************************/
-bool checkExt(String ext, String pattern) {
-    ext.toUpperCase();
-    pattern.toUpperCase();
-    if (ext == pattern) return true;
-
-    // If the pattern is a list of extensions (e.g., "TXT|JPG|PNG"), split and check
-    int start = 0;
-    int end = pattern.indexOf('|');
-    while (end != -1) {
-        String currentExt = pattern.substring(start, end);
-        if (ext == currentExt) { return true; }
-        start = end + 1;
-        end = pattern.indexOf('|', start);
-    }
-
-    // Check the last extension in the list
-    String lastExt = pattern.substring(start);
-    return ext == lastExt;
+/*********************************************************************
+**  Function: hashFile
+**  Streams the file through one of the DIGEST_* algorithms, returns
+**  the hex digest or "" when the file can't be read
+**********************************************************************/
+String hashFile(FS &fs, String filepath, uint8_t algo) {
+    FileDigest digest(algo);
+    if (!digest.digestFile(fs, filepath)) return "";
+    log_i(
+        "%s %s: %llu bytes in %lu ms, %.2f MB/s",
+        FileDigest::name(algo),
+        filepath.c_str(),
+        digest.bytes(),
+        (unsigned long)digest.ms(),
+        digest.mbPerSec()
+    );
+    return digest.hex(algo);
 }
 
-/***************************************************************************************
-** Function name: readFs
-** Description:   read files/folders from a folder
-***************************************************************************************/
-void readFs(FS fs, String folder, String allowed_ext) {
-    int allFilesCount = 0;
-    fileList.clear();
-    FileList object;
-
-    File root = fs.open(folder);
-    if (!root || !root.isDirectory()) { return; }
-
-    while (true) {
-        bool isDir;
-        String fullPath = root.getNextFileName(&isDir);
-        String nameOnly = fullPath.substring(fullPath.lastIndexOf("/") + 1);
-        if (fullPath == "") { break; }
-        // Serial.printf("Path: %s (isDir: %d)\n", fullPath.c_str(), isDir);
-
-        if (isDir) {
-            object.filename = nameOnly;
-            object.folder = true;
-            object.operation = false;
-            fileList.push_back(object);
-        } else {
-            int dotIndex = nameOnly.lastIndexOf(".");
-            String ext = dotIndex >= 0 ? nameOnly.substring(dotIndex + 1) : "";
-            if (allowed_ext == "*" || checkExt(ext, allowed_ext)) {
-                object.filename = nameOnly;
-                object.folder = false;
-                object.operation = false;
-                fileList.push_back(object);
-            }
-        }
-    }
-    root.close();
-
-    // Sort folders/files
-    std::sort(fileList.begin(), fileList.end(), sortList);
-
-    Serial.println("Files listed with: " + String(fileList.size()) + " files/folders found");
+String md5File(FS &fs, String filepath) { return hashFile(fs, filepath, DIGEST_MD5); }
 
-    // Adds Operational btn at the botton
-    object.filename = "> Back";
-    object.folder = false;
-    object.operation = true;
+String crc32File(FS &fs, String filepath) { return hashFile(fs, filepath, DIGEST_CRC32); }
 
-    fileList.push_back(object);
+/*********************************************************************
+**  Function: exportTrackFile
+**  Converts a GPS tracker .trk log to GPX, KML or CSV
+**********************************************************************/
+static void exportTrackFile(FS &fs, const String &filepath, TrackFormat format) {
+    displayRedStripe("Exporting...", getComplementaryColor2(bruceConfig.priColor), bruceConfig.priColor);
+    int32_t points = exportTrack(fs, filepath, format);
+    if (points < 0) displayError("Export failed", true);
+    else displaySuccess(String(points) + " points exported", true);
 }
 
 /*********************************************************************
@@ -565,9 +484,11 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
     bool exit = false;
     // returnToMenu=true;  // make sure menu is redrawn when quitting in any point
 
-    readFs(fs, Folder, allowed_ext);
+    DirCursor files;
+    String selected;
+    files.open(fs, Folder, allowed_ext);
 
-    maxFiles = fileList.size() - 1; // discount the >back operator
+    maxFiles = files.count() - 1; // discount the >back operator
     LongPress = false;
     unsigned long LongPressTmp = millis();
     while (1) {
@@ -581,21 +502,28 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                 tft.fillScreen(bruceConfig.bgColor);
                 tft.drawRoundRect(5, 5, tftWidth - 10, tftHeight - 10, 5, bruceConfig.priColor);
                 Serial.println("reload to read: " + Folder);
-                readFs(fs, Folder, allowed_ext);
+                // the folder was changed from a menu, read it again
+                if (reload) files.invalidate();
+                files.open(fs, Folder, allowed_ext);
                 PreFolder = Folder;
-                maxFiles = fileList.size() - 1;
+                maxFiles = files.count() - 1;
                 if (strcmp(PreFolder.c_str(), Folder.c_str()) != 0 || index > maxFiles) index = 0;
                 reload = false;
             }
-            if (fileList.size() < 2) readFs(fs, Folder, allowed_ext);
+            if (files.count() < 2) {
+                files.invalidate();
+                files.open(fs, Folder, allowed_ext);
+                maxFiles = files.count() - 1;
+            }
 
-            coord = listFiles(index, fileList);
+            coord = listFiles(index, files);
+            selected = files.name(index);
 #if defined(HAS_TOUCH)
             TouchFooter();
 #endif
             redraw = false;
         }
-        displayScrollingText(fileList[index].filename, coord);
+        displayScrollingText(selected, coord);
 
 #ifdef HAS_KEYBOARD
         char pressed_letter = checkLetterShortcutPress();
@@ -604,18 +532,18 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
         // check letter shortcuts
         if (pressed_letter > 0) {
             // Serial.println(pressed_letter);
-            if (tolower(fileList[index].filename.c_str()[0]) == pressed_letter) {
+            if (tolower(files.name(index)[0]) == pressed_letter) {
                 // already selected, go to the next
                 index += 1;
                 // check if index is still valid
-                if (index <= maxFiles && tolower(fileList[index].filename.c_str()[0]) == pressed_letter) {
+                if (index <= maxFiles && tolower(files.name(index)[0]) == pressed_letter) {
                     redraw = true;
                     continue;
                 }
             }
             // else look again from the start
             for (int i = 0; i < maxFiles; i++) {
-                if (tolower(fileList[i].filename.c_str()[0]) == pressed_letter) { // check if 1st char matches
+                if (tolower(files.name(i)[0]) == pressed_letter) { // check if 1st char matches
                     index = i;
                     redraw = true;
                     break; // quit on 1st match
@@ -659,22 +587,20 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
             LongPress = false;
 
             if (check(SelPress)) {
-                if (fileList[index].folder == true && fileList[index].operation == false) {
+                if (files.isFolder(index)) {
+                    String filename = files.name(index);
                     options = {
-                        {"New Folder", [=]() { createFolder(fs, Folder); }                                 },
-                        {"Rename",
-                         [=]() {
-                             renameFile(fs, Folder + fileList[index].filename, fileList[index].filename);
-                         }                                                                                 },
-                        {"Delete",     [=]() { deleteFromSd(fs, Folder + "/" + fileList[index].filename); }},
-                        {"Close Menu", [&]() { yield(); }                                                  },
-                        {"Main Menu",  [&]() { exit = true; }                                              },
+                        {"New Folder", [=]() { createFolder(fs, Folder); }                     },
+                        {"Rename",     [=]() { renameFile(fs, Folder + filename, filename); }  },
+                        {"Delete",     [=]() { deleteFromSd(fs, Folder + "/" + filename); }    },
+                        {"Close Menu", [&]() { yield(); }                                      },
+                        {"Main Menu",  [&]() { exit = true; }                                  },
                     };
                     loopOptions(options);
                     tft.drawRoundRect(5, 5, tftWidth - 10, tftHeight - 10, 5, bruceConfig.priColor);
                     reload = true;
                     redraw = true;
-                } else if (fileList[index].folder == false && fileList[index].operation == false) {
+                } else if (!files.isOperation(index)) {
                     goto Files;
                 } else {
                     options = {
@@ -690,19 +616,18 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                 }
             } else {
             Files:
-                if (fileList[index].folder == true && fileList[index].operation == false) {
-                    Folder = Folder + (Folder == "/" ? "" : "/") +
-                             fileList[index].filename; // Folder=="/"? "":"/" +
+                if (files.isFolder(index)) {
+                    Folder = Folder + (Folder == "/" ? "" : "/") + files.name(index); // Folder=="/"? "":"/" +
                     // Debug viewer
                     Serial.println(Folder);
                     redraw = true;
-                } else if (fileList[index].folder == false && fileList[index].operation == false) {
+                } else if (!files.isOperation(index)) {
                     // Save the file/folder info to Clear memory to allow other functions to work better
-                    String filepath = Folder + (Folder == "/" ? "" : "/") + fileList[index].filename; //
-                    String filename = fileList[index].filename;
+                    String filepath = Folder + (Folder == "/" ? "" : "/") + files.name(index); //
+                    String filename = files.name(index);
                     // Debug viewer
                     Serial.println(filepath + " --> " + filename);
-                    fileList.clear(); // Clear memory to allow other functions to work better
+                    files.clear(); // Clear memory to allow other functions to work better
 
                     options = {
                         {"View File",  [=]() { viewFile(fs, filepath); }            },
@@ -732,11 +657,36 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                                                              delay(200);
                                                              txIrFile(&fs, filepath);
                                                          }});
-                    if (filepath.endsWith(".sub"))
+                    if (filepath.endsWith(".sub")) {
+#if !defined(LITE_VERSION)
+                        options.insert(options.begin(), {"Decode All", [&]() {
+                                                             delay(200);
+                                                             rf_sub_decode(&fs, Folder);
+                                                         }});
+                        options.insert(options.begin(), {"Subghz Decode", [&]() {
+                                                             delay(200);
+                                                             rf_sub_decode(&fs, filepath);
+                                                         }});
+#endif
                         options.insert(options.begin(), {"Subghz Tx", [&]() {
                                                              delay(200);
                                                              txSubFile(&fs, filepath);
                                                          }});
+                    }
+                    if (filepath.endsWith(".trk")) {
+                        options.insert(options.begin(), {"Export CSV", [&]() {
+                                                             delay(200);
+                                                             exportTrackFile(fs, filepath, TRACK_CSV);
+                                                         }});
+                        options.insert(options.begin(), {"Export KML", [&]() {
+                                                             delay(200);
+                                                             exportTrackFile(fs, filepath, TRACK_KML);
+                                                         }});
+                        options.insert(options.begin(), {"Export GPX", [&]() {
+                                                             delay(200);
+                                                             exportTrackFile(fs, filepath, TRACK_GPX);
+                                                         }});
+                    }
                     if (filepath.endsWith(".csv")) {
                         options.insert(options.begin(), {"Wigle Upload", [&]() {
                                                              delay(200);
@@ -819,15 +769,19 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
                                                delay(200);
                                                qrcode_display(readSmallFile(fs, filepath));
                                            }});
-                        options.push_back({"CRC32", [&]() {
-                                               delay(200);
-                                               displaySuccess(crc32File(fs, filepath), true);
-                                           }});
-                        options.push_back({"MD5", [&]() {
-                                               delay(200);
-                                               displaySuccess(md5File(fs, filepath), true);
-                                           }});
                     }
+                    options.push_back({"CRC32", [&]() {
+                                           delay(200);
+                                           displaySuccess(crc32File(fs, filepath), true);
+                                       }});
+                    options.push_back({"MD5", [&]() {
+                                           delay(200);
+                                           displaySuccess(md5File(fs, filepath), true);
+                                       }});
+                    options.push_back({"SHA256", [&]() {
+                                           delay(200);
+                                           displaySuccess(hashFile(fs, filepath, DIGEST_SHA256), true);
+                                       }});
                     options.push_back({"Close Menu", [&]() { yield(); }});
                     options.push_back({"Main Menu", [&]() { exit = true; }});
                     if (!filePicker) loopOptions(options);
@@ -853,7 +807,6 @@ String loopSD(FS &fs, bool filePicker, String allowed_ext, String rootPath) {
             delay(10);
         }
     }
-    fileList.clear();
     return result;
 }
 
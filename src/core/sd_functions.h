@@ -38,14 +38,12 @@ String readSmallFile(FS &fs, String filepath);
 
 char *readBigFile(FS &fs, String filepath, bool binary = false, size_t *fileSize = NULL);
 
+String hashFile(FS &fs, String filepath, uint8_t algo);
+
 String md5File(FS &fs, String filepath);
 
 String crc32File(FS &fs, String filepath);
 
-void readFs(FS fs, String folder, String allowed_ext = "*");
-
-bool sortList(const FileList &a, const FileList &b);
-
 String loopSD(FS &fs, bool filePicker = false, String allowed_ext = "*", String rootPath = "/");
 
 void viewFile(FS fs, String filepath);
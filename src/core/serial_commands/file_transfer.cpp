@@ -0,0 +1,226 @@
+#include "file_transfer.h"
+#include <esp_rom_crc.h>
+
+#define XFER_MAGIC0 0xB5
+#define XFER_MAGIC1 0x62
+#define XFER_HEADER_SIZE 9 // magic, type, len, offset
+#define XFER_FRAME_MAX (XFER_HEADER_SIZE + XFER_CHUNK + 4)
+
+enum XferRead { XFER_NONE, XFER_BAD, XFER_OK };
+
+struct XferFrame {
+    uint8_t type;
+    uint16_t len;
+    uint32_t offset;
+    uint8_t *payload;
+};
+
+static void putLE(uint8_t *p, uint32_t v, int n) {
+    for (int i = 0; i < n; i++) p[i] = v >> (8 * i);
+}
+
+static uint32_t getLE(const uint8_t *p, int n) {
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void sendFrame(Stream &io, uint8_t *buf, uint8_t type, uint32_t pos, const void *data, uint16_t len) {
+    buf[0] = XFER_MAGIC0;
+    buf[1] = XFER_MAGIC1;
+    buf[2] = type;
+    putLE(buf + 3, len, 2);
+    putLE(buf + 5, pos, 4);
+    if (len && data != buf + XFER_HEADER_SIZE) memcpy(buf + XFER_HEADER_SIZE, data, len);
+    putLE(buf + XFER_HEADER_SIZE + len, esp_rom_crc32_le(0, buf + 2, XFER_HEADER_SIZE - 2 + len), 4);
+    io.write(buf, XFER_HEADER_SIZE + len + 4);
+}
+
+static void sendControl(Stream &io, uint8_t type, uint32_t offset, const char *reason = "") {
+    uint8_t buf[XFER_HEADER_SIZE + 64 + 4];
+    sendFrame(io, buf, type, offset, reason, strnlen(reason, 64));
+}
+
+static bool readBytes(Stream &io, uint8_t *buf, size_t len, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    size_t got = 0;
+    while (got < len) {
+        int avail = io.available();
+        if (avail > 0) {
+            got += io.readBytes(buf + got, min((size_t)avail, len - got));
+            start = millis();
+        } else if (millis() - start > timeoutMs) {
+            return false;
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    return true;
+}
+
+// Waits up to waitMs for a frame start, then reads the frame into buf, which holds cap bytes.
+// Frames that don't fit are bad, the rest of them is skipped while looking for the next one.
+static XferRead readFrame(Stream &io, uint8_t *buf, size_t cap, XferFrame &frame, uint32_t waitMs) {
+    uint32_t start = millis();
+    uint8_t prev = 0;
+    while (true) {
+        if (io.available() <= 0) {
+            if (millis() - start >= waitMs) return XFER_NONE;
+            vTaskDelay(1);
+            continue;
+        }
+        uint8_t c = io.read();
+        if (prev == XFER_MAGIC0 && c == XFER_MAGIC1) break;
+        prev = c;
+    }
+    if (!readBytes(io, buf + 2, XFER_HEADER_SIZE - 2, XFER_TIMEOUT_MS)) return XFER_BAD;
+    frame.type = buf[2];
+    frame.len = getLE(buf + 3, 2);
+    frame.offset = getLE(buf + 5, 4);
+    frame.payload = buf + XFER_HEADER_SIZE;
+    if (frame.len > XFER_CHUNK || frame.len + 4u > cap - XFER_HEADER_SIZE) return XFER_BAD;
+    if (!readBytes(io, buf + XFER_HEADER_SIZE, frame.len + 4, XFER_TIMEOUT_MS)) return XFER_BAD;
+    uint32_t crc = getLE(buf + XFER_HEADER_SIZE + frame.len, 4);
+    if (crc != esp_rom_crc32_le(0, buf + 2, XFER_HEADER_SIZE - 2 + frame.len)) return XFER_BAD;
+    return XFER_OK;
+}
+
+bool xferSendFile(Stream &io, File &file, uint32_t offset, XferStats &stats) {
+    const uint32_t size = file.size();
+    uint8_t *out = (uint8_t *)malloc(XFER_FRAME_MAX);
+    uint8_t in[XFER_HEADER_SIZE + 64 + 4];
+    if (!out) {
+        sendControl(io, 'X', 0, "out of memory");
+        return false;
+    }
+
+    uint32_t acked = offset;
+    uint32_t next = offset;
+    uint32_t retries = 0;
+    bool endSent = false;
+    bool ok = false;
+    uint32_t start = millis();
+    stats = XferStats();
+
+    while (true) {
+        bool windowOpen = next < size && next - acked < XFER_WINDOW * XFER_CHUNK;
+        if (windowOpen) {
+            if (file.position() != next) file.seek(next);
+            uint16_t len = min((uint32_t)XFER_CHUNK, size - next);
+            if (file.read(out + XFER_HEADER_SIZE, len) != len) {
+                sendControl(io, 'X', next, "read error");
+                break;
+            }
+            sendFrame(io, out, 'D', next, out + XFER_HEADER_SIZE, len);
+            next += len;
+        } else if (acked == size && !endSent) {
+            sendControl(io, 'E', size);
+            endSent = true;
+        }
+
+        // Drain acks while sending, wait for them when the window is full
+        XferFrame frame;
+        XferRead r;
+        while ((r = readFrame(io, in, sizeof(in), frame, windowOpen ? 0 : XFER_TIMEOUT_MS)) == XFER_OK) {
+            if (frame.type == 'A' && frame.offset > acked && frame.offset <= next) {
+                acked = frame.offset;
+                retries = 0;
+            } else if (frame.type == 'N' && frame.offset >= acked && frame.offset <= next) {
+                acked = frame.offset;
+                next = frame.offset;
+                stats.retries++;
+            } else if (frame.type == 'E' && frame.offset == size && endSent) {
+                ok = true;
+            } else if (frame.type == 'X') {
+                break;
+            }
+            if (ok || !windowOpen) break;
+        }
+        if (ok || (r == XFER_OK && frame.type == 'X')) break;
+        if (r != XFER_OK && !windowOpen) {
+            // nothing came back, go back to the last acknowledged byte
+            if (++retries > XFER_MAX_RETRIES) {
+                sendControl(io, 'X', acked, "timeout");
+                break;
+            }
+            next = acked;
+            endSent = false;
+            stats.retries++;
+        }
+    }
+
+    free(out);
+    stats.bytes = acked - offset;
+    stats.ms = millis() - start;
+    return ok;
+}
+
+bool xferReceiveFile(Stream &io, File &file, uint32_t offset, uint32_t size, XferStats &stats) {
+    uint8_t *in = (uint8_t *)malloc(XFER_FRAME_MAX);
+    if (!in) {
+        sendControl(io, 'X', 0, "out of memory");
+        return false;
+    }
+
+    uint32_t expected = offset;
+    uint32_t timeouts = 0;
+    bool nakSent = false;
+    bool ok = false;
+    uint32_t start = millis();
+    stats = XferStats();
+
+    while (true) {
+        XferFrame frame;
+        XferRead r = readFrame(io, in, XFER_FRAME_MAX, frame, XFER_TIMEOUT_MS);
+        if (r == XFER_NONE) {
+            if (++timeouts > XFER_MAX_RETRIES) {
+                sendControl(io, 'X', expected, "timeout");
+                break;
+            }
+            sendControl(io, 'N', expected);
+            nakSent = true;
+            stats.retries++;
+            continue;
+        }
+        timeouts = 0;
+        if (r == XFER_BAD || (frame.type == 'D' && frame.offset > expected)) {
+            // one NAK per gap, the frames already in flight behind it are dropped quietly
+            if (!nakSent) {
+                sendControl(io, 'N', expected);
+                nakSent = true;
+                stats.retries++;
+            }
+            continue;
+        }
+        if (frame.type == 'D') {
+            if (frame.offset == expected) {
+                if (expected + frame.len > size || file.write(frame.payload, frame.len) != frame.len) {
+                    sendControl(io, 'X', expected, "write error");
+                    break;
+                }
+                expected += frame.len;
+                nakSent = false;
+            }
+            sendControl(io, 'A', expected);
+        } else if (frame.type == 'E') {
+            if (frame.offset == expected && expected == size) {
+                sendControl(io, 'E', size);
+                ok = true;
+                stats.ms = millis() - start;
+                // the echo may get lost, answer the repeats for a moment
+                while (readFrame(io, in, XFER_FRAME_MAX, frame, XFER_TIMEOUT_MS) != XFER_NONE) {
+                    if (frame.type == 'E') sendControl(io, 'E', size);
+                }
+                break;
+            }
+            sendControl(io, 'N', expected);
+        } else if (frame.type == 'X') {
+            break;
+        }
+    }
+
+    free(in);
+    stats.bytes = expected - offset;
+    if (!ok) stats.ms = millis() - start;
+    return ok;
+}
@@ -0,0 +1,45 @@
+#ifndef __SERIAL_FILE_TRANSFER_H__
+#define __SERIAL_FILE_TRANSFER_H__
+
+#include <Arduino.h>
+#include <FS.h>
+
+/*
+  Framed file transfer used by "storage get" and "storage put".
+
+  frame: 0xB5 0x62 | type | len (2, LE) | offset (4, LE) | payload (len) | crc32 (4, LE)
+  The CRC (zlib CRC-32) covers type, len, offset and payload.
+
+  'D' data at file offset              sender -> receiver
+  'A' everything before offset arrived receiver -> sender
+  'N' resend from offset               receiver -> sender
+  'E' end, offset is the file size     both ways, the receiver echoes it back
+  'X' abort, payload is the reason     both ways
+
+  The sender keeps up to XFER_WINDOW frames unacknowledged and goes back
+  to the last acknowledged offset on 'N' or when acks stop coming.
+  Bytes between frames are skipped, so stray log lines do no harm.
+*/
+#ifndef XFER_CHUNK
+#define XFER_CHUNK 1024
+#endif
+#ifndef XFER_WINDOW
+#define XFER_WINDOW 8
+#endif
+#ifndef XFER_TIMEOUT_MS
+#define XFER_TIMEOUT_MS 1000
+#endif
+#define XFER_MAX_RETRIES 10
+
+struct XferStats {
+    uint32_t bytes = 0;
+    uint32_t ms = 0;
+    uint32_t retries = 0;
+};
+
+// Sends file from offset to its end. The file is read sequentially, seeking back only on resends
+bool xferSendFile(Stream &io, File &file, uint32_t offset, XferStats &stats);
+// Receives the bytes from offset to size into file, which must be positioned at offset
+bool xferReceiveFile(Stream &io, File &file, uint32_t offset, uint32_t size, XferStats &stats);
+
+#endif
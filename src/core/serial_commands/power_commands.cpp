@@ -3,12 +3,14 @@
 #include <globals.h>
 
 uint32_t poweroffCallback(cmd *c) {
+    bruceConfig.commit();
     powerOff();
     esp_deep_sleep_start(); // only wake up via hardware reset
     return true;
 }
 
 uint32_t rebootCallback(cmd *c) {
+    bruceConfig.commit();
     ESP.restart();
     return true;
 }
@@ -4,6 +4,8 @@
 #include "helpers.h"
 #include "modules/rf/rf_scan.h"
 #include "modules/rf/rf_send.h"
+#include "modules/rf/rf_sub_decode.h"
+#include "modules/rf/rf_tuning.h"
 #include "modules/rf/rf_utils.h"
 #include <ArduinoJson.h>
 #include <globals.h>
@@ -91,6 +93,12 @@ uint32_t rfScanCallback(cmd *c) {
     stopFreq /= 1000000;
 
     rf_scan(startFreq, stopFreq, 10 * 1000); // 10s timeout
+    serialDevice->printf(
+        "%u channels, %.1f sweeps/s, %lu us per channel\n",
+        rfTuning.size(),
+        rfTuning.sweepsPerSecond(),
+        rfTuning.dwellUs()
+    );
     return true;
 }
 
@@ -123,6 +131,43 @@ uint32_t rfTxFileCallback(cmd *c) {
     return txSubFile(fs, filepath, hideDefaultUI);
 }
 
+uint32_t rfDecodeCallback(cmd *c) {
+    // example: subghz decode BruceRF/autoSaved
+#ifndef LITE_VERSION
+    Command cmd(c);
+
+    Argument pathArg = cmd.getArgument("path");
+    String path = pathArg.getValue();
+    path.trim();
+    if (!path.startsWith("/")) path = "/" + path;
+
+    FS *fs;
+    if (!getFsStorage(fs)) return false;
+
+    if (!(*fs).exists(path)) {
+        serialDevice->println("File does not exist");
+        return false;
+    }
+
+    SubDecodeStats stats;
+    if (!rf_sub_decode(fs, path, &stats, false)) {
+        serialDevice->println("No RAW .sub file found");
+        return false;
+    }
+    serialDevice->printf(
+        "%lu files, %lu trains, %lu decoded, %lu messages in %lu ms\n",
+        stats.files,
+        stats.trains,
+        stats.hits,
+        stats.messages,
+        stats.ms
+    );
+    return true;
+#else
+    return false;
+#endif
+}
+
 uint32_t rfTxBufferCallback(cmd *c) {
 #ifndef LITE_VERSION
     if (!(_setupPsramFs())) return false;
@@ -227,6 +272,11 @@ void createRfTxFileCommand(Command *rfCmd) {
     cmd.addPosArg("hideDefaultUI", "false");
 }
 
+void createRfDecodeCommand(Command *rfCmd) {
+    Command cmd = rfCmd->addCommand("decode", rfDecodeCallback);
+    cmd.addPosArg("path");
+}
+
 void createRfTxBufferCommand(Command *rfCmd) {
     Command cmd = rfCmd->addCommand("tx_from_buffer", rfTxBufferCallback);
 }
@@ -239,6 +289,7 @@ void createRfCommands(SimpleCLI *cli) {
     createRfScanCommand(&cmd);
     createRfTxFileCommand(&cmd);
     createRfTxBufferCommand(&cmd);
+    createRfDecodeCommand(&cmd);
 
     cli->addSingleArgCmd("RfSend", rfSendCallback);
 }
@@ -1,5 +1,7 @@
 #include "storage_commands.h"
+#include "core/digest.h"
 #include "core/sd_functions.h"
+#include "file_transfer.h"
 #include "helpers.h"
 #include <globals.h>
 
@@ -67,7 +69,8 @@ uint32_t readCallback(cmd *c) {
     return true;
 }
 
-uint32_t md5Callback(cmd *c) {
+// Prints the digest, then the throughput on a second line
+static uint32_t hashCallback(cmd *c, uint8_t algo) {
     Command cmd(c);
 
     Argument arg = cmd.getArgument("filepath");
@@ -81,27 +84,26 @@ uint32_t md5Callback(cmd *c) {
     FS *fs;
     if (!getFsStorage(fs) || !(*fs).exists(filepath)) return false;
 
-    serialDevice->println(md5File(*fs, filepath));
+    FileDigest digest(algo);
+    if (!digest.digestFile(*fs, filepath)) {
+        serialDevice->println("Error reading " + filepath);
+        return false;
+    }
+    serialDevice->println(digest.hex(algo));
+    serialDevice->printf(
+        "%llu bytes in %lu ms, %.2f MB/s\n",
+        digest.bytes(),
+        (unsigned long)digest.ms(),
+        digest.mbPerSec()
+    );
     return true;
 }
 
-uint32_t crc32Callback(cmd *c) {
-    Command cmd(c);
+uint32_t md5Callback(cmd *c) { return hashCallback(c, DIGEST_MD5); }
 
-    Argument arg = cmd.getArgument("filepath");
-    String filepath = arg.getValue();
-    filepath.trim();
-
-    if (filepath.length() == 0) return false;
+uint32_t crc32Callback(cmd *c) { return hashCallback(c, DIGEST_CRC32); }
 
-    if (!filepath.startsWith("/")) filepath = "/" + filepath;
-
-    FS *fs;
-    if (!getFsStorage(fs) || !(*fs).exists(filepath)) return false;
-
-    serialDevice->println(crc32File(*fs, filepath));
-    return true;
-}
+uint32_t sha256Callback(cmd *c) { return hashCallback(c, DIGEST_SHA256); }
 
 uint32_t removeCallback(cmd *c) {
     Command cmd(c);
@@ -163,6 +165,118 @@ uint32_t writeCallback(cmd *c) {
     return true;
 }
 #endif
+// Binary frames need the raw stream, BLE serial only carries text lines
+static Stream *transferStream() {
+    if (serialDevice != &USBserial) {
+        serialDevice->println("ERROR: file transfer only works over USB serial");
+        return nullptr;
+    }
+    return USBserial.getSerialOutput();
+}
+
+static void printTransferStats(const char *what, bool ok, const XferStats &stats) {
+    uint32_t ms = stats.ms ? stats.ms : 1;
+    serialDevice->printf(
+        "\n%s %s: %lu bytes in %lu ms, %lu B/s, %lu resends\n",
+        what,
+        ok ? "done" : "failed",
+        (unsigned long)stats.bytes,
+        (unsigned long)stats.ms,
+        (unsigned long)((uint64_t)stats.bytes * 1000 / ms),
+        (unsigned long)stats.retries
+    );
+}
+
+uint32_t getCallback(cmd *c) {
+    Command cmd(c);
+
+    Argument arg = cmd.getArgument("filepath");
+    Argument offsetArg = cmd.getArgument("offset");
+    String filepath = arg.getValue();
+    filepath.trim();
+    uint32_t offset = offsetArg.getValue().toInt();
+
+    if (filepath.length() == 0) return false;
+
+    if (!filepath.startsWith("/")) filepath = "/" + filepath;
+
+    Stream *io = transferStream();
+    FS *fs;
+    if (!io || !getFsStorage(fs)) return false;
+
+    File file = fs->open(filepath, FILE_READ);
+    if (!file || file.isDirectory()) {
+        serialDevice->println("ERROR: cannot open " + filepath);
+        return false;
+    }
+    if (offset > file.size() || !file.seek(offset)) {
+        serialDevice->println("ERROR: offset past the end of the file");
+        file.close();
+        return false;
+    }
+
+    serialDevice->printf(
+        "READY GET %lu %lu %d %d\n",
+        (unsigned long)file.size(),
+        (unsigned long)offset,
+        XFER_CHUNK,
+        XFER_WINDOW
+    );
+    serialDevice->flush();
+    XferStats stats;
+    bool ok = xferSendFile(*io, file, offset, stats);
+    file.close();
+    printTransferStats("GET", ok, stats);
+    return ok;
+}
+
+uint32_t putCallback(cmd *c) {
+    Command cmd(c);
+
+    Argument arg = cmd.getArgument("filepath");
+    Argument sizeArg = cmd.getArgument("size");
+    Argument resumeArg = cmd.getArgument("resume");
+    String filepath = arg.getValue();
+    filepath.trim();
+    uint32_t size = sizeArg.getValue().toInt();
+
+    if (filepath.length() == 0) return false;
+
+    if (!filepath.startsWith("/")) filepath = "/" + filepath;
+
+    Stream *io = transferStream();
+    FS *fs;
+    if (!io || !getFsStorage(fs)) return false;
+
+    // Resuming appends to the partial file, the sender continues from its size
+    uint32_t offset = 0;
+    bool resume = resumeArg.isSet() && fs->exists(filepath);
+    if (resume) {
+        File partial = fs->open(filepath, FILE_READ);
+        offset = partial ? partial.size() : 0;
+        partial.close();
+        if (offset > size) {
+            serialDevice->println("ERROR: file on the device is larger than the upload");
+            return false;
+        }
+    }
+    File file = fs->open(filepath, resume ? FILE_APPEND : FILE_WRITE, true);
+    if (!file) {
+        serialDevice->println("ERROR: cannot create " + filepath);
+        return false;
+    }
+
+    serialDevice->printf(
+        "READY PUT %lu %lu %d %d\n", (unsigned long)size, (unsigned long)offset, XFER_CHUNK, XFER_WINDOW
+    );
+    serialDevice->flush();
+    XferStats stats;
+    bool ok = offset == size || xferReceiveFile(*io, file, offset, size, stats);
+    file.close();
+    printTransferStats("PUT", ok, stats);
+    return ok;
+}
+
 uint32_t renameCallback(cmd *c) {
     Command cmd(c);
 
@@ -372,6 +486,11 @@ void createCrc32Command(SimpleCLI *cli) {
     cmd.addPosArg("filepath");
 }
 
+void createSha256Command(SimpleCLI *cli) {
+    Command cmd = cli->addCommand("sha256", sha256Callback);
+    cmd.addPosArg("filepath");
+}
+
 void createRemoveCommand(SimpleCLI *cli) {
     Command cmd = cli->addCommand("rm,del", removeCallback);
     cmd.addPosArg("filepath");
@@ -404,6 +523,15 @@ void createStorageCommand(SimpleCLI *cli) {
     cmdWrite.addPosArg("filepath");
     cmdWrite.addPosArg("size", "0");
 #endif
+    Command cmdGet = cmd.addCommand("get", getCallback);
+    cmdGet.addPosArg("filepath");
+    cmdGet.addPosArg("offset", "0");
+
+    Command cmdPut = cmd.addCommand("put", putCallback);
+    cmdPut.addPosArg("filepath");
+    cmdPut.addPosArg("size");
+    cmdPut.addFlagArg("resume");
+
     Command cmdRename = cmd.addCommand("rename", renameCallback);
     cmdRename.addPosArg("filepath");
     cmdRename.addPosArg("newName");
@@ -424,6 +552,9 @@ void createStorageCommand(SimpleCLI *cli) {
     Command cmdCrc32 = cmd.addCommand("crc32", crc32Callback);
     cmdCrc32.addPosArg("filepath");
 
+    Command cmdSha256 = cmd.addCommand("sha256", sha256Callback);
+    cmdSha256.addPosArg("filepath");
+
     Command cmdStat = cmd.addCommand("stat", statCallback);
     cmdStat.addPosArg("filepath");
 
@@ -441,6 +572,7 @@ void createStorageCommands(SimpleCLI *cli) {
 
     createMd5Command(cli);
     createCrc32Command(cli);
+    createSha256Command(cli);
 
     createStorageCommand(cli);
 }
@@ -150,7 +150,7 @@ uint32_t helpCallback(cmd *c) {
         "  wifi on  (Connects to a known Wifi network. if there's no known network, starts in AP Mode)"
     );
     serialDevice->println("  wifi add \"SSID\" \"Password\" (adds a network to the list)");
-    serialDevice->println("  arp - Starts Scan Hosts ARP Scanner");
+    serialDevice->println("  arp [wifi|eth] [rate] [retries] - Sweeps the subnet with ARP requests");
     serialDevice->println("  listen   - Starts listening TCP default port");
     serialDevice->println("  sniffer - Starts Raw Sniffer");
     serialDevice->println("\nWebUI Commands:");
@@ -1,8 +1,11 @@
 #include "wifi_commands.h"
+#include "core/oui_db.h"
+#include "core/serialcmds.h"
 #include "core/wifi/webInterface.h"
 #include "core/wifi/wifi_common.h" //to return MAC addr
 #include <globals.h>
 #include <modules/ethernet/ARPScanner.h>
+#include <modules/ethernet/arp_sweep.h>
 #include "esp_netif.h"          
 #include "esp_netif_net_stack.h"
 #include "modules/wifi/tcp_utils.h"
@@ -65,19 +68,62 @@ uint32_t webuiCallback(cmd *c) {
 }
 
 uint32_t scanHostsCallback(cmd *c) {
-    esp_netif_t *esp_netinterface =
-      esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-      if (esp_netinterface == nullptr) {
-          Serial.println("Failed to get netif handle\nTry connecting to a network first");
-          return false;
-      }
+    Command cmd(c);
+    String iface = cmd.getArgument("iface").getValue();
+    iface.trim();
 
-    ARPScanner{esp_netinterface};
+    esp_netif_t *esp_netinterface = ArpSweep::interfaceByName(iface);
+    if (esp_netinterface == nullptr) {
+        serialDevice->println("Interface " + iface + " is not up\nTry connecting to a network first");
+        return false;
+    }
 
+    ArpSweepConfig config;
+    config.rate = cmd.getArgument("rate").getValue().toInt();
+    config.retries = cmd.getArgument("retries").getValue().toInt();
+
+    // hosts are printed as their replies arrive
+    ArpSweep sweep(esp_netinterface);
+    uint8_t lastPass = 0;
+    bool started = sweep.run(
+        config,
+        [](const ArpHost &host) {
+            String ip = IPAddress(host.ip).toString();
+            String mac = macToString(host.mac);
+            serialDevice->printf("%-15s %s %s\n", ip.c_str(), mac.c_str(), ouiDb.lookup(host.mac).c_str());
+        },
+        [&](const ArpSweepStatus &status) {
+            if (status.pass != lastPass) {
+                lastPass = status.pass;
+                serialDevice->printf(
+                    "retry %u: %lu hosts left\n", status.pass, (unsigned long)status.pending
+                );
+            }
+            return !check(EscPress);
+        }
+    );
+    if (!started) {
+        serialDevice->printf("ARP sweep failed: %s\n", sweep.error());
+        return false;
+    }
+    serialDevice->printf(
+        "%lu hosts in %lu ms\n", (unsigned long)sweep.count(), (unsigned long)sweep.elapsedMs()
+    );
     return true;
 }
 
 uint32_t snifferCallback(cmd *c) {
+    Command cmd(c);
+    Argument actionArg = cmd.getArgument("action");
+    String action = actionArg.getValue();
+    action.trim();
+
+    if (action == "stats") {
+        // read-only, a capture running on screen keeps going
+        serialCmdKeepScreen();
+        serialDevice->println(sniffer_stats_report());
+        return true;
+    }
     sniffer_setup();
 
     return true;
@@ -113,10 +159,14 @@ void createWifiCommands(SimpleCLI *cli) {
     #if !defined(LITE_VERSION)
 
     Command ScanHostsCmd = cli->addCommand("arp", scanHostsCallback);
+    ScanHostsCmd.addPosArg("iface", "wifi"); // wifi or eth
+    ScanHostsCmd.addPosArg("rate", String(ARP_SWEEP_RATE).c_str());
+    ScanHostsCmd.addPosArg("retries", String(ARP_SWEEP_RETRIES).c_str());
 
     Command listenTCPCmd = cli->addCommand("listen", listenTCPCallback); //TODO: make possible to select port to open via Serial
     
     Command snifferCmd = cli->addCommand("sniffer", snifferCallback); //TODO: be able to exit from it from Serial
+    snifferCmd.addPosArg("action", "start"); // "sniffer stats" prints the capture counters
     
     #endif
     //Command responderCmd = cli->addCommand("responder", responderCallback); TODO
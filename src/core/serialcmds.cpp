@@ -8,6 +8,9 @@
 QueueHandle_t cmdQueue = nullptr;
 QueueHandle_t rspQueue = nullptr;
 TaskHandle_t serialcmdsTaskHandle;
+static bool keepScreen = false;
+
+void serialCmdKeepScreen() { keepScreen = true; }
 
 struct CmdPacket {
     char text[SAFE_STACK_BUFFER_SIZE];
@@ -48,9 +51,10 @@ void handleSerialCommands(SerialCli &serialCli) {
 
     String cmd_str = serialDevice->readStringUntil('\n');
     Serial.println("COMMAND: " + cmd_str);
+    keepScreen = false;
     serialCli.parse(cmd_str);
     serialDevice->print("# "); // prompt
-    backToMenu();              // forced menu redrawn
+    if (!keepScreen) backToMenu(); // forced menu redrawn
 }
 
 void _serialCmdsTaskLoop(void *pvParameters) {
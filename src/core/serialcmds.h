@@ -8,4 +8,7 @@ extern TaskHandle_t serialcmdsTaskHandle;
 void startSerialCommandsHandlerTask();
 
 bool parseSerialCommand(const String &command, bool waitForResponse = true);
+
+// Called by a read-only command: the screen it ran over is kept instead of going back to the menu
+void serialCmdKeepScreen();
 #endif
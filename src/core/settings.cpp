@@ -160,6 +160,7 @@ void setBrightnessMenu() {
 **  Turn screen off and reduces cpu clock
 **********************************************************************/
 void setSleepMode() {
+    bruceConfig.commit();
     sleepModeOn();
     while (1) {
         if (check(AnyKeyPress)) {
@@ -1,5 +1,9 @@
 #include <globals.h>
 #include <tftLogger.h>
+#if defined(HAS_SCREEN) && TFT_COMPOSITE_DMA
+#include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#endif
 
 /*
 AUXILIARY FUNCTIONS TO CREATE THE JSONS
@@ -44,23 +48,9 @@ void tft_logger::asyncSerialTaskFunc(void *pv) {
     tftLog item;
     while (logger->async_serial || uxQueueMessagesWaiting(logger->asyncSerialQueue) > 0) {
         if (xQueueReceive(logger->asyncSerialQueue, &item, pdMS_TO_TICKS(100))) {
-            uint8_t *entry = item.data;
-            uint8_t fn = entry[2];
-            if (fn == DRAWIMAGE) {
-                uint8_t imageSlot = entry[12];
-                const char *imgPath = logger->images[imageSlot];
-                size_t baseLen = 12; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS
-                size_t imgLen = strlen(imgPath);
-                uint8_t packet[MAX_LOG_SIZE];
-                memcpy(packet, entry, baseLen);
-                if (imgLen > MAX_LOG_SIZE - baseLen) imgLen = MAX_LOG_SIZE - baseLen;
-                memcpy(packet + baseLen, imgPath, imgLen);
-                packet[1] = baseLen + imgLen;
-                serialDevice->write(packet, baseLen + imgLen);
-            } else {
-                uint8_t size = entry[1];
-                serialDevice->write(entry, size);
-            }
+            uint8_t packet[MAX_LOG_SIZE];
+            size_t size = logger->writeEntry(item, packet);
+            if (size) serialDevice->write(packet, size);
         }
     }
     logger->asyncSerialTask = NULL;
@@ -87,59 +77,150 @@ void tft_logger::stopAsyncSerial() {
     // task will exit on its own and clear handle
 }
 void tft_logger::getTftInfo() {
-    uint8_t buffer[16];
-    uint8_t pos = 0;
-    logWriteHeader(buffer, pos, SCREEN_INFO);
-    writeUint16(buffer, pos, width());
-    writeUint16(buffer, pos, height());
-    buffer[pos++] = rotation;
-    buffer[1] = pos;
     tftLog l;
-    memcpy(l.data, buffer, pos);
+    writeTftInfo(l.data);
     pushLogIfUnique(l);
 }
-void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
-    outSize = 0;
-    // add Screen Info at the beginning of the Bin packet
-    uint8_t buffer[16];
+
+size_t tft_logger::writeTftInfo(uint8_t *out) {
     uint8_t pos = 0;
-    logWriteHeader(buffer, pos, SCREEN_INFO);
-    writeUint16(buffer, pos, width());
-    writeUint16(buffer, pos, height());
-    buffer[pos++] = rotation;
-    buffer[1] = pos;
+    logWriteHeader(out, pos, SCREEN_INFO);
+    writeUint16(out, pos, width());
+    writeUint16(out, pos, height());
+    out[pos++] = rotation;
+    out[1] = pos;
+    return pos;
+}
+
+// Copies a log entry as it is sent to clients, out must hold MAX_LOG_SIZE bytes. 0 for deleted entries
+size_t tft_logger::writeEntry(const tftLog &l, uint8_t *out) {
+    const uint8_t *entry = l.data;
+    if (entry[0] != LOG_PACKET_HEADER) return 0;
+    if (entry[2] != DRAWIMAGE) {
+        memcpy(out, entry, entry[1]);
+        return entry[1];
+    }
+    // AA SS FN XX XX YY YY Ce Ce Ms Ms FS SLOT, the slot is replaced by the image path
+    // 0  1  2  3  4  5  6  7  8  9  10 11 12
+    const char *imgPath = images[entry[12]];
+    size_t baseLen = 12;
+    size_t imgLen = strlen(imgPath);
+    if (imgLen > MAX_LOG_SIZE - baseLen) imgLen = MAX_LOG_SIZE - baseLen;
+    memcpy(out, entry, baseLen);
+    memcpy(out + baseLen, imgPath, imgLen);
+    out[1] = baseLen + imgLen; // update packet size
+    return baseLen + imgLen;
+}
+
+size_t tft_logger::writeBinLog(uint8_t *outBuffer, size_t maxLen) {
+    // add Screen Info at the beginning of the Bin packet
+    size_t outSize = writeTftInfo(outBuffer);
+    uint8_t entry[MAX_LOG_SIZE];
+    for (int i = 0; i < logCount; i++) {
+        size_t size = writeEntry(log[i], entry);
+        if (size == 0 || outSize + size > maxLen) continue;
+        memcpy(outBuffer + outSize, entry, size);
+        outSize += size;
+    }
+    return outSize;
+}
 
-    memcpy(outBuffer + outSize, buffer, pos);
-    outSize += pos;
+void tft_logger::getBinLog(uint8_t *outBuffer, size_t &outSize) {
+    outSize = writeBinLog(outBuffer, MAX_LOG_SIZE * MAX_LOG_ENTRIES);
+}
 
+void tft_logger::getBinLog(Print &out) {
+    uint8_t entry[MAX_LOG_SIZE];
+    out.write(entry, writeTftInfo(entry));
     for (int i = 0; i < logCount; i++) {
-        if (log[i].data[0] != LOG_PACKET_HEADER) continue;
-        uint8_t *entry = log[i].data;
-        uint8_t fn = entry[2];
-
-        if (fn == DRAWIMAGE) {
-            uint8_t imageSlot = entry[12]; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS SLOT
-                                           // 0  1  2  3  4  5  6  7  8  9  10 11 12
-            const char *imgPath = images[imageSlot];
-            size_t baseLen = 12; // AA SS FN XX XX YY YY Ce Ce Ms Ms FS + PATH
-            size_t imgLen = strlen(imgPath);
-            if (outSize + baseLen + imgLen > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
-
-            memcpy(outBuffer + outSize, entry, baseLen);
-            outSize += baseLen;
-            memcpy(outBuffer + outSize, imgPath, imgLen);
-            outSize += imgLen;
-
-            outBuffer[outSize - imgLen - baseLen + 1] = baseLen + imgLen; // update packet size
-        } else {
-            uint8_t size = entry[1];
-            if (outSize + size > MAX_LOG_SIZE * MAX_LOG_ENTRIES) continue;
-            memcpy(outBuffer + outSize, entry, size);
-            outSize += size;
+        size_t size = writeEntry(log[i], entry);
+        if (size) out.write(entry, size);
+    }
+}
+
+size_t tft_logger::getKeyframe(uint8_t *outBuffer, size_t maxLen) {
+    if (maxLen < TFT_MIRROR_HEADER_SIZE + MAX_LOG_SIZE) return 0;
+    const uint32_t seq = logSeq;
+    outBuffer[0] = TFT_MIRROR_HEADER;
+    outBuffer[1] = TFT_MIRROR_KEYFRAME;
+    for (int i = 0; i < 4; i++) outBuffer[2 + i] = outBuffer[6 + i] = seq >> (24 - 8 * i);
+    return TFT_MIRROR_HEADER_SIZE +
+           writeBinLog(outBuffer + TFT_MIRROR_HEADER_SIZE, maxLen - TFT_MIRROR_HEADER_SIZE);
+}
+
+void tft_logger::mirrorEntry(const tftLog &l) {
+    const uint32_t seq = ++logSeq;
+    if (!mirroring || !mirrorQueue) return;
+    tftMirrorItem item;
+    item.seq = seq;
+    item.keyframe = mirrorKeyframe;
+    memcpy(item.log.data, l.data, l.data[1]);
+    mirrorKeyframe = false;
+    // a full queue leaves a gap in the sequence, clients ask for a keyframe then
+    xQueueSend(mirrorQueue, &item, 0);
+}
+
+void tft_logger::mirrorTaskFunc(void *pv) {
+    tft_logger *logger = static_cast<tft_logger *>(pv);
+    uint8_t packet[TFT_MIRROR_PACKET_SIZE];
+    size_t len = 0;
+    uint32_t first = 0;
+    uint32_t last = 0;
+    tftMirrorItem item;
+
+    auto flush = [&]() {
+        if (len == 0) return;
+        for (int i = 0; i < 4; i++) {
+            packet[2 + i] = first >> (24 - 8 * i);
+            packet[6 + i] = last >> (24 - 8 * i);
         }
+        logger->mirrorSink(packet, len);
+        len = 0;
+    };
+
+    while (logger->mirroring) {
+        if (!xQueueReceive(logger->mirrorQueue, &item, pdMS_TO_TICKS(100))) continue;
+        vTaskDelay(pdMS_TO_TICKS(TFT_MIRROR_BATCH_MS));
+        do {
+            if (item.keyframe || len + MAX_LOG_SIZE > sizeof(packet)) flush();
+            if (len == 0) {
+                packet[0] = TFT_MIRROR_HEADER;
+                packet[1] = item.keyframe ? TFT_MIRROR_KEYFRAME : 0;
+                len = TFT_MIRROR_HEADER_SIZE;
+                if (item.keyframe) len += logger->writeTftInfo(packet + len);
+                first = item.seq;
+            }
+            len += logger->writeEntry(item.log, packet + len);
+            last = item.seq;
+        } while (xQueueReceive(logger->mirrorQueue, &item, 0));
+        flush();
+    }
+    vQueueDelete(logger->mirrorQueue);
+    logger->mirrorQueue = NULL;
+    logger->mirrorTask = NULL;
+    vTaskDelete(NULL);
+}
+
+void tft_logger::startMirror(tftMirrorSink sink) {
+    if (mirroring || !sink) return;
+    mirrorSink = sink;
+    mirrorQueue = xQueueCreate(TFT_MIRROR_QUEUE, sizeof(tftMirrorItem));
+    if (!mirrorQueue) return;
+    mirroring = true;
+    if (xTaskCreate(mirrorTaskFunc, "tft_mirror", 4096, this, 1, &mirrorTask) != pdPASS) {
+        mirroring = false;
+        vQueueDelete(mirrorQueue);
+        mirrorQueue = NULL;
     }
 }
 
+void tft_logger::stopMirror() {
+    if (!mirroring) return;
+    mirroring = false;
+    // wait for the task, the sink may be gone after this returns
+    while (mirrorTask) vTaskDelay(pdMS_TO_TICKS(10));
+}
+
 void tft_logger::restoreLogger() {
     if (_logging) logging = true;
 }
@@ -152,6 +233,8 @@ bool tft_logger::isLogEqual(const tftLog &a, const tftLog &b) {
 }
 
 void tft_logger::pushLogIfUnique(const tftLog &l) {
+    // the mirror gets every entry, redrawing something already logged still changes the screen
+    mirrorEntry(l);
     for (int i = 0; i < logCount; i++) {
         if (isLogEqual(log[i], l)) {
             return; // Entry already exists
@@ -202,10 +285,12 @@ void tft_logger::removeOverlappedImages(int x, int y, int center, int ms) {
 void tft_logger::fillScreen(int32_t color) {
     if (logging) {
         clearLog();
+        mirrorKeyframe = true;
         checkAndLog(FILLSCREEN, color);
     }
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillScreen(color);
+    canvas(0, 0, width(), height()).fillScreen(color);
+    present();
 }
 
 void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center, int Ms) {
@@ -263,14 +348,16 @@ void tft_logger::imageToBin(uint8_t fs, String file, int x, int y, bool center,
 void tft_logger::drawLine(int32_t x, int32_t y, int32_t x1, int32_t y1, int32_t color) {
     if (logging) checkAndLog(DRAWLINE, x, y, x1, y1, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawLine(x, y, x1, y1, color);
+    canvas(min(x, x1), min(y, y1), abs(x1 - x) + 1, abs(y1 - y) + 1).drawLine(x, y, x1, y1, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t color) {
     if (logging) checkAndLog(DRAWRECT, x, y, w, h, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawRect(x, y, w, h, color);
+    canvas(x, y, w, h).drawRect(x, y, w, h, color);
+    present();
     restoreLogger();
 }
 
@@ -280,14 +367,16 @@ void tft_logger::fillRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t co
         checkAndLog(FILLRECT, x, y, w, h, color);
     }
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillRect(x, y, w, h, color);
+    canvas(x, y, w, h).fillRect(x, y, w, h, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, int32_t color) {
     if (logging) checkAndLog(DRAWROUNDRECT, x, y, w, h, r, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawRoundRect(x, y, w, h, r, color);
+    canvas(x, y, w, h).drawRoundRect(x, y, w, h, r, color);
+    present();
     restoreLogger();
 }
 
@@ -297,35 +386,40 @@ void tft_logger::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32
         checkAndLog(FILLROUNDRECT, x, y, w, h, r, color);
     }
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillRoundRect(x, y, w, h, r, color);
+    canvas(x, y, w, h).fillRoundRect(x, y, w, h, r, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawCircle(int32_t x, int32_t y, int32_t r, int32_t color) {
     if (logging) checkAndLog(DRAWCIRCLE, x, y, r, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawCircle(x, y, r, color);
+    canvas(x - r, y - r, 2 * r + 1, 2 * r + 1).drawCircle(x, y, r, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::fillCircle(int32_t x, int32_t y, int32_t r, int32_t color) {
     if (logging) checkAndLog(FILLCIRCLE, x, y, r, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillCircle(x, y, r, color);
+    canvas(x - r, y - r, 2 * r + 1, 2 * r + 1).fillCircle(x, y, r, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawEllipse(int16_t x, int16_t y, int32_t rx, int32_t ry, uint16_t color) {
     if (logging) checkAndLog(DRAWELIPSE, x, y, rx, ry, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawEllipse(x, y, rx, ry, color);
+    canvas(x - rx, y - ry, 2 * rx + 1, 2 * ry + 1).drawEllipse(x, y, rx, ry, color);
+    present();
     restoreLogger();
 }
 
 void tft_logger::fillEllipse(int16_t x, int16_t y, int32_t rx, int32_t ry, uint16_t color) {
     if (logging) checkAndLog(FILLELIPSE, x, y, rx, ry, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillEllipse(x, y, rx, ry, color);
+    canvas(x - rx, y - ry, 2 * rx + 1, 2 * ry + 1).fillEllipse(x, y, rx, ry, color);
+    present();
     restoreLogger();
 }
 
@@ -334,7 +428,10 @@ void tft_logger::drawTriangle(
 ) {
     if (logging) checkAndLog(DRAWTRIAGLE, x1, y1, x2, y2, x3, y3, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawTriangle(x1, y1, x2, y2, x3, y3, color);
+    int32_t tx = min(x1, min(x2, x3)), ty = min(y1, min(y2, y3));
+    canvas(tx, ty, max(x1, max(x2, x3)) - tx + 1, max(y1, max(y2, y3)) - ty + 1)
+        .drawTriangle(x1, y1, x2, y2, x3, y3, color);
+    present();
     restoreLogger();
 }
 
@@ -343,7 +440,10 @@ void tft_logger::fillTriangle(
 ) {
     if (logging) checkAndLog(FILLTRIANGLE, x1, y1, x2, y2, x3, y3, color);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::fillTriangle(x1, y1, x2, y2, x3, y3, color);
+    int32_t tx = min(x1, min(x2, x3)), ty = min(y1, min(y2, y3));
+    canvas(tx, ty, max(x1, max(x2, x3)) - tx + 1, max(y1, max(y2, y3)) - ty + 1)
+        .fillTriangle(x1, y1, x2, y2, x3, y3, color);
+    present();
     restoreLogger();
 }
 void tft_logger::drawArc(
@@ -355,7 +455,9 @@ void tft_logger::drawArc(
             DRAWARC, x, y, r, ir, (int32_t)startAngle, (int32_t)endAngle, (int32_t)fg_color, (int32_t)bg_color
         );
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawArc(x, y, r, ir, startAngle, endAngle, fg_color, bg_color, smoothArc);
+    canvas(x - r, y - r, 2 * r + 1, 2 * r + 1)
+        .drawArc(x, y, r, ir, startAngle, endAngle, fg_color, bg_color, smoothArc);
+    present();
     restoreLogger();
 }
 
@@ -365,21 +467,25 @@ void tft_logger::drawWideLine(float ax, float ay, float bx, float by, float wd,
             DRAWWIDELINE, (uint16_t)ax, (uint16_t)ay, (uint16_t)bx, (uint16_t)by, (uint16_t)wd, fg, bg
         );
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawWideLine(ax, ay, bx, by, wd, fg, bg);
+    canvas(min(ax, bx) - wd, min(ay, by) - wd, fabsf(bx - ax) + 2 * wd + 2, fabsf(by - ay) + 2 * wd + 2)
+        .drawWideLine(ax, ay, bx, by, wd, fg, bg);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawFastVLine(int32_t x, int32_t y, int32_t h, int32_t fg) {
     if (logging) checkAndLog(DRAWFASTVLINE, x, y, h, fg);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawFastVLine(x, y, h, fg);
+    canvas(x, y, 1, h).drawFastVLine(x, y, h, fg);
+    present();
     restoreLogger();
 }
 
 void tft_logger::drawFastHLine(int32_t x, int32_t y, int32_t w, int32_t fg) {
     if (logging) checkAndLog(DRAWFASTHLINE, x, y, w, fg);
     if (isSleeping) return;
-    BRUCE_TFT_DRIVER::drawFastHLine(x, y, w, fg);
+    canvas(x, y, w, 1).drawFastHLine(x, y, w, fg);
+    present();
     restoreLogger();
 }
 
@@ -418,7 +524,11 @@ int16_t tft_logger::drawString(const String &string, int32_t x, int32_t y, uint8
     log_drawString(string, DRAWSTRING, x, y);
     int16_t r;
     if (isSleeping) return string.length();
-    r = BRUCE_TFT_DRIVER::drawString(string, x, y, font);
+#ifdef HAS_SCREEN
+    if (frame) r = composeString(string, x, y, font, textdatum);
+    else
+#endif
+        r = BRUCE_TFT_DRIVER::drawString(string, x, y, font);
     restoreLogger();
     return r;
 }
@@ -427,7 +537,11 @@ int16_t tft_logger::drawCentreString(const String &string, int32_t x, int32_t y,
     log_drawString(string, DRAWCENTRESTRING, x, y);
     int16_t r;
     if (isSleeping) return string.length();
-    r = BRUCE_TFT_DRIVER::drawCentreString(string, x, y, font);
+#ifdef HAS_SCREEN
+    if (frame) r = composeString(string, x, y, font, TC_DATUM);
+    else
+#endif
+        r = BRUCE_TFT_DRIVER::drawCentreString(string, x, y, font);
     restoreLogger();
     return r;
 }
@@ -436,7 +550,11 @@ int16_t tft_logger::drawRightString(const String &string, int32_t x, int32_t y,
     log_drawString(string, DRAWRIGHTSTRING, x, y);
     int16_t r;
     if (isSleeping) return string.length();
-    r = BRUCE_TFT_DRIVER::drawRightString(string, x, y, font);
+#ifdef HAS_SCREEN
+    if (frame) r = composeString(string, x, y, font, TR_DATUM);
+    else
+#endif
+        r = BRUCE_TFT_DRIVER::drawRightString(string, x, y, font);
     restoreLogger();
     return r;
 }
@@ -484,6 +602,9 @@ size_t tft_logger::print(const String &s) {
 
         log_print(chunk);
         if (isSleeping) totalPrinted += chunk.length();
+#ifdef HAS_SCREEN
+        else if (frame) totalPrinted += composePrint(chunk);
+#endif
         else totalPrinted += BRUCE_TFT_DRIVER::print(chunk);
 
         offset += chunkSize;
@@ -541,3 +662,321 @@ size_t tft_logger::printf(const char *format, ...) {
     va_end(args);
     return print(String(buf));
 }
+
+/* COMPOSITED RENDERING */
+BRUCE_TFT_DRIVER &tft_logger::canvas(int32_t x, int32_t y, int32_t w, int32_t h) {
+#ifdef HAS_SCREEN
+    if (frame) {
+        addDamage(x, y, w, h);
+        return *frame;
+    }
+#endif
+    return *this;
+}
+
+void tft_logger::present() {
+#ifdef HAS_SCREEN
+    if (frame && frameDepth == 0) pushDamage();
+#endif
+}
+
+void tft_logger::beginFrame(void) { ++frameDepth; }
+
+void tft_logger::endFrame(void) {
+    if (frameDepth == 0) return;
+    if (--frameDepth == 0) present();
+}
+
+bool tft_logger::getCompositing(void) {
+#ifdef HAS_SCREEN
+    return frame != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool tft_logger::setCompositing(bool enable) {
+#ifdef HAS_SCREEN
+    if (enable == (frame != nullptr)) return true;
+    if (!enable) {
+        pushDamage();
+        frame->deleteSprite();
+        delete frame;
+        frame = nullptr;
+        free(dmaBands);
+        dmaBands = nullptr;
+        return true;
+    }
+    if (!createFrame()) return false;
+#if TFT_COMPOSITE_DMA && !defined(TFT_PARALLEL_8_BIT) && !defined(TFT_PARALLEL_16_BIT)
+    if (!DMA_Enabled && !initDMA()) log_w("TFT DMA not available, pushing frames by CPU");
+    if (DMA_Enabled && esp_ptr_external_ram(frame->getPointer())) {
+        // PSRAM is not a valid DMA source on every target (classic ESP32), bands are copied
+        // to internal RAM first. Sized for the longest side, so rotations don't reallocate.
+        dmaBandSize = max(width(), height()) * TFT_COMPOSITE_DMA_ROWS;
+        dmaBands = (uint16_t *)heap_caps_malloc(
+            2 * dmaBandSize * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL
+        );
+        if (!dmaBands) log_w("No internal RAM for the TFT DMA bands, pushing frames by CPU");
+    }
+#endif
+    statsFrames = statsBytes = 0;
+    statsStart = millis();
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+void tft_logger::getFrameStats(float &fps, uint32_t &bytesPerFrame) {
+    fps = 0;
+    bytesPerFrame = 0;
+#ifdef HAS_SCREEN
+    uint32_t elapsed = millis() - statsStart;
+    if (elapsed > 0) fps = statsFrames * 1000.0f / elapsed;
+    if (statsFrames > 0) bytesPerFrame = statsBytes / statsFrames;
+    statsFrames = statsBytes = 0;
+    statsStart = millis();
+#endif
+}
+
+#ifdef HAS_SCREEN
+void tft_logger::setRotation(uint8_t r) {
+    BRUCE_TFT_DRIVER::setRotation(r);
+    if (frame && (frame->width() != width() || frame->height() != height())) {
+        // the framebuffer must match the new orientation
+        frame->deleteSprite();
+        damageCount = 0;
+        if (!createFrame()) {
+            delete frame;
+            frame = nullptr;
+        }
+    }
+}
+
+void tft_logger::drawPixel(int32_t x, int32_t y, uint32_t color) {
+    if (isSleeping) return;
+    // virtual, TFT_eSPI draws through it too: never call it on canvas()
+    if (!frame) return BRUCE_TFT_DRIVER::drawPixel(x, y, color);
+    addDamage(x, y, 1, 1);
+    frame->drawPixel(x, y, color);
+    present();
+}
+
+void tft_logger::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *data) {
+    if (isSleeping) return;
+    if (!frame) return BRUCE_TFT_DRIVER::pushImage(x, y, w, h, data);
+    // images, decoded icons included, use the same byte order as on the panel
+    frame->setSwapBytes(getSwapBytes());
+    addDamage(x, y, w, h);
+    frame->pushImage(x, y, w, h, data);
+    present();
+}
+
+void tft_logger::pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *data) {
+    if (isSleeping) return;
+    if (!frame) return BRUCE_TFT_DRIVER::pushImage(x, y, w, h, data);
+    frame->setSwapBytes(getSwapBytes());
+    addDamage(x, y, w, h);
+    frame->pushImage(x, y, w, h, data);
+    present();
+}
+
+void tft_logger::drawXBitmap(
+    int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color
+) {
+    if (isSleeping) return;
+    // one damage area for the bitmap instead of one per pixel
+    canvas(x, y, w, h).drawXBitmap(x, y, bitmap, w, h, color);
+    present();
+}
+
+void tft_logger::drawXBitmap(
+    int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color, uint16_t bgcolor
+) {
+    if (isSleeping) return;
+    canvas(x, y, w, h).drawXBitmap(x, y, bitmap, w, h, color, bgcolor);
+    present();
+}
+
+void tft_logger::pushSprite(TFT_eSprite &sprite, int32_t x, int32_t y) {
+    if (isSleeping) return;
+    // the framebuffer takes 16 bit sprites only, others still go to the panel
+    if (!frame || sprite.getColorDepth() != 16) return sprite.pushSprite(x, y);
+    addDamage(x, y, sprite.width(), sprite.height());
+    sprite.pushToSprite(frame, x, y);
+    present();
+}
+
+bool tft_logger::createFrame() {
+    if (!frame) frame = new TFT_eSprite(this);
+    frame->setColorDepth(16);
+    // uses PSRAM when the board has it
+    if (!frame->createSprite(width(), height())) {
+        log_e("Not enough memory for a %dx%d framebuffer, compositing disabled", width(), height());
+        delete frame;
+        frame = nullptr;
+        return false;
+    }
+    // the panel content is unknown, start from a cleared screen
+    frame->fillSprite(TFT_BLACK);
+    addDamage(0, 0, width(), height());
+    return true;
+}
+
+static bool touchesRect(const tftRect &a, const tftRect &b) {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+static tftRect uniteRect(const tftRect &a, const tftRect &b) {
+    int32_t x = min(a.x, b.x), y = min(a.y, b.y);
+    return {x, y, max(a.x + a.w, b.x + b.w) - x, max(a.y + a.h, b.y + b.h) - y};
+}
+
+void tft_logger::addDamage(int32_t x, int32_t y, int32_t w, int32_t h) {
+    const int32_t fw = frame->width(), fh = frame->height();
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > fw) w = fw - x;
+    if (y + h > fh) h = fh - y;
+    if (w <= 0 || h <= 0) return;
+
+    tftRect r = {x, y, w, h};
+    // Merge with every touching area, so pushed areas never overlap
+    for (uint8_t i = 0; i < damageCount;) {
+        if (touchesRect(damage[i], r)) {
+            r = uniteRect(damage[i], r);
+            damage[i] = damage[--damageCount];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (damageCount == TFT_MAX_DAMAGE_RECTS) {
+        // list is full, grow the area that gets the smallest extra surface
+        uint8_t best = 0;
+        int32_t bestCost = INT32_MAX;
+        for (uint8_t i = 0; i < damageCount; i++) {
+            tftRect u = uniteRect(damage[i], r);
+            int32_t cost = u.w * u.h - damage[i].w * damage[i].h;
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = i;
+            }
+        }
+        r = uniteRect(damage[best], r);
+        damage[best] = damage[--damageCount];
+    }
+    damage[damageCount++] = r;
+}
+
+void tft_logger::addTextDamage(int32_t x, int32_t y, int32_t w, int32_t h, uint8_t datum) {
+    // horizontal alignment is datum % 3, vertical is datum / 3 (top, middle, bottom, baseline)
+    if (datum % 3 == 1) x -= w / 2;
+    else if (datum % 3 == 2) x -= w;
+    switch (datum / 3) {
+        case 1: y -= h / 2; break;
+        case 2: y -= h; break;
+        case 3:
+            y -= h;
+            h *= 2; // descenders go below the baseline
+            break;
+    }
+    addDamage(x - 1, y - 1, w + 2, h + 2);
+}
+
+void tft_logger::syncTextState() {
+    frame->setTextColor(textcolor, textbgcolor, _fillbg);
+    frame->setTextFont(textfont);
+#ifdef LOAD_GFXFF
+    if (gfxFont) frame->setFreeFont(gfxFont);
+#endif
+    frame->setTextSize(textsize);
+    frame->setTextDatum(textdatum);
+    frame->setTextPadding(padX);
+    frame->setTextWrap(textwrapX, textwrapY);
+    frame->setCursor(cursor_x, cursor_y);
+}
+
+size_t tft_logger::composePrint(const String &s) {
+    syncTextState();
+    const int32_t x0 = cursor_x;
+    int32_t y0 = cursor_y;
+    size_t n = frame->print(s);
+    int32_t h = frame->fontHeight();
+#ifdef LOAD_GFXFF
+    if (gfxFont) y0 -= h; // free fonts print above the cursor baseline
+#endif
+    if (frame->cursor_y == cursor_y) addDamage(x0, y0, frame->cursor_x - x0, h);
+    else addDamage(0, y0, frame->width(), frame->cursor_y - y0 + h); // wrapped or new line
+    cursor_x = frame->cursor_x;
+    cursor_y = frame->cursor_y;
+    present();
+    return n;
+}
+
+int16_t tft_logger::composeString(const String &string, int32_t x, int32_t y, uint8_t font, uint8_t datum) {
+    syncTextState();
+    frame->setTextDatum(datum);
+    int16_t w = frame->drawString(string, x, y, font);
+    addTextDamage(x, y, max((int32_t)w, padX), frame->fontHeight(font), datum);
+    present();
+    return w;
+}
+
+/***************************************************************************************
+** Function name: pushDamage
+** Description:   Sends the damaged areas of the framebuffer to the panel
+***************************************************************************************/
+void tft_logger::pushDamage() {
+    if (damageCount == 0) return;
+
+    uint16_t *fb = (uint16_t *)frame->getPointer();
+    const int32_t fw = frame->width();
+    uint32_t bytes = 0;
+    // sprite pixels are already stored in the panel byte order
+    bool swap = getSwapBytes();
+    setSwapBytes(false);
+    startWrite();
+    for (uint8_t i = 0; i < damageCount; i++) {
+        tftRect r = damage[i];
+#if TFT_COMPOSITE_DMA && !defined(TFT_PARALLEL_8_BIT) && !defined(TFT_PARALLEL_16_BIT)
+        if (DMA_Enabled && (dmaBands || !esp_ptr_external_ram(fb))) {
+            // whole rows are contiguous in the framebuffer, a band goes out in few transfers
+            int32_t rows = dmaBands ? TFT_COMPOSITE_DMA_ROWS : 32767 / fw;
+            uint8_t band = 0;
+            for (int32_t y = r.y; y < r.y + r.h; y += rows) {
+                int32_t h = min(rows, r.y + r.h - y);
+                uint16_t *src = fb + y * fw;
+                if (dmaBands) {
+                    // filled while the other band is still being sent
+                    src = dmaBands + band * dmaBandSize;
+                    band ^= 1;
+                    memcpy(src, fb + y * fw, fw * h * sizeof(uint16_t));
+                }
+                dmaWait(); // the window can't change while the previous band is sent
+                setAddrWindow(0, y, fw, h);
+                pushPixelsDMA(src, fw * h);
+                bytes += fw * h * 2;
+            }
+            continue;
+        }
+#endif
+        setAddrWindow(r.x, r.y, r.w, r.h);
+        for (int32_t y = r.y; y < r.y + r.h; y++) pushPixels(fb + y * fw + r.x, r.w);
+        bytes += r.w * r.h * 2;
+    }
+    endWrite(); // also waits for the DMA to finish
+    setSwapBytes(swap);
+
+    damageCount = 0;
+    statsFrames++;
+    statsBytes += bytes;
+}
+#endif
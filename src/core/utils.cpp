@@ -90,6 +90,15 @@ void showDeviceInfo() {
     area.addLine("LittleFS total: " + String(LittleFS.totalBytes()));
     area.addLine("LittleFS used: " + String(LittleFS.usedBytes()));
     area.addLine("LittleFS free: " + String(LittleFS.totalBytes() - LittleFS.usedBytes()));
+    area.addLine("Config writes: " + String(bruceConfig.flushCount()));
+    area.addLine("Config saves coalesced: " + String(bruceConfig.savesCoalesced()));
+    if (tft.getCompositing()) {
+        float fps;
+        uint32_t bytesPerFrame;
+        tft.getFrameStats(fps, bytesPerFrame);
+        area.addLine("Screen frames/s: " + String(fps, 1));
+        area.addLine("Screen bytes/frame: " + String(bytesPerFrame));
+    }
     area.addLine("MAC addr: " + String(WiFi.macAddress()));
     area.addLine("");
 
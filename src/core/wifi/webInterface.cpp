@@ -1,17 +1,22 @@
 #include "webInterface.h"
+#include "core/digest.h"
 #include "core/display.h"    // using displayRedStripe as error msg
 #include "core/mykeyboard.h" // using keyboard when calling rename
 #include "core/passwords.h"
 #include "core/sd_functions.h" // using sd functions called to rename and manage sd files
 #include "core/serialcmds.h"
+#include "core/dir_reader.h"
 #include "core/settings.h"
 #include "core/utils.h"
 #include "core/wifi/wifi_common.h" // using common wifisetup
 #include "esp_task_wdt.h"
 #include "webFiles.h"
 #include <MD5Builder.h>
+#include <algorithm>
+#include <atomic>
 #include <esp_heap_caps.h>
 #include <globals.h>
+#include <memory>
 
 #if defined(CONFIG_IDF_TARGET_ESP32) && !defined(BOARD_HAS_PSRAM)
 #define MOUNT_SD_CARD setupSdCard()
@@ -21,6 +26,12 @@
 #define UNMOUNT_SD_CARD
 #endif
 
+// Sorted listings keep up to this many entries in memory, the entries past them are
+// listed in directory order
+#ifndef LISTFILES_MAX_SORTED
+#define LISTFILES_MAX_SORTED 1000
+#endif
+
 File uploadFile;
 FS _webFS = LittleFS;
 // WiFi as a Client
@@ -30,6 +41,8 @@ const int default_webserverporthttp = 80;
 IPAddress AP_GATEWAY(172, 0, 0, 1); // Gateway
 
 AsyncWebServer *server = nullptr; // initialise webserver
+static AsyncWebSocket *screenWs = nullptr; // screen mirror, owned by server
+static AsyncWebSocket *spectrumWs = nullptr; // spectrum view, owned by server
 const char *host = "bruce";
 String uploadFolder = "";
 static bool mdnsRunning = false;
@@ -47,12 +60,15 @@ String generateToken(int length = 24) {
 **  Turn off the WebUI
 **********************************************************************/
 void stopWebUi() {
+    tft.stopMirror();
     tft.setLogging(false);
     isWebUIActive = false;
     server->end();
     server->~AsyncWebServer();
     free(server);
     server = nullptr;
+    screenWs = nullptr;
+    spectrumWs = nullptr;
     if (mdnsRunning) {
         MDNS.end();
         mdnsRunning = false;
@@ -95,48 +111,246 @@ String humanReadableSize(uint64_t bytes) {
 }
 
 /**********************************************************************
-**  Function: listFiles
-**  list all of the files, if ishtml=true, return html rather than simple text
+**  Function: formatSize
+**  Same text as humanReadableSize, using integer math on a char buffer
 **********************************************************************/
-String listFiles(FS fs, String folder) {
-    // log_i("Listfiles Start");
-    String returnText = "pa:" + folder + ":0\n";
-    MOUNT_SD_CARD;
-    // Serial.println("Listing files stored on SD");
+static int formatSize(char *buf, size_t len, uint64_t bytes) {
+    static const char *units[] = {"B", "kB", "MB", "GB"};
+    if (bytes < 1024) return snprintf(buf, len, "%u B", (unsigned)bytes);
+    uint8_t unit = 1;
+    uint64_t scale = 1024;
+    while (unit < 3 && bytes >= scale * 1024) {
+        scale *= 1024;
+        unit++;
+    }
+    uint64_t hundredths = bytes * 100 / scale;
+    return snprintf(
+        buf, len, "%u.%02u %s", (unsigned)(hundredths / 100), (unsigned)(hundredths % 100), units[unit]
+    );
+}
 
-    _webFS = fs;
+/**********************************************************************
+**  Class: FileListing
+**  State of a streamed /listfiles response. Lines are written from the
+**  directory straight into the buffers of the chunked response, so heap
+**  use doesn't depend on the folder size. Sorted listings only keep the
+**  entries up to offset + limit, and at most LISTFILES_MAX_SORTED: pages
+**  past that list the remaining entries in directory order.
+**
+**  Format, one entry per line:
+**    pa:<folder>:0     current folder
+**    Fo:<name>:0       folder
+**    Fi:<name>:<size>  file
+**    mo:<offset>:<u>   more entries, offset of the next page, u is 1 when
+**                      that page is past the sorted entries
+**********************************************************************/
+class FileListing {
+public:
+    enum Sort : uint8_t { SORT_NONE, SORT_NAME, SORT_SIZE };
+
+    FileListing(
+        FS &fs, const String &folder, size_t offset, size_t limit, Sort sort, bool desc, bool unmountSd
+    )
+        : _folder(folder), _offset(offset), _limit(limit), _sort(sort), _desc(desc), _unmountSd(unmountSd) {
+        _open = _dir.open(fs, folder);
+        if (_sort != SORT_NONE && _offset >= LISTFILES_MAX_SORTED) {
+            _rest = true;
+        } else if (_sort != SORT_NONE && (_limit == 0 || _offset + _limit > LISTFILES_MAX_SORTED)) {
+            _limit = LISTFILES_MAX_SORTED - _offset;
+        }
+    }
 
-    File root = fs.open(folder);
-    uploadFolder = folder;
+    ~FileListing() {
+        _dir.close();
+        if (_unmountSd) { UNMOUNT_SD_CARD; }
+    }
 
-    while (true) {
+    size_t fill(uint8_t *buffer, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (_linePos == _lineLen && !nextLine()) break;
+            size_t n = min(_lineLen - _linePos, maxLen - written);
+            memcpy(buffer + written, _line + _linePos, n);
+            _linePos += n;
+            written += n;
+        }
+        return written;
+    }
+
+private:
+    struct Entry {
+        String name;
+        uint64_t size;
         bool isDir;
-        String fullPath = root.getNextFileName(&isDir);
-        String nameOnly = fullPath.substring(fullPath.lastIndexOf("/") + 1);
-        if (fullPath == "") { break; }
-        // Serial.printf("Path: %s (isDir: %d)\n", fullPath.c_str(), isDir);
-
-        if (esp_get_free_heap_size() > (String("Fo:" + nameOnly + ":0\n").length()) + 1024) {
-            if (isDir) {
-                // Serial.printf("Directory: %s\n", fullPath.c_str());
-                returnText += "Fo:" + nameOnly + ":0\n";
-            } else {
-                // For files, we need to get the size, so we open the file briefly
-                // Serial.printf("Opening file for size check: %s\n", fullPath.c_str());
-                File file = fs.open(fullPath);
-                // Serial.printf("File size: %llu bytes\n", file.size());
-                if (file) {
-                    returnText += "Fi:" + nameOnly + ":" + humanReadableSize(file.size()) + "\n";
-                    file.close();
-                }
+    };
+
+    DirReader _dir;
+    bool _open = false;
+    String _folder;
+    size_t _offset;
+    size_t _limit;
+    Sort _sort;
+    bool _desc;
+    bool _unmountSd;
+    bool _rest = false; // past the sorted entries, only the ones after _last are listed
+    Entry _last;
+    enum Stage : uint8_t { HEADER, ENTRIES, FOOTER, DONE } _stage = HEADER;
+    size_t _skipped = 0;
+    size_t _sent = 0;
+    bool _more = false;
+    bool _collected = false;
+    std::vector<Entry> _sorted;
+    char _line[DIR_NAME_MAX + 32];
+    size_t _lineLen = 0;
+    size_t _linePos = 0;
+
+    // Folders first, then by the chosen key
+    bool before(const Entry &a, const Entry &b) const {
+        if (a.isDir != b.isDir) return a.isDir;
+        int cmp = 0;
+        if (_sort == SORT_SIZE && a.size != b.size) cmp = a.size < b.size ? -1 : 1;
+        if (cmp == 0) cmp = strcasecmp(a.name.c_str(), b.name.c_str());
+        if (cmp == 0) cmp = strcmp(a.name.c_str(), b.name.c_str()); // a total order, see _rest
+        return _desc ? cmp > 0 : cmp < 0;
+    }
+
+    // Keeps the first keep entries in a max-heap, the worst kept entry on top
+    void collectSorted(size_t keep) {
+        _collected = true;
+        auto cmp = [this](const Entry &a, const Entry &b) { return before(a, b); };
+        DirEntry de;
+        size_t total = 0;
+        while (_open && _dir.next(de)) {
+            total++;
+            Entry e = {de.name, de.size, de.isDir};
+            if (_sorted.size() < keep) {
+                _sorted.push_back(std::move(e));
+                std::push_heap(_sorted.begin(), _sorted.end(), cmp);
+            } else if (before(e, _sorted.front())) {
+                std::pop_heap(_sorted.begin(), _sorted.end(), cmp);
+                _sorted.back() = std::move(e);
+                std::push_heap(_sorted.begin(), _sorted.end(), cmp);
             }
-        } else break;
+            esp_task_wdt_reset();
+        }
+        std::sort_heap(_sorted.begin(), _sorted.end(), cmp);
+        _more = total > keep;
+    }
+
+    // Finds the last sorted entry, then lists what sorts after it from the start of the folder
+    bool startRest() {
+        collectSorted(LISTFILES_MAX_SORTED);
+        bool any = _more && _dir.rewind();
+        if (any) _last = _sorted.back();
+        std::vector<Entry>().swap(_sorted);
+        _more = false;
+        _offset -= LISTFILES_MAX_SORTED;
+        return any;
+    }
+
+    bool isRest(const DirEntry &de) {
+        if (!_rest) return true;
         esp_task_wdt_reset();
+        return before(_last, {de.name, de.size, de.isDir});
     }
-    root.close();
-    UNMOUNT_SD_CARD;
-    // log_i("ListFiles End");
-    return returnText;
+
+    void setEntryLine(const char *name, uint64_t size, bool isDir) {
+        if (isDir) {
+            _lineLen = snprintf(_line, sizeof(_line), "Fo:%s:0\n", name);
+        } else {
+            _lineLen = snprintf(_line, sizeof(_line), "Fi:%s:", name);
+            _lineLen += formatSize(_line + _lineLen, sizeof(_line) - _lineLen - 1, size);
+            _line[_lineLen++] = '\n';
+        }
+        _sent++;
+    }
+
+    bool nextLine() {
+        _linePos = _lineLen = 0;
+        switch (_stage) {
+            case HEADER:
+                _lineLen = snprintf(_line, sizeof(_line), "pa:%s:0\n", _folder.c_str());
+                _stage = ENTRIES;
+                return true;
+            case ENTRIES:
+                if (_sort != SORT_NONE && !_rest) {
+                    if (!_collected) collectSorted(_offset + _limit);
+                    if (_offset + _sent < _sorted.size()) {
+                        const Entry &e = _sorted[_offset + _sent];
+                        setEntryLine(e.name.c_str(), e.size, e.isDir);
+                        return true;
+                    }
+                } else if (_open && (!_rest || _collected || startRest())) {
+                    DirEntry de;
+                    if (_limit > 0 && _sent >= _limit) {
+                        while ((_more = _dir.next(de)) && !isRest(de)) {}
+                    } else {
+                        while (_dir.next(de)) {
+                            if (!isRest(de)) continue;
+                            if (_skipped++ < _offset) continue;
+                            setEntryLine(de.name, de.size, de.isDir);
+                            return true;
+                        }
+                    }
+                }
+                _stage = FOOTER;
+                // fall through
+            case FOOTER:
+                _stage = DONE;
+                if (_more) {
+                    size_t next = _offset + _sent + (_rest ? LISTFILES_MAX_SORTED : 0);
+                    bool unsorted = _sort != SORT_NONE && next >= LISTFILES_MAX_SORTED;
+                    _lineLen = snprintf(_line, sizeof(_line), "mo:%u:%d\n", (unsigned)next, unsorted);
+                    return true;
+                }
+                // fall through
+            case DONE: break;
+        }
+        return false;
+    }
+};
+
+/**********************************************************************
+**  Struct: HashJob
+** /hash request state, filled by hashTask and read by the chunked response
+**********************************************************************/
+struct HashJob {
+    FS *fs;
+    String path;
+    uint8_t algos;
+    bool unmountSd;
+    String result;
+    std::atomic<bool> done{false};
+};
+
+static void hashTask(void *param) {
+    auto *ref = (std::shared_ptr<HashJob> *)param;
+    HashJob &job = **ref;
+    FileDigest digest(job.algos);
+    if (digest.digestFile(*job.fs, job.path)) {
+        String json = "{";
+        for (uint8_t algo = DIGEST_MD5; algo <= DIGEST_SHA256; algo <<= 1) {
+            if (!(job.algos & algo)) continue;
+            json += "\"" + String(FileDigest::name(algo)) + "\":\"" + digest.hex(algo) + "\",";
+        }
+        char tail[96];
+        snprintf(
+            tail,
+            sizeof(tail),
+            "\"bytes\":%llu,\"ms\":%lu,\"mbps\":%.2f}",
+            digest.bytes(),
+            (unsigned long)digest.ms(),
+            digest.mbPerSec()
+        );
+        job.result = json + tail;
+    } else {
+        job.result = "{\"error\":\"could not read file\"}";
+    }
+    // the card stays mounted until the file is read, even when the client left earlier
+    if (job.unmountSd) { UNMOUNT_SD_CARD; }
+    job.done = true;
+    delete ref;
+    vTaskDelete(NULL);
 }
 
 /**********************************************************************
@@ -144,7 +358,7 @@ String listFiles(FS fs, String folder) {
 ** used by server->on functions to discern whether a user has the correct
 ** httpapitoken OR is authenticated by username and password
 **********************************************************************/
-bool checkUserWebAuth(AsyncWebServerRequest *request, bool onFailureReturnLoginPage = false) {
+static bool hasWebUISession(AsyncWebServerRequest *request) {
     if (request->hasHeader("Cookie")) {
         const AsyncWebHeader *cookie = request->getHeader("Cookie");
         String c = cookie->value();
@@ -157,6 +371,11 @@ bool checkUserWebAuth(AsyncWebServerRequest *request, bool onFailureReturnLoginP
             if (bruceConfig.isValidWebUISession(token)) { return true; }
         }
     }
+    return false;
+}
+
+bool checkUserWebAuth(AsyncWebServerRequest *request, bool onFailureReturnLoginPage = false) {
+    if (hasWebUISession(request)) return true;
     if (onFailureReturnLoginPage) {
         serveWebUIFile(request, "login.html", "text/html", true, login_html, login_html_size);
     } else {
@@ -369,6 +588,64 @@ static bool startMdnsResponder() {
     return true;
 }
 
+// Called from the tft_logger mirror task with each batch of entries
+static void screenMirrorSink(const uint8_t *packet, size_t len) {
+    if (screenWs && screenWs->count() > 0) screenWs->binaryAll(packet, len);
+}
+
+static void sendScreenKeyframe(AsyncWebSocketClient *client) {
+    const size_t maxLen = TFT_MIRROR_HEADER_SIZE + MAX_LOG_ENTRIES * MAX_LOG_SIZE;
+    uint8_t *buffer = (uint8_t *)malloc(maxLen);
+    if (!buffer) {
+        log_w("Screen mirror: no memory for a keyframe");
+        return;
+    }
+    client->binary(buffer, tft.getKeyframe(buffer, maxLen));
+    free(buffer);
+}
+
+/**********************************************************************
+**  Function: onScreenWsEvent
+**  Screen mirror clients send "since <seq>" with the last sequence
+**  they drew, on connect and when they see a gap. They get a keyframe
+**  unless the screen did not change since then.
+**********************************************************************/
+static void onScreenWsEvent(
+    AsyncWebSocket *ws, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len
+) {
+    if (type == WS_EVT_CONNECT) ws->cleanupClients();
+    if (type != WS_EVT_DATA) return;
+    AwsFrameInfo *info = (AwsFrameInfo *)arg;
+    if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) return;
+
+    char msg[24];
+    len = std::min(len, sizeof(msg) - 1);
+    memcpy(msg, data, len);
+    msg[len] = '\0';
+    if (strncmp(msg, "since ", 6) != 0) return;
+    uint32_t since = strtoul(msg + 6, NULL, 10);
+    if (since == 0 || since != tft.getLogSeq()) sendScreenKeyframe(client);
+}
+
+static void onSpectrumWsEvent(
+    AsyncWebSocket *ws, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len
+) {
+    if (type == WS_EVT_CONNECT) ws->cleanupClients();
+}
+
+bool webSpectrumListening() { return spectrumWs && spectrumWs->count() > 0; }
+
+/**********************************************************************
+**  Function: webSpectrumSend
+**  Pushes one sweep to the spectrum view. While a client queue is
+**  full sweeps are dropped, the next one replaces them anyway.
+**********************************************************************/
+void webSpectrumSend(const uint8_t *frame, size_t len) {
+    if (!webSpectrumListening() || len == 0) return;
+    if (!spectrumWs->availableForWriteAll()) return;
+    spectrumWs->binaryAll(frame, len);
+}
+
 /**********************************************************************
 **  Function: configureWebServer
 **  configure web server
@@ -475,14 +752,25 @@ void configureWebServer() {
     // Get Screen
     server->on("/getscreen", HTTP_GET, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
-            uint8_t binData[MAX_LOG_ENTRIES * MAX_LOG_SIZE];
-            size_t binSize = 0;
-
-            tft.getBinLog(binData, binSize);
-            request->send(200, "application/octet-stream", (const uint8_t *)binData, binSize);
+            AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+            tft.getBinLog(*response);
+            request->send(response);
         }
     });
 
+    // Screen mirror, pushes tft_logger entries as they are drawn
+    screenWs = new AsyncWebSocket("/screenws");
+    screenWs->handleHandshake([](AsyncWebServerRequest *request) { return hasWebUISession(request); });
+    screenWs->onEvent(onScreenWsEvent);
+    server->addHandler(screenWs);
+    tft.startMirror(screenMirrorSink);
+
+    // Spectrum view, the running spectrum tool pushes its sweeps
+    spectrumWs = new AsyncWebSocket("/spectrumws");
+    spectrumWs->handleHandshake([](AsyncWebServerRequest *request) { return hasWebUISession(request); });
+    spectrumWs->onEvent(onSpectrumWsEvent);
+    server->addHandler(spectrumWs);
+
     // Rename file or folder
     server->on("/rename", HTTP_POST, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
@@ -549,21 +837,38 @@ void configureWebServer() {
 
     // Reboot device
     server->on("/reboot", HTTP_GET, [](AsyncWebServerRequest *request) {
-        if (checkUserWebAuth(request)) { ESP.restart(); }
+        if (checkUserWebAuth(request)) {
+            bruceConfig.commit();
+            ESP.restart();
+        }
     });
 
     // List files
+    // args: fs, folder, offset, limit (0 = all), sort (name|size), order (asc|desc)
     server->on("/listfiles", HTTP_GET, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
             String folder = "/";
             if (request->hasArg("folder")) { folder = request->arg("folder"); }
-            if (strcmp(request->arg("fs").c_str(), "SD") == 0) {
-                MOUNT_SD_CARD;
-                request->send(200, "text/plain", listFiles(SD, folder));
-                UNMOUNT_SD_CARD;
-            } else {
-                request->send(200, "text/plain", listFiles(LittleFS, folder));
-            }
+            bool useSD = strcmp(request->arg("fs").c_str(), "SD") == 0;
+            size_t offset = request->hasArg("offset") ? request->arg("offset").toInt() : 0;
+            size_t limit = request->hasArg("limit") ? request->arg("limit").toInt() : 0;
+            FileListing::Sort sort = FileListing::SORT_NONE;
+            if (request->arg("sort") == "name") sort = FileListing::SORT_NAME;
+            else if (request->arg("sort") == "size") sort = FileListing::SORT_SIZE;
+            bool desc = request->arg("order") == "desc";
+
+            if (useSD) { MOUNT_SD_CARD; }
+            _webFS = useSD ? (FS)SD : (FS)LittleFS;
+            uploadFolder = folder;
+            auto listing = std::make_shared<FileListing>(
+                useSD ? (FS &)SD : (FS &)LittleFS, folder, offset, limit, sort, desc, useSD
+            );
+            request->send(request->beginChunkedResponse(
+                "text/plain",
+                [listing](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                    return listing->fill(buffer, maxLen);
+                }
+            ));
         }
     });
 
@@ -653,6 +958,51 @@ void configureWebServer() {
         }
     });
 
+    // Hash a file, args: fs, name, algo (comma separated md5,crc32,sha1,sha256, default md5)
+    // The digest runs in its own task, the response waits for it without blocking async_tcp
+    server->on("/hash", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!checkUserWebAuth(request)) return;
+        if (!request->hasArg("name")) {
+            request->send(400, "text/plain", "ERROR: name param required");
+            return;
+        }
+        uint8_t algos = FileDigest::parseAlgos(request->hasArg("algo") ? request->arg("algo") : "md5");
+        if (algos == 0) {
+            request->send(400, "text/plain", "ERROR: algo must be md5, crc32, sha1 or sha256");
+            return;
+        }
+        bool useSD = request->arg("fs") == "SD";
+        if (useSD) { MOUNT_SD_CARD; }
+        auto job = std::make_shared<HashJob>();
+        job->fs = useSD ? (FS *)&SD : (FS *)&LittleFS;
+        job->path = request->arg("name");
+        job->algos = algos;
+        job->unmountSd = useSD;
+        if (!job->fs->exists(job->path)) {
+            if (useSD) { UNMOUNT_SD_CARD; }
+            request->send(404, "text/plain", "ERROR: file does not exist");
+            return;
+        }
+        // the task holds its own reference and unmounts the card, the request may go away first
+        auto *ref = new std::shared_ptr<HashJob>(job);
+        if (xTaskCreate(hashTask, "web_hash", 4096, ref, 1, NULL) != pdPASS) {
+            delete ref;
+            if (useSD) { UNMOUNT_SD_CARD; }
+            request->send(500, "text/plain", "ERROR: could not start hash task");
+            return;
+        }
+        request->send(request->beginChunkedResponse(
+            "application/json",
+            [job](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                if (!job->done) return RESPONSE_TRY_AGAIN;
+                if (index >= job->result.length()) return 0;
+                size_t n = min(maxLen, job->result.length() - index);
+                memcpy(buffer, job->result.c_str() + index, n);
+                return n;
+            }
+        ));
+    });
+
     // Edit file
     server->on("/edit", HTTP_POST, [](AsyncWebServerRequest *request) {
         if (checkUserWebAuth(request)) {
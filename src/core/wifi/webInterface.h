@@ -11,7 +11,6 @@ extern AsyncWebServer *server; // used to check if the webserver is running
 
 // function defaults
 String humanReadableSize(uint64_t bytes);
-String listFiles(FS fs, String folder);
 String readLineFromFile(File myFile);
 
 void loopOptionsWebUi();
@@ -24,3 +23,7 @@ void serveWebUIFile(
 void configureWebServer();
 void startWebUi(bool mode_ap = false);
 void stopWebUi();
+
+// Live spectrum view, binary frames pushed to the /spectrumws clients
+bool webSpectrumListening();
+void webSpectrumSend(const uint8_t *frame, size_t len);
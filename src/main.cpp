@@ -1,6 +1,7 @@
 #include "core/main_menu.h"
 #include <globals.h>
 
+#include "core/input_events.h"
 #include "core/powerSave.h"
 #include "core/serial_commands/cli.h"
 #include "core/utils.h"
@@ -60,24 +61,16 @@ void __attribute__((weak)) taskInputHandler(void *parameter) {
         // if AnyKeyPress is false, or rerun if it was not renewed within 75ms (arbitrary)
         // because AnyKeyPress will be true if didn´t passed through a check(bool var)
         if (!AnyKeyPress || millis() - timer > 75) {
-            NextPress = false;
-            PrevPress = false;
-            UpPress = false;
-            DownPress = false;
-            SelPress = false;
-            EscPress = false;
-            AnyKeyPress = false;
-            SerialCmdPress = false;
-            NextPagePress = false;
-            PrevPagePress = false;
-            touchPoint.pressed = false;
-            touchPoint.Clear();
+            // what was set since the last poll is queued before the flags go
+            inputClearFlags();
 #ifndef USE_TFT_eSPI_TOUCH
             InputHandler();
 #endif
             timer = millis();
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        inputPublish();
+        // input interrupts wake the task early, boards without them are polled every INPUT_POLL_MS
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(inputPollInterval()));
     }
 }
 // Public Globals Variables
@@ -209,6 +202,9 @@ void begin_tft() {
     tftHeight = tft.height() - 20;
 #else
     tftHeight = tft.height();
+#endif
+#if defined(HAS_SCREEN) && TFT_COMPOSITE
+    tft.setCompositing(true);
 #endif
     resetTftDisplay();
     setBrightness(bruceConfig.bright, false);
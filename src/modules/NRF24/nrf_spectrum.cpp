@@ -1,17 +1,17 @@
 #include "nrf_spectrum.h"
 #include "../../core/display.h"
 #include "../../core/mykeyboard.h"
+#include "../../core/wifi/webInterface.h"
 
-#define CHANNELS 80
+#define CHANNELS NRF_SPECTRUM_CHANNELS
 #define RGB565(r, g, b) ((((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)))
-uint8_t channel[CHANNELS];
+#define NRF_SPI_SPEED 10000000
 
-// Register Access Functions
+// Register Access Functions, command and data byte in one 16 bit transfer
 inline byte getRegister(SPIClass &SSPI, byte r) {
 
     digitalWrite(bruceConfigPins.NRF24_bus.cs, LOW);
-    byte c = SSPI.transfer(r & 0x1F);
-    c = SSPI.transfer(0);
+    byte c = SSPI.transfer16((R_REGISTER | (r & REGISTER_MASK)) << 8) & 0xFF;
     digitalWrite(bruceConfigPins.NRF24_bus.cs, HIGH);
 
     return c;
@@ -20,67 +20,123 @@ inline byte getRegister(SPIClass &SSPI, byte r) {
 inline void setRegister(SPIClass &SSPI, byte r, byte v) {
 
     digitalWrite(bruceConfigPins.NRF24_bus.cs, LOW);
-    SSPI.transfer((r & 0x1F) | 0x20);
-    SSPI.transfer(v);
+    SSPI.transfer16(((W_REGISTER | (r & REGISTER_MASK)) << 8) | v);
     digitalWrite(bruceConfigPins.NRF24_bus.cs, HIGH);
 }
 
 inline void powerDown(SPIClass &SSPI) { setRegister(SSPI, 0x00, getRegister(SSPI, 0x00) & ~0x02); }
 
-// scanning channels
-#define _BW tftWidth / CHANNELS
-String scanChannels(SPIClass *SSPI, bool web) {
-    String result = "{";
-
-    uint8_t rpdValues[CHANNELS] = {0};
-    digitalWrite(bruceConfigPins.NRF24_bus.io0, LOW);
-
-    for (int i = 0; i < CHANNELS; i++) {
-        NRFradio.setChannel(i);
-        NRFradio.startListening();
-        delayMicroseconds(128);
-        NRFradio.stopListening();
-
-        int rpd = NRFradio.testRPD() ? 1 : 0;
-        channel[i] = (channel[i] * 3 + rpd * 125) / 4;
-        rpdValues[i] = channel[i];
+/////////////////////////////////////////////////////////////////////////////////////
+// Engine
+/////////////////////////////////////////////////////////////////////////////////////
+
+void NRFSpectrum::sweep() {
+    const uint8_t ce = bruceConfigPins.NRF24_bus.io0;
+    uint8_t hits[CHANNELS];
+
+    // The radio is already in RX (PRIM_RX, PWR_UP), CE low only while RF_CH changes
+    _spi->beginTransaction(SPISettings(NRF_SPI_SPEED, MSBFIRST, SPI_MODE0));
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+        digitalWrite(ce, LOW);
+        setRegister(*_spi, RF_CH, ch);
+        digitalWrite(ce, HIGH);
+        delayMicroseconds(NRF_SPECTRUM_SETTLE_US);
+
+        hits[ch] = 0;
+        for (uint8_t s = 0; s < NRF_SPECTRUM_SAMPLES; s++) {
+            if (s) delayMicroseconds(NRF_SPECTRUM_SAMPLE_US);
+            hits[ch] += getRegister(*_spi, RPD) & 0x01;
+        }
+    }
+    digitalWrite(ce, LOW);
+    _spi->endTransaction();
+
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+        uint8_t sample = hits[ch] * NRF_SPECTRUM_MAX_LEVEL / NRF_SPECTRUM_SAMPLES;
+        level[ch] = (level[ch] * 3 + sample) / 4;
+
+        if (level[ch] >= peak[ch]) {
+            peak[ch] = level[ch];
+            _peakAge[ch] = 0;
+        } else if (_peakAge[ch] < NRF_SPECTRUM_PEAK_HOLD) {
+            _peakAge[ch]++;
+        } else {
+            peak[ch]--;
+        }
     }
 
-    digitalWrite(bruceConfigPins.NRF24_bus.io0, HIGH);
-
-    for (int i = 0; i < CHANNELS; i++) {
-        int level = rpdValues[i];
-        int x = i * _BW;
-        int c = i;
+    _sweeps++;
+    _rateSweeps++;
+    uint32_t now = millis();
+    if (now - _rateStart >= 1000) {
+        _rate = _rateSweeps * 1000 / (now - _rateStart);
+        _rateStart = now;
+        _rateSweeps = 0;
+    }
+}
 
-        tft.drawFastVLine(
-            x, tftHeight - (10 + level), level, (i % 2 == 0) ? bruceConfig.priColor : TFT_DARKGREY
-        ); // for level display
+size_t NRFSpectrum::frame(uint8_t *out, size_t size) const {
+    if (size < NRF_SPECTRUM_FRAME_SIZE) return 0;
+    out[0] = NRF_SPECTRUM_FRAME_MAGIC;
+    out[1] = NRF_SPECTRUM_FRAME_SOURCE;
+    out[2] = CHANNELS >> 8;
+    out[3] = CHANNELS & 0xFF;
+    out[4] = _sweeps >> 24;
+    out[5] = _sweeps >> 16;
+    out[6] = _sweeps >> 8;
+    out[7] = _sweeps;
+    out[8] = _rate >> 8;
+    out[9] = _rate;
+    memcpy(out + NRF_SPECTRUM_FRAME_HEADER, level, CHANNELS);
+    memcpy(out + NRF_SPECTRUM_FRAME_HEADER + CHANNELS, peak, CHANNELS);
+    return NRF_SPECTRUM_FRAME_SIZE;
+}
 
-        tft.drawFastVLine(
-            x, 0, tftHeight - (9 + level), (i % 8) ? TFT_BLACK : RGB565(25, 25, 25)
-        );                                                    /// for clearing
-        tft.drawFastVLine(x, 0, level, bruceConfig.secColor); /// for top display
-        // show 5 channel gap only
-        if (c % 5 == 0 && c != 0) { tft.drawCentreString(String(c).c_str(), x, tftHeight / 2, 1); }
+/////////////////////////////////////////////////////////////////////////////////////
+// Display
+/////////////////////////////////////////////////////////////////////////////////////
 
-        if (web) {
-            if (i > 0) result += ",";
-            result += String(level);
-        }
-    }
+#define PLOT_TOP (LH + 2)
 
-    if (web) result += "}";
-    return result; // return a string in this format "{1,32,45,32,84,32 .... 12,54,65}" with 80 values to be
-                   // used in the WebUI (Future)
-}
+static int barWidth() { return tftWidth >= CHANNELS ? tftWidth / CHANNELS : 1; }
+static int plotLeft() { return (tftWidth - barWidth() * CHANNELS) / 2; }
+static int plotHeight() { return tftHeight - 2 * LH - 2 - PLOT_TOP; }
 
-void nrf_spectrum(SPIClass *SSPI) {
+static void draw_frame() {
     tft.fillScreen(bruceConfig.bgColor);
     tft.setTextSize(FP);
+    tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
+    tft.drawString("NRF24", 0, 0);
     tft.drawString("2.40Ghz", 0, tftHeight - LH);
     tft.drawCentreString("2.44Ghz", tftWidth / 2, tftHeight - LH, 1);
     tft.drawRightString("2.48Ghz", tftWidth, tftHeight - LH, 1);
+    // show 10 channel gap only
+    for (int c = 10; c < CHANNELS; c += 10) {
+        tft.drawCentreString(String(c).c_str(), plotLeft() + c * barWidth(), tftHeight - 2 * LH, 1);
+    }
+}
+
+static void draw_rate(uint16_t rate) {
+    String text = String(rate) + " sweeps/s";
+    tft.fillRect(tftWidth / 2, 0, tftWidth / 2, LH, bruceConfig.bgColor);
+    tft.drawRightString(text.c_str(), tftWidth, 0, 1);
+}
+
+// One bar is drawn in the sprite and pushed whole, so it never flickers
+static void draw_bar(int ch, int levelHeight, int peakHeight) {
+    const int h = plotHeight();
+    const int w = barWidth();
+    sprite.fillSprite((ch % 8) ? bruceConfig.bgColor : RGB565(25, 25, 25));
+    if (levelHeight > 0) {
+        uint16_t color = (ch % 2 == 0) ? bruceConfig.priColor : TFT_DARKGREY;
+        sprite.fillRect(0, h - levelHeight, w, levelHeight, color);
+    }
+    if (peakHeight > 0) sprite.drawFastHLine(0, h - peakHeight, w, bruceConfig.secColor);
+    tft.pushSprite(sprite, plotLeft() + ch * w, PLOT_TOP);
+}
+
+void nrf_spectrum(SPIClass *SSPI) {
+    draw_frame();
 
     if (nrf_start(NRF_MODE_SPI)) { // This function only works on SPI
         NRFradio.setAutoAck(false);
@@ -96,8 +152,43 @@ void nrf_spectrum(SPIClass *SSPI) {
         };
         for (uint8_t i = 0; i < 6; ++i) { NRFradio.openReadingPipe(i, noiseAddress[i]); }
         NRFradio.setDataRate(RF24_1MBPS);
-
-        while (!check(EscPress)) { scanChannels(SSPI); }
+        NRFradio.startListening(); // the sweeps only move CE and RF_CH from here
+
+        NRFSpectrum spectrum(SSPI);
+        uint16_t drawnLevel[CHANNELS];
+        uint16_t drawnPeak[CHANNELS];
+        memset(drawnLevel, 0xFF, sizeof(drawnLevel)); // draws every bar once
+        memset(drawnPeak, 0xFF, sizeof(drawnPeak));
+        uint16_t drawnRate = 0xFFFF;
+        uint32_t lastWeb = 0;
+        uint8_t webFrame[NRF_SPECTRUM_FRAME_SIZE];
+
+        const int h = plotHeight();
+        sprite.deleteSprite();
+        sprite.createSprite(barWidth(), h);
+
+        while (!check(EscPress)) {
+            spectrum.sweep();
+
+            for (int ch = 0; ch < CHANNELS; ch++) {
+                uint16_t levelHeight = spectrum.level[ch] * h / NRF_SPECTRUM_MAX_LEVEL;
+                uint16_t peakHeight = spectrum.peak[ch] * h / NRF_SPECTRUM_MAX_LEVEL;
+                if (levelHeight == drawnLevel[ch] && peakHeight == drawnPeak[ch]) continue;
+                draw_bar(ch, levelHeight, peakHeight);
+                drawnLevel[ch] = levelHeight;
+                drawnPeak[ch] = peakHeight;
+            }
+            if (spectrum.sweepsPerSecond() != drawnRate) {
+                drawnRate = spectrum.sweepsPerSecond();
+                draw_rate(drawnRate);
+            }
+
+            if (millis() - lastWeb >= NRF_SPECTRUM_WEB_MS && webSpectrumListening()) {
+                lastWeb = millis();
+                webSpectrumSend(webFrame, spectrum.frame(webFrame, sizeof(webFrame)));
+            }
+        }
+        sprite.deleteSprite();
         NRFradio.stopListening();
         powerDown(*SSPI);
         delay(250);
@@ -3,8 +3,72 @@
 #include "modules/NRF24/nrf_common.h"
 #include <RF24.h>
 
-void nrf_spectrum(SPIClass *SSPI);
+#define NRF_SPECTRUM_CHANNELS 80
+// RPD reads per channel per sweep, spread over the dwell
+#ifndef NRF_SPECTRUM_SAMPLES
+#define NRF_SPECTRUM_SAMPLES 4
+#endif
+// RX settling after CE goes high (Tstby2a), RPD is valid after it
+#ifndef NRF_SPECTRUM_SETTLE_US
+#define NRF_SPECTRUM_SETTLE_US 130
+#endif
+#ifndef NRF_SPECTRUM_SAMPLE_US
+#define NRF_SPECTRUM_SAMPLE_US 10
+#endif
+// Sweeps a peak is held before it starts falling
+#ifndef NRF_SPECTRUM_PEAK_HOLD
+#define NRF_SPECTRUM_PEAK_HOLD 30
+#endif
+#ifndef NRF_SPECTRUM_WEB_MS
+#define NRF_SPECTRUM_WEB_MS 100
+#endif
+
+// Highest level, a channel where every RPD sample was set
+#define NRF_SPECTRUM_MAX_LEVEL 125
 
-String scanChannels(SPIClass *SSPI, bool web = false);
+/*********************************************************************
+**  Web frame, pushed on /spectrumws, multi byte fields big endian:
+**    0     0xAC
+**    1     source, 1 = NRF24
+**    2-3   channel count N
+**    4-7   sweep number
+**    8-9   sweeps per second
+**    10    N levels, 0..125, then N peaks
+**********************************************************************/
+#define NRF_SPECTRUM_FRAME_MAGIC 0xAC
+#define NRF_SPECTRUM_FRAME_SOURCE 1
+#define NRF_SPECTRUM_FRAME_HEADER 10
+#define NRF_SPECTRUM_FRAME_SIZE (NRF_SPECTRUM_FRAME_HEADER + 2 * NRF_SPECTRUM_CHANNELS)
+
+/*********************************************************************
+**  Class: NRFSpectrum
+**  Sweeps the 80 channels with raw register writes: per channel one
+**  RF_CH write between CE low/high, then a few RPD reads. The radio
+**  stays in RX the whole time, no RF24 startListening/stopListening
+**  per channel. Each sweep feeds a decayed average and a peak hold.
+**********************************************************************/
+class NRFSpectrum {
+public:
+    uint8_t level[NRF_SPECTRUM_CHANNELS] = {};
+    uint8_t peak[NRF_SPECTRUM_CHANNELS] = {};
+
+    explicit NRFSpectrum(SPIClass *spi) : _spi(spi) {}
+
+    void sweep();
+    uint32_t sweeps() const { return _sweeps; }
+    uint16_t sweepsPerSecond() const { return _rate; }
+    // Web frame of the last sweep, returns its size
+    size_t frame(uint8_t *out, size_t size) const;
+
+private:
+    SPIClass *_spi;
+    uint8_t _peakAge[NRF_SPECTRUM_CHANNELS] = {};
+    uint32_t _sweeps = 0;
+    uint32_t _rateStart = 0;
+    uint32_t _rateSweeps = 0;
+    uint16_t _rate = 0;
+};
+
+void nrf_spectrum(SPIClass *SSPI);
 
 #endif
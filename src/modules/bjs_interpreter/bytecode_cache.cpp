@@ -0,0 +1,114 @@
+#if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
+#include "bytecode_cache.h"
+#include <esp_rom_crc.h>
+#include <globals.h>
+
+// Any rebuild may change the Duktape config, so the build time is part of the key
+static const char bytecodeBuild[] = BRUCE_VERSION " " __DATE__ " " __TIME__;
+static const long dukVersion = DUK_VERSION;
+
+static uint32_t crc(uint32_t crc, const void *data, size_t len) {
+    return esp_rom_crc32_le(crc, (const uint8_t *)data, len);
+}
+
+static duk_ret_t loadFunction(duk_context *ctx, void *udata) {
+    (void)udata;
+    duk_load_function(ctx);
+    return 1;
+}
+
+// Pushes the cached function, false with the stack untouched when there is no valid cache
+static bool loadBytecode(duk_context *ctx, FS *fs, const String &bcPath, const BjsBytecodeHeader &expected) {
+    if (!fs->exists(bcPath)) return false;
+    File file = fs->open(bcPath, FILE_READ);
+    if (!file) return false;
+
+    BjsBytecodeHeader header;
+    if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != expected.magic ||
+        header.buildHash != expected.buildHash || header.sourceLen != expected.sourceLen ||
+        header.sourceCrc != expected.sourceCrc || file.size() != sizeof(header) + header.bytecodeLen) {
+        file.close();
+        Serial.printf("JS bytecode: %s is stale\n", bcPath.c_str());
+        return false;
+    }
+
+    void *buf = duk_push_fixed_buffer(ctx, header.bytecodeLen);
+    size_t n = file.read((uint8_t *)buf, header.bytecodeLen);
+    file.close();
+    // Duktape does not validate bytecode, never load a damaged file
+    if (n != header.bytecodeLen || crc(0, buf, n) != header.bytecodeCrc ||
+        duk_safe_call(ctx, loadFunction, NULL, 1, 1) != DUK_EXEC_SUCCESS) {
+        duk_pop(ctx);
+        log_w("JS bytecode: %s is damaged", bcPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Dumps the function on the stack top, keeping it there
+static void saveBytecode(duk_context *ctx, FS *fs, const String &bcPath, BjsBytecodeHeader &header) {
+    duk_dup_top(ctx);
+    duk_dump_function(ctx);
+    duk_size_t len;
+    const void *buf = duk_get_buffer(ctx, -1, &len);
+    header.bytecodeLen = len;
+    header.bytecodeCrc = crc(0, buf, len);
+
+    const String tmpPath = bcPath + ".tmp";
+    File file = fs->open(tmpPath, FILE_WRITE);
+    bool ok = file && file.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+              file.write((const uint8_t *)buf, len) == len;
+    if (file) file.close();
+    duk_pop(ctx);
+
+    if (ok) {
+        if (fs->exists(bcPath)) fs->remove(bcPath);
+        ok = fs->rename(tmpPath, bcPath);
+    }
+    if (!ok) {
+        fs->remove(tmpPath);
+        log_w("JS bytecode: could not write %s", bcPath.c_str());
+    }
+}
+
+duk_int_t bjs_pcompile_cached(
+    duk_context *ctx, FS *fs, const char *path, const char *source, const char *filename, const char *prefix,
+    const char *suffix
+) {
+#if defined(DUK_USE_BYTECODE_DUMP_SUPPORT)
+    const bool cached = fs != NULL && path != NULL && path[0] != '\0';
+#else
+    const bool cached = false; // duk_dump_function() is not built in
+#endif
+    const String bcPath = cached ? String(path) + BJS_BYTECODE_EXT : String();
+    const size_t prefixLen = strlen(prefix);
+    const size_t sourceLen = strlen(source);
+    const size_t suffixLen = strlen(suffix);
+
+    BjsBytecodeHeader header = {};
+    header.magic = BJS_BYTECODE_MAGIC;
+    header.buildHash = crc(0, bytecodeBuild, sizeof(bytecodeBuild) - 1);
+    header.buildHash = crc(header.buildHash, &dukVersion, sizeof(dukVersion));
+    header.sourceLen = prefixLen + sourceLen + suffixLen;
+    header.sourceCrc = crc(crc(crc(0, prefix, prefixLen), source, sourceLen), suffix, suffixLen);
+
+    uint32_t start = millis();
+    if (cached && loadBytecode(ctx, fs, bcPath, header)) {
+        Serial.printf("JS bytecode: %s loaded in %lu ms\n", path, millis() - start);
+        return DUK_EXEC_SUCCESS;
+    }
+
+    duk_push_lstring(ctx, prefix, prefixLen);
+    duk_push_lstring(ctx, source, sourceLen);
+    duk_push_lstring(ctx, suffix, suffixLen);
+    duk_concat(ctx, 3);
+    duk_push_string(ctx, filename);
+    duk_int_t rc = duk_pcompile(ctx, DUK_COMPILE_EVAL);
+    if (rc != DUK_EXEC_SUCCESS) return rc;
+    Serial.printf("JS bytecode: %s compiled in %lu ms\n", cached ? path : filename, millis() - start);
+
+    if (cached) saveBytecode(ctx, fs, bcPath, header);
+    return rc;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef __BJS_BYTECODE_CACHE_H__
+#define __BJS_BYTECODE_CACHE_H__
+#if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
+#include <FS.h>
+#include <duktape.h>
+
+// Compiled scripts are kept next to the source, "script.js" -> "script.js.bc"
+#define BJS_BYTECODE_EXT ".bc"
+#define BJS_BYTECODE_MAGIC 0x43424A42 // "BJBC"
+
+struct BjsBytecodeHeader {
+    uint32_t magic;
+    uint32_t buildHash; // firmware build and Duktape version, the bytecode format is not portable
+    uint32_t sourceLen;
+    uint32_t sourceCrc;
+    uint32_t bytecodeLen;
+    uint32_t bytecodeCrc;
+};
+
+/*********************************************************************
+**  Function: bjs_pcompile_cached
+**  Compiles prefix + source + suffix as eval code and pushes the
+**  function, or the error like duk_pcompile(). When fs and path are
+**  set, the bytecode sidecar is loaded if it matches the source and
+**  rewritten otherwise.
+**********************************************************************/
+duk_int_t bjs_pcompile_cached(
+    duk_context *ctx, FS *fs, const char *path, const char *source, const char *filename = "eval",
+    const char *prefix = "", const char *suffix = ""
+);
+
+#endif
+#endif
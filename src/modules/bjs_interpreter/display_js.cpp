@@ -639,7 +639,7 @@ duk_ret_t native_pushSprite(duk_context *ctx) {
     return 1;
 #else
     duk_int_t magic = duk_get_current_magic(ctx);
-    sprites.at(magic - 1)->pushSprite(duk_get_int(ctx, 0), duk_get_int(ctx, 1));
+    tft.pushSprite(*sprites.at(magic - 1), duk_get_int(ctx, 0), duk_get_int(ctx, 1));
 #endif
 #endif
     return 0;
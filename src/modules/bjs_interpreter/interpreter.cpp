@@ -1,11 +1,18 @@
 #if !defined(LITE_VERSION) && !defined(DISABLE_INTERPRETER)
 #include "interpreter.h"
+#include "bytecode_cache.h"
 
 #include <duktape.h>
 
 char *script = NULL;
 char *scriptDirpath = NULL;
 char *scriptName = NULL;
+// Where the script was read from, used to cache its bytecode. NULL for scripts passed as text
+FS *scriptFs = NULL;
+char *scriptFilepath = NULL;
+
+#define BJS_MODULE_PREFIX "(function(){exports={};module={exports:exports};\n"
+#define BJS_MODULE_SUFFIX "\n})"
 
 // #define DUK_USE_DEBUG
 // #define DUK_USE_DEBUG_LEVEL 2
@@ -92,7 +99,12 @@ void interpreterHandler(void *pvParameters) {
 
     Serial.printf("Script length: %d\n", strlen(script));
 
-    if (duk_peval_string(ctx, script) != DUK_EXEC_SUCCESS) {
+    duk_int_t rc = bjs_pcompile_cached(ctx, scriptFs, scriptFilepath, script);
+    if (rc == DUK_EXEC_SUCCESS) {
+        duk_push_global_object(ctx);
+        rc = duk_pcall_method(ctx, 0);
+    }
+    if (rc != DUK_EXEC_SUCCESS) {
         tft.fillScreen(bruceConfig.bgColor);
         tft.setTextSize(FM);
         tft.setTextColor(TFT_RED, bruceConfig.bgColor);
@@ -152,6 +164,9 @@ void interpreterHandler(void *pvParameters) {
     scriptDirpath = NULL;
     free((char *)scriptName);
     scriptName = NULL;
+    free((char *)scriptFilepath);
+    scriptFilepath = NULL;
+    scriptFs = NULL;
     duk_pop(ctx);
 
     // Clean up.
@@ -181,6 +196,8 @@ void run_bjs_script() {
     filename = loopSD(*fs, true, "BJS|JS");
     script = readBigFile(*fs, filename);
     if (script == NULL) { return; }
+    scriptFs = fs;
+    scriptFilepath = strdup(filename.c_str());
 
     returnToMenu = true;
     interpreter_start = true;
@@ -193,18 +210,23 @@ bool run_bjs_script_headless(char *code) {
     if (script == NULL) { return false; }
     scriptDirpath = NULL;
     scriptName = NULL;
+    scriptFs = NULL;
+    scriptFilepath = NULL;
     returnToMenu = true;
     interpreter_start = true;
     return true;
 }
 
-bool run_bjs_script_headless(FS fs, String filename) {
+bool run_bjs_script_headless(FS &fs, String filename) {
     script = readBigFile(fs, filename);
     if (script == NULL) { return false; }
     const char *sName = filename.substring(0, filename.lastIndexOf('/')).c_str();
     const char *sDirpath = filename.substring(filename.lastIndexOf('/') + 1).c_str();
     scriptDirpath = strdup(sDirpath);
     scriptName = strdup(sName);
+    // temporary scripts, e.g. sent over serial to PSRamFS, are not worth caching
+    scriptFs = (&fs == &SD || &fs == &LittleFS) ? &fs : NULL;
+    scriptFilepath = scriptFs ? strdup(filename.c_str()) : NULL;
     returnToMenu = true;
     interpreter_start = true;
     return true;
@@ -320,19 +342,25 @@ duk_ret_t native_require(duk_context *ctx) {
         else if (LittleFS.exists(filepath)) fs = &LittleFS;
         if (fs == NULL) { return 1; }
 
-        const char *requiredScript = readBigFile(*fs, filepath);
+        char *requiredScript = readBigFile(*fs, filepath);
         if (requiredScript == NULL) { return 1; }
 
-        duk_push_string(ctx, "(function(){exports={};module={exports:exports};\n");
-        duk_push_string(ctx, requiredScript);
-        duk_push_string(ctx, "\n})");
-        duk_concat(ctx, 3);
-
-        duk_int_t pcall_rc = duk_pcompile(ctx, DUK_COMPILE_EVAL);
+        duk_int_t pcall_rc = bjs_pcompile_cached(
+            ctx, fs, filepath.c_str(), requiredScript, filepath.c_str(), BJS_MODULE_PREFIX, BJS_MODULE_SUFFIX
+        );
+        free(requiredScript);
         if (pcall_rc != DUK_EXEC_SUCCESS) { return 1; }
 
-        pcall_rc = duk_pcall(ctx, 1);
+        // Evaluating the module gives its wrapper function, calling it fills module.exports
+        duk_push_global_object(ctx);
+        pcall_rc = duk_pcall_method(ctx, 0);
+        if (pcall_rc == DUK_EXEC_SUCCESS) {
+            duk_push_global_object(ctx);
+            pcall_rc = duk_pcall_method(ctx, 0);
+        }
         if (pcall_rc == DUK_EXEC_SUCCESS) {
+            duk_pop(ctx);
+            duk_get_global_string(ctx, "module");
             duk_get_prop_string(ctx, -1, "exports");
             duk_compact(ctx, -1);
         }
@@ -354,9 +382,12 @@ duk_ret_t native_load(duk_context *ctx) {
     free((char *)script);
     free((char *)scriptDirpath);
     free((char *)scriptName);
+    free((char *)scriptFilepath);
     script = strdup(duk_to_string(ctx, 0));
     scriptDirpath = NULL;
     scriptName = NULL;
+    scriptFs = NULL;
+    scriptFilepath = NULL;
     return 0;
 }
 
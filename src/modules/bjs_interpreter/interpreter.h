@@ -10,6 +10,8 @@
 extern char *script;
 extern char *scriptDirpath;
 extern char *scriptName;
+extern FS *scriptFs;
+extern char *scriptFilepath;
 
 #include "audio_js.h"
 #include "badusb_js.h"
@@ -36,7 +38,7 @@ extern char *scriptName;
 void interpreterHandler(void *pvParameters);
 void run_bjs_script();
 bool run_bjs_script_headless(char *code);
-bool run_bjs_script_headless(FS fs, String filename);
+bool run_bjs_script_headless(FS &fs, String filename);
 
 duk_ret_t native_print(duk_context *ctx);
 duk_ret_t native_console_log(duk_context *ctx);
@@ -1,5 +1,6 @@
 #include "ble_common.h"
 #include "core/mykeyboard.h"
+#include "core/oui_db.h"
 #include "core/utils.h"
 #include "esp_mac.h"
 #define SERVICE_UUID "1bc68b2a-f3e3-11e9-81b4-2a2ae2dbcce4"
@@ -44,13 +45,18 @@ uint8_t sta_mac[6];
 char strID[18];
 char strAddl[200];
 
-void ble_info(String name, String address, String signal) {
+void ble_info(String name, String address, String signal, bool publicAddress) {
+    // random addresses carry no OUI
+    String vendor = publicAddress ? ouiDb.lookup(address) : "<random address>";
+    if (vendor.isEmpty()) vendor = "<unknown>";
+
     drawMainBorder();
     tft.setTextColor(bruceConfig.priColor);
     tft.drawCentreString("-=Information=-", tftWidth / 2, 28, SMOOTH_FONT);
     tft.drawString("Name: " + name, 10, 48);
     tft.drawString("Adresse: " + address, 10, 66);
-    tft.drawString("Signal: " + String(signal) + " dBm", 10, 84);
+    tft.drawString("Vendor: " + vendor, 10, 84);
+    tft.drawString("Signal: " + String(signal) + " dBm", 10, 102);
     tft.drawCentreString("   Press " + String(BTN_ALIAS) + " to act", tftWidth / 2, tftHeight - 20, 1);
 
     delay(300);
@@ -75,12 +81,15 @@ class AdvertisedDeviceCallbacks : public NimBLEAdvertisedDeviceCallbacks {
         bt_title = advertisedDevice->getName().c_str();
         bt_address = advertisedDevice->getAddress().toString().c_str();
         bt_signal = String(advertisedDevice->getRSSI());
+        bool bt_public = advertisedDevice->getAddress().getType() == BLE_ADDR_PUBLIC;
         // Serial.println("\n\nAddress - " + bt_address + "Name-"+ bt_name +"\n\n");
         if (bt_title.isEmpty()) bt_title = bt_address;
         if (bt_name.isEmpty()) bt_name = "<no name>";
         // If BT name is empty, set NONAME
         if (options.size() < 250)
-            options.emplace_back(bt_title.c_str(), [=]() { ble_info(bt_name, bt_address, bt_signal); });
+            options.emplace_back(bt_title.c_str(), [=]() {
+                ble_info(bt_name, bt_address, bt_signal, bt_public);
+            });
         else {
             Serial.println("Memory low, stopping BLE scan...");
             pBLEScan->stop();
@@ -141,12 +150,15 @@ void ble_scan() {
         bt_title = advertisedDevice->getName().c_str();
         bt_address = advertisedDevice->getAddress().toString().c_str();
         bt_signal = String(advertisedDevice->getRSSI());
+        bool bt_public = advertisedDevice->getAddress().getType() == BLE_ADDR_PUBLIC;
         // Serial.println("\n\nAddress - " + bt_address + "Name-"+ bt_name +"\n\n");
         if (bt_title.isEmpty()) bt_title = bt_address;
         if (bt_name.isEmpty()) bt_name = "<no name>";
         // If BT name is empty, set NONAME
         if (options.size() < 250)
-            options.emplace_back(bt_title.c_str(), [=]() { ble_info(bt_name, bt_address, bt_signal); });
+            options.emplace_back(bt_title.c_str(), [=]() {
+                ble_info(bt_name, bt_address, bt_signal, bt_public);
+            });
         else {
             Serial.println("Memory low, stopping BLE scan...");
             pBLEScan->stop();
@@ -11,11 +11,8 @@
 class ARPScanner {
 private:
     esp_netif_t *esp_net_interface;
-    TickType_t arpRequestDelay =
-        20u / portTICK_PERIOD_MS; // can be relatively low, helps to not overwhelm the stream
 
     void setup();
-    void readArpTableETH(netif *iface);
     IPAddress gateway;
 
     std::vector<Host> hostslist_eth;
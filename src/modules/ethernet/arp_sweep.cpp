@@ -0,0 +1,219 @@
+#include "arp_sweep.h"
+#include "esp_netif_net_stack.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/etharp.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/tcpip.h"
+#if !defined(LITE_VERSION)
+#include <ETH.h>
+#endif
+
+#define ARP_FRAME_LEN (SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR)
+#define ARP_HWTYPE_ETHERNET 1
+
+// One sweep at a time, the hook has no other way to find it
+static std::atomic<ArpSweep *> activeSweep{nullptr};
+static netif_input_fn previousInput = nullptr;
+
+ArpSweep::ArpSweep(esp_netif_t *netif) : _esp(netif) {}
+
+ArpSweep::~ArpSweep() { release(); }
+
+esp_netif_t *ArpSweep::interfaceByName(const String &name) {
+    esp_netif_t *netif = nullptr;
+    if (name == "eth") {
+#if !defined(LITE_VERSION)
+        netif = ETH.netif();
+#endif
+        if (netif == nullptr) netif = esp_netif_get_handle_from_ifkey("ETH_DEF");
+    } else {
+        netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    }
+    if (netif == nullptr || !esp_netif_is_netif_up(netif)) return nullptr;
+    return netif;
+}
+
+bool ArpSweep::allocate(uint32_t hosts) {
+    _delivered = 0;
+    return _table.allocate(
+        min(hosts, (uint32_t)(psramFound() ? ARP_SWEEP_MAX_HOSTS_PSRAM : ARP_SWEEP_MAX_HOSTS))
+    );
+}
+
+void ArpSweep::release() {
+    _table.release();
+    _delivered = 0;
+}
+
+bool ArpSweep::find(uint32_t ip, uint8_t mac[6]) {
+    portENTER_CRITICAL(&_lock);
+    int32_t idx = _table.indexOf(ntohl(ip));
+    if (idx >= 0) memcpy(mac, _table.host(idx).mac, 6);
+    portEXIT_CRITICAL(&_lock);
+    return idx >= 0;
+}
+
+// Runs in the WiFi / Ethernet driver task for every received frame, keep it short
+err_t ArpSweep::inputHook(struct pbuf *p, struct netif *inp) {
+    ArpSweep *sweep = activeSweep.load(std::memory_order_acquire);
+    if (sweep && inp == sweep->_netif) sweep->capture(p);
+    return previousInput(p, inp);
+}
+
+void ArpSweep::capture(struct pbuf *p) {
+    if (p->len < ARP_FRAME_LEN) return;
+    const struct eth_hdr *eth = (const struct eth_hdr *)p->payload;
+    if (eth->type != PP_HTONS(ETHTYPE_ARP)) return;
+    const struct etharp_hdr *arp = (const struct etharp_hdr *)((const uint8_t *)p->payload + SIZEOF_ETH_HDR);
+    if (arp->hwtype != PP_HTONS(ARP_HWTYPE_ETHERNET) || arp->proto != PP_HTONS(ETHTYPE_IP) ||
+        arp->hwlen != ETH_HWADDR_LEN || arp->protolen != sizeof(ip4_addr_t)) {
+        return;
+    }
+    // replies and the requests other hosts send alike, both tell who is there
+    uint32_t sender;
+    memcpy(&sender, &arp->sipaddr, sizeof(sender));
+    sender = ntohl(sender);
+    if (sender < _first || sender > _last || sender == _myIp) return;
+    portENTER_CRITICAL(&_lock);
+    _table.insert(sender, arp->shwaddr.addr);
+    portEXIT_CRITICAL(&_lock);
+}
+
+bool ArpSweep::sendRequest(uint32_t ipHost) {
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, ARP_FRAME_LEN, PBUF_RAM);
+    if (p == nullptr) return false;
+
+    struct eth_hdr *eth = (struct eth_hdr *)p->payload;
+    struct etharp_hdr *arp = (struct etharp_hdr *)((uint8_t *)p->payload + SIZEOF_ETH_HDR);
+    memset(&eth->dest, 0xFF, ETH_HWADDR_LEN);
+    memcpy(&eth->src, _netif->hwaddr, ETH_HWADDR_LEN);
+    eth->type = PP_HTONS(ETHTYPE_ARP);
+
+    arp->hwtype = PP_HTONS(ARP_HWTYPE_ETHERNET);
+    arp->proto = PP_HTONS(ETHTYPE_IP);
+    arp->hwlen = ETH_HWADDR_LEN;
+    arp->protolen = sizeof(ip4_addr_t);
+    arp->opcode = PP_HTONS(ARP_REQUEST);
+    memcpy(&arp->shwaddr, _netif->hwaddr, ETH_HWADDR_LEN);
+    uint32_t ip = htonl(_myIp);
+    memcpy(&arp->sipaddr, &ip, sizeof(ip));
+    memset(&arp->dhwaddr, 0, ETH_HWADDR_LEN);
+    ip = htonl(ipHost);
+    memcpy(&arp->dipaddr, &ip, sizeof(ip));
+
+    LOCK_TCPIP_CORE();
+    err_t err = _netif->linkoutput(_netif, p);
+    UNLOCK_TCPIP_CORE();
+    pbuf_free(p);
+    return err == ERR_OK;
+}
+
+void ArpSweep::deliver(HostCallback &onHost) {
+    uint32_t n = count();
+    while (_delivered < n) {
+        if (onHost) onHost(_table.host(_delivered));
+        _delivered++;
+    }
+}
+
+bool ArpSweep::run(const ArpSweepConfig &config, HostCallback onHost, ProgressCallback progress) {
+    _netif = (struct netif *)esp_netif_get_netif_impl(_esp);
+    if (_netif == nullptr || _netif->linkoutput == nullptr || _netif->hwaddr_len != ETH_HWADDR_LEN) {
+        _error = "Interface not ready";
+        return false;
+    }
+    esp_netif_ip_info_t info;
+    if (esp_netif_get_ip_info(_esp, &info) != ESP_OK || info.ip.addr == 0 || info.netmask.addr == 0) {
+        _error = "Interface has no IP";
+        return false;
+    }
+    _myIp = ntohl(info.ip.addr);
+    uint32_t mask = ntohl(info.netmask.addr);
+    if (~mask >> ARP_SWEEP_MAX_PREFIX_BITS) {
+        log_w("Subnet larger than /%d, sweeping the one around us", 32 - ARP_SWEEP_MAX_PREFIX_BITS);
+    }
+    if (!arpSweepRange(_myIp, mask, _first, _last)) {
+        _error = "Subnet has no other hosts";
+        return false;
+    }
+    // every address but ours
+    const uint32_t targets = _last - _first;
+    if (!allocate(targets)) {
+        _error = "Not enough memory";
+        return false;
+    }
+    ArpSweep *idle = nullptr;
+    if (!activeSweep.compare_exchange_strong(idle, this)) {
+        _error = "Another sweep is running";
+        return false;
+    }
+    LOCK_TCPIP_CORE();
+    previousInput = _netif->input;
+    _netif->input = inputHook;
+    UNLOCK_TCPIP_CORE();
+
+    const uint32_t rate = max(config.rate, (uint32_t)1);
+    const uint32_t start = millis();
+    uint32_t lastProgress = 0;
+    bool stop = false;
+    ArpSweepStatus status = {};
+    status.total = targets;
+
+    auto poll = [&]() {
+        deliver(onHost);
+        if (progress && millis() - lastProgress >= 200) {
+            lastProgress = millis();
+            status.found = count();
+            status.dropped = _table.dropped();
+            if (!progress(status)) stop = true;
+        }
+    };
+
+    for (uint8_t pass = 0; pass <= config.retries && !stop && count() < targets; pass++) {
+        status.pass = pass;
+        status.probed = 0;
+        status.pending = targets - count();
+        const uint32_t passStart = millis();
+        uint32_t passSent = 0;
+
+        for (uint32_t ip = _first; ip <= _last && !stop; ip++) {
+            if (ip == _myIp) continue;
+            portENTER_CRITICAL(&_lock);
+            bool known = _table.indexOf(ip) >= 0;
+            portEXIT_CRITICAL(&_lock);
+            if (known) continue;
+
+            // pace the requests to the configured rate
+            while (!stop && (uint64_t)passSent * 1000 > (uint64_t)(millis() - passStart) * rate) {
+                poll();
+                vTaskDelay(1);
+            }
+            if (stop) break;
+            if (sendRequest(ip)) {
+                passSent++;
+                status.sent++;
+            }
+            status.probed++;
+            poll();
+        }
+
+        // late replies
+        const uint32_t waitStart = millis();
+        while (!stop && millis() - waitStart < config.waitMs) {
+            poll();
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    LOCK_TCPIP_CORE();
+    _netif->input = previousInput;
+    UNLOCK_TCPIP_CORE();
+    // frames already inside the hook still use this sweep
+    vTaskDelay(pdMS_TO_TICKS(20));
+    activeSweep.store(nullptr, std::memory_order_release);
+
+    deliver(onHost);
+    _elapsedMs = millis() - start;
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef __ARP_SWEEP_H__
+#define __ARP_SWEEP_H__
+
+#include "arp_table.h"
+#include <Arduino.h>
+#include <esp_netif.h>
+#include <functional>
+#include <lwip/netif.h>
+
+// ARP requests per second
+#ifndef ARP_SWEEP_RATE
+#define ARP_SWEEP_RATE 250
+#endif
+// Extra passes over the hosts that did not answer
+#ifndef ARP_SWEEP_RETRIES
+#define ARP_SWEEP_RETRIES 2
+#endif
+// Wait for late replies after each pass
+#ifndef ARP_SWEEP_WAIT_MS
+#define ARP_SWEEP_WAIT_MS 500
+#endif
+// Hosts kept per sweep, more replies are counted but dropped
+#ifndef ARP_SWEEP_MAX_HOSTS
+#define ARP_SWEEP_MAX_HOSTS 1024
+#endif
+#ifndef ARP_SWEEP_MAX_HOSTS_PSRAM
+#define ARP_SWEEP_MAX_HOSTS_PSRAM 8192
+#endif
+
+struct ArpSweepConfig {
+    uint32_t rate = ARP_SWEEP_RATE;
+    uint8_t retries = ARP_SWEEP_RETRIES;
+    uint32_t waitMs = ARP_SWEEP_WAIT_MS;
+};
+
+struct ArpSweepStatus {
+    uint8_t pass;     // 0 is the first pass, then the retries
+    uint32_t probed;  // requests sent in this pass
+    uint32_t pending; // hosts to probe in this pass
+    uint32_t total;   // addresses in the subnet
+    uint32_t found;
+    uint32_t sent; // requests sent in all passes
+    uint32_t dropped;
+};
+
+/*********************************************************************
+**  Class: ArpSweep
+**  Host discovery for one esp-netif (WiFi STA or Ethernet). Requests
+**  are built by hand and sent through linkoutput at a fixed rate, so
+**  the lwIP ARP table is never involved. Replies are taken from a hook
+**  on netif->input into an ArpTable, and every
+**  ARP frame from the subnet counts, requests from other hosts too.
+**  Addresses that did not answer are probed again on each retry pass.
+**********************************************************************/
+class ArpSweep {
+public:
+    typedef std::function<void(const ArpHost &host)> HostCallback;
+    // Called about 5 times a second, return false to stop the sweep
+    typedef std::function<bool(const ArpSweepStatus &status)> ProgressCallback;
+
+    explicit ArpSweep(esp_netif_t *netif);
+    ~ArpSweep();
+
+    // Blocks until all passes are done or progress returns false. onHost runs on the calling
+    // task for every new host, as the replies come in. False when the sweep could not start.
+    bool run(const ArpSweepConfig &config, HostCallback onHost, ProgressCallback progress = nullptr);
+
+    const char *error() const { return _error; }
+    uint32_t count() const { return _table.count(); }
+    const ArpHost &host(uint32_t i) const { return _table.host(i); }
+    // ip in network order
+    bool find(uint32_t ip, uint8_t mac[6]);
+    uint32_t elapsedMs() const { return _elapsedMs; }
+
+    // "wifi" for the STA interface, "eth" for the Ethernet one, nullptr when it is not up
+    static esp_netif_t *interfaceByName(const String &name);
+
+private:
+    static err_t inputHook(struct pbuf *p, struct netif *inp);
+    void capture(struct pbuf *p);
+    bool sendRequest(uint32_t ipHost);
+    void deliver(HostCallback &onHost);
+    bool allocate(uint32_t hosts);
+    void release();
+
+    esp_netif_t *_esp;
+    struct netif *_netif = nullptr;
+    const char *_error = "";
+    uint32_t _myIp = 0; // host order from here on
+    uint32_t _first = 0;
+    uint32_t _last = 0;
+
+    ArpTable _table;
+    uint32_t _delivered = 0;
+    uint32_t _elapsedMs = 0;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED; // the hook inserts, the sweep looks up
+};
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file arp_table.cpp
+ * @brief IP -> MAC table filled by the ARP sweep
+ */
+
+#include "arp_table.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static void *allocZeroed(size_t count, size_t size) {
+#ifdef ARDUINO
+    if (psramFound()) return ps_calloc(count, size);
+#endif
+    return calloc(count, size);
+}
+
+static uint32_t networkOrder(uint32_t ipHost) {
+    const uint8_t bytes[4] = {
+        (uint8_t)(ipHost >> 24), (uint8_t)(ipHost >> 16), (uint8_t)(ipHost >> 8), (uint8_t)ipHost
+    };
+    uint32_t ip;
+    memcpy(&ip, bytes, sizeof(ip));
+    return ip;
+}
+
+bool ArpTable::allocate(uint32_t maxHosts) {
+    release();
+    // at least twice the hosts, probing stays short
+    uint32_t slots = 16;
+    _slotShift = 28;
+    while (slots < maxHosts * 2) {
+        slots <<= 1;
+        _slotShift--;
+    }
+    _hosts = (ArpHost *)allocZeroed(maxHosts ? maxHosts : 1, sizeof(ArpHost));
+    _slots = (uint16_t *)allocZeroed(slots, sizeof(uint16_t));
+    if (!_hosts || !_slots) {
+        release();
+        return false;
+    }
+    _maxHosts = maxHosts;
+    _slotMask = slots - 1;
+    return true;
+}
+
+void ArpTable::release() {
+    free(_hosts);
+    free(_slots);
+    _hosts = nullptr;
+    _slots = nullptr;
+    _maxHosts = 0;
+    _slotMask = 0;
+    _count = 0;
+    _dropped = 0;
+}
+
+int32_t ArpTable::indexOf(uint32_t ipHost) const {
+    if (!_slots) return -1;
+    const uint32_t ip = networkOrder(ipHost);
+    for (uint32_t i = home(ipHost);; i = (i + 1) & _slotMask) {
+        if (_slots[i] == 0) return -1;
+        if (_hosts[_slots[i] - 1].ip == ip) return _slots[i] - 1;
+    }
+}
+
+bool ArpTable::insert(uint32_t ipHost, const uint8_t mac[6]) {
+    if (!_slots) return false;
+    const uint32_t ip = networkOrder(ipHost);
+    uint32_t i = home(ipHost);
+    while (_slots[i] != 0 && _hosts[_slots[i] - 1].ip != ip) i = (i + 1) & _slotMask;
+    if (_slots[i] != 0) return false;
+
+    const uint32_t n = _count.load(std::memory_order_relaxed);
+    if (n >= _maxHosts) {
+        _dropped++;
+        return false;
+    }
+    _hosts[n].ip = ip;
+    memcpy(_hosts[n].mac, mac, 6);
+    _slots[i] = n + 1;
+    _count.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+bool arpSweepRange(uint32_t ip, uint32_t mask, uint32_t &first, uint32_t &last) {
+    if (~mask >> ARP_SWEEP_MAX_PREFIX_BITS) mask = ~0u << ARP_SWEEP_MAX_PREFIX_BITS;
+    first = (ip & mask) + 1;
+    last = (ip | ~mask) - 1;
+    return last > first;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file arp_table.h
+ * @brief IP -> MAC table filled by the ARP sweep
+ *
+ * No Arduino dependencies, builds on the host for testing.
+ */
+
+#ifndef __ARP_TABLE_H__
+#define __ARP_TABLE_H__
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Subnets larger than this are swept only around our own address
+#define ARP_SWEEP_MAX_PREFIX_BITS 16
+
+struct ArpHost {
+    uint32_t ip; // network order, like ip4_addr_t
+    uint8_t mac[6];
+};
+
+/*********************************************************************
+**  Class: ArpTable
+**  Hosts in the order they were found, plus an open addressed index
+**  with linear probing over twice as many slots, keyed by IP. One task
+**  inserts, others may read count() and the hosts below it without a
+**  lock. Lookups and inserts from different tasks need one.
+**********************************************************************/
+class ArpTable {
+public:
+    ~ArpTable() { release(); }
+
+    // Room for maxHosts, what was in the table is dropped. False when out of memory
+    bool allocate(uint32_t maxHosts);
+    void release();
+
+    // ipHost in host order. False when it is known already or the table is full
+    bool insert(uint32_t ipHost, const uint8_t mac[6]);
+    // Index into host(), -1 when unknown
+    int32_t indexOf(uint32_t ipHost) const;
+    // Slot the probe for ipHost starts at
+    uint32_t home(uint32_t ipHost) const { return (ipHost * 2654435761u) >> _slotShift; }
+
+    uint32_t count() const { return _count.load(std::memory_order_acquire); }
+    const ArpHost &host(uint32_t i) const { return _hosts[i]; }
+    uint32_t maxHosts() const { return _maxHosts; }
+    uint32_t slots() const { return _slots ? _slotMask + 1 : 0; }
+    uint32_t dropped() const { return _dropped; } // new hosts that found the table full
+
+private:
+    ArpHost *_hosts = nullptr;
+    uint16_t *_slots = nullptr; // index + 1 into _hosts, 0 is free
+    uint32_t _maxHosts = 0;
+    uint32_t _slotMask = 0;
+    uint8_t _slotShift = 0; // multiplicative hash keeps the top bits
+    std::atomic<uint32_t> _count{0};
+    uint32_t _dropped = 0;
+};
+
+// First and last address to sweep around ip (host order), without the network and broadcast
+// addresses. Masks wider than /ARP_SWEEP_MAX_PREFIX_BITS are narrowed to it. False when the
+// subnet has no other hosts
+bool arpSweepRange(uint32_t ip, uint32_t mask, uint32_t &first, uint32_t &last);
+
+#endif
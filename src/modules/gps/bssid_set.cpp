@@ -0,0 +1,104 @@
+/**
+ * @file bssid_set.cpp
+ * @brief Compact set of seen BSSIDs for wardriving
+ */
+
+#include "bssid_set.h"
+#include <stdlib.h>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#define SLOT_USED (1ULL << 63)
+#define SLOT_KEY 0xFFFFFFFFFFFFULL
+#define SLOT_RSSI_SHIFT 48
+
+static uint64_t *allocTable(uint32_t slots) {
+#ifdef ARDUINO
+    if (psramFound()) return (uint64_t *)ps_calloc(slots, sizeof(uint64_t));
+#endif
+    return (uint64_t *)calloc(slots, sizeof(uint64_t));
+}
+
+static inline uint64_t macKey(const uint8_t *mac) {
+    return ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) |
+           ((uint64_t)mac[3] << 16) | ((uint64_t)mac[4] << 8) | mac[5];
+}
+
+// MurmurHash3 finalizer, vendors share the top bytes so they must be mixed in
+static inline uint32_t macHash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static inline int8_t slotRssi(uint64_t slot) { return (int8_t)(uint8_t)(slot >> SLOT_RSSI_SHIFT); }
+
+static inline uint64_t makeSlot(uint64_t key, int8_t rssi) {
+    return SLOT_USED | ((uint64_t)(uint8_t)rssi << SLOT_RSSI_SHIFT) | key;
+}
+
+BssidSet::~BssidSet() { free(_table); }
+
+void BssidSet::clear() {
+    free(_table);
+    _table = nullptr;
+    _mask = 0;
+    _size = 0;
+    _untracked = 0;
+}
+
+bool BssidSet::grow() {
+    uint32_t slots = _table ? (_mask + 1) * 2 : BSSID_SET_INITIAL;
+    if (slots > _maxSlots) return false;
+    uint64_t *table = allocTable(slots);
+    if (!table) return false;
+    const uint32_t mask = slots - 1;
+    for (uint32_t i = 0; _table && i <= _mask; i++) {
+        if (!(_table[i] & SLOT_USED)) continue;
+        uint32_t j = macHash(_table[i] & SLOT_KEY) & mask;
+        while (table[j] & SLOT_USED) j = (j + 1) & mask;
+        table[j] = _table[i];
+    }
+    free(_table);
+    _table = table;
+    _mask = mask;
+    return true;
+}
+
+bool BssidSet::contains(const uint8_t bssid[6]) const {
+    if (!_table) return false;
+    const uint64_t key = macKey(bssid);
+    for (uint32_t i = macHash(key) & _mask; _table[i] & SLOT_USED; i = (i + 1) & _mask) {
+        if ((_table[i] & SLOT_KEY) == key) return true;
+    }
+    return false;
+}
+
+BssidResult BssidSet::update(const uint8_t bssid[6], int8_t rssi, uint8_t margin) {
+    const uint64_t key = macKey(bssid);
+    if (_table) {
+        uint32_t i = macHash(key) & _mask;
+        for (; _table[i] & SLOT_USED; i = (i + 1) & _mask) {
+            if ((_table[i] & SLOT_KEY) != key) continue;
+            if (rssi < slotRssi(_table[i]) + margin) return BSSID_SEEN;
+            _table[i] = makeSlot(key, rssi);
+            return BSSID_STRONGER;
+        }
+    }
+    // Not found, grow at 3/4 load. A table that can't grow takes up to 15/16
+    if (!_table || (_size + 1) * 4 > slots() * 3) {
+        if (!grow() && (!_table || (_size + 1) * 16 > slots() * 15)) {
+            _untracked++;
+            return BSSID_UNTRACKED;
+        }
+    }
+    uint32_t i = macHash(key) & _mask;
+    while (_table[i] & SLOT_USED) i = (i + 1) & _mask;
+    _table[i] = makeSlot(key, rssi);
+    _size++;
+    return BSSID_NEW;
+}
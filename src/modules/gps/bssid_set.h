@@ -0,0 +1,65 @@
+/**
+ * @file bssid_set.h
+ * @brief Compact set of seen BSSIDs for wardriving
+ *
+ * No Arduino dependencies, builds on the host for testing.
+ */
+
+#ifndef __BSSID_SET_H__
+#define __BSSID_SET_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Slots, powers of two. The table starts small and doubles at 3/4 load up to the max
+#ifndef BSSID_SET_INITIAL
+#define BSSID_SET_INITIAL 256
+#endif
+#ifndef BSSID_SET_MAX_PSRAM
+#define BSSID_SET_MAX_PSRAM (64 * 1024) // 512 KB
+#endif
+#ifndef BSSID_SET_MAX_SRAM
+#define BSSID_SET_MAX_SRAM (8 * 1024) // 64 KB
+#endif
+
+enum BssidResult : uint8_t {
+    BSSID_NEW,       // first time seen
+    BSSID_STRONGER,  // seen, and stronger by the margin than when last reported
+    BSSID_SEEN,      // seen, nothing to report
+    BSSID_UNTRACKED, // the set is full, unknown whether it was seen
+};
+
+/*********************************************************************
+**  Class: BssidSet
+**  Open addressed hash set of 48 bit MACs with linear probing. Each
+**  slot is one uint64_t: the MAC, the RSSI last reported and a used
+**  bit, so a network costs 8 bytes plus the free slots instead of a
+**  heap String and a tree node. When the table can not grow anymore it
+**  fills up to 15/16 and then reports BSSID_UNTRACKED.
+**********************************************************************/
+class BssidSet {
+public:
+    explicit BssidSet(uint32_t maxSlots = BSSID_SET_MAX_SRAM) : _maxSlots(maxSlots) {}
+    ~BssidSet();
+
+    // Adds bssid, or reports it again when rssi beats the one last reported by margin dB (> 0)
+    BssidResult update(const uint8_t bssid[6], int8_t rssi, uint8_t margin);
+    bool contains(const uint8_t bssid[6]) const;
+    void clear();
+
+    uint32_t size() const { return _size; }
+    uint32_t slots() const { return _mask ? _mask + 1 : 0; }
+    size_t bytes() const { return slots() * sizeof(uint64_t); }
+    uint32_t untracked() const { return _untracked; } // updates that found the set full
+
+private:
+    uint64_t *_table = nullptr;
+    uint32_t _mask = 0;
+    uint32_t _size = 0;
+    uint32_t _maxSlots;
+    uint32_t _untracked = 0;
+
+    bool grow();
+};
+
+#endif
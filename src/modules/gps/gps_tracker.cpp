@@ -13,11 +13,12 @@
 #include "current_year.h"
 
 #define MAX_WAIT 5000
+#define SEGMENT_GAP 30000 // ms without a fix before the track is split
 
 GPSTracker::GPSTracker() { setup(); }
 
 GPSTracker::~GPSTracker() {
-    add_final_file_data();
+    finish_log();
     if (gpsConnected) end();
     ioExpander.turnPinOnOff(IO_EXP_GPS, LOW);
 #ifdef USE_BOOST
@@ -73,6 +74,7 @@ void GPSTracker::loop() {
     returnToMenu = false;
     while (1) {
         display_banner();
+        logger.update();
 
         if (check(EscPress) || returnToMenu) return end();
 
@@ -125,6 +127,7 @@ void GPSTracker::display_banner() {
     if (gpsCoordCount > 0) {
         padprintln("File: " + filename.substring(0, filename.length() - 4), 2);
         padprintln("GPS Coordinates: " + String(gpsCoordCount), 2);
+        padprintf(2, "Stored: %lu (%lu on file)\n", logger.kept(), logger.written());
         padprintf(2, "Distance: %.2fkm\n", distance / 1000);
     }
 
@@ -155,84 +158,70 @@ void GPSTracker::create_filename() {
         gps.time.minute() % 100,
         gps.time.second() % 100
     );
-    filename = String(timestamp) + "_gps_tracker.gpx";
+    filename = String(timestamp) + "_gps_tracker.trk";
 }
 
-void GPSTracker::add_initial_file_data(File file) {
-    file.println("<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>");
-    file.println("<?xml-stylesheet type=\"text/xsl\" href=\"details.xsl\"?>");
-    file.println("<gpx");
-    file.println("  version=\"1.1\"");
-    file.println("  creator=\"Bruce Firmware\"");
-    file.println("  xmlns=\"http://www.topografix.com/GPX/1/1\"");
-    file.println("  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"");
-    file.println(
-        "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd\""
-    );
-    file.println(">");
-    file.println("  <metadata>");
-    file.println("    <name>Bruce GPS Tracker</name>");
-    file.println("    <desc>GPS Tracker using Bruce Firmware</desc>");
-    file.println("    <link href=\"https://bruce.computer\">");
-    file.println("      <text>Bruce Website</text>");
-    file.println("    </link>");
-    file.println("  </metadata>");
-    file.println("  <trk>");
-    file.println("    <name>Bruce Route</name>");
-    file.println("    <desc>GPS route captured by Bruce firmware</desc>");
-    file.println("    <trkseg>");
-}
-
-void GPSTracker::add_final_file_data() {
-    FS *fs;
-    if (!getFsStorage(fs)) return;
-    if (filename == "" || !(*fs).exists("/BruceGPS/" + filename)) return;
-
-    File file = (*fs).open("/BruceGPS/" + filename, FILE_APPEND);
-
-    if (!file) return;
-    file.println("    </trkseg>");
-    file.println("  </trk>");
-    file.println("</gpx>");
-
-    file.close();
-}
-
-void GPSTracker::add_coord() {
+bool GPSTracker::start_log() {
     FS *fs;
     if (!getFsStorage(fs)) {
         padprintln("Storage setup error");
-        returnToMenu = true;
-        return;
+        return false;
     }
 
     if (filename == "") create_filename();
 
     if (!(*fs).exists("/BruceGPS")) (*fs).mkdir("/BruceGPS");
 
-    bool is_new_file = false;
-    if (!(*fs).exists("/BruceGPS/" + filename)) is_new_file = true;
-    File file = (*fs).open("/BruceGPS/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
-
-    if (!file) {
+    if (!logger.begin(*fs, "/BruceGPS/" + filename, fix_time())) {
         padprintln("Failed to open file for writing");
+        return false;
+    }
+    return true;
+}
+
+void GPSTracker::finish_log() {
+    if (!logger.isOpen()) return;
+    logger.end();
+
+    FS *fs;
+    if (!getFsStorage(fs)) return;
+    // The tracker has always left a .gpx behind, KML and CSV are exported from the file browser
+    exportTrack(*fs, "/BruceGPS/" + filename, TRACK_GPX);
+}
+
+uint32_t GPSTracker::fix_time() {
+    if (!gps.date.isValid() || gps.date.year() < CURRENT_YEAR) return 0;
+    return trackUnixTime(
+        gps.date.year(),
+        gps.date.month(),
+        gps.date.day(),
+        gps.time.hour(),
+        gps.time.minute(),
+        gps.time.second()
+    );
+}
+
+void GPSTracker::add_coord() {
+    if (!logger.isOpen() && !start_log()) {
         returnToMenu = true;
         return;
     }
 
-    if (is_new_file) add_initial_file_data(file);
-
-    file.printf("      <trkpt lat=\"%f\" lon=\"%f\">\n", gps.location.lat(), gps.location.lng());
-    file.println("        <sym>Waypoint</sym>");
-    file.printf("        <ele>%f</ele>\n", gps.altitude.meters());
-    file.printf("        <hdop>%f</hdop>\n", gps.hdop.hdop());
-    file.printf("        <sat>%ld</sat>\n", gps.satellites.value());
-    file.println("      </trkpt>");
+    TrackPoint point = trackPoint(
+        fix_time(),
+        gps.location.lat(),
+        gps.location.lng(),
+        gps.altitude.meters(),
+        gps.hdop.hdop(),
+        gps.satellites.value()
+    );
+    // First fix, or the first one after the fix was lost
+    if (gpsCoordCount == 0 || millis() - lastFix > SEGMENT_GAP) point.info |= TRACK_INFO_SEGMENT;
+    lastFix = millis();
+    logger.add(point);
 
     gpsCoordCount++;
 
-    file.close();
-
     padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
 }
 
@@ -9,6 +9,7 @@
 #ifndef __GPS_TRACKER_H__
 #define __GPS_TRACKER_H__
 
+#include "track_logger.h"
 #include <TinyGPS++.h>
 #include <globals.h>
 
@@ -37,6 +38,8 @@ private:
     HardwareSerial GPSserial = HardwareSerial(2);
     int gpsCoordCount = 0;
     bool rxPinReleased = false;
+    TrackLogger logger;
+    uint32_t lastFix = 0;
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Setup
@@ -57,8 +60,9 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
     void set_position(void);
     void add_coord(void);
-    void add_initial_file_data(File file);
-    void add_final_file_data(void);
+    bool start_log(void);
+    void finish_log(void);
+    uint32_t fix_time(void);
     void create_filename(void);
 };
 
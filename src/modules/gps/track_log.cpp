@@ -0,0 +1,291 @@
+/**
+ * @file track_log.cpp
+ * @brief Binary GPS track format, track simplification and GPX/KML/CSV export
+ */
+
+#include "track_log.h"
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define METERS_PER_E7 0.0111319491 // one 1e-7 degree of latitude
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Records
+/////////////////////////////////////////////////////////////////////////////////////
+
+TrackPoint trackPoint(uint32_t time, double lat, double lon, double alt, double hdop, uint8_t sats) {
+    TrackPoint p;
+    p.time = time;
+    p.lat = (int32_t)lround(lat * 1e7);
+    p.lon = (int32_t)lround(lon * 1e7);
+    p.alt = alt < -32768 ? -32768 : (alt > 32767 ? 32767 : (int16_t)lround(alt));
+    p.hdop = hdop < 0 ? 0 : (hdop >= 25.5 ? 255 : (uint8_t)lround(hdop * 10));
+    p.info = sats > TRACK_INFO_SATS ? TRACK_INFO_SATS : sats;
+    return p;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil)
+static int32_t daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+uint32_t trackUnixTime(int year, int month, int day, int hour, int minute, int second) {
+    if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31) return 0;
+    return (uint32_t)daysFromCivil(year, month, day) * 86400u + hour * 3600 + minute * 60 + second;
+}
+
+bool trackHeaderValid(const TrackHeader &header) {
+    return header.magic == TRACK_MAGIC && header.version == TRACK_VERSION &&
+           header.recordSize == sizeof(TrackPoint);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TrackSimplifier
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Distance in meters from p to the segment a-b, on a plane tangent at a
+static float segmentDistance(const TrackPoint &a, const TrackPoint &b, const TrackPoint &p) {
+    const double kx = METERS_PER_E7 * cos(a.lat * 1e-7 * M_PI / 180.0);
+    const double bx = ((int64_t)b.lon - a.lon) * kx, by = ((int64_t)b.lat - a.lat) * METERS_PER_E7;
+    const double px = ((int64_t)p.lon - a.lon) * kx, py = ((int64_t)p.lat - a.lat) * METERS_PER_E7;
+    const double len2 = bx * bx + by * by;
+    double t = len2 > 0 ? (px * bx + py * by) / len2 : 0;
+    if (t < 0) t = 0;
+    else if (t > 1) t = 1;
+    const double dx = px - t * bx, dy = py - t * by;
+    return (float)sqrt(dx * dx + dy * dy);
+}
+
+bool TrackSimplifier::fits(const TrackPoint &end) const {
+    const TrackPoint &start = _window[0];
+    if (start.time && end.time && end.time - start.time > TRACK_SIMPLIFY_MAX_SPAN_S) return false;
+    for (uint8_t i = 1; i < _count; i++) {
+        if (segmentDistance(start, end, _window[i]) > _tolerance) return false;
+    }
+    return true;
+}
+
+uint8_t TrackSimplifier::push(const TrackPoint &point, TrackPoint out[2]) {
+    if (_tolerance <= 0) {
+        out[0] = point;
+        return 1;
+    }
+    uint8_t n = 0;
+    if (!_count || (point.info & TRACK_INFO_SEGMENT)) {
+        // the end of the previous segment is kept
+        if (_count > 1) out[n++] = _window[_count - 1];
+        _window[0] = point;
+        _count = 1;
+        out[n++] = point;
+        return n;
+    }
+    if (_count < TRACK_SIMPLIFY_WINDOW && fits(point)) {
+        _window[_count++] = point;
+        return 0;
+    }
+    if (_count == 1) {
+        // only the time span failed
+        _window[0] = point;
+        out[n++] = point;
+        return n;
+    }
+    _window[0] = _window[_count - 1];
+    _window[1] = point;
+    _count = 2;
+    out[n++] = _window[0];
+    return n;
+}
+
+uint8_t TrackSimplifier::finish(TrackPoint out[1]) {
+    uint8_t n = 0;
+    if (_tolerance > 0 && _count > 1) out[n++] = _window[_count - 1];
+    _count = 0;
+    return n;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Text formatting
+/////////////////////////////////////////////////////////////////////////////////////
+
+void trackFormatCoord(int32_t e7, char *buf, size_t size) {
+    const uint32_t v = e7 < 0 ? (uint32_t)(-(int64_t)e7) : (uint32_t)e7;
+    snprintf(
+        buf,
+        size,
+        "%s%lu.%07lu",
+        e7 < 0 ? "-" : "",
+        (unsigned long)(v / 10000000),
+        (unsigned long)(v % 10000000)
+    );
+}
+
+void trackFormatTime(uint32_t time, char *buf, size_t size) {
+    // civil_from_days
+    const int32_t z = time / 86400 + 719468;
+    const uint32_t secs = time % 86400;
+    const int era = z / 146097;
+    const unsigned doe = z - era * 146097;
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int y = yoe + era * 400 + (m <= 2);
+    snprintf(
+        buf,
+        size,
+        "%04d-%02u-%02uT%02lu:%02lu:%02luZ",
+        y,
+        m,
+        d,
+        (unsigned long)(secs / 3600),
+        (unsigned long)(secs / 60 % 60),
+        (unsigned long)(secs % 60)
+    );
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// TrackExporter
+/////////////////////////////////////////////////////////////////////////////////////
+
+const char *TrackExporter::extension(TrackFormat format) {
+    switch (format) {
+        case TRACK_KML: return ".kml";
+        case TRACK_CSV: return ".csv";
+        default: return ".gpx";
+    }
+}
+
+void TrackExporter::put(const char *text) { _out(_ctx, text, strlen(text)); }
+
+void TrackExporter::printf(const char *fmt, ...) {
+    char buf[160];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (len > 0) _out(_ctx, buf, len < (int)sizeof(buf) ? len : sizeof(buf) - 1);
+}
+
+void TrackExporter::begin(const char *name) {
+    if (!name) name = "Bruce Route";
+    _inSegment = false;
+    _segment = 0;
+    _points = 0;
+    switch (_format) {
+        case TRACK_GPX:
+            put("<?xml version=\"1.0\" encoding=\"ISO-8859-1\" standalone=\"yes\"?>\n"
+                "<?xml-stylesheet type=\"text/xsl\" href=\"details.xsl\"?>\n"
+                "<gpx\n"
+                "  version=\"1.1\"\n"
+                "  creator=\"Bruce Firmware\"\n"
+                "  xmlns=\"http://www.topografix.com/GPX/1/1\"\n"
+                "  xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
+                "  xsi:schemaLocation=\"http://www.topografix.com/GPX/1/1 "
+                "http://www.topografix.com/GPX/1/1/gpx.xsd\"\n"
+                ">\n"
+                "  <metadata>\n"
+                "    <name>Bruce GPS Tracker</name>\n"
+                "    <desc>GPS Tracker using Bruce Firmware</desc>\n"
+                "    <link href=\"https://bruce.computer\">\n"
+                "      <text>Bruce Website</text>\n"
+                "    </link>\n"
+                "  </metadata>\n"
+                "  <trk>\n");
+            printf("    <name>%s</name>\n", name);
+            put("    <desc>GPS route captured by Bruce firmware</desc>\n");
+            break;
+        case TRACK_KML:
+            put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+                "  <Document>\n");
+            printf("    <name>%s</name>\n", name);
+            break;
+        case TRACK_CSV: put("time,latitude,longitude,altitude,hdop,satellites,segment\n"); break;
+    }
+}
+
+void TrackExporter::openSegment() {
+    if (_format == TRACK_GPX) put("    <trkseg>\n");
+    else if (_format == TRACK_KML) {
+        put("    <Placemark>\n"
+            "      <LineString>\n"
+            "        <altitudeMode>absolute</altitudeMode>\n"
+            "        <coordinates>\n");
+    }
+    _inSegment = true;
+}
+
+void TrackExporter::closeSegment() {
+    if (!_inSegment) return;
+    if (_format == TRACK_GPX) put("    </trkseg>\n");
+    else if (_format == TRACK_KML) {
+        put("        </coordinates>\n"
+            "      </LineString>\n"
+            "    </Placemark>\n");
+    }
+    _inSegment = false;
+}
+
+void TrackExporter::point(const TrackPoint &p) {
+    if (_inSegment && (p.info & TRACK_INFO_SEGMENT)) {
+        closeSegment();
+        _segment++;
+    }
+    if (!_inSegment) openSegment();
+    _points++;
+
+    char lat[16], lon[16], time[24] = "";
+    trackFormatCoord(p.lat, lat, sizeof(lat));
+    trackFormatCoord(p.lon, lon, sizeof(lon));
+    if (p.time) trackFormatTime(p.time, time, sizeof(time));
+    const unsigned sats = p.info & TRACK_INFO_SATS;
+
+    switch (_format) {
+        case TRACK_GPX:
+            printf("      <trkpt lat=\"%s\" lon=\"%s\">\n        <ele>%d</ele>\n", lat, lon, p.alt);
+            if (p.time) printf("        <time>%s</time>\n", time);
+            printf(
+                "        <sym>Waypoint</sym>\n"
+                "        <sat>%u</sat>\n"
+                "        <hdop>%u.%u</hdop>\n"
+                "      </trkpt>\n",
+                sats,
+                p.hdop / 10,
+                p.hdop % 10
+            );
+            break;
+        case TRACK_KML: printf("          %s,%s,%d\n", lon, lat, p.alt); break;
+        case TRACK_CSV:
+            printf(
+                "%s,%s,%s,%d,%u.%u,%u,%lu\n",
+                time,
+                lat,
+                lon,
+                p.alt,
+                p.hdop / 10,
+                p.hdop % 10,
+                sats,
+                (unsigned long)_segment
+            );
+            break;
+    }
+}
+
+void TrackExporter::end() {
+    closeSegment();
+    if (_format == TRACK_GPX) {
+        put("  </trk>\n"
+            "</gpx>\n");
+    } else if (_format == TRACK_KML) {
+        put("  </Document>\n"
+            "</kml>\n");
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file track_log.h
+ * @brief Binary GPS track format, track simplification and GPX/KML/CSV export
+ *
+ * No Arduino dependencies, the converter builds on the host for testing.
+ * Storage and buffering are in track_logger.h.
+ */
+
+#ifndef __TRACK_LOG_H__
+#define __TRACK_LOG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACK_MAGIC 0x4B525442 // "BTRK"
+#define TRACK_VERSION 1
+#define TRACK_SECTOR_SIZE 512
+
+// Points within this distance (meters) of the line between the kept points around them
+// are dropped, 0 keeps them all
+#ifndef TRACK_SIMPLIFY_M
+#define TRACK_SIMPLIFY_M 2.0f
+#endif
+// Never drop more than this many points in a row
+#ifndef TRACK_SIMPLIFY_WINDOW
+#define TRACK_SIMPLIFY_WINDOW 32
+#endif
+// Keep at least one point every this many seconds, so stops still show up in time
+#ifndef TRACK_SIMPLIFY_MAX_SPAN_S
+#define TRACK_SIMPLIFY_MAX_SPAN_S 120
+#endif
+
+#define TRACK_INFO_SATS 0x7F
+#define TRACK_INFO_SEGMENT 0x80 // first point after a fix loss, starts a new track segment
+
+// One fix, 16 bytes so a sector holds 32 of them
+struct __attribute__((packed)) TrackPoint {
+    uint32_t time; // unix seconds, UTC, 0 when unknown
+    int32_t lat;   // degrees * 1e7
+    int32_t lon;   // degrees * 1e7
+    int16_t alt;   // meters
+    uint8_t hdop;  // * 10, 255 = 25.5 or worse
+    uint8_t info;  // satellites and TRACK_INFO_SEGMENT
+};
+
+// File header, one record long so records stay sector aligned
+struct __attribute__((packed)) TrackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t startTime;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TrackPoint) == 16, "TrackPoint must stay 16 bytes");
+static_assert(sizeof(TrackHeader) == sizeof(TrackPoint), "TrackHeader must be one record long");
+static_assert(TRACK_SECTOR_SIZE % sizeof(TrackPoint) == 0, "records must not straddle sectors");
+
+#define TRACK_RECORDS_PER_SECTOR (TRACK_SECTOR_SIZE / sizeof(TrackPoint))
+
+/*********************************************************************
+**  Function: trackPoint
+**  Packs a fix, time from trackUnixTime()
+**********************************************************************/
+TrackPoint trackPoint(uint32_t time, double lat, double lon, double alt, double hdop, uint8_t sats);
+
+/*********************************************************************
+**  Function: trackUnixTime
+**  Unix seconds of a UTC date and time, 0 for dates before 1970
+**********************************************************************/
+uint32_t trackUnixTime(int year, int month, int day, int hour, int minute, int second);
+
+bool trackHeaderValid(const TrackHeader &header);
+
+/*********************************************************************
+**  Class: TrackSimplifier
+**  Opening window simplification: the window grows from the last kept
+**  point while every point in it stays within the tolerance of the
+**  line from that point to the newest one. When one does not, the
+**  point before the newest is kept and starts the next window. Each
+**  window is a Douglas-Peucker segment checked as it grows, so the
+**  track is simplified on the fly with one window of RAM.
+**********************************************************************/
+class TrackSimplifier {
+public:
+    explicit TrackSimplifier(float toleranceM = TRACK_SIMPLIFY_M) : _tolerance(toleranceM) {}
+
+    // Feeds a fix, out receives the points to store (0, 1 or 2 of them), in order
+    uint8_t push(const TrackPoint &point, TrackPoint out[2]);
+    // Last point of the track, if it was held back. Returns 0 or 1
+    uint8_t finish(TrackPoint out[1]);
+    void reset() { _count = 0; }
+
+private:
+    float _tolerance;
+    TrackPoint _window[TRACK_SIMPLIFY_WINDOW]; // [0] was kept, the others are pending
+    uint8_t _count = 0;
+
+    bool fits(const TrackPoint &end) const;
+};
+
+enum TrackFormat : uint8_t { TRACK_GPX, TRACK_KML, TRACK_CSV };
+
+/*********************************************************************
+**  Class: TrackExporter
+**  Streams a track to text, one point at a time. out() receives the
+**  text in small pieces, so the device writes straight to a file.
+**********************************************************************/
+class TrackExporter {
+public:
+    typedef void (*Output)(void *ctx, const char *text, size_t len);
+
+    TrackExporter(TrackFormat format, Output out, void *ctx) : _format(format), _out(out), _ctx(ctx) {}
+
+    void begin(const char *name);
+    void point(const TrackPoint &p);
+    void end();
+
+    static const char *extension(TrackFormat format);
+
+private:
+    TrackFormat _format;
+    Output _out;
+    void *_ctx;
+    bool _inSegment = false;
+    uint32_t _segment = 0; // CSV segment column
+    uint32_t _points = 0;
+
+    void put(const char *text);
+    void printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    void openSegment();
+    void closeSegment();
+};
+
+/*********************************************************************
+**  Function: trackFormatCoord
+**  Fixed point degrees as text, exact to the 7th decimal
+**********************************************************************/
+void trackFormatCoord(int32_t e7, char *buf, size_t size);
+
+/*********************************************************************
+**  Function: trackFormatTime
+**  ISO 8601 UTC, "2024-11-20T12:34:56Z"
+**********************************************************************/
+void trackFormatTime(uint32_t time, char *buf, size_t size);
+
+#endif
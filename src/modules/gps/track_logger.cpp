@@ -0,0 +1,198 @@
+/**
+ * @file track_logger.cpp
+ * @brief Buffered binary GPS track log
+ */
+
+#include "track_logger.h"
+#include "core/utils.h"
+#include <esp_system.h>
+#include <new>
+
+static TrackLogger *shutdownLogger = nullptr;
+
+// Runs from esp_restart(), writes what is still in RAM
+static void trackShutdownHandler() {
+    if (shutdownLogger) shutdownLogger->flush(true);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Life Cycle
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool TrackLogger::begin(FS &fs, const String &path, uint32_t startTime) {
+    end();
+    if (!_ring) {
+        size_t bytes = TRACK_LOG_RAM_RECORDS * sizeof(TrackPoint);
+        _ring = (TrackPoint *)(psramFound() ? ps_malloc(bytes) : malloc(bytes));
+    }
+    if (!_simplifier) _simplifier = new (std::nothrow) TrackSimplifier();
+    if (!_ring || !_simplifier) {
+        log_e("Not enough memory for the track log");
+        release();
+        return false;
+    }
+
+    _file = fs.open(path, FILE_WRITE);
+    if (!_file) {
+        log_e("Failed to create %s", path.c_str());
+        release();
+        return false;
+    }
+    TrackHeader header = {};
+    header.magic = TRACK_MAGIC;
+    header.version = TRACK_VERSION;
+    header.recordSize = sizeof(TrackPoint);
+    header.startTime = startTime;
+    if (_file.write((const uint8_t *)&header, sizeof(header)) != sizeof(header)) {
+        log_e("Failed to write %s", path.c_str());
+        _file.close();
+        release();
+        return false;
+    }
+    _file.flush();
+
+    _open = true;
+    _simplifier->reset();
+    _head = _count = 0;
+    _fileRecords = 1;
+    _points = _kept = _written = _dropped = 0;
+    _lastFlush = millis();
+    shutdownLogger = this;
+    esp_register_shutdown_handler(trackShutdownHandler);
+    return true;
+}
+
+void TrackLogger::end() {
+    if (!_open) return;
+    TrackPoint last[1];
+    if (_simplifier->finish(last)) store(last[0]);
+    flush(true);
+    _file.close();
+    _open = false;
+    if (shutdownLogger == this) {
+        esp_unregister_shutdown_handler(trackShutdownHandler);
+        shutdownLogger = nullptr;
+    }
+    release();
+}
+
+void TrackLogger::release() {
+    free(_ring);
+    _ring = nullptr;
+    delete _simplifier;
+    _simplifier = nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Operations
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TrackLogger::add(const TrackPoint &point) {
+    if (!_open) return;
+    _points++;
+    TrackPoint out[2];
+    uint8_t n = _simplifier->push(point, out);
+    for (uint8_t i = 0; i < n; i++) store(out[i]);
+    update();
+}
+
+void TrackLogger::store(const TrackPoint &point) {
+    _kept++;
+    if (_count == TRACK_LOG_RAM_RECORDS && !flush()) {
+        // storage is failing, keep the oldest points and give up on this one
+        _dropped++;
+        return;
+    }
+    _ring[(_head + _count) % TRACK_LOG_RAM_RECORDS] = point;
+    _count++;
+}
+
+void TrackLogger::update() {
+    if (!_open || !_count) return;
+    if (millis() - _lastFlush >= TRACK_LOG_FLUSH_MS) {
+        flush(true);
+        return;
+    }
+    int battery = getBattery();
+    if (battery > 0 && battery <= TRACK_LOG_LOW_BATTERY) flush(true);
+    else if (_count >= TRACK_RECORDS_PER_SECTOR) flush();
+}
+
+bool TrackLogger::flush(bool all) {
+    if (!_open) return false;
+    if (all) {
+        _lastFlush = millis();
+        return write(_count);
+    }
+    // Fill up the current sector, then whole sectors only
+    uint16_t n = TRACK_RECORDS_PER_SECTOR - _fileRecords % TRACK_RECORDS_PER_SECTOR;
+    if (n > _count) return false;
+    n += (_count - n) / TRACK_RECORDS_PER_SECTOR * TRACK_RECORDS_PER_SECTOR;
+    return write(n);
+}
+
+// Writes the oldest count records, in two pieces when the ring wraps
+bool TrackLogger::write(uint16_t count) {
+    while (count) {
+        uint16_t chunk = min<uint16_t>(count, TRACK_LOG_RAM_RECORDS - _head);
+        size_t bytes = chunk * sizeof(TrackPoint);
+        if (_file.write((const uint8_t *)&_ring[_head], bytes) != bytes) {
+            log_e("Track write failed");
+            return false;
+        }
+        _head = (_head + chunk) % TRACK_LOG_RAM_RECORDS;
+        _count -= chunk;
+        _fileRecords += chunk;
+        _written += chunk;
+        count -= chunk;
+    }
+    _file.flush();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Export
+/////////////////////////////////////////////////////////////////////////////////////
+
+static void writeToFile(void *ctx, const char *text, size_t len) {
+    static_cast<File *>(ctx)->write((const uint8_t *)text, len);
+}
+
+int32_t exportTrack(FS &fs, const String &path, TrackFormat format) {
+    File in = fs.open(path, FILE_READ);
+    if (!in) return -1;
+    TrackHeader header;
+    if (in.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || !trackHeaderValid(header)) {
+        log_e("%s is not a track log", path.c_str());
+        in.close();
+        return -1;
+    }
+
+    int dot = path.lastIndexOf('.');
+    String outPath = (dot > path.lastIndexOf('/') ? path.substring(0, dot) : path);
+    String name = outPath.substring(outPath.lastIndexOf('/') + 1);
+    outPath += TrackExporter::extension(format);
+    File out = fs.open(outPath, FILE_WRITE);
+    if (!out) {
+        log_e("Failed to create %s", outPath.c_str());
+        in.close();
+        return -1;
+    }
+
+    TrackExporter exporter(format, writeToFile, &out);
+    exporter.begin(name.c_str());
+    TrackPoint points[TRACK_RECORDS_PER_SECTOR];
+    int32_t total = 0;
+    size_t bytes;
+    // a record cut short by a power loss is left out
+    while ((bytes = in.read((uint8_t *)points, sizeof(points))) >= sizeof(TrackPoint)) {
+        size_t n = bytes / sizeof(TrackPoint);
+        for (size_t i = 0; i < n; i++) exporter.point(points[i]);
+        total += n;
+        if (bytes < sizeof(points)) break;
+    }
+    exporter.end();
+    in.close();
+    out.close();
+    return total;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file track_logger.h
+ * @brief Buffered binary GPS track log
+ *
+ * Fixes are simplified on the fly and kept in RAM, then appended to a .trk
+ * file in whole sectors. GPX/KML/CSV are exported from the .trk on demand.
+ */
+
+#ifndef __TRACK_LOGGER_H__
+#define __TRACK_LOGGER_H__
+
+#include "track_log.h"
+#include <FS.h>
+
+// Records held in RAM, a multiple of TRACK_RECORDS_PER_SECTOR
+#ifndef TRACK_LOG_RAM_RECORDS
+#define TRACK_LOG_RAM_RECORDS 128
+#endif
+// Everything in RAM is written at least this often, bounds what a crash or a pulled card loses
+#ifndef TRACK_LOG_FLUSH_MS
+#define TRACK_LOG_FLUSH_MS 60000
+#endif
+// Below this battery percentage every kept point is written right away
+#ifndef TRACK_LOG_LOW_BATTERY
+#define TRACK_LOG_LOW_BATTERY 10
+#endif
+
+static_assert(
+    TRACK_LOG_RAM_RECORDS % TRACK_RECORDS_PER_SECTOR == 0, "TRACK_LOG_RAM_RECORDS must hold whole sectors"
+);
+
+class TrackLogger {
+public:
+    /////////////////////////////////////////////////////////////////////////////////////
+    // Constructor
+    /////////////////////////////////////////////////////////////////////////////////////
+    TrackLogger() {}
+    ~TrackLogger() {
+        end();
+        release();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    // Life Cycle
+    /////////////////////////////////////////////////////////////////////////////////////
+    bool begin(FS &fs, const String &path, uint32_t startTime = 0);
+    void end(void);
+    bool isOpen(void) { return _open; }
+
+    /////////////////////////////////////////////////////////////////////////////////////
+    // Operations
+    /////////////////////////////////////////////////////////////////////////////////////
+    void add(const TrackPoint &point);
+    // Writes the full sectors held in RAM, or everything when all is set
+    bool flush(bool all = false);
+    // Time and battery based flushes, call from the main loop
+    void update(void);
+
+    uint32_t points(void) { return _points; }   // fixes received
+    uint32_t kept(void) { return _kept; }       // fixes left after simplification
+    uint32_t written(void) { return _written; } // kept fixes on storage
+    uint32_t dropped(void) { return _dropped; } // kept fixes lost to a full buffer
+
+private:
+    File _file;
+    bool _open = false;
+    // on the heap from begin() to end(), GPSTracker lives on the loop task's stack
+    TrackSimplifier *_simplifier = nullptr;
+    TrackPoint *_ring = nullptr;
+    uint16_t _head = 0;        // oldest record in RAM
+    uint16_t _count = 0;       // records in RAM
+    uint32_t _fileRecords = 0; // records in the file, header included
+    uint32_t _lastFlush = 0;
+    uint32_t _points = 0;
+    uint32_t _kept = 0;
+    uint32_t _written = 0;
+    uint32_t _dropped = 0;
+
+    void store(const TrackPoint &point);
+    void release(void);
+    bool write(uint16_t count);
+};
+
+/*********************************************************************
+**  Function: exportTrack
+**  Converts a .trk log to GPX, KML or CSV next to it, same name with
+**  the format extension. Returns the points exported, -1 on error
+**********************************************************************/
+int32_t exportTrack(FS &fs, const String &path, TrackFormat format);
+
+#endif
@@ -9,13 +9,21 @@
 #include "wardriving.h"
 #include "core/display.h"
 #include "core/mykeyboard.h"
+#include "core/oui_db.h"
 #include "core/sd_functions.h"
 #include "core/wifi/wifi_common.h"
 #include "current_year.h"
 
-#define MAX_WAIT 5000
+#define GPS_TIMEOUT 30000 // ms without GPS data before giving up
+#define REFRESH_MS 1000
+#define CSV_ROW_MAX 256
 
-Wardriving::Wardriving() { setup(); }
+// Sweep order, the busy channels come up three times per sweep
+static const uint8_t scanChannels[] = {1, 6, 11, 2, 3, 4, 1, 6, 11, 5, 7, 8, 1, 6, 11, 9, 10, 12, 13};
+
+Wardriving::Wardriving() : registeredMACs(psramFound() ? BSSID_SET_MAX_PSRAM : BSSID_SET_MAX_SRAM) {
+    setup();
+}
 
 Wardriving::~Wardriving() {
     if (gpsConnected) end();
@@ -68,8 +76,26 @@ bool Wardriving::begin_gps() {
 }
 
 void Wardriving::end() {
+    WiFi.scanDelete();
     wifiDisconnect();
 
+    if (file) {
+        flush_file();
+        file.close();
+    }
+    free(csvBuffer);
+    csvBuffer = nullptr;
+    if (wifiNetworkCount > 0) {
+        Serial.printf(
+            "Wardriving: %d networks, %lu/min, index %lu slots %u KB, %lu untracked\n",
+            wifiNetworkCount,
+            networks_per_minute(),
+            registeredMACs.slots(),
+            registeredMACs.bytes() / 1024,
+            registeredMACs.untracked()
+        );
+    }
+
     GPSserial.end();
     restorePins();
     returnToMenu = true;
@@ -77,41 +103,41 @@ void Wardriving::end() {
 }
 
 void Wardriving::loop() {
-    int count = 0;
+    uint32_t lastData = millis();
+    uint32_t lastDraw = 0;
     returnToMenu = false;
+    wifiConnected = true;
+    // GPS parsing, scanning and the screen are all polled, nothing here waits for the radio
     while (1) {
-        display_banner();
-
         if (check(EscPress) || returnToMenu) return end();
 
         if (GPSserial.available() > 0) {
-            count = 0;
+            lastData = millis();
             while (GPSserial.available() > 0) gps.encode(GPSserial.read());
 
-            if (gps.location.isUpdated()) {
-                padprintln("GPS location updated");
-                set_position();
-                scan_networks();
+            if (gps.location.isUpdated()) set_position();
+            if (filename == "" && gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5)
+                create_filename();
+        } else if (millis() - lastData > GPS_TIMEOUT) {
+            displayError("GPS not Found!");
+            return end();
+        }
+
+        poll_scan();
+        if (file && millis() - lastFlush >= WARDRIVING_FLUSH_MS) flush_file();
+
+        if (millis() - lastDraw >= REFRESH_MS) {
+            lastDraw = millis();
+            update_top_vendor();
+            display_banner();
+            if (gps.location.isValid()) {
+                padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
+                padprintf(2, "Channel %d: %d networks\n", lastScanChannel, lastScanCount);
             } else {
-                padprintln("GPS location not updated");
                 dump_gps_data();
-
-                if (filename == "" && gps.date.year() >= CURRENT_YEAR && gps.date.year() < CURRENT_YEAR + 5)
-                    create_filename();
             }
-        } else {
-            if (count > 5) {
-                displayError("GPS not Found!");
-                return end();
-            }
-            padprintln("No GPS data available");
-            count++;
-        }
-
-        int tmp = millis();
-        while (millis() - tmp < MAX_WAIT && !gps.location.isUpdated()) {
-            if (check(EscPress) || returnToMenu) return end();
         }
+        vTaskDelay(5 / portTICK_PERIOD_MS);
     }
 }
 
@@ -134,6 +160,16 @@ void Wardriving::display_banner() {
         padprintln("File: " + filename.substring(0, filename.length() - 4), 2);
         padprintln("Unique Networks Found: " + String(wifiNetworkCount), 2);
         padprintf(2, "Distance: %.2fkm\n", distance / 1000);
+        if (topVendorCount > 0 && !topVendor.isEmpty()) {
+            padprintf(2, "Top vendor: %s (%d)\n", topVendor.c_str(), topVendorCount);
+        }
+        padprintf(2, "Rate: %lu networks/min\n", networks_per_minute());
+        padprintf(
+            2,
+            "Memory: %u KB (%lu slots)\n",
+            (registeredMACs.bytes() + WARDRIVING_CSV_BUFFER) / 1024,
+            registeredMACs.slots()
+        );
     }
 
     padprintln("");
@@ -151,7 +187,7 @@ void Wardriving::dump_gps_data() {
     padprintf(2, "HDOP: %.2f\n", gps.hdop.hdop());
 }
 
-String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
+const char *Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
     switch (authMode) {
         case WIFI_AUTH_OPEN: return "OPEN";
         case WIFI_AUTH_WEP: return "WEP";
@@ -166,19 +202,24 @@ String Wardriving::auth_mode_to_string(wifi_auth_mode_t authMode) {
     }
 }
 
-void Wardriving::scan_networks() {
-    wifiConnected = true;
+void Wardriving::start_scan() {
+    const uint8_t channel = scanChannels[scanSlot];
+    scanSlot = (scanSlot + 1) % sizeof(scanChannels);
+    const bool busy = channel == 1 || channel == 6 || channel == 11;
+    // Async esp_wifi_scan_start() on one channel, WIFI_EVENT_SCAN_DONE sets what scanComplete() reads
+    WiFi.scanNetworks(true, false, false, busy ? WARDRIVING_DWELL_BUSY_MS : WARDRIVING_DWELL_MS, channel);
+    lastScanChannel = channel;
+}
 
-    int network_amount = WiFi.scanNetworks();
-    if (network_amount == 0) {
-        padprintln("No Wi-Fi networks found", 2);
-        return;
+void Wardriving::poll_scan() {
+    int16_t result = WiFi.scanComplete();
+    if (result == WIFI_SCAN_RUNNING) return;
+    if (result >= 0) {
+        lastScanCount = result;
+        if (result > 0) log_networks(result);
+        WiFi.scanDelete();
     }
-
-    padprintf(2, "Coord: %.6f, %.6f\n", gps.location.lat(), gps.location.lng());
-    padprintln("Networks Found: " + String(network_amount), 2);
-
-    return append_to_file(network_amount);
+    start_scan();
 }
 
 void Wardriving::create_filename() {
@@ -196,12 +237,12 @@ void Wardriving::create_filename() {
     filename = String(timestamp) + "_wardriving.csv";
 }
 
-void Wardriving::append_to_file(int network_amount) {
+bool Wardriving::open_file() {
     FS *fs;
     if (!getFsStorage(fs)) {
         padprintln("Storage setup error");
         returnToMenu = true;
-        return;
+        return false;
     }
 
     if (filename == "") create_filename();
@@ -210,12 +251,14 @@ void Wardriving::append_to_file(int network_amount) {
 
     bool is_new_file = false;
     if (!(*fs).exists("/BruceWardriving/" + filename)) is_new_file = true;
-    File file = (*fs).open("/BruceWardriving/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
+    file = (*fs).open("/BruceWardriving/" + filename, is_new_file ? FILE_WRITE : FILE_APPEND);
+    if (!csvBuffer) csvBuffer = (char *)malloc(WARDRIVING_CSV_BUFFER);
 
-    if (!file) {
-        padprintln("Failed to open file for writing");
+    if (!file || !csvBuffer) {
+        padprintln(file ? "Not enough memory" : "Failed to open file for writing");
+        if (file) file.close();
         returnToMenu = true;
-        return;
+        return false;
     }
 
     if (is_new_file) {
@@ -229,44 +272,165 @@ void Wardriving::append_to_file(int network_amount) {
             "AltitudeMeters,AccuracyMeters,RCOIs,MfgrId,Type"
         );
     }
+    csvFill = 0;
+    lastFlush = millis();
+    return true;
+}
+
+void Wardriving::log_networks(int network_amount) {
+    // Without a current position the rows would be wrong, they are logged on a later pass
+    if (!gps.location.isValid() || gps.location.age() > WARDRIVING_FIX_MAX_AGE) return;
+    if (!file && !open_file()) return;
+
+    char firstSeen[20];
+    snprintf(
+        firstSeen,
+        sizeof(firstSeen),
+        "%04d-%02d-%02d %02d:%02d:%02d",
+        gps.date.year(),
+        gps.date.month(),
+        gps.date.day(),
+        gps.time.hour(),
+        gps.time.minute(),
+        gps.time.second()
+    );
 
+    uint32_t found = 0;
     for (int i = 0; i < network_amount; i++) {
-        String macAddress = WiFi.BSSIDstr(i);
-
-        // Check if MAC was already found in this session
-        if (registeredMACs.find(macAddress) == registeredMACs.end()) {
-            registeredMACs.insert(macAddress); // Adds MAC to file
-            int32_t channel = WiFi.channel(i);
-
-            char buffer[512];
-            snprintf(
-                buffer,
-                sizeof(buffer),
-                "%s,\"%s\",[%s],%04d-%02d-%02d %02d:%02d:%02d,%ld,%ld,%ld,%f,%f,%f,%f,,,WIFI\n",
-                macAddress.c_str(),
-                WiFi.SSID(i).c_str(),
-                auth_mode_to_string(WiFi.encryptionType(i)).c_str(),
-                gps.date.year(),
-                gps.date.month(),
-                gps.date.day(),
-                gps.time.hour(),
-                gps.time.minute(),
-                gps.time.second(),
-                channel,
-                channel != 14 ? 2407 + (channel * 5) : 2484,
-                WiFi.RSSI(i),
-                gps.location.lat(),
-                gps.location.lng(),
-                gps.altitude.meters(),
-                gps.hdop.hdop() * 1.0
-            );
-            file.print(buffer);
-
-            wifiNetworkCount++;
+        const wifi_ap_record_t *ap = (const wifi_ap_record_t *)WiFi.getScanInfoByIndex(i);
+        if (!ap) continue;
+
+        // Check if MAC was already found in this session, stronger signals are logged again
+        switch (registeredMACs.update(ap->bssid, ap->rssi, WARDRIVING_RSSI_STEP)) {
+            case BSSID_NEW:
+                count_vendor(ap->bssid);
+                wifiNetworkCount++;
+                found++;
+                write_row(ap, firstSeen);
+                break;
+            case BSSID_STRONGER:
+            case BSSID_UNTRACKED: write_row(ap, firstSeen); break;
+            case BSSID_SEEN: break;
         }
     }
+    count_rate(found);
+}
+
+void Wardriving::write_row(const wifi_ap_record_t *ap, const char *firstSeen) {
+    if (csvFill + CSV_ROW_MAX > WARDRIVING_CSV_BUFFER) flush_file();
+
+    // SSIDs are quoted, quotes inside are doubled
+    char ssid[2 * sizeof(ap->ssid)];
+    size_t len = 0;
+    for (const uint8_t *c = ap->ssid; c < ap->ssid + sizeof(ap->ssid) && *c; c++) {
+        if (*c == '"') ssid[len++] = '"';
+        ssid[len++] = *c;
+    }
+    ssid[len] = '\0';
+
+    const int channel = ap->primary;
+    int n = snprintf(
+        csvBuffer + csvFill,
+        WARDRIVING_CSV_BUFFER - csvFill,
+        "%02X:%02X:%02X:%02X:%02X:%02X,\"%s\",[%s],%s,%d,%d,%d,%f,%f,%f,%f,,,WIFI\n",
+        ap->bssid[0],
+        ap->bssid[1],
+        ap->bssid[2],
+        ap->bssid[3],
+        ap->bssid[4],
+        ap->bssid[5],
+        ssid,
+        auth_mode_to_string(ap->authmode),
+        firstSeen,
+        channel,
+        channel != 14 ? 2407 + (channel * 5) : 2484,
+        ap->rssi,
+        gps.location.lat(),
+        gps.location.lng(),
+        gps.altitude.meters(),
+        gps.hdop.hdop() * 1.0
+    );
+    if (n > 0) csvFill += min((size_t)n, WARDRIVING_CSV_BUFFER - csvFill - 1);
+}
+
+void Wardriving::flush_file() {
+    lastFlush = millis();
+    if (!csvFill) return;
+    if (file.write((const uint8_t *)csvBuffer, csvFill) != csvFill) log_e("Wardriving CSV write failed");
+    file.flush();
+    csvFill = 0;
+}
 
-    file.close();
+void Wardriving::count_rate(uint32_t networks) {
+    const uint32_t now = millis();
+    if (now - rateBucketStart >= 60000) {
+        memset(rateBuckets, 0, sizeof(rateBuckets));
+        rateBucketStart = now;
+    }
+    while (now - rateBucketStart >= 10000) {
+        rateBucket = (rateBucket + 1) % 6;
+        rateBuckets[rateBucket] = 0;
+        rateBucketStart += 10000;
+    }
+    rateBuckets[rateBucket] += networks;
+}
+
+uint32_t Wardriving::networks_per_minute() {
+    count_rate(0);
+    uint32_t total = 0;
+    for (uint16_t n : rateBuckets) total += n;
+    return total;
+}
+
+// Scan path: no file access, the vendor is looked up later by update_top_vendor()
+void Wardriving::count_vendor(const uint8_t *bssid) {
+    // randomized and locally assigned addresses have no vendor
+    if (bssid[0] & 0x02) return;
+    for (uint8_t i = 0; i < ouiCountsUsed; i++) {
+        OuiCount &oui = ouiCounts[i];
+        if (memcmp(oui.mac, bssid, 3) == 0) {
+            if (oui.count < UINT16_MAX) oui.count++;
+            return;
+        }
+    }
+    if (ouiCountsUsed == WARDRIVING_VENDOR_OUIS) return;
+    OuiCount &oui = ouiCounts[ouiCountsUsed++];
+    memcpy(oui.mac, bssid, 6);
+    oui.resolved = false;
+    oui.vendor = OUI_DB_UNKNOWN;
+    oui.count = 1;
+}
+
+void Wardriving::update_top_vendor() {
+    uint8_t lookups = 0;
+    for (uint8_t i = 0; i < ouiCountsUsed && lookups < WARDRIVING_VENDOR_LOOKUPS; i++) {
+        OuiCount &oui = ouiCounts[i];
+        if (oui.resolved) continue;
+        oui.vendor = ouiDb.vendorId(oui.mac);
+        oui.resolved = true;
+        lookups++;
+    }
+
+    // a vendor owns several OUIs, their counts add up
+    uint32_t bestId = OUI_DB_UNKNOWN;
+    int best = 0;
+    for (uint8_t i = 0; i < ouiCountsUsed; i++) {
+        const uint32_t id = ouiCounts[i].vendor;
+        if (id == OUI_DB_UNKNOWN || id == bestId) continue;
+        int count = 0;
+        for (uint8_t j = 0; j < ouiCountsUsed; j++) {
+            if (ouiCounts[j].vendor == id) count += ouiCounts[j].count;
+        }
+        if (count > best) {
+            best = count;
+            bestId = id;
+        }
+    }
+    topVendorCount = best;
+    if (bestId != topVendorId) {
+        topVendorId = bestId;
+        topVendor = ouiDb.vendorName(bestId);
+    }
 }
 
 void Wardriving::releasePins() {
@@ -9,10 +9,42 @@
 #ifndef __WAR_DRIVING_H__
 #define __WAR_DRIVING_H__
 
+#include "bssid_set.h"
+#include "core/oui_db.h"
 #include <TinyGPS++.h>
 #include <esp_wifi_types.h>
 #include <globals.h>
-#include <set>
+
+// Active scan time per channel. 1, 6 and 11 carry most networks and get the longer one
+#ifndef WARDRIVING_DWELL_MS
+#define WARDRIVING_DWELL_MS 80
+#endif
+#ifndef WARDRIVING_DWELL_BUSY_MS
+#define WARDRIVING_DWELL_BUSY_MS 150
+#endif
+// CSV rows are collected in RAM and written when the buffer is full or this often
+#ifndef WARDRIVING_CSV_BUFFER
+#define WARDRIVING_CSV_BUFFER 4096
+#endif
+#ifndef WARDRIVING_FLUSH_MS
+#define WARDRIVING_FLUSH_MS 10000
+#endif
+// A network seen again this many dB stronger is logged again, with the new position
+#ifndef WARDRIVING_RSSI_STEP
+#define WARDRIVING_RSSI_STEP 10
+#endif
+// Scan results are only logged with a fix younger than this
+#ifndef WARDRIVING_FIX_MAX_AGE
+#define WARDRIVING_FIX_MAX_AGE 2000
+#endif
+// New networks are counted per OUI while scanning, OUIs past this many are not counted
+#ifndef WARDRIVING_VENDOR_OUIS
+#define WARDRIVING_VENDOR_OUIS 64
+#endif
+// OUIs matched to their vendor in the OUI database on each screen refresh
+#ifndef WARDRIVING_VENDOR_LOOKUPS
+#define WARDRIVING_VENDOR_LOOKUPS 2
+#endif
 
 class Wardriving {
 public:
@@ -37,10 +69,33 @@ private:
     String filename = "";
     TinyGPSPlus gps;
     HardwareSerial GPSserial = HardwareSerial(2); // Uses UART2 for GPS
-    std::set<String> registeredMACs;              // Store and track registered MAC
+    BssidSet registeredMACs;                      // Store and track registered MAC
     int wifiNetworkCount = 0;                     // Counter fo wifi networks
+    struct OuiCount {
+        uint8_t mac[6];  // first network seen with the OUI, picks the block of a split OUI
+        bool resolved;   // vendor looked up
+        uint32_t vendor; // OuiDb::vendorId()
+        uint16_t count;
+    };
+    OuiCount ouiCounts[WARDRIVING_VENDOR_OUIS]; // New networks per OUI
+    uint8_t ouiCountsUsed = 0;
+    uint32_t topVendorId = OUI_DB_UNKNOWN;
+    String topVendor = "";
+    int topVendorCount = 0;
     bool rxPinReleased = false;
 
+    File file;
+    char *csvBuffer = nullptr;
+    size_t csvFill = 0;
+    uint32_t lastFlush = 0;
+
+    uint8_t scanSlot = 0; // next entry of the channel plan
+    int lastScanChannel = 0;
+    int lastScanCount = 0;
+    uint16_t rateBuckets[6] = {}; // new networks per 10 s, for networks/minute
+    uint8_t rateBucket = 0;
+    uint32_t rateBucketStart = 0;
+
     /////////////////////////////////////////////////////////////////////////////////////
     // Setup
     /////////////////////////////////////////////////////////////////////////////////////
@@ -60,9 +115,17 @@ private:
     // Operations
     /////////////////////////////////////////////////////////////////////////////////////
     void set_position(void);
-    void scan_networks(void);
-    String auth_mode_to_string(wifi_auth_mode_t authMode);
-    void append_to_file(int network_amount);
+    void start_scan(void);
+    void poll_scan(void);
+    void log_networks(int network_amount);
+    const char *auth_mode_to_string(wifi_auth_mode_t authMode);
+    bool open_file(void);
+    void write_row(const wifi_ap_record_t *ap, const char *firstSeen);
+    void flush_file(void);
+    void count_vendor(const uint8_t *bssid);
+    void update_top_vendor(void);
+    void count_rate(uint32_t networks);
+    uint32_t networks_per_minute(void);
     void create_filename(void);
 };
 
@@ -5,6 +5,7 @@
 #include "core/sd_functions.h"
 #include "core/settings.h"
 #include "core/type_convertion.h"
+#include "ir_file.h"
 #include "ir_utils.h"
 #include <IRutils.h>
 
@@ -16,13 +17,6 @@ uint32_t swap32(uint32_t value) {
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Custom IR
 
-static std::vector<IRCode *> codes;
-
-void resetCodesArray() {
-    for (auto code : codes) { delete code; }
-    codes.clear();
-}
-
 static std::vector<IRCode *> recent_ircodes;
 
 void addToRecentCodes(IRCode *ircode) {
@@ -72,124 +66,29 @@ void selectRecentIrMenu() {
 
 bool txIrFile(FS *fs, String filepath, bool hideDefaultUI) {
     // SPAM all codes of the file
-
-    int total_codes = 0;
-    String line;
-
-    File databaseFile = fs->open(filepath, FILE_READ);
+    IrFileIndex index;
 
     setup_ir_pin(bruceConfigPins.irTx, OUTPUT);
     // digitalWrite(bruceConfigPins.irTx, LED_ON);
 
-    if (!databaseFile) {
+    if (!index.open(fs, filepath)) {
         Serial.println("Failed to open database file.");
         displayError("Fail to open file");
         delay(2000);
         return false;
     }
-    Serial.println("Opened database file.");
 
     bool endingEarly = false;
-    int codes_sent = 0;
-    uint16_t frequency = 0;
-    String rawData = "";
-    String protocol = "";
-    String address = "";
-    String command = "";
-    String value = "";
-    uint8_t bits = 32;
-
-    databaseFile.seek(0); // comes back to first position
-
-    // count the number of codes to replay
-    while (databaseFile.available()) {
-        line = databaseFile.readStringUntil('\n');
-        if (line.startsWith("type:")) total_codes++;
-    }
+    size_t total_codes = index.size();
+    IrIndexEntry entry;
+
+    Serial.printf("\nStarted SPAM all codes with: %d codes\n", total_codes);
+    for (size_t i = 0; i < total_codes; i++) {
+        if (!hideDefaultUI) { progressHandler(i + 1, total_codes); }
+        IRCode code;
+        if (!index.get(i, entry)) break;
+        if (index.loadCode(entry, code)) sendIRCommand(&code, hideDefaultUI);
 
-    Serial.printf("\nStarted SPAM all codes with: %d codes", total_codes);
-    // comes back to first position, beggining of the file
-    databaseFile.seek(0);
-    while (databaseFile.available()) {
-        if (!hideDefaultUI) { progressHandler(codes_sent, total_codes); }
-        line = databaseFile.readStringUntil('\n');
-        if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-        if (line.startsWith("type:")) {
-            codes_sent++;
-            String type = line.substring(5);
-            type.trim();
-            Serial.println("Type: " + type);
-            if (type == "raw") {
-                Serial.println("RAW code");
-                while (databaseFile.available()) {
-                    line = databaseFile.readStringUntil('\n');
-                    if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-                    if (line.startsWith("frequency:")) {
-                        line = line.substring(10);
-                        line.trim();
-                        frequency = line.toInt();
-                        Serial.printf("Frequency: %d\n", frequency);
-                    } else if (line.startsWith("data:")) {
-                        rawData = line.substring(5);
-                        rawData.trim();
-                        Serial.println("RawData: " + rawData);
-                    } else if ((frequency != 0 && rawData != "") || line.startsWith("#")) {
-                        IRCode code;
-                        code.type = "raw";
-                        code.data = rawData;
-                        code.frequency = frequency;
-                        sendIRCommand(&code, hideDefaultUI);
-
-                        rawData = "";
-                        frequency = 0;
-                        type = "";
-                        line = "";
-                        break;
-                    }
-                }
-            } else if (type == "parsed") {
-                Serial.println("PARSED");
-                while (databaseFile.available()) {
-                    line = databaseFile.readStringUntil('\n');
-                    if (line.endsWith("\r")) line.remove(line.length() - 1);
-
-                    if (line.startsWith("protocol:")) {
-                        protocol = line.substring(9);
-                        protocol.trim();
-                        Serial.println("Protocol: " + protocol);
-                    } else if (line.startsWith("address:")) {
-                        address = line.substring(8);
-                        address.trim();
-                        Serial.println("Address: " + address);
-                    } else if (line.startsWith("command:")) {
-                        command = line.substring(8);
-                        command.trim();
-                        Serial.println("Command: " + command);
-                    } else if (line.startsWith("value:") || line.startsWith("state:")) {
-                        value = line.substring(6);
-                        value.trim();
-                        Serial.println("Value: " + value);
-                    } else if (line.startsWith("bits:")) {
-                        bits = line.substring(strlen("bits:")).toInt();
-                        Serial.println("bits: " + bits);
-                    } else if (line.indexOf("#") != -1) { // TODO: also detect EOF
-                        IRCode code(protocol, address, command, value, bits);
-                        sendIRCommand(&code, hideDefaultUI);
-
-                        protocol = "";
-                        address = "";
-                        command = "";
-                        value = "";
-                        bits = 32;
-                        type = "";
-                        line = "";
-                        break;
-                    }
-                }
-            }
-        }
         // if user is pushing (holding down) TRIGGER button, stop transmission early
         if (check(SelPress)) // Pause TV-B-Gone
         {
@@ -206,22 +105,17 @@ bool txIrFile(FS *fs, String filepath, bool hideDefaultUI) {
             if (endingEarly) break; // Cancels  custom IR Spam
             if (!hideDefaultUI) { displayTextLine("Running, Wait"); }
         }
-    } // end while file has lines to process
-    databaseFile.close();
-    Serial.println("closed");
+    }
+    index.close();
     Serial.println("EXTRA finished");
 
-    resetCodesArray();
     digitalWrite(bruceConfigPins.irTx, LED_OFF);
     return true;
 }
 
 void otherIRcodes() {
     checkIrTxPin();
-    resetCodesArray();
-    int total_codes = 0;
     String filepath;
-    File databaseFile;
     FS *fs = NULL;
 
     returnToMenu = true; // make sure menu is redrawn when quitting in any point
@@ -264,68 +158,36 @@ void otherIRcodes() {
         return;
     }
 
-    // else continue and try to parse the file
-
-    databaseFile = fs->open(filepath, FILE_READ);
+    // else continue and list the codes of the file
+    IrFileIndex index;
     drawMainBorder();
 
-    if (!databaseFile) {
+    if (!index.open(fs, filepath)) {
         Serial.println("Failed to open database file.");
-        // displayError("Fail to open file");
-        // delay(2000);
         return;
     }
-    Serial.println("Opened database file.");
 
     setup_ir_pin(bruceConfigPins.irTx, OUTPUT);
     // digitalWrite(bruceConfigPins.irTx, LED_ON);
 
     // Mode to choose and send command by command limitted to 100 commands
-    String line;
-    String txt;
-    codes.push_back(new IRCode());
-    while (databaseFile.available() && total_codes < 100) {
-        line = databaseFile.readStringUntil('\n');
-        txt = line.substring(line.indexOf(":") + 1);
-        txt.trim();
-        if (line.startsWith("name:")) {
-            // in case that the separation between codes are not made by "#" line
-            if (codes[total_codes]->name != "") {
-                total_codes++;
-                codes.push_back(new IRCode());
-            }
-            // save signal name
-            codes[total_codes]->name = txt;
-            codes[total_codes]->filepath = txt + " " + filepath.substring(1 + filepath.lastIndexOf("/"));
-        }
-        if (line.startsWith("type:")) codes[total_codes]->type = txt;
-        if (line.startsWith("protocol:")) codes[total_codes]->protocol = txt;
-        if (line.startsWith("address:")) codes[total_codes]->address = txt;
-        if (line.startsWith("frequency:")) codes[total_codes]->frequency = txt.toInt();
-        if (line.startsWith("bits:")) codes[total_codes]->bits = txt.toInt();
-        if (line.startsWith("command:")) codes[total_codes]->command = txt;
-        if (line.startsWith("data:") || line.startsWith("value:") || line.startsWith("state:")) {
-            codes[total_codes]->data = txt;
-        }
-        // if there are a line with "#", and the code name isnt't "" (there are a signal saved), go to next
-        // signal
-        if (line.startsWith("#") && total_codes < codes.size() && codes[total_codes]->name != "") {
-            total_codes++;
-            codes.push_back(new IRCode());
-        }
-        // if(line.startsWith("duty_cycle:")) codes[total_codes]->duty_cycle = txt.toFloat();
-    }
+    // Codes are loaded from the file only when selected
+    String fileName = filepath.substring(1 + filepath.lastIndexOf("/"));
+    IrIndexEntry entry;
     options = {};
-    for (auto code : codes) {
-        if (code->name != "") {
-            options.push_back({code->name.c_str(), [code]() {
-                                   sendIRCommand(code);
-                                   addToRecentCodes(code);
-                               }});
-        }
+    for (size_t i = 0; i < index.size() && options.size() < 100; i++) {
+        if (!index.get(i, entry)) break;
+        if (entry.name[0] == '\0') continue;
+        options.push_back({entry.name, [&index, i, fileName]() {
+                               IrIndexEntry selected;
+                               IRCode code;
+                               if (!index.get(i, selected) || !index.loadCode(selected, code)) return;
+                               code.filepath = code.name + " " + fileName;
+                               sendIRCommand(&code);
+                               addToRecentCodes(&code);
+                           }});
     }
     options.push_back({"Main Menu", [&]() { exit = true; }});
-    databaseFile.close();
 
 #ifdef USE_BOOST /// DISABLE 5V OUTPUT
     PPM.disableOTG();
@@ -1,3 +1,5 @@
+#ifndef __CUSTOM_IR_H__
+#define __CUSTOM_IR_H__
 
 #include <Arduino.h>
 #include <FS.h>
@@ -50,3 +52,5 @@ void sendKaseikyoCommand(String address, String command, bool hideDefaultUI = fa
 bool sendDecodedCommand(String protocol, String value, uint8_t bits = 32, bool hideDefaultUI = false);
 void otherIRcodes();
 bool txIrFile(FS *fs, String filepath, bool hideDefaultUI = false);
+
+#endif
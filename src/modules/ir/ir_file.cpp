@@ -0,0 +1,133 @@
+#include "ir_file.h"
+
+/////////////////////////////////////////////////////////////////////////////////////
+// IrFileIndex
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool IrFileIndex::open(FS *fs, const String &filepath) {
+    close();
+    _fs = fs;
+    _source = fs->open(filepath, FILE_READ);
+    if (!_source) return false;
+
+    const uint32_t size = _source.size();
+    const uint32_t mtime = (uint32_t)_source.getLastWrite();
+    const String idxPath = filepath + ".idx";
+    uint32_t start = millis();
+
+    if (size >= IR_INDEX_MIN_SIZE && openIndex(idxPath, size, mtime)) {
+        Serial.printf("IR index: %u codes loaded in %lu ms\n", _count, millis() - start);
+        return true;
+    }
+    if (!buildIndex(idxPath, size, mtime)) {
+        close();
+        return false;
+    }
+    Serial.printf("IR index: %u codes parsed in %lu ms\n", _count, millis() - start);
+    return true;
+}
+
+void IrFileIndex::close() {
+    if (_source) _source.close();
+    if (_index) _index.close();
+    _entries.clear();
+    _entries.shrink_to_fit();
+    _count = 0;
+}
+
+bool IrFileIndex::openIndex(const String &idxPath, uint32_t size, uint32_t mtime) {
+    if (!_fs->exists(idxPath)) return false;
+    _index = _fs->open(idxPath, FILE_READ);
+    if (!_index) return false;
+
+    IrIndexHeader header;
+    if (_index.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && header.magic == IR_INDEX_MAGIC &&
+        header.version == IR_INDEX_VERSION && header.entrySize == sizeof(IrIndexEntry) &&
+        header.sourceSize == size && header.sourceMtime == mtime &&
+        _index.size() == sizeof(header) + header.count * sizeof(IrIndexEntry)) {
+        _count = header.count;
+        return true;
+    }
+    _index.close(); // stale
+    return false;
+}
+
+size_t IrFileIndex::parseSource(std::function<void(const IrIndexEntry &)> onCode) {
+    IrFileParser parser(onCode);
+    char buf[512];
+    int n;
+    _source.seek(0);
+    while ((n = _source.read((uint8_t *)buf, sizeof(buf))) > 0) parser.feed(buf, n);
+    parser.finish();
+    return parser.count();
+}
+
+bool IrFileIndex::writeIndex(const String &path, uint32_t size, uint32_t mtime) {
+    File out = _fs->open(path, FILE_WRITE);
+    if (!out) return false;
+
+    IrIndexHeader header = {};
+    bool ok = out.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    size_t count = parseSource([&](const IrIndexEntry &entry) {
+        if (ok) ok = out.write((const uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+    });
+    if (ok) {
+        header = {IR_INDEX_MAGIC, IR_INDEX_VERSION, sizeof(IrIndexEntry), size, mtime, (uint32_t)count};
+        ok = out.seek(0) && out.write((const uint8_t *)&header, sizeof(header)) == sizeof(header);
+    }
+    out.close();
+    if (!ok) _fs->remove(path);
+    return ok;
+}
+
+bool IrFileIndex::buildIndex(const String &idxPath, uint32_t size, uint32_t mtime) {
+    if (size >= IR_INDEX_MIN_SIZE) {
+        const String tmpPath = idxPath + ".tmp";
+        if (writeIndex(tmpPath, size, mtime)) {
+            if (_fs->exists(idxPath)) _fs->remove(idxPath);
+            if (_fs->rename(tmpPath, idxPath) && openIndex(idxPath, size, mtime)) return true;
+            _fs->remove(tmpPath);
+        }
+        log_w("IR index not writable, keeping it in RAM");
+    }
+
+    // Small file or read-only storage: keep the entries in RAM
+    _count = parseSource([&](const IrIndexEntry &entry) { _entries.push_back(entry); });
+    return true;
+}
+
+bool IrFileIndex::get(size_t i, IrIndexEntry &entry) {
+    if (i >= _count) return false;
+    if (!_index) {
+        if (i >= _entries.size()) return false;
+        entry = _entries[i];
+        return true;
+    }
+    if (!_index.seek(sizeof(IrIndexHeader) + i * sizeof(IrIndexEntry))) return false;
+    return _index.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+}
+
+bool IrFileIndex::loadCode(const IrIndexEntry &entry, IRCode &code) {
+    String data;
+    if (entry.dataLen > 0) {
+        if (!data.reserve(entry.dataLen) || !_source.seek(entry.dataOffset)) return false;
+        char buf[64];
+        uint32_t left = entry.dataLen;
+        while (left > 0) {
+            int n = _source.read((uint8_t *)buf, left < sizeof(buf) ? left : sizeof(buf));
+            if (n <= 0) return false;
+            data.concat(buf, n);
+            left -= n;
+        }
+    }
+
+    code.name = entry.name;
+    code.type = entry.type == IR_TYPE_RAW ? "raw" : "parsed";
+    code.protocol = entry.protocol;
+    code.address = entry.address;
+    code.command = entry.command;
+    code.frequency = entry.frequency;
+    code.bits = entry.bits;
+    code.data = data;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef __IR_FILE_H__
+#define __IR_FILE_H__
+
+#include "custom_ir.h"
+#include "ir_file_parser.h"
+#include <FS.h>
+#include <functional>
+#include <vector>
+
+// Files smaller than this are parsed on every open, bigger ones get a ".idx" sidecar
+#ifndef IR_INDEX_MIN_SIZE
+#define IR_INDEX_MIN_SIZE 4096
+#endif
+
+#define IR_INDEX_MAGIC 0x58524942 // "BIRX"
+#define IR_INDEX_VERSION 1
+
+struct IrIndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entrySize;
+    uint32_t sourceSize;
+    uint32_t sourceMtime;
+    uint32_t count;
+};
+
+/*********************************************************************
+**  Class: IrFileIndex
+**  Opens an .ir file through its binary index, rebuilding the index
+**  when the source size or modification time changed.
+**********************************************************************/
+class IrFileIndex {
+public:
+    ~IrFileIndex() { close(); }
+
+    bool open(FS *fs, const String &filepath);
+    void close();
+    size_t size() const { return _count; }
+    bool get(size_t i, IrIndexEntry &entry);
+    bool loadCode(const IrIndexEntry &entry, IRCode &code);
+
+private:
+    FS *_fs = nullptr;
+    File _source;
+    File _index;
+    size_t _count = 0;
+    std::vector<IrIndexEntry> _entries; // used when no index file is available
+
+    bool openIndex(const String &idxPath, uint32_t size, uint32_t mtime);
+    bool buildIndex(const String &idxPath, uint32_t size, uint32_t mtime);
+    bool writeIndex(const String &path, uint32_t size, uint32_t mtime);
+    size_t parseSource(std::function<void(const IrIndexEntry &)> onCode);
+};
+
+#endif
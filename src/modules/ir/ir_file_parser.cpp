@@ -0,0 +1,130 @@
+/**
+ * @file ir_file_parser.cpp
+ * @brief Single pass tokenizer for Flipper .ir files
+ */
+
+#include "ir_file_parser.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static_assert(sizeof(IrIndexEntry) == 80, "IrIndexEntry layout is stored on disk");
+
+static void copyField(char *dst, size_t size, const char *src) {
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// IrFileParser
+/////////////////////////////////////////////////////////////////////////////////////
+
+IrFileParser::IrFileParser(std::function<void(const IrIndexEntry &)> onCode) : _onCode(onCode) {
+    resetEntry();
+}
+
+void IrFileParser::resetEntry() {
+    memset(&_entry, 0, sizeof(_entry));
+    _entry.bits = 32;
+    _inRecord = false;
+    _dataTooLong = false;
+}
+
+void IrFileParser::feed(const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        const char c = buf[i];
+        const uint32_t pos = _offset++;
+        switch (_state) {
+            case LINE_START:
+                if (c == '\n' || c == '\r' || c == ' ' || c == '\t') break;
+                if (c == '#') { // record separator
+                    endRecord();
+                    _state = SKIP_LINE;
+                    break;
+                }
+                _keyLen = 0;
+                _state = KEY;
+                // fall through
+            case KEY:
+                if (c == ':') {
+                    _key[_keyLen] = '\0';
+                    _valueLen = 0;
+                    _valueOffset = _valueEnd = pos + 1;
+                    _state = VALUE_START;
+                } else if (c == '\n') {
+                    _state = LINE_START; // line without a key, ignore it
+                } else if (_keyLen < sizeof(_key) - 1) {
+                    _key[_keyLen++] = c;
+                } else {
+                    _state = SKIP_LINE; // not a key we care about
+                }
+                break;
+            case VALUE_START:
+                if (c == ' ' || c == '\t') break;
+                _valueOffset = _valueEnd = pos;
+                _state = VALUE;
+                // fall through
+            case VALUE:
+                if (c == '\n' || c == '\r') {
+                    endField();
+                    _state = c == '\n' ? LINE_START : SKIP_LINE;
+                    break;
+                }
+                if (c != ' ' && c != '\t') _valueEnd = pos + 1;
+                if (_valueLen < sizeof(_value) - 1) _value[_valueLen++] = c;
+                break;
+            case SKIP_LINE:
+                if (c == '\n') _state = LINE_START;
+                break;
+        }
+    }
+}
+
+void IrFileParser::finish() {
+    if (_state == VALUE || _state == VALUE_START) endField();
+    endRecord();
+    _state = LINE_START;
+}
+
+void IrFileParser::endField() {
+    const uint32_t len = _valueEnd - _valueOffset;
+    _value[len < _valueLen ? len : _valueLen] = '\0';
+
+    if (strcmp(_key, "name") == 0) {
+        if (_inRecord) endRecord();
+        _inRecord = true;
+        copyField(_entry.name, sizeof(_entry.name), _value);
+    } else if (strcmp(_key, "type") == 0) {
+        // files without "name:" lines start a new code on each "type:"
+        if (_entry.type != IR_TYPE_NONE) endRecord();
+        _inRecord = true;
+        _entry.type = strcasecmp(_value, "raw") == 0 ? IR_TYPE_RAW : IR_TYPE_PARSED;
+    } else if (strcmp(_key, "protocol") == 0) {
+        copyField(_entry.protocol, sizeof(_entry.protocol), _value);
+    } else if (strcmp(_key, "address") == 0) {
+        copyField(_entry.address, sizeof(_entry.address), _value);
+    } else if (strcmp(_key, "command") == 0) {
+        copyField(_entry.command, sizeof(_entry.command), _value);
+    } else if (strcmp(_key, "frequency") == 0) {
+        _entry.frequency = atoi(_value);
+    } else if (strcmp(_key, "bits") == 0) {
+        _entry.bits = atoi(_value);
+    } else if (strcmp(_key, "data") == 0 || strcmp(_key, "value") == 0 || strcmp(_key, "state") == 0) {
+        _entry.dataOffset = _valueOffset;
+        _entry.dataLen = len > UINT16_MAX ? 0 : len;
+        _dataTooLong = len > UINT16_MAX;
+    }
+}
+
+void IrFileParser::endRecord() {
+    bool valid = false;
+    if (_entry.type == IR_TYPE_RAW) valid = _entry.dataLen > 0 && !_dataTooLong;
+    else if (_entry.type == IR_TYPE_PARSED) valid = _entry.protocol[0] != '\0';
+
+    if (valid) {
+        if (_entry.type == IR_TYPE_RAW && _entry.frequency == 0) _entry.frequency = 38000;
+        _onCode(_entry);
+        _count++;
+    }
+    resetEntry();
+}
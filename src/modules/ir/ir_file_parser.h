@@ -0,0 +1,67 @@
+/**
+ * @file ir_file_parser.h
+ * @brief Single pass tokenizer for Flipper .ir files
+ *
+ * No Arduino dependencies, it only sees the bytes it is fed.
+ */
+
+#ifndef __IR_FILE_PARSER_H__
+#define __IR_FILE_PARSER_H__
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+
+enum IrCodeType : uint8_t { IR_TYPE_NONE = 0, IR_TYPE_PARSED = 1, IR_TYPE_RAW = 2 };
+
+// One code of a Flipper .ir file. Raw samples and decoded values stay in the
+// source file, only their position is kept.
+struct IrIndexEntry {
+    uint32_t dataOffset; // file offset of the data:/value:/state: contents
+    uint16_t dataLen;
+    uint16_t frequency;
+    uint8_t type; // IrCodeType
+    uint8_t bits;
+    char protocol[14];
+    char address[12];
+    char command[12];
+    char name[32];
+};
+
+/*********************************************************************
+**  Class: IrFileParser
+**  Single pass tokenizer for .ir files. Chunks of the file are fed in
+**  order and every complete code is reported through the callback,
+**  without building a String per line.
+**********************************************************************/
+class IrFileParser {
+public:
+    explicit IrFileParser(std::function<void(const IrIndexEntry &)> onCode);
+
+    void feed(const char *buf, size_t len);
+    void finish();
+    size_t count() const { return _count; }
+
+private:
+    enum State : uint8_t { LINE_START, KEY, VALUE_START, VALUE, SKIP_LINE };
+
+    std::function<void(const IrIndexEntry &)> _onCode;
+    IrIndexEntry _entry;
+    bool _inRecord = false;
+    bool _dataTooLong = false;
+    State _state = LINE_START;
+    uint32_t _offset = 0;
+    char _key[12];
+    uint8_t _keyLen = 0;
+    char _value[40];
+    uint8_t _valueLen = 0;
+    uint32_t _valueOffset = 0;
+    uint32_t _valueEnd = 0;
+    size_t _count = 0;
+
+    void endField();
+    void endRecord();
+    void resetEntry();
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include <core/utils.h>
 #include <globals.h>
 #include <vector>
+#include "lora_log.h"
 
 extern BruceConfigPins bruceConfigPins;
 
@@ -20,10 +21,37 @@ String msg;
 String rcvmsg;
 String displayName;
 bool intlora = true;
-// scrolling thing
-std::vector<String> messages;
-int scrollOffset = 0;
+// scrolling thing, only the lines on screen are kept in RAM
 const int maxMessages = 19;
+struct ChatLine {
+    String text;
+    LoraLogPos start;
+    LoraLogPos end;
+};
+ChatLine chatLines[maxMessages];
+int chatHead = 0;  // ring index of the top line
+int chatCount = 0; // lines in the ring
+bool followTail = true;
+uint32_t unseenMessages = 0;
+bool headerDirty = true;
+LoraLog chatLog;
+
+#ifndef LORA_RX_QUEUE
+#define LORA_RX_QUEUE 8
+#endif
+#define LORA_MAX_PACKET 255
+
+struct LoraPacket {
+    uint16_t len;
+    int16_t rssi10;
+    int8_t snr4;
+    uint8_t data[LORA_MAX_PACKET];
+};
+QueueHandle_t loraRxQueue = nullptr;
+SemaphoreHandle_t loraRadioLock = nullptr;
+TaskHandle_t loraRxTask = nullptr;
+volatile bool loraRxStop = false;
+volatile uint32_t loraRxDropped = 0;
 
 #define spreadingFactor 9
 #define SignalBandwidth 31.25E3
@@ -81,6 +109,16 @@ void clearLoraRadio() {
 void onLoraPacket() {
     if (!loraInterruptEnabled) return;
     loraPacketReceived = true;
+    if (loraRxTask) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loraRxTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+PhysicalLayer *activeLoraRadio() {
+    if (loraRadioVariant == LoRaRadioVariant::SX1262) return lora1262;
+    return lora1276;
 }
 
 SPIClass *selectLoraSPIBus() {
@@ -173,6 +211,7 @@ bool startLoraRadio(float bandMHz) {
 
 bool sendLoraMessage(String &payload) {
     if (!intlora) return false;
+    if (loraRadioLock) xSemaphoreTake(loraRadioLock, portMAX_DELAY);
     loraInterruptEnabled = false;
     int state = RADIOLIB_ERR_NONE;
     if (loraRadioVariant == LoRaRadioVariant::SX1276 && lora1276) {
@@ -183,9 +222,11 @@ bool sendLoraMessage(String &payload) {
         lora1262->startReceive();
     } else {
         loraInterruptEnabled = true;
+        if (loraRadioLock) xSemaphoreGive(loraRadioLock);
         return false;
     }
     loraInterruptEnabled = true;
+    if (loraRadioLock) xSemaphoreGive(loraRadioLock);
     if (state != RADIOLIB_ERR_NONE) {
         Serial.printf("LoRa transmit failed: %d\n", state);
         displayError("LoRa send failed");
@@ -194,69 +235,188 @@ bool sendLoraMessage(String &payload) {
     return true;
 }
 
-void reciveMessage() {
-    if (!loraPacketReceived || !intlora) return;
+// Reads the pending packet and restarts reception, the radio is locked meanwhile
+bool readLoraPacket(LoraPacket &pkt) {
+    PhysicalLayer *radio = activeLoraRadio();
+    if (!radio || !intlora) return false;
+    xSemaphoreTake(loraRadioLock, portMAX_DELAY);
     loraInterruptEnabled = false;
     loraPacketReceived = false;
-    String incoming;
-    int state = (loraRadioVariant == LoRaRadioVariant::SX1262 && lora1262)
-                    ? lora1262->readData(incoming)
-                    : (lora1276 ? lora1276->readData(incoming) : -1);
-    if (state == RADIOLIB_ERR_NONE) {
-        rcvmsg = incoming;
-        Serial.println("Recived:" + rcvmsg);
-        File file = LittleFS.open("/chats.txt", "a");
-        file.println(rcvmsg);
-        file.close();
-        messages.push_back(rcvmsg);
-        if (messages.size() > maxMessages) { scrollOffset = messages.size() - maxMessages; }
+    size_t len = min(radio->getPacketLength(), (size_t)LORA_MAX_PACKET);
+    int state = radio->readData(pkt.data, len);
+    pkt.len = len;
+    pkt.rssi10 = radio->getRSSI() * 10;
+    pkt.snr4 = radio->getSNR() * 4;
+    radio->startReceive();
+    loraInterruptEnabled = true;
+    xSemaphoreGive(loraRadioLock);
+    if (state != RADIOLIB_ERR_NONE) Serial.printf("LoRa read failed: %d\n", state);
+    return state == RADIOLIB_ERR_NONE;
+}
+
+// Empties the radio as soon as the IRQ fires, so bursts are not lost while the UI draws
+void loraRxLoop(void *param) {
+    LoraPacket pkt;
+    while (!loraRxStop) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (loraRxStop) break;
+        if (readLoraPacket(pkt) && xQueueSend(loraRxQueue, &pkt, 0) != pdTRUE) loraRxDropped++;
+    }
+    loraRxTask = nullptr;
+    vTaskDelete(NULL);
+}
+
+// A radio on the display or SD card bus is read from the UI loop, never in parallel with drawing
+bool loraSharesUiBus() {
+    if (loraSpi == &sdcardSPI) return true;
+#if TFT_MOSI > 0
+    if (loraSpi == &tft.getSPIinstance()) return true;
+#endif
+    return false;
+}
+
+void startLoraRx() {
+    if (!loraRxQueue) loraRxQueue = xQueueCreate(LORA_RX_QUEUE, sizeof(LoraPacket));
+    if (!loraRadioLock) loraRadioLock = xSemaphoreCreateMutex();
+    xQueueReset(loraRxQueue);
+    loraRxStop = false;
+    loraRxDropped = 0;
+    if (!loraSharesUiBus()) { xTaskCreate(loraRxLoop, "lora_rx", 4096, NULL, 3, &loraRxTask); }
+}
+
+void stopLoraRx() {
+    if (!loraRxTask) return;
+    loraRxStop = true;
+    xTaskNotifyGive(loraRxTask);
+    while (loraRxTask) vTaskDelay(pdMS_TO_TICKS(5));
+}
+
+// chat window, a ring of the lines on screen
+
+ChatLine &chatLine(int row) { return chatLines[(chatHead + row) % maxMessages]; }
+
+String formatChatLine(const LoraLogRecord &rec) {
+    if (rec.sender.isEmpty()) return rec.text;
+    return rec.sender + ": " + rec.text;
+}
+
+void pushChatLineBack(const LoraLogRecord &rec, const LoraLogPos &start, const LoraLogPos &end) {
+    if (chatCount == maxMessages) {
+        chatHead = (chatHead + 1) % maxMessages;
+        chatCount--;
+    }
+    chatLine(chatCount++) = {formatChatLine(rec), start, end};
+}
+
+void pushChatLineFront(const LoraLogRecord &rec, const LoraLogPos &start, const LoraLogPos &end) {
+    chatHead = (chatHead + maxMessages - 1) % maxMessages;
+    if (chatCount < maxMessages) chatCount++;
+    chatLine(0) = {formatChatLine(rec), start, end};
+}
+
+void addChatMessage(const LoraLogRecord &rec) {
+    LoraLogPos start, end;
+    if (!chatLog.append(rec, &start, &end)) {
+        Serial.println("Failed to log LoRa message");
+        return;
+    }
+    if (followTail) {
+        pushChatLineBack(rec, start, end);
         update = true;
     } else {
-        Serial.printf("LoRa read failed: %d\n", state);
+        unseenMessages++;
+        headerDirty = true;
     }
-    if (loraRadioVariant == LoRaRadioVariant::SX1262 && lora1262) {
-        lora1262->startReceive();
-    } else if (lora1276) {
-        lora1276->startReceive();
+}
+
+void reciveMessage() {
+    if (!intlora) return;
+    if (!loraRxTask && loraPacketReceived) {
+        LoraPacket pkt;
+        if (readLoraPacket(pkt)) xQueueSend(loraRxQueue, &pkt, 0);
+    }
+    LoraPacket pkt;
+    while (xQueueReceive(loraRxQueue, &pkt, 0) == pdTRUE) {
+        rcvmsg = String((const char *)pkt.data, pkt.len);
+        Serial.println("Recived:" + rcvmsg);
+        LoraLogRecord rec;
+        rec.time = time(nullptr);
+        rec.rssi10 = pkt.rssi10;
+        rec.snr4 = pkt.snr4;
+        // chat messages are "name: text"
+        int sep = rcvmsg.indexOf(": ");
+        if (sep > 0 && sep < 64) {
+            rec.sender = rcvmsg.substring(0, sep);
+            rec.text = rcvmsg.substring(sep + 2);
+        } else {
+            rec.text = rcvmsg;
+        }
+        addChatMessage(rec);
     }
-    loraInterruptEnabled = true;
 }
 
 // render stuff
 
 void render() {
-    if (!update) return;
+    if (!update && !headerDirty) return;
     tft.setTextSize(1);
-    tft.fillScreen(TFT_BLACK);
-    tft.setTextColor(0x6DFC);
-    if (!intlora) { tft.drawString("Lora Init Failed", 10, 13); }
-    Serial.println(String(displayName));
-    tft.drawString("USRN: " + String(displayName), 10, 25);
-
-    int yPos = yStart;
-    int endLine = scrollOffset + maxMessages;
-    if (endLine > messages.size()) endLine = messages.size();
-    for (int i = scrollOffset; i < endLine; i++) {
+    if (headerDirty) {
+        tft.fillRect(0, 0, tftWidth, yStart, TFT_BLACK);
+        tft.setTextColor(0x6DFC);
+        if (!intlora) { tft.drawString("Lora Init Failed", 10, 13); }
+        String header = "USRN: " + String(displayName);
+        if (unseenMessages) header += "  +" + String(unseenMessages) + " new";
+        if (loraRxDropped) header += "  lost " + String(loraRxDropped);
+        tft.drawString(header, 10, 25);
+        headerDirty = false;
+    }
+    if (update) {
+        // only the message rows are redrawn
         tft.setTextColor(bruceConfig.priColor);
-        tft.drawString(messages[i], 10, yPos);
-        yPos += ySpacing;
+        for (int row = 0; row < maxMessages; row++) {
+            int y = yStart + row * ySpacing;
+            tft.fillRect(0, y, tftWidth, ySpacing, TFT_BLACK);
+            if (row < chatCount) tft.drawString(chatLine(row).text, 10, y);
+        }
+        update = false;
     }
-    update = false;
 }
 
 void loadMessages() {
-    messages.clear();
-    File file = LittleFS.open("/chats.txt", "r");
-    while (file.available()) {
-        String line = file.readStringUntil('\n');
-        messages.push_back(line);
+    chatHead = 0;
+    chatCount = 0;
+    followTail = true;
+    unseenMessages = 0;
+    // the newest lines, read backwards from the end of the log
+    LoraLogPos pos = chatLog.tail();
+    LoraLogRecord rec;
+    while (chatCount < maxMessages) {
+        LoraLogPos end = pos;
+        if (!chatLog.readBefore(pos, rec)) break;
+        pushChatLineFront(rec, pos, end);
     }
-    file.close();
-    if (messages.size() > maxMessages) {
-        scrollOffset = messages.size() - maxMessages;
-    } else {
-        scrollOffset = 0;
+    update = true;
+    headerDirty = true;
+}
+
+// Moves the old /chats.txt into the log once
+void importOldChats() {
+    if (!LittleFS.exists("/chats.txt")) return;
+    if (chatLog.empty()) {
+        File file = LittleFS.open("/chats.txt", "r");
+        while (file.available()) {
+            String line = file.readStringUntil('\n');
+            line.trim();
+            if (line.isEmpty()) continue;
+            LoraLogRecord rec;
+            rec.flags = LORA_MSG_IMPORTED;
+            rec.text = line;
+            chatLog.append(rec);
+        }
+        file.close();
     }
+    LittleFS.remove("/chats.txt.old");
+    LittleFS.rename("/chats.txt", "/chats.txt.old");
 }
 
 // optional call funcs
@@ -273,42 +433,73 @@ void sendmsg() {
 
         tft.drawCentreString("LoRa not initialized!", tftWidth / 2, tftHeight / 2, 2);
         delay(1500);
+        tft.fillScreen(TFT_BLACK);
+        headerDirty = true;
+        update = true;
+        return;
+    }
+    String text = keyboard(msg, 256, "Message:");
+    if (text == "") {
+        tft.fillScreen(TFT_BLACK);
+        headerDirty = true;
         update = true;
         return;
     }
-    msg = keyboard(msg, 256, "Message:");
-    msg = String(displayName) + ": " + msg;
-    if (msg == "") return;
+    msg = String(displayName) + ": " + text;
     Serial.println(msg);
     if (!sendLoraMessage(msg)) {
+        tft.fillScreen(TFT_BLACK);
+        headerDirty = true;
         update = true;
         return;
     }
     tft.fillScreen(TFT_BLACK);
+    headerDirty = true;
     update = true;
-    File file = LittleFS.open("/chats.txt", "a");
-    file.println(msg);
-    file.close();
-
-    messages.push_back(msg);
-    if (messages.size() > maxMessages) { scrollOffset = messages.size() - maxMessages; }
+    LoraLogRecord rec;
+    rec.time = time(nullptr);
+    rec.flags = LORA_MSG_SENT;
+    rec.sender = displayName;
+    rec.text = text;
+    // a sent message brings the view back to the newest lines
+    if (!followTail) loadMessages();
+    addChatMessage(rec);
     msg = "";
 }
 
 void upress() {
     Serial.println("Up Pressed");
-    if (scrollOffset > 0) {
-        scrollOffset--;
-        update = true;
-    }
+    if (chatCount == 0) return;
+    LoraLogPos pos = chatLine(0).start;
+    LoraLogRecord rec;
+    LoraLogPos end = pos;
+    if (!chatLog.readBefore(pos, rec)) return;
+    if (chatCount == maxMessages) chatCount--; // the bottom line leaves the ring
+    pushChatLineFront(rec, pos, end);
+    followTail = false;
+    update = true;
 }
 
 void downpress() {
     Serial.println("Down Pressed");
-    if (scrollOffset < messages.size() - maxMessages) {
-        scrollOffset++;
-        update = true;
+    if (chatCount == 0 || followTail) return;
+    LoraLogPos pos = chatLine(chatCount - 1).end;
+    LoraLogPos start = pos;
+    LoraLogRecord rec;
+    if (!chatLog.readAfter(pos, rec)) {
+        followTail = true;
+        unseenMessages = 0;
+        headerDirty = true;
+        return;
     }
+    pushChatLineBack(rec, start, pos);
+    LoraLogPos next = pos;
+    if (!chatLog.readAfter(next, rec)) {
+        followTail = true;
+        unseenMessages = 0;
+        headerDirty = true;
+    }
+    update = true;
 }
 
 void selectRadioVariant(JsonDocument &doc) {
@@ -397,11 +588,11 @@ void mainloop() {
 
 void lorachat() {
     // set filesystem thing
-    if (!LittleFS.exists("/chats.txt")) {
-        File file = LittleFS.open("/chats.txt", "w");
-        file.close();
-        Serial.println("chat file created :)");
+    if (!chatLog.begin(LittleFS)) {
+        displayError("Can't open the chat log", true);
+        return;
     }
+    importOldChats();
     if (!LittleFS.exists("/lora_settings.json")) {
         Serial.println("creating lora settings .json file");
         JsonDocument doc;
@@ -422,6 +613,7 @@ void lorachat() {
     float bandMHz = (BAND > 1000) ? BAND / 1000000.0f : BAND;
     if (bandMHz <= 0) {
         displayError("Invalid LoRa frequency", true);
+        chatLog.end();
         return;
     }
     tft.fillScreen(TFT_BLACK);
@@ -438,12 +630,16 @@ void lorachat() {
 
     if (!startLoraRadio(bandMHz)) {
         update = true;
+        chatLog.end();
         return;
     }
     tft.setTextWrap(true, true);
     tft.setTextDatum(TL_DATUM);
+    startLoraRx();
     loadMessages();
     mainloop();
+    stopLoraRx();
+    chatLog.end();
 }
 
 // settings
@@ -0,0 +1,187 @@
+#if !defined(LITE_VERSION)
+#include "lora_log.h"
+
+#define LORA_LOG_HEADER 14
+#define LORA_LOG_TRAILER 2
+#define LORA_LOG_MIN_RECORD (LORA_LOG_HEADER + LORA_LOG_TRAILER)
+#define LORA_LOG_MAX_RECORD (LORA_LOG_MIN_RECORD + 255 + LORA_LOG_MAX_TEXT)
+
+static void putLE(uint8_t *p, uint32_t v, int n) {
+    for (int i = 0; i < n; i++) p[i] = v >> (8 * i);
+}
+
+static uint32_t getLE(const uint8_t *p, int n) {
+    uint32_t v = 0;
+    for (int i = n - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+String LoraLog::segmentPath(uint32_t segment) const {
+    char path[32];
+    snprintf(path, sizeof(path), LORA_LOG_DIR "/%05lu.bin", (unsigned long)segment);
+    return String(path);
+}
+
+bool LoraLog::begin(FS &fs) {
+    end();
+    _fs = &fs;
+    if (!_fs->exists(LORA_LOG_DIR) && !_fs->mkdir(LORA_LOG_DIR)) return false;
+
+    _first = UINT32_MAX;
+    _last = 0;
+    File dir = _fs->open(LORA_LOG_DIR);
+    while (true) {
+        bool isDir;
+        String name = dir.getNextFileName(&isDir);
+        if (name == "") break;
+        if (isDir || !name.endsWith(".bin")) continue;
+        uint32_t segment = name.substring(name.lastIndexOf('/') + 1).toInt();
+        if (segment == 0) continue;
+        _first = min(_first, segment);
+        _last = max(_last, segment);
+    }
+    dir.close();
+    if (_last == 0) _first = _last = 1;
+    return openOutput();
+}
+
+void LoraLog::end() {
+    if (_out) _out.close();
+    if (_in) _in.close();
+    _outSize = 0;
+}
+
+bool LoraLog::openOutput() {
+    _out = _fs->open(segmentPath(_last), FILE_APPEND);
+    if (!_out) {
+        log_e("Could not open %s", segmentPath(_last).c_str());
+        return false;
+    }
+    _outSize = _out.size();
+    return true;
+}
+
+bool LoraLog::append(const LoraLogRecord &rec, LoraLogPos *start, LoraLogPos *end) {
+    if (!_out) return false;
+    uint8_t senderLen = min(rec.sender.length(), (unsigned int)255);
+    uint16_t textLen = min(rec.text.length(), (unsigned int)LORA_LOG_MAX_TEXT);
+    uint16_t length = LORA_LOG_MIN_RECORD + senderLen + textLen;
+
+    uint8_t buf[LORA_LOG_MAX_RECORD];
+    buf[0] = 'L';
+    buf[1] = 'R';
+    buf[2] = rec.flags;
+    buf[3] = senderLen;
+    putLE(buf + 4, textLen, 2);
+    putLE(buf + 6, rec.time, 4);
+    putLE(buf + 10, (uint16_t)rec.rssi10, 2);
+    buf[12] = (uint8_t)rec.snr4;
+    buf[13] = 0;
+    memcpy(buf + LORA_LOG_HEADER, rec.sender.c_str(), senderLen);
+    memcpy(buf + LORA_LOG_HEADER + senderLen, rec.text.c_str(), textLen);
+    putLE(buf + length - LORA_LOG_TRAILER, length, 2);
+
+    if (_outSize > 0 && _outSize + length > LORA_LOG_SEGMENT_BYTES) {
+        _out.close();
+        _last++;
+        if (!openOutput()) return false;
+        while (_last - _first + 1 > LORA_LOG_SEGMENTS) {
+            if (_in && _inSegment == _first) _in.close();
+            _fs->remove(segmentPath(_first++));
+        }
+    }
+    if (start) *start = {_last, _outSize};
+    if (_out.write(buf, length) != length) {
+        log_e("LoRa log write failed");
+        return false;
+    }
+    // LittleFS commits on flush, a power cut loses at most the record being written
+    _out.flush();
+    _outSize += length;
+    if (end) *end = {_last, _outSize};
+    // a reader opened before the write does not see the new size
+    if (_in && _inSegment == _last) _in.close();
+    return true;
+}
+
+LoraLogPos LoraLog::tail() const { return {_last, _outSize}; }
+
+File &LoraLog::reader(uint32_t segment) {
+    if (_in && _inSegment == segment) return _in;
+    if (_in) _in.close();
+    _inSegment = segment;
+    if (segment >= _first && segment <= _last) _in = _fs->open(segmentPath(segment), FILE_READ);
+    return _in;
+}
+
+bool LoraLog::readAt(File &file, uint32_t offset, LoraLogRecord &rec, uint16_t &length) {
+    uint8_t header[LORA_LOG_HEADER];
+    if (!file.seek(offset) || file.read(header, sizeof(header)) != sizeof(header)) return false;
+    if (header[0] != 'L' || header[1] != 'R') return false;
+    uint8_t senderLen = header[3];
+    uint16_t textLen = getLE(header + 4, 2);
+    if (textLen > LORA_LOG_MAX_TEXT) return false;
+
+    char buf[LORA_LOG_MAX_TEXT + 1];
+    if (file.read((uint8_t *)buf, senderLen) != senderLen) return false;
+    buf[senderLen] = '\0';
+    rec.sender = buf;
+    if (file.read((uint8_t *)buf, textLen) != textLen) return false;
+    buf[textLen] = '\0';
+    rec.text = buf;
+
+    rec.flags = header[2];
+    rec.time = getLE(header + 6, 4);
+    rec.rssi10 = (int16_t)getLE(header + 10, 2);
+    rec.snr4 = (int8_t)header[12];
+    length = LORA_LOG_MIN_RECORD + senderLen + textLen;
+    return true;
+}
+
+bool LoraLog::readBefore(LoraLogPos &pos, LoraLogRecord &rec) {
+    if (!_fs) return false;
+    while (pos.offset == 0) {
+        if (pos.segment <= _first) return false;
+        pos.segment--;
+        File &file = reader(pos.segment);
+        if (!file) return false;
+        pos.offset = file.size();
+    }
+    File &file = reader(pos.segment);
+    if (!file || pos.offset < LORA_LOG_MIN_RECORD) return false;
+
+    uint8_t trailer[LORA_LOG_TRAILER];
+    if (!file.seek(pos.offset - LORA_LOG_TRAILER) || file.read(trailer, sizeof(trailer)) != sizeof(trailer)) {
+        return false;
+    }
+    uint16_t length = getLE(trailer, 2);
+    if (length < LORA_LOG_MIN_RECORD || length > pos.offset) return false;
+
+    uint16_t parsed;
+    if (!readAt(file, pos.offset - length, rec, parsed) || parsed != length) return false;
+    pos.offset -= length;
+    return true;
+}
+
+bool LoraLog::readAfter(LoraLogPos &pos, LoraLogRecord &rec) {
+    if (!_fs) return false;
+    while (true) {
+        uint32_t size = 0;
+        if (pos.segment == _last) {
+            size = _outSize;
+        } else {
+            File &file = reader(pos.segment);
+            if (file) size = file.size();
+        }
+        if (pos.offset < size) break;
+        if (pos.segment >= _last) return false;
+        pos.segment = max(pos.segment + 1, _first);
+        pos.offset = 0;
+    }
+    File &file = reader(pos.segment);
+    uint16_t length;
+    if (!file || !readAt(file, pos.offset, rec, length)) return false;
+    pos.offset += length;
+    return true;
+}
+#endif
@@ -0,0 +1,87 @@
+#ifndef __LORA_LOG_H__
+#define __LORA_LOG_H__
+#if !defined(LITE_VERSION)
+
+#include <Arduino.h>
+#include <FS.h>
+
+/*
+  Append-only LoRa chat log, split in numbered segment files.
+
+  record: header (14 bytes, LE) | sender | text | length (2 bytes, LE)
+  header: 'L' 'R' | flags | sender length | text length (2) | unix time (4) |
+          RSSI in 0.1 dBm (2) | SNR in 0.25 dB (1) | reserved (1)
+
+  The trailing length repeats the size of the whole record, so the log is
+  read backwards from the end of the newest segment without an index file.
+*/
+#ifndef LORA_LOG_DIR
+#define LORA_LOG_DIR "/lora_log"
+#endif
+#ifndef LORA_LOG_SEGMENT_BYTES
+#define LORA_LOG_SEGMENT_BYTES (32 * 1024)
+#endif
+// Older segments are deleted, the log never takes more than this many
+#ifndef LORA_LOG_SEGMENTS
+#define LORA_LOG_SEGMENTS 8
+#endif
+#define LORA_LOG_MAX_TEXT 512
+
+#define LORA_MSG_SENT 0x01
+#define LORA_MSG_IMPORTED 0x02 // read from the old chats.txt, no time nor signal
+
+struct LoraLogRecord {
+    uint32_t time = 0;
+    int16_t rssi10 = 0;
+    int8_t snr4 = 0;
+    uint8_t flags = 0;
+    String sender;
+    String text;
+};
+
+struct LoraLogPos {
+    uint32_t segment = 0;
+    uint32_t offset = 0;
+};
+
+/*********************************************************************
+**  Class: LoraLog
+**  Records are appended to the newest segment, which stays open and
+**  is flushed after every record. Readers walk the log with positions:
+**  readBefore() goes towards older records, readAfter() towards newer.
+**********************************************************************/
+class LoraLog {
+public:
+    ~LoraLog() { end(); }
+
+    bool begin(FS &fs);
+    void end();
+    bool empty() const { return _first == _last && _outSize == 0; }
+
+    // start and end, when given, receive the position of the new record
+    bool append(const LoraLogRecord &rec, LoraLogPos *start = nullptr, LoraLogPos *end = nullptr);
+    // Position after the newest record
+    LoraLogPos tail() const;
+
+    // Reads the record ending at pos and moves pos to its start, false at the oldest record
+    bool readBefore(LoraLogPos &pos, LoraLogRecord &rec);
+    // Reads the record starting at pos and moves pos to its end, false past the newest record
+    bool readAfter(LoraLogPos &pos, LoraLogRecord &rec);
+
+private:
+    String segmentPath(uint32_t segment) const;
+    File &reader(uint32_t segment);
+    bool readAt(File &file, uint32_t offset, LoraLogRecord &rec, uint16_t &length);
+    bool openOutput();
+
+    FS *_fs = nullptr;
+    uint32_t _first = 0;
+    uint32_t _last = 0;
+    File _out;
+    uint32_t _outSize = 0;
+    File _in;
+    uint32_t _inSegment = 0;
+};
+
+#endif
+#endif
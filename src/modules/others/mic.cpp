@@ -2,6 +2,7 @@
 #if defined(MIC_SPM1423) || defined(MIC_INMP441)
 #include "core/mykeyboard.h"
 #include "core/powerSave.h"
+#include "mic_dsp.h"
 #include "driver/gpio.h"
 #include "soc/gpio_struct.h"
 #include "soc/io_mux_reg.h"
@@ -18,11 +19,22 @@ static i2s_chan_handle_t i2s_chan = nullptr;
 #define FFT_SIZE 1024
 #define SPECTRUM_WIDTH 200
 #define SPECTRUM_HEIGHT 124
-#define HISTORY_LEN (SPECTRUM_WIDTH + 1)
+// Columns waiting for the display, the capture task drops new ones when it is full
+#ifndef MIC_SPECTRUM_QUEUE
+#define MIC_SPECTRUM_QUEUE 4
+#endif
 
 static int16_t *i2s_buffer = nullptr;
-static uint8_t *fftHistory = nullptr; // Linear buffer [WIDTH + 1][HEIGHT]
-static uint16_t posData = 0;
+
+struct SpectrumColumn {
+    uint8_t level[SPECTRUM_HEIGHT]; // top row is the highest bin
+};
+static SpectrumDsp spectrumDsp;
+static QueueHandle_t spectrumQueue = nullptr;
+static TaskHandle_t spectrumTask = nullptr;
+static volatile bool spectrumRunning = false;
+static volatile uint32_t spectrumFrames = 0;
+static volatile uint32_t spectrumDropped = 0;
 
 #ifndef PIN_CLK
 #define PIN_CLK I2S_PIN_NO_CHANGE
@@ -89,10 +101,6 @@ const unsigned char ImageData[768] = {
     0xFF, 0xFF, 0xFD,
 };
 
-static inline uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
-    return (r << (5 + 6)) | (g << 5) | b;
-    // return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-}
 
 bool deinitMicroPhone() {
     // Disable codec, if exists
@@ -111,8 +119,9 @@ bool InitI2SMicroPhone() {
     // Enable codec, if exists
     _setup_codec_mic(true);
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    // the DMA ring holds two FFT frames, one fills while the other is transformed
     chan_cfg.dma_desc_num = 8;
-    chan_cfg.dma_frame_num = SPECTRUM_HEIGHT;
+    chan_cfg.dma_frame_num = FFT_SIZE / 4;
     esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &i2s_chan);
 #if defined(MIC_INMP441) // #ifdef PIN_WS // INMP441
     i2s_std_slot_config_t slot_cfg =
@@ -185,6 +194,34 @@ bool InitI2SMicroPhone() {
     return (err == ESP_OK);
 }
 
+// Reads whole frames from I2S and turns them into spectrum columns, paced by the sample rate
+static void spectrumCapture(void *param) {
+    SpectrumColumn column;
+    uint8_t levels[SPECTRUM_HEIGHT - 1];
+    size_t filled = 0;
+    column.level[0] = 0;
+    while (spectrumRunning) {
+        size_t bytesread = 0;
+        i2s_channel_read(
+            i2s_chan,
+            (char *)i2s_buffer + filled,
+            FFT_SIZE * sizeof(int16_t) - filled,
+            &bytesread,
+            pdMS_TO_TICKS(100)
+        );
+        filled += bytesread;
+        if (filled < FFT_SIZE * sizeof(int16_t)) continue;
+        filled = 0;
+
+        spectrumDsp.process(i2s_buffer, levels, SPECTRUM_HEIGHT - 1);
+        for (int i = 1; i < SPECTRUM_HEIGHT; i++) column.level[SPECTRUM_HEIGHT - i] = levels[i - 1];
+        spectrumFrames++;
+        if (xQueueSend(spectrumQueue, &column, 0) != pdTRUE) spectrumDropped++;
+    }
+    spectrumTask = nullptr;
+    vTaskDelete(NULL);
+}
+
 void mic_test_one_task() {
     tft.fillScreen(TFT_BLACK);
 
@@ -202,61 +239,77 @@ void mic_test_one_task() {
         displayError("Not Enough RAM", true);
         return;
     }
-    tft.drawRect(
-        tftWidth / 2 - SPECTRUM_WIDTH / 2 - 2,
-        tftHeight / 2 - SPECTRUM_HEIGHT / 2 - 2,
-        SPECTRUM_WIDTH + 4,
-        SPECTRUM_HEIGHT + 4,
-        bruceConfig.priColor
-    );
-
-    while (1) {
-        fft_config_t *plan = fft_init(FFT_SIZE, FFT_REAL, FFT_FORWARD, NULL, NULL);
-        size_t bytesread;
-        i2s_channel_read(i2s_chan, (char *)i2s_buffer, FFT_SIZE * sizeof(int16_t), &bytesread, portMAX_DELAY);
+    if (!spectrumDsp.begin(FFT_SIZE)) {
+        free(frameBuffer);
+        displayError("Not Enough RAM", true);
+        return;
+    }
+    if (!spectrumQueue) spectrumQueue = xQueueCreate(MIC_SPECTRUM_QUEUE, sizeof(SpectrumColumn));
+    xQueueReset(spectrumQueue);
 
-        int16_t *samples = (int16_t *)i2s_buffer;
+    uint16_t palette[256];
+    for (int i = 0; i < 256; i++) {
+        palette[i] = tft.color565(ImageData[i * 3 + 0], ImageData[i * 3 + 1], ImageData[i * 3 + 2]);
+    }
+    for (int i = 0; i < SPECTRUM_WIDTH * SPECTRUM_HEIGHT; i++) frameBuffer[i] = palette[0];
 
-        for (int i = 0; i < FFT_SIZE; i++) { plan->input[i] = (float)samples[i] / 32768.0f; }
+    const int x0 = tftWidth / 2 - SPECTRUM_WIDTH / 2;
+    const int y0 = tftHeight / 2 - SPECTRUM_HEIGHT / 2;
+    tft.drawRect(x0 - 2, y0 - 2, SPECTRUM_WIDTH + 4, SPECTRUM_HEIGHT + 4, bruceConfig.priColor);
 
-        fft_execute(plan);
+    spectrumFrames = 0;
+    spectrumDropped = 0;
+    spectrumRunning = true;
+    xTaskCreatePinnedToCore(spectrumCapture, "mic_fft", 4096, NULL, 5, &spectrumTask, 0);
 
-        for (int i = 1; i < FFT_SIZE / 4 && i < SPECTRUM_HEIGHT; i++) {
-            float re = plan->output[2 * i];
-            float im = plan->output[2 * i + 1];
-            float mag = re * re + im * im;
-            if (mag > 1.0f) mag = 1.0f;
-            uint8_t value = map(mag * 2000, 0, 2000, 0, 255);
-            fftHistory[posData * SPECTRUM_HEIGHT + (SPECTRUM_HEIGHT - i)] = value;
+    // The framebuffer is a ring of columns, nextColumn is the oldest one on screen
+    int nextColumn = 0;
+    uint32_t statsTime = millis();
+    uint32_t statsFrames = 0;
+    while (1) {
+        SpectrumColumn column;
+        bool fresh = false;
+        while (xQueueReceive(spectrumQueue, &column, fresh ? 0 : pdMS_TO_TICKS(100)) == pdTRUE) {
+            for (int y = 0; y < SPECTRUM_HEIGHT; y++) {
+                frameBuffer[y * SPECTRUM_WIDTH + nextColumn] = palette[column.level[y]];
+            }
+            nextColumn = (nextColumn + 1) % SPECTRUM_WIDTH;
+            fresh = true;
         }
 
-        posData = (posData + 1) % HISTORY_LEN;
-
-        fft_destroy(plan);
-
-        // Render
-        for (int y = 0; y < SPECTRUM_HEIGHT; y++) {
-            for (int x = 0; x < SPECTRUM_WIDTH; x++) {
-                int index = (x + posData) % HISTORY_LEN;
-                uint8_t val = fftHistory[index * SPECTRUM_HEIGHT + y];
-                uint16_t color =
-                    rgb565(ImageData[val * 3 + 0], ImageData[val * 3 + 1], ImageData[val * 3 + 2]);
-                frameBuffer[y * SPECTRUM_WIDTH + x] = color;
+        if (fresh) {
+            // each row goes out in two runs, from the oldest column to the newest. pushImage,
+            // not raw pixel pushes, so the spectrum also lands in the composited framebuffer
+            const int oldest = SPECTRUM_WIDTH - nextColumn;
+            tft.beginFrame();
+            for (int y = 0; y < SPECTRUM_HEIGHT; y++) {
+                uint16_t *row = frameBuffer + y * SPECTRUM_WIDTH;
+                tft.pushImage(x0, y0 + y, oldest, 1, row + nextColumn);
+                if (nextColumn) tft.pushImage(x0 + oldest, y0 + y, nextColumn, 1, row);
             }
+            tft.endFrame();
+        }
+
+        if (millis() - statsTime >= 1000) {
+            uint32_t frames = spectrumFrames;
+            float rate = (frames - statsFrames) * 1000.0f / (millis() - statsTime);
+            statsFrames = frames;
+            statsTime = millis();
+            char stats[32];
+            snprintf(stats, sizeof(stats), "%.1f FFT/s  lost %lu", rate, (unsigned long)spectrumDropped);
+            tft.setTextSize(1);
+            tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
+            tft.drawString(String(stats) + "   ", x0, y0 + SPECTRUM_HEIGHT + 6);
         }
 
-        tft.pushImage(
-            tftWidth / 2 - SPECTRUM_WIDTH / 2,
-            tftHeight / 2 - SPECTRUM_HEIGHT / 2,
-            SPECTRUM_WIDTH,
-            SPECTRUM_HEIGHT,
-            frameBuffer
-        );
         wakeUpScreen();
         if (check(SelPress) || check(EscPress)) break;
     }
+    spectrumRunning = false;
+    while (spectrumTask) vTaskDelay(pdMS_TO_TICKS(5));
     i2s_channel_disable(i2s_chan);
 
+    spectrumDsp.end();
     free(frameBuffer);
 }
 
@@ -283,24 +336,17 @@ void mic_test() {
     Serial.println("Mic Spectrum start");
     InitI2SMicroPhone();
     // Alloc buffers in PSRAM if available
-    if (psramFound()) {
-        i2s_buffer = (int16_t *)ps_malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)ps_malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
-    } else {
-        i2s_buffer = (int16_t *)malloc(FFT_SIZE * sizeof(int16_t));
-        fftHistory = (uint8_t *)malloc(HISTORY_LEN * SPECTRUM_HEIGHT);
-    }
-    if (!i2s_buffer || !fftHistory) {
+    // the capture task reads it, keep it in internal RAM
+    i2s_buffer =
+        (int16_t *)heap_caps_malloc(FFT_SIZE * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!i2s_buffer) {
         displayError("Fail to alloc buffers, exiting", true);
         return;
     }
 
-    memset(fftHistory, 0, HISTORY_LEN * SPECTRUM_HEIGHT);
-
     mic_test_one_task();
 
     free(i2s_buffer);
-    free(fftHistory);
 
     delay(10);
     if (deinitMicroPhone()) Serial.println("Fail disabling I2S Driver");
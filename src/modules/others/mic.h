@@ -36,7 +36,6 @@ void mic_function() {
  */
 
 #include "core/display.h"
-#include <fft.h>
 #include <globals.h>
 
 /* Mic */
@@ -0,0 +1,124 @@
+#include "mic_dsp.h"
+#include <math.h>
+#include <stdlib.h>
+#ifdef MIC_DSP_ESP_DSP
+#include <dsps_bit_rev.h>
+#include <dsps_fft2r.h>
+#endif
+
+bool SpectrumDsp::begin(uint16_t size) {
+    end();
+    if (size < 4 || (size & (size - 1))) return false;
+    _window = (float *)malloc(size * sizeof(float));
+    _data = (float *)malloc(2 * size * sizeof(float));
+    if (!_window || !_data) {
+        end();
+        return false;
+    }
+#ifdef MIC_DSP_ESP_DSP
+    if (dsps_fft2r_init_fc32(NULL, size) != ESP_OK) {
+        end();
+        return false;
+    }
+#else
+    _twiddle = (float *)malloc(size * sizeof(float));
+    _bitrev = (uint16_t *)malloc(size * sizeof(uint16_t));
+    if (!_twiddle || !_bitrev) {
+        end();
+        return false;
+    }
+    for (uint16_t i = 0; i < size / 2; i++) {
+        _twiddle[2 * i] = cosf(2.0f * (float)M_PI * i / size);
+        _twiddle[2 * i + 1] = sinf(2.0f * (float)M_PI * i / size);
+    }
+    uint8_t bits = 0;
+    while ((1u << bits) < size) bits++;
+    for (uint16_t i = 0; i < size; i++) {
+        uint16_t r = 0;
+        for (uint8_t b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+        _bitrev[i] = r;
+    }
+#endif
+    _size = size;
+    // Hann has a coherent gain of 1/2 and a real sine puts half its energy in each side,
+    // 4 / size brings the peak of a full scale sine back to 1.0
+    const float scale = 4.0f / size / 32768.0f;
+    for (uint16_t i = 0; i < size; i++) {
+        _window[i] = scale * 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / size));
+    }
+    return true;
+}
+
+void SpectrumDsp::end() {
+    free(_window);
+    free(_data);
+    _window = nullptr;
+    _data = nullptr;
+#ifdef MIC_DSP_ESP_DSP
+    if (_size) dsps_fft2r_deinit_fc32();
+#else
+    free(_twiddle);
+    free(_bitrev);
+    _twiddle = nullptr;
+    _bitrev = nullptr;
+#endif
+    _size = 0;
+}
+
+void SpectrumDsp::fft() {
+#ifdef MIC_DSP_ESP_DSP
+    dsps_fft2r_fc32(_data, _size);
+    dsps_bit_rev_fc32(_data, _size);
+#else
+    // iterative radix-2, bit reversed input, natural order output
+    for (uint16_t i = 0; i < _size; i++) {
+        uint16_t j = _bitrev[i];
+        if (j > i) {
+            float re = _data[2 * i], im = _data[2 * i + 1];
+            _data[2 * i] = _data[2 * j];
+            _data[2 * i + 1] = _data[2 * j + 1];
+            _data[2 * j] = re;
+            _data[2 * j + 1] = im;
+        }
+    }
+    for (uint16_t half = 1, step = _size / 2; half < _size; half <<= 1, step >>= 1) {
+        for (uint16_t start = 0; start < _size; start += 2 * half) {
+            for (uint16_t k = 0; k < half; k++) {
+                const float wr = _twiddle[2 * k * step];
+                const float wi = -_twiddle[2 * k * step + 1];
+                float *a = _data + 2 * (start + k);
+                float *b = a + 2 * half;
+                const float tr = b[0] * wr - b[1] * wi;
+                const float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+#endif
+}
+
+float SpectrumDsp::power(uint16_t k) const {
+    const float re = _data[2 * k], im = _data[2 * k + 1];
+    return re * re + im * im;
+}
+
+void SpectrumDsp::process(const int16_t *samples, uint8_t *levels, uint16_t bins) {
+    if (!_size) return;
+    // plain loops over contiguous arrays, the compiler keeps them in registers
+    for (uint16_t i = 0; i < _size; i++) {
+        _data[2 * i] = samples[i] * _window[i];
+        _data[2 * i + 1] = 0.0f;
+    }
+    fft();
+
+    if (bins > _size / 2 - 1) bins = _size / 2 - 1;
+    const float toLevel = 255.0f / -MIC_SPECTRUM_FLOOR_DB;
+    for (uint16_t k = 1; k <= bins; k++) {
+        float db = 10.0f * log10f(power(k) + 1e-12f);
+        float level = (db - MIC_SPECTRUM_FLOOR_DB) * toLevel;
+        levels[k - 1] = level <= 0.0f ? 0 : (level >= 255.0f ? 255 : (uint8_t)level);
+    }
+}
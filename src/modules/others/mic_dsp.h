@@ -0,0 +1,51 @@
+#ifndef __MIC_DSP_H__
+#define __MIC_DSP_H__
+
+#include <stdint.h>
+
+// esp-dsp ships with the core on most targets and has hand tuned FFTs (S3 vector unit, ESP32 MAC)
+#if defined(ESP_PLATFORM) && __has_include(<dsps_fft2r.h>)
+#define MIC_DSP_ESP_DSP 1
+#endif
+
+// Levels below this, in dB of a full scale sine, are drawn as 0
+#ifndef MIC_SPECTRUM_FLOOR_DB
+#define MIC_SPECTRUM_FLOOR_DB -90.0f
+#endif
+
+/*********************************************************************
+**  Class: SpectrumDsp
+**  Magnitude spectrum of 16 bit audio frames. Everything that depends
+**  only on the frame size (Hann window, twiddles, bit reversal) is
+**  computed once in begin(), process() only runs the frame through.
+**  No Arduino dependencies, it builds on the host for testing.
+**********************************************************************/
+class SpectrumDsp {
+public:
+    ~SpectrumDsp() { end(); }
+
+    // size is a power of two, false when it is not or memory is short
+    bool begin(uint16_t size);
+    void end();
+
+    // Windows and transforms size samples, then writes the level of bins 1..bins into levels[0..bins-1],
+    // 0 at MIC_SPECTRUM_FLOOR_DB up to 255 at a full scale sine
+    void process(const int16_t *samples, uint8_t *levels, uint16_t bins);
+
+    // Power of bin k of the last frame, 1.0 for a full scale sine centred on the bin
+    float power(uint16_t k) const;
+    uint16_t size() const { return _size; }
+
+private:
+    void fft();
+
+    uint16_t _size = 0;
+    float *_window = nullptr; // Hann, scaled so a full scale sine peaks at 1.0
+    float *_data = nullptr;   // interleaved re, im
+#ifndef MIC_DSP_ESP_DSP
+    float *_twiddle = nullptr; // cos, sin pairs for size / 2 angles
+    uint16_t *_bitrev = nullptr;
+#endif
+};
+
+#endif
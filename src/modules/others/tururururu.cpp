@@ -53,13 +53,13 @@ void initSprites() {
 
 // Função para desenhar o tubarão
 void drawShark() {
-    sprite.pushSprite(sharkX - sharkSize, sharkY - 7);
+    tft.pushSprite(sprite, sharkX - sharkSize, sharkY - 7);
     // sprite.pushToSprite(&sprite,sharkX-sharkSize, sharkY,TFT_TRANSPARENT);
 }
 
 // Função para desenhar peixes
 void drawFish(Fish &f) {
-    draw.pushSprite(f.x, f.y);
+    tft.pushSprite(draw, f.x, f.y);
     // draw.pushToSprite(&sprite,f.x,f.y,TFT_TRANSPARENT);
 }
 #define STEP (tftHeight) / 44
@@ -1,5 +1,6 @@
 #include "emit.h"
 #include "modules/rf/rf_utils.h" // for initRfModule
+#include "sub_file.h"
 #include <ELECHOUSE_CC1101_SRC_DRV.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -108,3 +109,72 @@ void rf_raw_emit(RawRecording &recorded, bool &returnToMenu) {
 
     if (escPressed) returnToMenu = true;
 }
+
+/*********************************************************************
+**  Function: rf_raw_emit_stream
+**  Transmits the RAW_Data of a .sub file while it is being read, so
+**  recordings bigger than the free RAM can be replayed. The buffer is
+**  refilled during long pulses, against absolute deadlines, to keep
+**  the SD reads out of the signal timing. Stops early when *stop is
+**  set, it is checked after every value.
+**********************************************************************/
+size_t rf_raw_emit_stream(SubFileReader &reader, gpio_num_t txPin, volatile bool *stop) {
+    int *buf = (int *)malloc(RF_STREAM_BUFFER * sizeof(int));
+    if (!buf) {
+        log_e("rf_raw_emit_stream: no memory");
+        return 0;
+    }
+
+    size_t head = 0, count = 0, sent = 0;
+    bool eof = false;
+    // Reads up to max values into the free part of the ring
+    auto refill = [&](size_t max) {
+        size_t tail = (head + count) % RF_STREAM_BUFFER;
+        size_t space = RF_STREAM_BUFFER - count;
+        if (space > RF_STREAM_BUFFER - tail) space = RF_STREAM_BUFFER - tail;
+        if (space > max) space = max;
+        size_t n = reader.readRaw(buf + tail, space);
+        if (n == 0) eof = true;
+        count += n;
+    };
+
+    while (!eof && count < RF_STREAM_BUFFER) refill(RF_STREAM_BUFFER);
+
+    pinMode(txPin, OUTPUT);
+    uint32_t deadline = micros();
+    while (count > 0) {
+        int value = buf[head];
+        head = (head + 1) % RF_STREAM_BUFFER;
+        count--;
+
+        digitalWrite(txPin, value > 0 ? HIGH : LOW);
+        uint32_t duration = value > 0 ? value : -value;
+        deadline += duration;
+
+        if (!eof && duration >= RF_STREAM_REFILL_MIN_US) {
+            while (!eof && count < RF_STREAM_BUFFER &&
+                   (int32_t)(deadline - micros()) > RF_STREAM_REFILL_MARGIN_US) {
+                refill(RF_STREAM_REFILL_STEP);
+            }
+        }
+        if (count == 0 && !eof) {
+            // underrun, the signal gets a gap here
+            log_w("rf_raw_emit_stream: buffer underrun after %u values", sent);
+            while (!eof && count < RF_STREAM_BUFFER) refill(RF_STREAM_BUFFER);
+            deadline = micros();
+        }
+
+        // Long gaps sleep most of the way, one tick early at worst
+        while ((int32_t)(deadline - micros()) > RF_STREAM_YIELD_US) {
+            vTaskDelay(1);
+            if (stop && *stop) break;
+        }
+        while ((int32_t)(deadline - micros()) > 0);
+        sent++;
+        if (stop && *stop) break;
+    }
+    digitalWrite(txPin, LOW);
+
+    free(buf);
+    return sent;
+}
@@ -5,6 +5,23 @@
 #include "record.h"
 #include "structs.h"
 #include <vector>
+
+class SubFileReader;
+
+// Durations buffered ahead when streaming a .sub file
+#ifndef RF_STREAM_BUFFER
+#define RF_STREAM_BUFFER 2048
+#endif
+// Pulses at least this long (us) are used to read the file ahead
+#define RF_STREAM_REFILL_MIN_US 3000
+#define RF_STREAM_REFILL_MARGIN_US 1500
+#define RF_STREAM_REFILL_STEP 64
+// Gaps at least this long (us) give the CPU to other tasks, input included
+#ifndef RF_STREAM_YIELD_US
+#define RF_STREAM_YIELD_US 2500
+#endif
+
 void rf_raw_emit_draw(void *parameter);
 void rf_raw_emit(RawRecording &recorded, bool &returnToMenu);
+size_t rf_raw_emit_stream(SubFileReader &reader, gpio_num_t txPin, volatile bool *stop = nullptr);
 #endif
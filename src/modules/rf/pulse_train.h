@@ -0,0 +1,121 @@
+#pragma once
+/*
+ * pulse_train.h
+ *
+ * Pulse train buffer shared by the live capture ISR (rf_listen_decode.cpp)
+ * and the offline .sub decoder (rf_sub_decode.cpp, tools/sub_decode).
+ * No Arduino dependencies, so the host tool splits files exactly like the
+ * device does.
+ */
+
+#include <stdint.h>
+
+// ─── Pulse capture tuning ────────────────────────────────────────────────────
+
+/**
+ * Maximum number of pulse/gap pairs stored per train.
+ * Must be <= PD_MAX_PULSES defined in rtl_433 (typically 1200).
+ * Each pair costs 8 bytes, so 1024 pairs = 8 KB per raw buffer (×2 = 16 KB).
+ */
+#ifndef PULSE_BUF_SIZE
+#define PULSE_BUF_SIZE 1024
+#endif
+
+/**
+ * A gap longer than this value (µs) with no rising edge signals end-of-train.
+ * 10 ms is the standard OOK inter-message gap used by rtl_433.
+ * Raise to 15000–20000 if trains are being split prematurely.
+ */
+#ifndef PULSE_TRAIN_TIMEOUT_US
+#define PULSE_TRAIN_TIMEOUT_US 10000
+#endif
+
+// Plain POD struct — no heap, no constructors, safe in IRAM context.
+struct RawTrain {
+    int pulse[PULSE_BUF_SIZE]; // mark durations  (µs)
+    int gap[PULSE_BUF_SIZE];   // space durations (µs)
+    int num_pulses;            // pulse/gap pairs stored
+    bool ready;                // main loop may read this buffer
+};
+
+// ─── Offline splitter ────────────────────────────────────────────────────────
+
+/**
+ * Turns a stream of .sub RAW_Data durations (positive = carrier on, negative
+ * = off) into RawTrains with the same rules as onPulse_decode():
+ *   - a gap >= PULSE_TRAIN_TIMEOUT_US ends the train, which is shipped when
+ *     it holds more than one pulse; that long gap is not stored;
+ *   - a pulse >= PULSE_TRAIN_TIMEOUT_US is noise and drops the train;
+ *   - pulses past PULSE_BUF_SIZE are dropped, the train still ships.
+ * Consecutive durations of the same sign are one level and are merged.
+ * The end of the data counts as a long gap.
+ */
+class PulseTrainSplitter {
+public:
+    explicit PulseTrainSplitter(RawTrain &train) : _t(train) { reset(); }
+
+    void reset() {
+        _t.num_pulses = 0;
+        _t.ready = false;
+        _level = 0;
+        _pending = 0;
+    }
+
+    // True when a train was completed, it stays in the buffer until the next call
+    bool push(int duration) {
+        if (_t.ready) clear();
+        if (!duration) return false;
+        int level = duration > 0 ? 1 : -1;
+        int dur = duration > 0 ? duration : -duration;
+        if (level == _level) {
+            _pending += dur;
+            return false;
+        }
+        bool shipped = _level && edge(_level, _pending);
+        _level = level;
+        _pending = dur;
+        return shipped;
+    }
+
+    // Flushes the last level, true when that completed a train
+    bool finish() {
+        if (_t.ready) clear();
+        bool shipped = _level && edge(_level, _pending);
+        _level = 0;
+        if (!shipped) shipped = edge(-1, PULSE_TRAIN_TIMEOUT_US);
+        return shipped;
+    }
+
+private:
+    RawTrain &_t;
+    int _level;   // sign of the level being accumulated, 0 before the first value
+    int _pending; // its duration so far
+
+    void clear() {
+        _t.num_pulses = 0;
+        _t.ready = false;
+    }
+
+    // A level of dur µs just ended
+    bool edge(int level, int dur) {
+        if (level < 0) {
+            if (dur >= PULSE_TRAIN_TIMEOUT_US) {
+                if (_t.num_pulses > 1) return _t.ready = true;
+                _t.num_pulses = 0;
+            } else if (_t.num_pulses > 0 && _t.num_pulses <= PULSE_BUF_SIZE) {
+                _t.gap[_t.num_pulses - 1] = dur;
+            }
+            return false;
+        }
+        if (dur >= PULSE_TRAIN_TIMEOUT_US) {
+            _t.num_pulses = 0;
+            return false;
+        }
+        if (_t.num_pulses < PULSE_BUF_SIZE) {
+            _t.pulse[_t.num_pulses] = dur;
+            _t.gap[_t.num_pulses] = 0;
+            _t.num_pulses++;
+        }
+        return false;
+    }
+};
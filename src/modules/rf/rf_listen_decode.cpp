@@ -25,7 +25,7 @@
 #include "rf_listen_decode.h"
 
 #include "../others/audio.h"
-#include "signalDecoder.h" // pulse_data_t, processSignal(), rtlSetup(), _setCallback()
+#include "signalDecoder.h" // processSignal(), rtlSetup(), _setCallback()
 
 // ─── Pulse_data_t sizing guard ───────────────────────────────────────────────
 // rtl_433 defines PD_MAX_PULSES (typically 1200). Our buffer must not exceed it.
@@ -35,14 +35,7 @@
 static_assert(PULSE_BUF_SIZE <= PD_MAX_PULSES, "PULSE_BUF_SIZE must be <= PD_MAX_PULSES (1200)");
 
 // ─── ISR double-buffer ───────────────────────────────────────────────────────
-// Plain POD struct — no heap, no constructors, safe in IRAM context.
-struct RawTrain {
-    int pulse[PULSE_BUF_SIZE]; // mark durations  (µs)
-    int gap[PULSE_BUF_SIZE];   // space durations (µs)
-    int num_pulses;            // pulse/gap pairs stored
-    bool ready;                // main loop may read this buffer
-};
-
+// RawTrain (pulse_train.h) is shared with the offline .sub decoder.
 static RawTrain rawBuf[2];
 static volatile int writeBuf = 0; // ISR writes here
 static volatile bool trainReady = false;
@@ -126,13 +119,9 @@ void IRAM_ATTR onPulse_decode() {
 /**
  * Heap-allocates a pulse_data_t, copies the completed RawTrain into it, and
  * fills in metadata fields expected by the rtl_433 decoder.
- *
- * Ownership passes to the caller; processSignal() will free() it after decoding.
- *
- * @param  t    Completed RawTrain (must have ready == true).
- * @return      Heap-allocated pulse_data_t*, or nullptr on alloc failure.
+ * Also used by rf_sub_decode() for trains read back from .sub files.
  */
-static pulse_data_t *buildPulseData(const RawTrain &t) {
+pulse_data_t *buildPulseData(const RawTrain &t, float freqMhz) {
     if (t.num_pulses < 2) return nullptr;
 
     pulse_data_t *pd = (pulse_data_t *)calloc(1, sizeof(pulse_data_t));
@@ -151,7 +140,7 @@ static pulse_data_t *buildPulseData(const RawTrain &t) {
     pd->signalDuration = totalDuration;
     pd->signalRssi = 0;      // optionally: ELECHOUSE_cc1101.getRssi()
     pd->sample_rate = 1.0e6; // µs timestamps → 1 MHz effective rate
-    pd->freq1_hz = (uint32_t)(captureFreqMhz * 1.0e6f);
+    pd->freq1_hz = (uint32_t)(freqMhz * 1.0e6f);
 
     return pd;
 }
@@ -291,7 +280,7 @@ void rf_listen_decode() {
 
                 // Build heap-allocated pulse_data_t and hand ownership to the
                 // decoder queue. processSignal() free()s it after decoding.
-                pulse_data_t *pd = buildPulseData(rawBuf[readBuf]);
+                pulse_data_t *pd = buildPulseData(rawBuf[readBuf], captureFreqMhz);
                 if (pd) {
                     processSignal(pd);
                 } else {
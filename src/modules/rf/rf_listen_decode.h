@@ -1,5 +1,7 @@
 #pragma once
+#include "pulse_train.h"
 #include "rf_utils.h"
+#include "signalDecoder.h" // pulse_data_t
 /*
  * rf_listen_decode.h
  *
@@ -16,26 +18,6 @@
  *   - optional audio: BUZZ_PIN / HAS_NS4168_SPKR
  */
 
-// ─── Pulse capture tuning ────────────────────────────────────────────────────
-
-/**
- * Maximum number of pulse/gap pairs stored per train.
- * Must be <= PD_MAX_PULSES defined in rtl_433 (typically 1200).
- * Each pair costs 8 bytes, so 1024 pairs = 8 KB per raw buffer (×2 = 16 KB).
- */
-#ifndef PULSE_BUF_SIZE
-#define PULSE_BUF_SIZE 1024
-#endif
-
-/**
- * A gap longer than this value (µs) with no rising edge signals end-of-train.
- * 10 ms is the standard OOK inter-message gap used by rtl_433.
- * Raise to 15000–20000 if trains are being split prematurely.
- */
-#ifndef PULSE_TRAIN_TIMEOUT_US
-#define PULSE_TRAIN_TIMEOUT_US 10000
-#endif
-
 /**
  * JSON decode result buffer size (bytes).
  * rtl_433 serialises decoded data as JSON; increase if messages are truncated.
@@ -61,3 +43,14 @@
  *   7. Esc exits and detaches the interrupt.
  */
 void rf_listen_decode();
+
+/**
+ * @brief Copies a completed RawTrain into a heap-allocated pulse_data_t.
+ *
+ * Ownership passes to the caller; processSignal() will free() it after decoding.
+ *
+ * @param  t        Completed RawTrain.
+ * @param  freqMhz  Carrier the train was received on, reported by the decoders.
+ * @return          pulse_data_t*, or nullptr on alloc failure / fewer than 2 pulses.
+ */
+pulse_data_t *buildPulseData(const RawTrain &t, float freqMhz);
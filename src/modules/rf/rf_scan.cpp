@@ -3,6 +3,8 @@
 #include "core/sd_functions.h"
 #include "core/type_convertion.h"
 #include "rf_send.h"
+#include "rf_tuning.h"
+#include "sub_file.h"
 #include <globals.h>
 #include <sstream>
 
@@ -84,15 +86,19 @@ void RFScan::init_freqs() {
 }
 
 bool RFScan::fast_scan() {
+    const int first = range_limits[bruceConfigPins.rfScanRange][0];
+    const int last = range_limits[bruceConfigPins.rfScanRange][1];
 
-    if (idx < range_limits[bruceConfigPins.rfScanRange][0] ||
-        idx > range_limits[bruceConfigPins.rfScanRange][1]) {
-        idx = range_limits[bruceConfigPins.rfScanRange][0];
+    if (idx < first || idx > last) {
+        if (idx > last) rfTuning.sweepDone();
+        idx = first;
     }
+    // cached after the first sweep of a range
+    if (!rfTuning.prepare(&subghz_frequency_list[first], last - first + 1)) return false;
     float checkFrequency = subghz_frequency_list[idx];
-    setMHZ(checkFrequency);
+    rfTuning.tune(idx - first);
     tft.drawPixel(0, 0, 0); // To make sure CC1101 shared with TFT works properly
-    vTaskDelay(5 / portTICK_PERIOD_MS);
+    vTaskDelay(pdMS_TO_TICKS(RF_SCAN_DWELL_MS));
     rssi = ELECHOUSE_cc1101.getRssi();
     if (rssi > rssiThreshold) {
         _freqs[_try].freq = checkFrequency;
@@ -475,28 +481,15 @@ bool RCSwitch_SaveSignal(float frequency, RfCodes codes, bool raw, char *key, bo
         return false;
     }
 
-    String subfile_out = "Filetype: Bruce SubGhz File\nVersion 1\n";
-    subfile_out += "Frequency: " + String(int(frequency * 1000000)) + "\n";
-    if (!raw) {
-        subfile_out += "Preset: " + String(codes.preset) + "\n";
-        subfile_out += "Protocol: RcSwitch\n";
-        subfile_out += "Bit: " + String(codes.Bit) + "\n";
-        subfile_out += "Key: " + String(key) + "\n";
-        subfile_out += "TE: " + String(codes.te) + "\n";
-        filename = "rcs.sub";
-        // subfile_out += "RAW_Data: " + codes.data;
-    } else {
-        // save as raw
+    if (raw) {
         if (codes.preset == "1") {
             codes.preset = "FuriHalSubGhzPresetOok270Async";
         } else if (codes.preset == "2") {
             codes.preset = "FuriHalSubGhzPresetOok650Async";
         }
-
-        subfile_out += "Preset: " + String(codes.preset) + "\n";
-        subfile_out += "Protocol: RAW\n";
-        subfile_out += "RAW_Data: " + codes.data;
         filename = "raw.sub";
+    } else {
+        filename = "rcs.sub";
     }
 
     String filepath = "/BruceRF";
@@ -504,8 +497,17 @@ bool RCSwitch_SaveSignal(float frequency, RfCodes codes, bool raw, char *key, bo
     File file = createNewFile(fs, filepath, filename);
 
     if (file) {
-        file.println(subfile_out);
-        if (!autoSave) displaySuccess(file.path());
+        SubFileWriter writer(file);
+        writer.writeHeader(int(frequency * 1000000), codes.preset.c_str(), raw ? "RAW" : "RcSwitch");
+        if (raw) {
+            writer.writeRaw(codes.data.c_str());
+        } else {
+            writer.writeField("Bit", codes.Bit);
+            writer.writeField("Key", key);
+            writer.writeField("TE", codes.te);
+        }
+        if (!writer.finish()) displayError("Error saving file", true);
+        else if (!autoSave) displaySuccess(file.path());
     } else {
         displayError("Error saving file", true);
     }
@@ -525,11 +527,19 @@ String rf_scan(float start_freq, float stop_freq, int max_loops) {
 
     ELECHOUSE_cc1101.setRxBW(256);
 
-    float settingf1 = start_freq;
-    float settingf2 = stop_freq;
-    float freq = 0;
-    long compare_freq = 0;
-    float mark_freq;
+    // 10kHz channels calibrated once for the whole range, prepare() spreads wide ranges over fewer
+    const uint16_t count = constrain((int)((stop_freq - start_freq) / 0.01f) + 1, 1, UINT16_MAX);
+    if (!rfTuning.prepare(start_freq, 0.01f, count)) {
+        deinitRfModule();
+        return "";
+    }
+    Serial.printf("Calibrated %u channels in %lu ms\n", rfTuning.size(), rfTuning.buildMs());
+    rfTuning.tune(0);
+
+    int ch = 0;
+    int compare_ch = -1;
+    int mark_ch = 0;
+    bool partial = false;
     int rssi;
     int mark_rssi = -100;
     String out = "";
@@ -538,41 +548,42 @@ String rf_scan(float start_freq, float stop_freq, int max_loops) {
         vTaskDelay(1 / portTICK_PERIOD_MS);
         max_loops -= 1;
 
-        setMHZ(freq);
-
-        rssi = ELECHOUSE_cc1101.getRssi();
+        rssi = ELECHOUSE_cc1101.getRssi(); // tuned on the last pass, after the delay
         if (rssi > -75) {
             if (rssi > mark_rssi) {
                 mark_rssi = rssi;
-                mark_freq = freq;
+                mark_ch = ch;
             };
         };
 
-        freq += 0.01;
+        ch++;
 
-        if (freq > settingf2) {
-            freq = settingf1;
+        if (ch >= rfTuning.size()) {
+            ch = 0;
+            rfTuning.sweepDone(!partial);
+            partial = false;
 
             if (mark_rssi > -75) {
-                long fr = mark_freq * 100;
-                if (fr == compare_freq) {
+                if (mark_ch == compare_ch) {
+                    float mark_freq = rfTuning.mhz(mark_ch);
                     Serial.print(F("\r\nSignal found at  "));
                     Serial.print(F("Freq: "));
                     Serial.print(mark_freq);
                     Serial.print(F(" Rssi: "));
                     Serial.println(mark_rssi);
-                    mark_rssi = -100;
-                    compare_freq = 0;
-                    mark_freq = 0;
                     out += String(mark_freq) + ",";
+                    mark_rssi = -100;
+                    compare_ch = -1;
                 } else {
-                    compare_freq = mark_freq * 100;
-                    freq = mark_freq - 0.10;
-                    mark_freq = 0;
+                    // look again around the mark before reporting it
+                    compare_ch = mark_ch;
+                    ch = max(0, mark_ch - 10);
+                    partial = true;
                     mark_rssi = -100;
                 };
             };
         }; // end of IF freq>stop frequency
+        rfTuning.tune(ch);
     }; // End of While
 
     deinitRfModule();
@@ -1,6 +1,8 @@
 #include "rf_send.h"
 #include "core/type_convertion.h"
+#include "emit.h"
 #include "rf_utils.h"
+#include "sub_file.h"
 #include <RCSwitch.h>
 
 void sendCustomRF() {
@@ -35,10 +37,28 @@ void sendCustomRF() {
     }
 }
 
+static bool rfTxBegin(const RfCodes &rfcode, int &rcswitch_protocol_no);
+
+/*********************************************************************
+**  Function: sendRfRawFile
+**  Sends the RAW_Data of an open .sub file straight from storage
+**********************************************************************/
+static void sendRfRawFile(const RfCodes &rfcode, SubFileReader &reader) {
+    int rcswitch_protocol_no;
+    if (!rfTxBegin(rfcode, rcswitch_protocol_no)) return;
+
+    gpio_num_t txPin = gpio_num_t(bruceConfigPins.rfTx);
+    if (bruceConfigPins.rfModule == CC1101_SPI_MODULE) txPin = gpio_num_t(bruceConfigPins.CC1101_bus.io0);
+
+    // The input task sets EscPress while the file plays, it is consumed by the caller's check()
+    size_t sent = rf_raw_emit_stream(reader, txPin, &EscPress);
+    Serial.printf("RAW_Data: %u values sent\n", sent);
+    deinitRfModule();
+}
+
 bool txSubFile(FS *fs, String filepath, bool hideDefaultUI) {
     struct RfCodes selected_code;
     File databaseFile;
-    String line;
     String txt;
     int sent = 0;
 
@@ -59,33 +79,35 @@ bool txSubFile(FS *fs, String filepath, bool hideDefaultUI) {
     std::vector<int> bitList;
     std::vector<int> bitRawList;
     std::vector<uint64_t> keyList;
-    std::vector<String> rawDataList;
+    std::vector<String> rawDataList; // BinRAW lines, RAW_Data is streamed from the file
+    bool hasRawData = false;
 
-    if (!databaseFile) Serial.println("Fail opening file");
     // Store the code(s) in the signal
-    while (databaseFile.available()) {
-        line = databaseFile.readStringUntil('\n');
-        txt = line.substring(line.indexOf(":") + 1);
-        if (txt.endsWith("\r")) txt.remove(txt.length() - 1);
-        txt.trim();
-        if (line.startsWith("Protocol:")) selected_code.protocol = txt;
-        if (line.startsWith("Preset:")) selected_code.preset = txt;
-        if (line.startsWith("Frequency:")) selected_code.frequency = txt.toInt();
-        if (line.startsWith("TE:")) selected_code.te = txt.toInt();
-        if (line.startsWith("Bit:")) bitList.push_back(txt.toInt()); // selected_code.Bit = txt.toInt();
-        if (line.startsWith("Bit_RAW:"))
-            bitRawList.push_back(txt.toInt()); // selected_code.BitRAW = txt.toInt();
-        if (line.startsWith("Key:"))
-            keyList.push_back(
-                hexStringToDecimal(txt.c_str())
-            ); // selected_code.key = hexStringToDecimal(txt.c_str());
-        if (line.startsWith("RAW_Data:") || line.startsWith("Data_RAW:"))
-            rawDataList.push_back(txt); // selected_code.data = txt;
+    SubFileReader reader(databaseFile);
+    char key[16];
+    while (reader.nextKey(key, sizeof(key))) {
+        if (strcmp(key, "RAW_Data") == 0) {
+            // keep the first line for the recent codes menu
+            if (!hasRawData) reader.readValue(selected_code.data);
+            hasRawData = true;
+            // the header is complete, no need to read the rest of a RAW recording now
+            if (selected_code.protocol == "RAW") break;
+            continue;
+        }
+        reader.readValue(txt);
+        if (strcmp(key, "Protocol") == 0) selected_code.protocol = txt;
+        else if (strcmp(key, "Preset") == 0) selected_code.preset = txt;
+        else if (strcmp(key, "Frequency") == 0) selected_code.frequency = txt.toInt();
+        else if (strcmp(key, "TE") == 0) selected_code.te = txt.toInt();
+        else if (strcmp(key, "Bit") == 0) bitList.push_back(txt.toInt());
+        else if (strcmp(key, "Bit_RAW") == 0) bitRawList.push_back(txt.toInt());
+        else if (strcmp(key, "Key") == 0) keyList.push_back(hexStringToDecimal(txt.c_str()));
+        else if (strcmp(key, "Data_RAW") == 0) rawDataList.push_back(txt);
         if (check(EscPress)) break;
     }
-    int total = bitList.size() + bitRawList.size() + keyList.size() + rawDataList.size() > 0 ? 1 : 0;
+    int total = bitList.size() + bitRawList.size() + keyList.size() +
+                (hasRawData || rawDataList.size() > 0 ? 1 : 0);
     Serial.printf("Total signals found: %d\n", total);
-    databaseFile.close();
 
     // If the signal is complete, send all of the code(s) that were found in it.
     // TODO: try to minimize the overhead between codes.
@@ -118,18 +140,26 @@ bool txSubFile(FS *fs, String filepath, bool hideDefaultUI) {
             }
         }
 
-        // RAS_Data is considered one long signal, doesn't matter the number of lines it has
-        if (rawDataList.size() > 0) sent++;
+        // RAW_Data is considered one long signal, doesn't matter the number of lines it has.
+        // Files of other protocols can carry it too, it is sent the same way
+        if (hasRawData) {
+            sent++;
+            reader.rewind();
+            if (!hideDefaultUI) { displayTextLine("Sending.."); }
+            sendRfRawFile(selected_code, reader);
+        } else if (rawDataList.size() > 0) {
+            sent++;
+        }
         for (String rawData : rawDataList) {
             selected_code.data = rawData;
             sendRfCommand(selected_code, hideDefaultUI);
-            // sent++;
             if (check(EscPress)) break;
-            // displayTextLine("Sent " + String(sent) + "/" + String(total));
         }
         addToRecentCodes(selected_code);
     }
 
+    databaseFile.close();
+
     Serial.printf("\nSent %d of %d signals\n", sent, total);
     if (!hideDefaultUI) { displayTextLine("Sent " + String(sent) + "/" + String(total), true); }
 
@@ -148,12 +178,14 @@ bool txSubFile(FS *fs, String filepath, bool hideDefaultUI) {
     return true;
 }
 
-void sendRfCommand(struct RfCodes rfcode, bool hideDefaultUI) {
+/*********************************************************************
+**  Function: rfTxBegin
+**  Configures the radio for the preset of the code and switches it to
+**  transmit. Returns false if the preset or modulation is unsupported.
+**********************************************************************/
+static bool rfTxBegin(const RfCodes &rfcode, int &rcswitch_protocol_no) {
     uint32_t frequency = rfcode.frequency;
-    String protocol = rfcode.protocol;
-    String preset = rfcode.preset;
-    String data = rfcode.data;
-    uint64_t key = rfcode.key;
+    const String &preset = rfcode.preset;
     byte modulation = 2; // possible values for CC1101: 0 = 2-FSK, 1 =GFSK, 2=ASK, 3 = 4-FSK, 4 = MSK
     float deviation = 1.58;
     float rxBW = 270.83; // Receive bandwidth
@@ -178,7 +210,7 @@ void sendRfCommand(struct RfCodes rfcode, bool hideDefaultUI) {
         FuriHalSubGhzPresetCustom, //Custom Preset
     */
     // struct Protocol rcswitch_protocol;
-    int rcswitch_protocol_no = 1;
+    rcswitch_protocol_no = 1;
     if (preset == "FuriHalSubGhzPresetOok270Async") {
         rcswitch_protocol_no = 1;
         //  pulseLength , syncFactor , zero , one, invertedSignal
@@ -217,12 +249,12 @@ void sendRfCommand(struct RfCodes rfcode, bool hideDefaultUI) {
         if (!found) {
             Serial.print("unsupported preset: ");
             Serial.println(preset);
-            return;
+            return false;
         }
     }
 
     // init transmitter
-    if (!initRfModule("", frequency / 1000000.0)) return;
+    if (!initRfModule("", frequency / 1000000.0)) return false;
     if (bruceConfigPins.rfModule == CC1101_SPI_MODULE) { // CC1101 in use
         // derived from
         // https://github.com/LSatan/SmartRC-CC1101-Driver-Lib/blob/master/examples/Rc-Switch%20examples%20cc1101/SendDemo_cc1101/SendDemo_cc1101.ino
@@ -246,37 +278,30 @@ void sendRfCommand(struct RfCodes rfcode, bool hideDefaultUI) {
         if (modulation != 2) {
             Serial.print("unsupported modulation: ");
             Serial.println(modulation);
-            return;
+            return false;
         }
         initRfModule("tx", frequency / 1000000.0);
     }
+    return true;
+}
+
+void sendRfCommand(struct RfCodes rfcode, bool hideDefaultUI) {
+    String protocol = rfcode.protocol;
+    String data = rfcode.data;
+    int rcswitch_protocol_no = 1;
+
+    if (!rfTxBegin(rfcode, rcswitch_protocol_no)) return;
 
     if (protocol == "RAW") {
-        // count the number of elements of RAW_Data
-        int buff_size = 0;
-        int index = 0;
-        while (index >= 0) {
-            index = data.indexOf(' ', index + 1);
-            buff_size++;
-        }
-        // alloc buffer for transmittimings
-        int *transmittimings =
-            (int *)calloc(sizeof(int), buff_size + 1); // should be smaller the data.length()
-        size_t transmittimings_idx = 0;
-
-        // split data into words, convert to int, and store them in transmittimings
-        int startIndex = 0;
-        index = 0;
-        for (transmittimings_idx = 0; transmittimings_idx < buff_size; transmittimings_idx++) {
-            index = data.indexOf(' ', startIndex);
-            if (index == -1) {
-                transmittimings[transmittimings_idx] = data.substring(startIndex).toInt();
-            } else {
-                transmittimings[transmittimings_idx] = data.substring(startIndex, index).toInt();
-            }
-            startIndex = index + 1;
+        // a value takes at least two chars, that bounds the buffer
+        size_t buff_size = data.length() / 2 + 1;
+        int *transmittimings = (int *)calloc(sizeof(int), buff_size + 1);
+        if (!transmittimings) {
+            Serial.println("Not enough memory for RAW_Data");
+            deinitRfModule();
+            return;
         }
-        transmittimings[transmittimings_idx] = 0; // termination
+        transmittimings[SubFileReader::parseRaw(data.c_str(), transmittimings, buff_size)] = 0; // termination
 
         // send rf command
         if (!hideDefaultUI) { displayTextLine("Sending.."); }
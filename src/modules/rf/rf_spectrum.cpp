@@ -1,4 +1,5 @@
 #include "rf_spectrum.h"
+#include "rf_tuning.h"
 #include "rf_utils.h"
 #include "structs.h"
 #include <RCSwitch.h>
@@ -234,10 +235,12 @@ void rf_CC1101_rssi() {
 
             int space = tftWidth / range;
             int max_idx = 0;
-            for (int i = 0; i < range; i++) {
+            rfTuning.prepare(&subghz_frequency_list[range_limits[bruceConfigPins.rfScanRange][0]], range);
+            int i = 0;
+            for (; i < range; i++) {
                 if (EscPress || SelPress) break;
-                setMHZ(subghz_frequency_list[range_limits[bruceConfigPins.rfScanRange][0] + i]);
-                vTaskDelay(pdMS_TO_TICKS(5));
+                rfTuning.tune(i);
+                vTaskDelay(pdMS_TO_TICKS(RF_SCAN_DWELL_MS));
                 int rssi = ELECHOUSE_cc1101.getRssi();
                 tft.drawPixel(0, 0, 0); // To make sure CC1101 shared with TFT works properly
                 int size = map(rssi, -95, -20, 0, max_bar_size);
@@ -249,6 +252,7 @@ void rf_CC1101_rssi() {
                 tft.fillRect(i * space, 20, space, max_bar_size - bar_size[i], bruceConfig.bgColor);
                 if (bar_size[i] > bar_size[max_idx] && bar_size[i] > min_value) max_idx = i;
             }
+            rfTuning.sweepDone(i == range);
             if (bar_size[max_idx] > min_value) {
                 char buf[7];
                 float var = subghz_frequency_list[range_limits[bruceConfigPins.rfScanRange][0] + max_idx];
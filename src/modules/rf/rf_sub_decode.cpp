@@ -0,0 +1,188 @@
+/*
+ * rf_sub_decode.cpp
+ *
+ * Offline decode of RAW .sub files through the rtl_433 decoder task.
+ *
+ * The decoder task reports results through a callback only when something
+ * decodes, so trains are handed over one at a time: processSignal(), then
+ * the results queue is drained for up to the adaptive wait before the next
+ * train. Results are copied out of the decoder task and written to the
+ * output file from this task.
+ */
+
+#include "rf_sub_decode.h"
+
+#include "rf_listen_decode.h"
+#include "sub_file.h"
+#include <globals.h>
+
+#define SUB_DECODE_CHUNK 256 // durations read from the file at a time
+#define SUB_DECODE_RESULTS 8 // decoded messages waiting to be written
+
+static QueueHandle_t results = nullptr;
+static char resultBuf[RF_DECODE_MSG_BUF_SIZE];
+
+// Runs on the decoder task, the message buffer is reused right after
+static void onSubDecodeResult(char *message) {
+    char *copy = strdup(message);
+    if (copy && xQueueSend(results, &copy, 0) != pdTRUE) free(copy);
+}
+
+struct SubDecodeRun {
+    File out;
+    SubDecodeStats stats;
+    uint32_t wait; // ms, see RF_SUB_DECODE_WAIT_MS
+    uint32_t slowest;
+    RawTrain *train;
+};
+
+static void decodeTrain(SubDecodeRun &run, const String &path, uint32_t freqHz) {
+    pulse_data_t *pd = buildPulseData(*run.train, freqHz / 1000000.0f);
+    if (!pd) return;
+
+    const uint32_t train = run.stats.trains++;
+    const uint32_t start = millis();
+    processSignal(pd); // takes ownership
+
+    bool hit = false;
+    char *msg;
+    while (xQueueReceive(results, &msg, pdMS_TO_TICKS(hit ? RF_SUB_DECODE_SETTLE_MS : run.wait)) == pdTRUE) {
+        if (!hit) {
+            hit = true;
+            run.stats.hits++;
+            run.slowest = max(run.slowest, (uint32_t)(millis() - start));
+            run.wait = constrain(2 * run.slowest, 2 * RF_SUB_DECODE_SETTLE_MS, RF_SUB_DECODE_WAIT_MS);
+        }
+        run.stats.messages++;
+        run.out.printf(
+            "{\"file\":\"%s\",\"train\":%lu,\"pulses\":%d,\"freq\":%lu,\"data\":%s}\n",
+            path.c_str(),
+            train,
+            run.train->num_pulses,
+            freqHz,
+            msg
+        );
+        free(msg);
+    }
+}
+
+static bool decodeFile(SubDecodeRun &run, FS *fs, const String &path) {
+    File file = fs->open(path, FILE_READ);
+    if (!file) return false;
+
+    SubFileReader reader(file);
+    char key[32];
+    String value;
+    uint32_t freqHz = 433920000;
+    bool raw = false;
+    while (!raw && reader.nextKey(key, sizeof(key))) {
+        if (strcmp(key, "Frequency") == 0) {
+            reader.readValue(value);
+            freqHz = value.toInt();
+        } else if (strcmp(key, "Protocol") == 0) {
+            reader.readValue(value);
+            if (value != "RAW") break;
+            raw = true;
+        }
+    }
+    if (!raw) {
+        run.stats.skipped++;
+        file.close();
+        return false;
+    }
+
+    int durations[SUB_DECODE_CHUNK];
+    PulseTrainSplitter splitter(*run.train);
+    size_t n;
+    while ((n = reader.readRaw(durations, SUB_DECODE_CHUNK)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (splitter.push(durations[i])) decodeTrain(run, path, freqHz);
+        }
+    }
+    if (splitter.finish()) decodeTrain(run, path, freqHz);
+    file.close();
+    run.stats.files++;
+    return true;
+}
+
+bool rf_sub_decode(FS *fs, const String &path, SubDecodeStats *stats, bool ui) {
+    File root = fs->open(path, FILE_READ);
+    if (!root) {
+        if (ui) displayError("File not found", true);
+        return false;
+    }
+    const bool folder = root.isDirectory();
+    String outPath = folder ? path : path.substring(0, path.lastIndexOf('/'));
+    if (outPath.endsWith("/")) outPath.remove(outPath.length() - 1);
+    outPath += "/decoded.jsonl";
+
+    SubDecodeRun run = {};
+    run.wait = RF_SUB_DECODE_WAIT_MS;
+    run.train = (RawTrain *)malloc(sizeof(RawTrain));
+    // the folder's decoded.jsonl keeps the lines of its other files when only one is decoded
+    run.out = fs->open(outPath, folder ? FILE_WRITE : FILE_APPEND);
+    if (!run.train || !run.out) {
+        if (ui) displayError(run.train ? "Can't create output" : "Not enough memory", true);
+        free(run.train);
+        root.close();
+        return false;
+    }
+
+    if (!results) results = xQueueCreate(SUB_DECODE_RESULTS, sizeof(char *));
+    _setCallback(onSubDecodeResult, resultBuf, sizeof(resultBuf));
+    rtlSetup();
+
+    const uint32_t start = millis();
+    if (folder) {
+        File entry = root.openNextFile();
+        while (entry) {
+            String name = entry.path();
+            bool sub = !entry.isDirectory() && name.endsWith(".sub");
+            entry.close();
+            if (sub) {
+                if (ui) {
+                    displayRedStripe(
+                        "Decoding " + name.substring(name.lastIndexOf('/') + 1),
+                        getComplementaryColor2(bruceConfig.priColor),
+                        bruceConfig.priColor
+                    );
+                }
+                decodeFile(run, fs, name);
+            }
+            if (ui && check(EscPress)) break;
+            entry = root.openNextFile();
+        }
+    } else {
+        if (ui) {
+            displayRedStripe(
+                "Decoding...", getComplementaryColor2(bruceConfig.priColor), bruceConfig.priColor
+            );
+        }
+        decodeFile(run, fs, path);
+    }
+    root.close();
+    run.stats.ms = millis() - start;
+    run.out.close();
+    free(run.train);
+
+    const SubDecodeStats &s = run.stats;
+    Serial.printf(
+        "# %lu files (%lu not RAW), %lu trains, %lu decoded (%.0f%%), %lu messages, %.1f trains/s\n",
+        s.files,
+        s.skipped,
+        s.trains,
+        s.hits,
+        s.trains ? 100.0f * s.hits / s.trains : 0.0f,
+        s.messages,
+        s.ms ? 1000.0f * s.trains / s.ms : 0.0f
+    );
+    if (stats) *stats = s;
+
+    if (!s.files) {
+        fs->remove(outPath);
+        if (ui) displayError("No RAW .sub file", true);
+        return false;
+    }
+    if (ui) displaySuccess(String(s.hits) + "/" + String(s.trains) + " trains decoded", true);
+    return true;
+}
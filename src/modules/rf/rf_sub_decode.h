@@ -0,0 +1,51 @@
+#pragma once
+#include <FS.h>
+/*
+ * rf_sub_decode.h
+ *
+ * Offline rtl_433 decode of RAW .sub recordings (rf_raw_record, Flipper).
+ * RAW_Data is streamed from storage through PulseTrainSplitter, so files
+ * are split into trains exactly like the live capture of
+ * rf_listen_decode(), and every train goes through the same decoder task.
+ *
+ * Every decoded message becomes one JSON line of decoded.jsonl, next to
+ * the input:
+ *   {"file":"/BruceRF/a.sub","train":3,"pulses":132,"freq":433920000,"data":{...}}
+ * A folder run rewrites it, a single file is appended to what is there.
+ *
+ * tools/sub_decode builds the same splitter on the host.
+ */
+
+/**
+ * Longest wait (ms) for the decoder task to report a train. The wait
+ * shrinks to twice the slowest decode seen so far, the rtl_433 decoders
+ * all run on every train, so a miss takes about as long as a hit.
+ */
+#ifndef RF_SUB_DECODE_WAIT_MS
+#define RF_SUB_DECODE_WAIT_MS 250
+#endif
+
+// Extra time for further messages of a train once the first one arrived
+#ifndef RF_SUB_DECODE_SETTLE_MS
+#define RF_SUB_DECODE_SETTLE_MS 10
+#endif
+
+struct SubDecodeStats {
+    uint32_t files;   // RAW files decoded
+    uint32_t skipped; // .sub files without RAW_Data
+    uint32_t trains;
+    uint32_t hits; // trains with at least one message
+    uint32_t messages;
+    uint32_t ms;
+};
+
+/**
+ * @brief Decodes a .sub file, or every .sub file of a folder.
+ *
+ * @param  fs     Storage holding path, decoded.jsonl is written there too.
+ * @param  path   .sub file or folder.
+ * @param  stats  Optional, filled with the counters of the run.
+ * @param  ui     Show progress and results on screen, Esc aborts.
+ * @return        false when nothing could be decoded (no RAW file, no output).
+ */
+bool rf_sub_decode(FS *fs, const String &path, SubDecodeStats *stats = nullptr, bool ui = true);
@@ -0,0 +1,128 @@
+#include "rf_tuning.h"
+#include "rf_utils.h"
+#include <globals.h>
+
+#define CC1101_FS_AUTOCAL 0x30    // MCSM0[5:4]
+#define CC1101_MARCSTATE_IDLE 0x01
+#define CC1101_CAL_TIMEOUT_US 2000 // a calibration takes ~720us
+
+RfTuning rfTuning;
+
+bool RfTuning::begin() {
+    if (bruceConfigPins.rfModule != CC1101_SPI_MODULE) return false;
+    // initRfModule() runs Init() again, so this is done on every prepare()
+    uint8_t mcsm0 = ELECHOUSE_cc1101.SpiReadReg(CC1101_MCSM0);
+    if (!_active) _mcsm0 = mcsm0;
+    ELECHOUSE_cc1101.SpiWriteReg(CC1101_MCSM0, mcsm0 & ~CC1101_FS_AUTOCAL);
+    _active = true;
+    _loaded = -1;
+    return true;
+}
+
+void RfTuning::end() {
+    if (!_active) return;
+    ELECHOUSE_cc1101.SpiWriteReg(CC1101_MCSM0, _mcsm0);
+    _active = false;
+    _sweepStart = 0;
+}
+
+void RfTuning::invalidate() { _channels.clear(); }
+
+bool RfTuning::fresh() const { return !_channels.empty() && millis() - _builtAt < RF_TUNING_MAX_AGE_MS; }
+
+void RfTuning::calibrate(RfChannel &channel) {
+    // the driver switches the antenna and sets the band offsets (FSCTRL0, TEST0), its FREQ word is replaced
+    setMHZ(channel.mhz);
+    // same fallback as setMHZ()
+    const float mhz = channel.mhz > 928 || channel.mhz < 280 ? 433.92f : channel.mhz;
+    const uint32_t word = cc1101FreqWord(mhz);
+    channel.freq[0] = word >> 16;
+    channel.freq[1] = word >> 8;
+    channel.freq[2] = word;
+
+    ELECHOUSE_cc1101.SpiStrobe(CC1101_SIDLE);
+    ELECHOUSE_cc1101.SpiWriteBurstReg(CC1101_FREQ2, channel.freq, 3);
+    ELECHOUSE_cc1101.SpiStrobe(CC1101_SCAL);
+    uint32_t start = micros();
+    while ((ELECHOUSE_cc1101.SpiReadStatus(CC1101_MARCSTATE) & 0x1F) != CC1101_MARCSTATE_IDLE) {
+        if (micros() - start > CC1101_CAL_TIMEOUT_US) {
+            log_w("CC1101 calibration timeout at %.3f MHz", channel.mhz);
+            break;
+        }
+    }
+    channel.fscal[0] = ELECHOUSE_cc1101.SpiReadReg(CC1101_FSCAL3);
+    channel.fscal[1] = ELECHOUSE_cc1101.SpiReadReg(CC1101_FSCAL2);
+    channel.fscal[2] = ELECHOUSE_cc1101.SpiReadReg(CC1101_FSCAL1);
+    channel.fsctrl0 = ELECHOUSE_cc1101.SpiReadReg(CC1101_FSCTRL0);
+    channel.test0 = ELECHOUSE_cc1101.SpiReadReg(CC1101_TEST0);
+}
+
+bool RfTuning::prepare(float start, float step, uint16_t count) {
+    rfSweepSpread(step, count);
+    if (!count || !begin()) return false;
+    if (!_list && _start == start && _step == step && _channels.size() == count && fresh()) return true;
+
+    uint32_t t = millis();
+    _channels.resize(count);
+    for (uint16_t i = 0; i < count; i++) {
+        _channels[i].mhz = start + i * step;
+        calibrate(_channels[i]);
+    }
+    _start = start;
+    _step = step;
+    _list = false;
+    _builtAt = millis();
+    _buildMs = _builtAt - t;
+    _sweepStart = 0;
+    log_i("RF tuning: %u channels calibrated in %lu ms", count, _buildMs);
+    return true;
+}
+
+bool RfTuning::prepare(const float *list, uint16_t count) {
+    if (count > RF_TUNING_MAX_CHANNELS) count = RF_TUNING_MAX_CHANNELS;
+    if (!count || !begin()) return false;
+    bool same = _list && _channels.size() == count && fresh();
+    for (uint16_t i = 0; same && i < count; i++) same = _channels[i].mhz == list[i];
+    if (same) return true;
+
+    uint32_t t = millis();
+    _channels.resize(count);
+    for (uint16_t i = 0; i < count; i++) {
+        _channels[i].mhz = list[i];
+        calibrate(_channels[i]);
+    }
+    _list = true;
+    _builtAt = millis();
+    _buildMs = _builtAt - t;
+    _sweepStart = 0;
+    log_i("RF tuning: %u channels calibrated in %lu ms", count, _buildMs);
+    return true;
+}
+
+void RfTuning::tune(uint16_t i) {
+    if (!_active || i >= _channels.size()) return;
+    RfChannel &c = _channels[i];
+    if (!_sweepStart) _sweepStart = micros();
+
+    selectRfAntenna(c.mhz);
+    // frequency registers may only change in IDLE, see initRfModule()
+    ELECHOUSE_cc1101.SpiStrobe(CC1101_SIDLE);
+    ELECHOUSE_cc1101.SpiWriteBurstReg(CC1101_FREQ2, c.freq, 3);
+    ELECHOUSE_cc1101.SpiWriteBurstReg(CC1101_FSCAL3, c.fscal, 3);
+    if (_loaded < 0 || _channels[_loaded].fsctrl0 != c.fsctrl0 || _channels[_loaded].test0 != c.test0) {
+        ELECHOUSE_cc1101.SpiWriteReg(CC1101_FSCTRL0, c.fsctrl0);
+        ELECHOUSE_cc1101.SpiWriteReg(CC1101_TEST0, c.test0);
+    }
+    _loaded = i;
+    ELECHOUSE_cc1101.SpiStrobe(CC1101_SRX);
+}
+
+void RfTuning::sweepDone(bool complete) {
+    uint32_t now = micros();
+    if (_sweepStart && complete) {
+        uint32_t us = now - _sweepStart;
+        // smoothed, the UI loops differ a lot between sweeps
+        _sweepUs = _sweepUs ? (_sweepUs * 3 + us) / 4 : us;
+    }
+    _sweepStart = now;
+}
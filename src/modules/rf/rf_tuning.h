@@ -0,0 +1,114 @@
+#ifndef __RF_TUNING_H__
+#define __RF_TUNING_H__
+
+#include <stdint.h>
+#include <vector>
+
+/*
+  CC1101 channel cache for the sweeping tools (waterfall, scan copy, RSSI
+  spectrum, serial "subghz scan").
+
+  setMHZ() works out the FREQ word with a float loop and lets the chip
+  recalibrate the synthesizer on every IDLE->RX (~800us each). The cache
+  does both once per sweep range: the FREQ word and the FSCAL3/2/1 results
+  of a manual calibration are stored for every channel, then a retune is
+  SIDLE, two 3 byte bursts and SRX, with FS_AUTOCAL off. This is the fast
+  hopping procedure of the CC1101 datasheet.
+*/
+
+#define CC1101_XOSC_MHZ 26.0f
+
+// Channels per sweep, wider sweeps are spread over this many steps
+#ifndef RF_TUNING_MAX_CHANNELS
+#define RF_TUNING_MAX_CHANNELS 512
+#endif
+// Calibration drifts with temperature, older caches are rebuilt
+#ifndef RF_TUNING_MAX_AGE_MS
+#define RF_TUNING_MAX_AGE_MS (5 * 60 * 1000)
+#endif
+// Time on each channel before reading RSSI in the list scanners
+#ifndef RF_SCAN_DWELL_MS
+#define RF_SCAN_DWELL_MS 2
+#endif
+
+/*********************************************************************
+**  Function: cc1101FreqWord
+**  FREQ[23:0] for a carrier, f_carrier * 2^16 / f_XOSC, rounded
+**********************************************************************/
+inline uint32_t cc1101FreqWord(float mhz) {
+    return (uint32_t)((double)mhz * 65536.0 / CC1101_XOSC_MHZ + 0.5) & 0xFFFFFF;
+}
+
+/*********************************************************************
+**  Function: cc1101WordMHz
+**  Carrier programmed by a FREQ word
+**********************************************************************/
+inline float cc1101WordMHz(uint32_t word) { return (float)(word * (double)CC1101_XOSC_MHZ / 65536.0); }
+
+/*********************************************************************
+**  Function: rfSweepSpread
+**  Sweeps of more than RF_TUNING_MAX_CHANNELS channels are spread
+**  over that many, with the same first and last channel
+**********************************************************************/
+inline void rfSweepSpread(float &step, uint16_t &count) {
+    if (count <= RF_TUNING_MAX_CHANNELS) return;
+    step = step * (count - 1) / (RF_TUNING_MAX_CHANNELS - 1);
+    count = RF_TUNING_MAX_CHANNELS;
+}
+
+struct RfChannel {
+    float mhz;
+    uint8_t freq[3];  // FREQ2, FREQ1, FREQ0
+    uint8_t fscal[3]; // FSCAL3, FSCAL2, FSCAL1 after calibration
+    uint8_t fsctrl0;  // band offsets set by the driver (setClb)
+    uint8_t test0;
+};
+
+/*********************************************************************
+**  Class: RfTuning
+**  prepare() builds or reuses the cache and turns autocalibration off,
+**  tune() hops, end() gives the radio back to the driver. Call
+**  sweepDone() after the last channel for the timing figures.
+**********************************************************************/
+class RfTuning {
+public:
+    // count channels from start, step MHz apart, spread by rfSweepSpread(). After initRfModule("rx"),
+    // false without a CC1101
+    bool prepare(float start, float step, uint16_t count);
+    // channels from a frequency list (subghz_frequency_list ranges)
+    bool prepare(const float *list, uint16_t count);
+    void end();
+    void invalidate();
+
+    // Switches to channel i and enters RX, no calibration
+    void tune(uint16_t i);
+    // End of a sweep over every channel, partial ones (resumed midway) only restart the clock
+    void sweepDone(bool complete = true);
+
+    uint16_t size() const { return _channels.size(); }
+    float mhz(uint16_t i) const { return i < _channels.size() ? _channels[i].mhz : 0; }
+    float sweepsPerSecond() const { return _sweepUs ? 1000000.0f / _sweepUs : 0; }
+    uint32_t dwellUs() const { return _channels.empty() ? 0 : _sweepUs / _channels.size(); }
+    uint32_t buildMs() const { return _buildMs; }
+
+private:
+    bool begin();
+    bool fresh() const;
+    void calibrate(RfChannel &channel);
+
+    std::vector<RfChannel> _channels;
+    float _start = 0;
+    float _step = 0;
+    bool _list = false;
+    uint32_t _builtAt = 0;
+    uint32_t _buildMs = 0;
+    bool _active = false;
+    uint8_t _mcsm0 = 0;
+    int16_t _loaded = -1; // fsctrl0/test0 of this channel are in the chip
+    uint32_t _sweepStart = 0;
+    uint32_t _sweepUs = 0;
+};
+
+extern RfTuning rfTuning;
+
+#endif
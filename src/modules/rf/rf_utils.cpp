@@ -1,5 +1,6 @@
 #include "rf_utils.h"
 #include "core/settings.h"
+#include "rf_tuning.h"
 
 // CRC-64-ECMA constants
 const uint64_t CRC64_ECMA_POLY = 0x42F0E1EBA9EA3693; // Polynomial for CRC-64-ECMA
@@ -205,6 +206,7 @@ bool initRfModule(String mode, float frequency) {
 void deinitRfModule() {
     if (bruceConfigPins.rfModule == CC1101_SPI_MODULE) {
         if (cc1101_spi_ready) {
+            rfTuning.end();
             ELECHOUSE_cc1101.setSidle();
             cc1101_spi_ready = false;
         }
@@ -234,43 +236,47 @@ void initCC1101once(SPIClass *SSPI) {
     return;
 }
 
+void selectRfAntenna(float frequency) {
+#if defined(T_EMBED)
+    static uint8_t antenna =
+        200; // 0=(<300), 1=(350-468), 2=(>778), 200=start to settle at the fisrt time
+    bool change = true;
+#if !defined(T_EMBED_1101)
+    // there's one version of T-Embed (White whith orange wheel) that has CC1101
+    // which antenna has the same circuit as the new CC1101 version with different pinouts
+    // this device uses 17 for CS
+    if (bruceConfigPins.CC1101_bus.cs != 17) change = false;
+#endif
+
+    // SW1:1  SW0:0 --- 315MHz
+    // SW1:0  SW0:1 --- 868/915MHz
+    // SW1:1  SW0:1 --- 434MHz
+    if (frequency <= 350 && antenna != 0 && change) {
+        digitalWrite(CC1101_SW1_PIN, HIGH);
+        digitalWrite(CC1101_SW0_PIN, LOW);
+        antenna = 0;
+        vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
+    } else if (frequency > 350 && frequency < 468 && antenna != 1 && change) {
+        digitalWrite(CC1101_SW1_PIN, HIGH);
+        digitalWrite(CC1101_SW0_PIN, HIGH);
+        antenna = 1;
+        vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
+    } else if (frequency > 778 && antenna != 2 && change) {
+        digitalWrite(CC1101_SW1_PIN, LOW);
+        digitalWrite(CC1101_SW0_PIN, HIGH);
+        antenna = 2;
+        vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
+    }
+#endif
+}
+
 void setMHZ(float frequency) {
     if (frequency > 928 || frequency < 280) {
         frequency = 433.92;
         Serial.println("Frequency out of band");
     }
     if (bruceConfigPins.rfModule == CC1101_SPI_MODULE) {
-#if defined(T_EMBED)
-        static uint8_t antenna =
-            200; // 0=(<300), 1=(350-468), 2=(>778), 200=start to settle at the fisrt time
-        bool change = true;
-#if !defined(T_EMBED_1101)
-        // there's one version of T-Embed (White whith orange wheel) that has CC1101
-        // which antenna has the same circuit as the new CC1101 version with different pinouts
-        // this device uses 17 for CS
-        if (bruceConfigPins.CC1101_bus.cs != 17) change = false;
-#endif
-
-        // SW1:1  SW0:0 --- 315MHz
-        // SW1:0  SW0:1 --- 868/915MHz
-        // SW1:1  SW0:1 --- 434MHz
-        if (frequency <= 350 && antenna != 0 && change) {
-            digitalWrite(CC1101_SW1_PIN, HIGH);
-            digitalWrite(CC1101_SW0_PIN, LOW);
-            antenna = 0;
-            vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
-        } else if (frequency > 350 && frequency < 468 && antenna != 1 && change) {
-            digitalWrite(CC1101_SW1_PIN, HIGH);
-            digitalWrite(CC1101_SW0_PIN, HIGH);
-            antenna = 1;
-            vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
-        } else if (frequency > 778 && antenna != 2 && change) {
-            digitalWrite(CC1101_SW1_PIN, LOW);
-            digitalWrite(CC1101_SW0_PIN, HIGH);
-            antenna = 2;
-            vTaskDelay(10 / portTICK_PERIOD_MS); // time to settle the antenna signal
-        }
-#endif
+        selectRfAntenna(frequency);
         ELECHOUSE_cc1101.setMHZ(frequency);
     }
 }
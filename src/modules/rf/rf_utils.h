@@ -23,6 +23,8 @@ void deinitRfModule();
 void initCC1101once(SPIClass *SSPI);
 
 void setMHZ(float frequency);
+// T-Embed antenna switch for the band of frequency, no-op when already there
+void selectRfAntenna(float frequency);
 int find_pulse_index(const std::vector<int> &indexed_durations, int duration);
 uint64_t crc64_ecma(const std::vector<int> &data);
 
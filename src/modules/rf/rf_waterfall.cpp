@@ -1,4 +1,5 @@
 #include "rf_waterfall.h"
+#include "rf_tuning.h"
 #ifndef TFT_MOSI
 #define TFT_MOSI -1
 #endif
@@ -115,9 +116,13 @@ void rf_waterfall_run() {
         else if (range > 0.1) step = 0.01;
         else step = 0.001;
 
+        if (!rfTuning.prepare(f_start, f_freq_step, screen_width)) break;
+        const int channels = rfTuning.size();
         for (int i = 0; i < screen_width; ++i) {
-            float f_freq = f_start + i * f_freq_step;
-            setMHZ(f_freq);
+            // wider sweeps than the cache share channels between columns
+            const int ch = i * channels / screen_width;
+            float f_freq = rfTuning.mhz(ch);
+            rfTuning.tune(ch);
             // To make sure CC1101 shared with TFT works properly on T-Embed
             if (bruceConfigPins.CC1101_bus.mosi == TFT_MOSI) {
                 tft.drawPixel(0, 0, 0);
@@ -160,19 +165,20 @@ void rf_waterfall_run() {
                 switch (selected_item) {
                     case 0: f_start += step; break;
                     case 1: f_end += step; break;
-                    case 2: return;
+                    case 2: rfTuning.end(); return;
                 }
                 delay(100);
             } else if (check(DownPress) || check(PrevPress)) {
                 switch (selected_item) {
                     case 0: f_start -= step; break;
                     case 1: f_end -= step; break;
-                    case 2: return;
+                    case 2: rfTuning.end(); return;
                 }
                 if (EscPress) EscPress = false; // Reset for StickCs
                 delay(100);
             }
         }
+        rfTuning.sweepDone();
         tft.drawPixel(0, 0, 0); // Cardputer Case, need to call something to the tft.
         tft.pushImage(0, current_line, screen_width, 1, frameBuffer);
         tft.drawFastHLine(0, current_line + 1, screen_width, TFT_DARKGREY);
@@ -185,6 +191,8 @@ void rf_waterfall_run() {
             tft.setTextSize(1);
             tft.setTextColor(TFT_YELLOW, TFT_BLACK);
             tft.printf("%d dBm @ %.3f", max_rssi, max_freq);
+            tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
+            tft.printf("  %.1f sweeps/s %luus", rfTuning.sweepsPerSecond(), rfTuning.dwellUs());
 
             lastMaxUpdate = millis();
         }
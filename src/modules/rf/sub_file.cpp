@@ -0,0 +1,231 @@
+#include "sub_file.h"
+
+static bool isRawKey(const char *key) { return strcmp(key, "RAW_Data") == 0; }
+
+/////////////////////////////////////////////////////////////////////////////////////
+// SubFileReader
+/////////////////////////////////////////////////////////////////////////////////////
+
+int SubFileReader::next() {
+    if (_pos >= _len) {
+        if (_eof) return -1;
+        int n = _file.read((uint8_t *)_buf, sizeof(_buf));
+        if (n <= 0) {
+            _eof = true;
+            return -1;
+        }
+        _len = n;
+        _pos = 0;
+    }
+    return (uint8_t)_buf[_pos++];
+}
+
+void SubFileReader::skipLine() {
+    int c;
+    do { c = next(); } while (c >= 0 && c != '\n');
+    _inLine = false;
+    _inRaw = false;
+}
+
+void SubFileReader::rewind() {
+    _file.seek(0);
+    _pos = _len = 0;
+    _eof = false;
+    _inLine = false;
+    _inRaw = false;
+}
+
+bool SubFileReader::nextKey(char *key, size_t size) {
+    if (_inLine) skipLine();
+
+    while (true) {
+        int c = next();
+        while (c == '\n' || c == '\r' || c == ' ' || c == '\t') c = next();
+        if (c < 0) return false;
+
+        size_t len = 0;
+        while (c >= 0 && c != ':' && c != '\n') {
+            if (len < size - 1) key[len++] = c;
+            c = next();
+        }
+        key[len] = '\0';
+        if (c == ':') {
+            _inLine = true;
+            _inRaw = isRawKey(key);
+            return true;
+        }
+        // line without a key, e.g. "Version 1"
+    }
+}
+
+void SubFileReader::readValue(String &value) {
+    value = "";
+    if (!_inLine) return;
+
+    int c = next();
+    while (c == ' ' || c == '\t') c = next();
+    while (c >= 0 && c != '\n') {
+        value += (char)c;
+        c = next();
+    }
+    value.trim();
+    _inLine = false;
+    _inRaw = false;
+}
+
+size_t SubFileReader::readRaw(int *dst, size_t max) {
+    char key[16];
+    size_t n = 0;
+
+    while (n < max) {
+        if (!_inRaw) {
+            do {
+                if (!nextKey(key, sizeof(key))) return n;
+            } while (!_inRaw);
+        }
+
+        int c = next();
+        while (c == ' ' || c == '\t' || c == '\r') c = next();
+        if (c < 0 || c == '\n') {
+            _inLine = false;
+            _inRaw = false;
+            continue;
+        }
+
+        bool negative = c == '-';
+        if (negative) c = next();
+        int value = 0;
+        bool digits = false;
+        while (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+            digits = true;
+            c = next();
+        }
+        if (digits && value != 0) dst[n++] = negative ? -value : value;
+        if (c < 0 || c == '\n') {
+            _inLine = false;
+            _inRaw = false;
+        }
+    }
+    return n;
+}
+
+size_t SubFileReader::parseRaw(const char *src, int *dst, size_t max, const char **end) {
+    size_t n = 0;
+    while (*src && n < max) {
+        bool negative = *src == '-';
+        if (negative) src++;
+        int value = 0;
+        bool digits = false;
+        while (*src >= '0' && *src <= '9') {
+            value = value * 10 + (*src++ - '0');
+            digits = true;
+        }
+        if (digits && value != 0) dst[n++] = negative ? -value : value;
+        else if (*src) src++; // separators and anything that is not a duration
+    }
+    if (end) *end = src;
+    return n;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// SubFileWriter
+/////////////////////////////////////////////////////////////////////////////////////
+
+SubFileWriter::SubFileWriter(File &file) : _file(file) {
+    _buf = (char *)malloc(SUB_WRITE_BUFFER_SIZE);
+    if (!_buf) log_w("SubFileWriter: no memory for the write buffer, writing unbuffered");
+}
+
+SubFileWriter::~SubFileWriter() {
+    finish();
+    free(_buf);
+}
+
+void SubFileWriter::flush() {
+    if (_len == 0) return;
+    if (_file.write((const uint8_t *)_buf, _len) != _len) _ok = false;
+    _len = 0;
+}
+
+void SubFileWriter::put(const char *data, size_t len) {
+    if (!_buf) {
+        if (_file.write((const uint8_t *)data, len) != len) _ok = false;
+        return;
+    }
+    while (len > 0) {
+        size_t n = SUB_WRITE_BUFFER_SIZE - _len;
+        if (n > len) n = len;
+        memcpy(_buf + _len, data, n);
+        _len += n;
+        data += n;
+        len -= n;
+        if (_len == SUB_WRITE_BUFFER_SIZE) flush();
+    }
+}
+
+void SubFileWriter::putInt(int value) {
+    char tmp[12];
+    char *p = tmp + sizeof(tmp);
+    unsigned int v = value < 0 ? -(unsigned int)value : value;
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (value < 0) *--p = '-';
+    put(p, tmp + sizeof(tmp) - p);
+}
+
+void SubFileWriter::endRawLine() {
+    if (_lineValues == 0) return;
+    put("\n", 1);
+    _lineValues = 0;
+}
+
+void SubFileWriter::writeHeader(uint32_t frequency, const char *preset, const char *protocol) {
+    put("Filetype: Bruce SubGhz File\nVersion 1\n");
+    writeField("Frequency", (int)frequency);
+    writeField("Preset", preset);
+    writeField("Protocol", protocol);
+}
+
+void SubFileWriter::writeField(const char *key, const char *value) {
+    endRawLine();
+    put(key);
+    put(": ", 2);
+    put(value);
+    put("\n", 1);
+}
+
+void SubFileWriter::writeField(const char *key, int value) {
+    endRawLine();
+    put(key);
+    put(": ", 2);
+    putInt(value);
+    put("\n", 1);
+}
+
+void SubFileWriter::writeRaw(int duration) {
+    if (duration == 0) return;
+    if (_lineValues == 0) put("RAW_Data: ", 10);
+    else put(" ", 1);
+    putInt(duration);
+    if (++_lineValues == SUB_RAW_VALUES_PER_LINE) endRawLine();
+}
+
+size_t SubFileWriter::writeRaw(const char *durations) {
+    size_t total = 0;
+    int value;
+    // one value at a time, so the source lines can be of any length
+    while (SubFileReader::parseRaw(durations, &value, 1, &durations) == 1) {
+        writeRaw(value);
+        total++;
+    }
+    return total;
+}
+
+bool SubFileWriter::finish() {
+    endRawLine();
+    flush();
+    return _ok;
+}
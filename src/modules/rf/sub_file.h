@@ -0,0 +1,86 @@
+#ifndef __SUB_FILE_H__
+#define __SUB_FILE_H__
+
+#include <FS.h>
+
+// Flipper limits RAW_Data lines to 512 values
+// https://github.com/flipperdevices/flipperzero-firmware/blob/dev/documentation/file_formats/SubGhzFileFormats.md#raw-files
+#define SUB_RAW_VALUES_PER_LINE 512
+
+#ifndef SUB_READ_BUFFER_SIZE
+#define SUB_READ_BUFFER_SIZE 512
+#endif
+
+#ifndef SUB_WRITE_BUFFER_SIZE
+#define SUB_WRITE_BUFFER_SIZE 4096
+#endif
+
+/*********************************************************************
+**  Class: SubFileReader
+**  Streaming tokenizer for .sub files. Keys are matched in place and
+**  RAW_Data durations are parsed straight into the caller's buffer, so
+**  a recording is never held in RAM as text.
+**********************************************************************/
+class SubFileReader {
+public:
+    explicit SubFileReader(File &file) : _file(file) {}
+
+    // Moves to the next "Key: value" line, false at the end of the file
+    bool nextKey(char *key, size_t size);
+    // Rest of the current line, trimmed
+    void readValue(String &value);
+    // Next durations of the RAW_Data lines, 0 once all of them were read
+    size_t readRaw(int *dst, size_t max);
+    void rewind();
+
+    // Parses a space separated list of durations, used for RAW data kept in a String.
+    // end is set to where parsing stopped.
+    static size_t parseRaw(const char *src, int *dst, size_t max, const char **end = nullptr);
+
+private:
+    File &_file;
+    char _buf[SUB_READ_BUFFER_SIZE];
+    size_t _pos = 0;
+    size_t _len = 0;
+    bool _eof = false;
+    bool _inLine = false; // the current line was not consumed yet
+    bool _inRaw = false;  // positioned inside a RAW_Data line
+
+    int next();
+    void skipLine();
+};
+
+/*********************************************************************
+**  Class: SubFileWriter
+**  Buffered .sub writer, data is flushed to the file in large blocks
+**  and RAW_Data lines are split every SUB_RAW_VALUES_PER_LINE values.
+**********************************************************************/
+class SubFileWriter {
+public:
+    explicit SubFileWriter(File &file);
+    ~SubFileWriter();
+
+    void writeHeader(uint32_t frequency, const char *preset, const char *protocol);
+    void writeField(const char *key, const char *value);
+    void writeField(const char *key, int value);
+    void writeRaw(int duration);
+    // Copies a space separated list of durations, re-splitting the lines
+    size_t writeRaw(const char *durations);
+    // Ends the last RAW_Data line and flushes, false if the file is incomplete
+    bool finish();
+
+private:
+    File &_file;
+    char *_buf;
+    size_t _len = 0;
+    uint16_t _lineValues = 0;
+    bool _ok = true;
+
+    void put(const char *data, size_t len);
+    void put(const char *str) { put(str, strlen(str)); }
+    void putInt(int value);
+    void endRawLine();
+    void flush();
+};
+
+#endif
@@ -55,11 +55,9 @@ bool PN532::begin() {
 int PN532::read(int cardBaudRate) {
     pageReadStatus = FAILURE;
 
-    bool felica = false;
     if (cardBaudRate == PN532_MIFARE_ISO14443A) {
         if (!nfc.startPassiveTargetIDDetection(cardBaudRate)) return TAG_NOT_PRESENT;
         if (!nfc.readDetectedPassiveTargetID()) return FAILURE;
-        format_data();
         set_uid();
     } else {
         uint16_t sys_code = 0xFFFF; // Default sys code for FeliCa
@@ -68,12 +66,15 @@ int PN532::read(int cardBaudRate) {
         uint8_t pmm[8];
         uint16_t sys_code_res;
         if (!nfc.felica_Polling(sys_code, req_code, idm, pmm, &sys_code_res)) { return TAG_NOT_PRESENT; }
-        format_data_felica(idm, pmm, sys_code_res);
+        set_uid_felica(idm, pmm, sys_code_res);
     }
 
     displayInfo("Reading data blocks...");
+    uint32_t readStart = millis();
     pageReadStatus = read_data_blocks();
+    dump.readMs = millis() - readStart;
     pageReadSuccess = pageReadStatus == SUCCESS;
+    format_printable_uid();
     return SUCCESS;
 }
 
@@ -158,29 +159,12 @@ int PN532::load() {
 
     if (!file) { return FAILURE; }
 
-    String line;
-    String strData;
-    strAllPages = "";
-    pageReadSuccess = true;
-
-    while (file.available()) {
-        line = file.readStringUntil('\n');
-        strData = line.substring(line.indexOf(":") + 1);
-        strData.trim();
-        if (line.startsWith("Device type:")) printableUID.picc_type = strData;
-        if (line.startsWith("UID:")) printableUID.uid = strData;
-        if (line.startsWith("SAK:")) printableUID.sak = strData;
-        if (line.startsWith("ATQA:")) printableUID.atqa = strData;
-        if (line.startsWith("Pages total:")) dataPages = strData.toInt();
-        if (line.startsWith("Pages read:")) pageReadSuccess = false;
-        if (line.startsWith("Page ")) strAllPages += line + "\n";
-    }
+    int status = load_dump(file);
 
     file.close();
     delay(100);
-    parse_data();
 
-    return SUCCESS;
+    return status;
 }
 
 int PN532::save(String filename) {
@@ -191,34 +175,20 @@ int PN532::save(String filename) {
 
     if (!file) { return FAILURE; }
 
-    file.println("Filetype: Bruce RFID File");
-    file.println("Version 1");
-    file.println("Device type: " + printableUID.picc_type);
-    file.println("# UID, ATQA and SAK are common for all formats");
-    file.println("UID: " + printableUID.uid);
-    if (printableUID.picc_type != "FeliCa") {
-        file.println("SAK: " + printableUID.sak);
-        file.println("ATQA: " + printableUID.atqa);
-        file.println("# Memory dump");
-        file.println("Pages total: " + String(dataPages));
-        if (!pageReadSuccess) file.println("Pages read: " + String(dataPages));
-    } else {
-        file.println("Manufacture id: " + printableUID.sak);
-        file.println("Blocks total: " + String(totalPages));
-        file.println("Blocks read: " + String(dataPages));
-    }
-    file.print(strAllPages);
+    int status = save_dump(file);
 
     file.close();
     delay(100);
-    return SUCCESS;
+    return status;
 }
 
 String PN532::get_tag_type() {
-    String tag_type = nfc.PICC_GetTypeName(nfc.targetUid.sak);
+    String tag_type = nfc.PICC_GetTypeName(uid.sak);
 
-    if (nfc.targetUid.sak == PICC_TYPE_MIFARE_UL) {
-        switch (totalPages) {
+    if (uid.sak == PICC_TYPE_MIFARE_UL) {
+        switch (dump.totalPages) {
+            case 20:
+            case 41: tag_type = "MIFARE Ultralight EV1"; break;
             case 45: tag_type = "NTAG213"; break;
             case 135: tag_type = "NTAG215"; break;
             case 231: tag_type = "NTAG216"; break;
@@ -236,84 +206,38 @@ void PN532::set_uid() {
     for (byte i = 0; i < 2; i++) uid.atqaByte[i] = nfc.targetUid.atqaByte[i];
 
     for (byte i = 0; i < nfc.targetUid.size; i++) { uid.uidByte[i] = nfc.targetUid.uidByte[i]; }
-}
-
-void PN532::format_data() {
-    byte bcc = 0;
 
-    printableUID.picc_type = get_tag_type();
-
-    printableUID.sak = nfc.targetUid.sak < 0x10 ? "0" : "";
-    printableUID.sak += String(nfc.targetUid.sak, HEX);
-    printableUID.sak.toUpperCase();
-
-    // UID
-    for (byte i = 0; i < nfc.targetUid.size; i++) { bcc = bcc ^ nfc.targetUid.uidByte[i]; }
-    printableUID.uid = hexToStr(nfc.targetUid.uidByte, nfc.targetUid.size);
-
-    // BCC
-    printableUID.bcc = bcc < 0x10 ? "0" : "";
-    printableUID.bcc += String(bcc, HEX);
-    printableUID.bcc.toUpperCase();
-
-    // ATQA
-    printableUID.atqa = hexToStr(nfc.targetUid.atqaByte, 2);
+    dump.reset();
 }
 
-void PN532::format_data_felica(uint8_t idm[8], uint8_t pmm[8], uint16_t sys_code) {
-    // Reuse uid-sak-atqa to save memory
-    printableUID.picc_type = "FeliCa";
-    printableUID.uid = hexToStr(idm, 8);
-    printableUID.sak = hexToStr(pmm, 8);
-    printableUID.atqa = String(sys_code, HEX);
-
+void PN532::set_uid_felica(uint8_t idm[8], uint8_t pmm[8], uint16_t sys_code) {
+    memset(&uid, 0, sizeof(uid));
+    uid.size = 8;
     memcpy(uid.uidByte, idm, 8);
-}
-
-void PN532::parse_data() {
-    String strUID = printableUID.uid;
-    strUID.trim();
-    strUID.replace(" ", "");
-    uid.size = strUID.length() / 2;
-    for (size_t i = 0; i < strUID.length(); i += 2) {
-        uid.uidByte[i / 2] = strtoul(strUID.substring(i, i + 2).c_str(), NULL, 16);
-    }
-
-    printableUID.sak.trim();
-    uid.sak = strtoul(printableUID.sak.c_str(), NULL, 16);
 
-    String strAtqa = printableUID.atqa;
-    strAtqa.trim();
-    strAtqa.replace(" ", "");
-    for (size_t i = 0; i < strAtqa.length(); i += 2) {
-        uid.atqaByte[i / 2] = strtoul(strAtqa.substring(i, i + 2).c_str(), NULL, 16);
-    }
+    dump.reset(14, 16);
+    dump.setType("FeliCa");
+    dump.felica = true;
+    memcpy(dump.pmm, pmm, 8);
+    dump.systemCode = sys_code;
 }
 
 int PN532::read_data_blocks() {
-    dataPages = 0;
-    totalPages = 0;
     int readStatus = FAILURE;
 
-    strAllPages = "";
+    if (dump.felica) return read_felica_data();
 
-    if (printableUID.picc_type != "FeliCa") {
-        switch (uid.sak) {
-            case PICC_TYPE_MIFARE_MINI:
-            case PICC_TYPE_MIFARE_1K:
-            case PICC_TYPE_MIFARE_4K: readStatus = read_mifare_classic_data_blocks(); break;
+    switch (uid.sak) {
+        case PICC_TYPE_MIFARE_MINI:
+        case PICC_TYPE_MIFARE_1K:
+        case PICC_TYPE_MIFARE_4K: readStatus = read_mifare_classic_data_blocks(); break;
 
-            case PICC_TYPE_MIFARE_UL:
-                readStatus = read_mifare_ultralight_data_blocks();
-                if (totalPages == 0) totalPages = dataPages;
-                break;
+        case PICC_TYPE_MIFARE_UL: readStatus = read_mifare_ultralight_data_blocks(); break;
 
-            default: break;
-        }
-    } else {
-        readStatus = read_felica_data();
+        default: break;
     }
 
+    dump.setType(get_tag_type().c_str());
     return readStatus;
 }
 
@@ -324,17 +248,17 @@ int PN532::read_mifare_classic_data_blocks() {
     switch (uid.sak) {
         case PICC_TYPE_MIFARE_MINI:
             no_of_sectors = 5;
-            totalPages = 20; // 320 bytes / 16 bytes per page
+            dump.reset(20, 16); // 320 bytes / 16 bytes per page
             break;
 
         case PICC_TYPE_MIFARE_1K:
             no_of_sectors = 16;
-            totalPages = 64; // 1024 bytes / 16 bytes per page
+            dump.reset(64, 16); // 1024 bytes / 16 bytes per page
             break;
 
         case PICC_TYPE_MIFARE_4K:
             no_of_sectors = 40;
-            totalPages = 256; // 4096 bytes / 16 bytes per page
+            dump.reset(256, 16); // 4096 bytes / 16 bytes per page
             break;
 
         default: // Should not happen. Ignore.
@@ -366,21 +290,16 @@ int PN532::read_mifare_classic_data_sector(byte sector) {
 
     byte buffer[18];
     byte blockAddr;
-    String strPage;
 
     int authStatus = authenticate_mifare_classic(firstBlock);
     if (authStatus != SUCCESS) return authStatus;
 
     for (int8_t blockOffset = 0; blockOffset < no_of_blocks; blockOffset++) {
-        strPage = "";
         blockAddr = firstBlock + blockOffset;
 
         if (!nfc.mifareclassic_ReadDataBlock(blockAddr, buffer)) return FAILURE;
 
-        strPage = hexToStr(buffer, 16);
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
-        dataPages++;
+        dump.setPage(blockAddr, buffer);
     }
 
     return SUCCESS;
@@ -445,163 +364,158 @@ int PN532::authenticate_mifare_classic(byte block) {
     return (successA && successB) ? SUCCESS : TAG_AUTH_ERROR;
 }
 
-int PN532::read_mifare_ultralight_data_blocks() {
-    uint8_t success;
-    byte buffer[18];
-    byte i;
-    String strPage = "";
+bool PN532::ultralight_get_version(uint8_t version[8]) {
+    // inDataExchange talks to the target listed by inListPassiveTarget
+    if (!nfc.inListPassiveTarget()) return false;
 
+    uint8_t cmd[1] = {ULTRALIGHT_GET_VERSION};
+    uint8_t response[16];
+    uint8_t len = sizeof(response);
+    if (!nfc.inDataExchange(cmd, sizeof(cmd), response, &len) || len != 8) return false;
+
+    memcpy(version, response, 8);
+    return true;
+}
+
+bool PN532::ultralight_fast_read(uint8_t startPage, uint8_t endPage, uint8_t *buffer) {
+    uint8_t cmd[3] = {ULTRALIGHT_FAST_READ, startPage, endPage};
+    uint8_t len = (endPage - startPage + 1) * 4;
+    uint8_t expected = len;
+    return nfc.inDataExchange(cmd, sizeof(cmd), buffer, &len) && len == expected;
+}
+
+int PN532::ultralight_total_pages(bool *fastRead) {
+    uint8_t version[8];
+    *fastRead = false;
+
+    if (ultralight_get_version(version)) {
+        *fastRead = true;
+        // Storage size byte
+        switch (version[6]) {
+            // MIFARE UL EV1
+            case 0x0B: return 20;
+            case 0x0E: return 41;
+            // NTAG213
+            case 0x0F: return 45;
+            // NTAG215
+            case 0x11: return 135;
+            // NTAG216
+            case 0x13: return 231;
+            default: break;
+        }
+    } else {
+        // Plain Ultralight answers GET_VERSION with a NAK and goes idle, select it again
+        if (!nfc.startPassiveTargetIDDetection() || !nfc.readDetectedPassiveTargetID()) return 0;
+    }
+
+    // Capability container
     uint8_t buf[4];
-    nfc.mifareultralight_ReadPage(3, buf);
+    if (!nfc.mifareultralight_ReadPage(3, buf)) return 0;
     switch (buf[2]) {
         // NTAG213
-        case 0x12: totalPages = 45; break;
+        case 0x12: return 45;
         // NTAG215
-        case 0x3E: totalPages = 135; break;
+        case 0x3E: return 135;
         // NTAG216
-        case 0x6D: totalPages = 231; break;
+        case 0x6D: return 231;
         // MIFARE UL
-        default: totalPages = 64; break;
+        default: return 64;
     }
+}
 
-    for (byte page = 0; page < totalPages; page += 4) {
-        success = nfc.ntag2xx_ReadPage(page, buffer);
+int PN532::read_mifare_ultralight_data_blocks() {
+    bool fastRead;
+    byte buffer[PN532_FAST_READ_PAGES * 4];
+
+    int pages = ultralight_total_pages(&fastRead);
+    if (pages == 0) return FAILURE;
+    dump.reset(pages, 4);
+
+    // READ returns 4 pages per command, FAST_READ a whole range
+    for (int page = 0; page < pages;) {
+        int count = min(pages - page, fastRead ? PN532_FAST_READ_PAGES : 4);
+        bool success = fastRead ? ultralight_fast_read(page, page + count - 1, buffer)
+                                : nfc.ntag2xx_ReadPage(page, buffer);
         if (!success) return FAILURE;
 
-        for (byte offset = 0; offset < 4; offset++) {
-            strPage = "";
-            for (byte index = 0; index < 4; index++) {
-                i = 4 * offset + index;
-                strPage += buffer[i] < 0x10 ? F(" 0") : F(" ");
-                strPage += String(buffer[i], HEX);
-            }
-            strPage.trim();
-            strPage.toUpperCase();
-
-            strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
-            dataPages++;
-            if (dataPages >= totalPages) break;
-        }
+        for (int offset = 0; offset < count; offset++) dump.setPage(page + offset, buffer + 4 * offset);
+        page += count;
     }
 
     return SUCCESS;
 }
 
 int PN532::read_felica_data() {
-    String strPage = "";
-    totalPages = 14;
+    uint16_t default_service_code[1] = {
+        0x000B
+    }; // Default service code for reading. Should works for every card
 
-    for (uint16_t i = 0x8000; i < 0x8000 + totalPages; i++) {
-        uint16_t block_list[1] = {i}; // Read the block i
+    for (uint16_t i = 0; i < dump.totalPages; i++) {
+        uint16_t block_list[1] = {(uint16_t)(0x8000 + i)}; // Read the block i
         uint8_t block_data[1][16] = {0};
-        uint16_t default_service_code[1] = {
-            0x000B
-        }; // Default service code for reading. Should works for every card
         int res = nfc.felica_ReadWithoutEncryption(1, default_service_code, 1, block_list, block_data);
 
-        for (size_t i = 0; i < 16; i++) {
-            if (res) { // If card block read successfully, copy data to string
-                strPage = hexToStr(block_data[0], 16);
-            }
-        }
-        if (res) { // If PN532 can't read the FeliCa tag, don't write the block to file
-            strAllPages += "Block " + String(dataPages++) + ": " + strPage + "\n";
-        }
-        strPage = ""; // Reset for the next block
+        // If PN532 can't read the FeliCa block, it stays unread and is not written to file
+        if (res) dump.setPage(i, block_data[0]);
     }
 
     return SUCCESS;
 }
 
 int PN532::write_data_blocks() {
-    String pageLine = "";
-    String strBytes = "";
-    int lineBreakIndex;
-    int pageIndex;
     bool blockWriteSuccess;
-    int totalSize = strAllPages.length();
+    const int pages = dump.totalPages;
 
-    Serial.println(strAllPages);
-    while (strAllPages.length() > 0) {
-        lineBreakIndex = strAllPages.indexOf("\n");
-        pageLine = strAllPages.substring(0, lineBreakIndex);
-        strAllPages = strAllPages.substring(lineBreakIndex + 1);
+    for (int pageIndex = 1; pageIndex < pages; pageIndex++) {
+        if (!dump.hasPage(pageIndex)) continue;
 
-        pageIndex = pageLine.substring(5, pageLine.indexOf(":")).toInt();
-        strBytes = pageLine.substring(pageLine.indexOf(":") + 1);
-        strBytes.trim();
-
-        if (pageIndex == 0) continue;
-
-        if (printableUID.picc_type != "FeliCa") {
+        if (!dump.felica) {
             switch (uid.sak) {
                 case PICC_TYPE_MIFARE_MINI:
                 case PICC_TYPE_MIFARE_1K:
                 case PICC_TYPE_MIFARE_4K:
-                    if (pageIndex == 0 || (pageIndex + 1) % 4 == 0)
-                        continue; // Data blocks for MIFARE Classic
-                    blockWriteSuccess = write_mifare_classic_data_block(pageIndex, strBytes);
+                    if ((pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
+                    blockWriteSuccess = write_mifare_classic_data_block(pageIndex, dump.page(pageIndex));
                     break;
 
                 case PICC_TYPE_MIFARE_UL:
-                    if (pageIndex < 4 || pageIndex >= dataPages - 5) continue; // Data blocks for NTAG21X
-                    blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, strBytes);
+                    if (pageIndex < 4 || pageIndex >= pages - 5) continue; // Data blocks for NTAG21X
+                    blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, dump.page(pageIndex));
                     break;
 
                 default: blockWriteSuccess = false; break;
             }
         } else {
-            blockWriteSuccess = write_felica_data_block(pageIndex, strBytes);
+            blockWriteSuccess = write_felica_data_block(pageIndex, dump.page(pageIndex));
         }
 
         if (!blockWriteSuccess) return FAILURE;
 
-        progressHandler(totalSize - strAllPages.length(), totalSize, "Writing data blocks...");
+        progressHandler(pageIndex + 1, pages, "Writing data blocks...");
     }
 
     return SUCCESS;
 }
 
-bool PN532::write_mifare_classic_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    if (size != 16) return false;
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool PN532::write_mifare_classic_data_block(int block, const uint8_t *data) {
+    byte buffer[16];
+    memcpy(buffer, data, sizeof(buffer));
 
     if (authenticate_mifare_classic(block) != SUCCESS) return false;
 
     return nfc.mifareclassic_WriteDataBlock(block, buffer);
 }
 
-bool PN532::write_mifare_ultralight_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    if (size != 4) return false;
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool PN532::write_mifare_ultralight_data_block(int block, const uint8_t *data) {
+    byte buffer[4];
+    memcpy(buffer, data, sizeof(buffer));
 
     return nfc.ntag2xx_WritePage(block, buffer);
 }
 
-int PN532::write_felica_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    uint8_t block_data[1][16] = {0};
-
-    if (size != 16) { return false; }
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        block_data[0][i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+int PN532::write_felica_data_block(int block, const uint8_t *data) {
+    uint8_t block_data[1][16];
+    memcpy(block_data[0], data, 16);
 
     uint16_t block_list[1] = {(uint16_t)(block +
                                          0x8000)}; // Write the block i. Block in FeliCa start from 0x8000
@@ -615,6 +529,9 @@ int PN532::write_felica_data_block(int block, String data) {
 
 int PN532::erase_data_blocks() {
     bool blockWriteSuccess;
+    const uint8_t empty[16] = {0};
+    // NDEF stardard
+    const uint8_t emptyNdef[4] = {0x03, 0x00, 0xFE, 0x00};
 
     switch (uid.sak) {
         case PICC_TYPE_MIFARE_MINI:
@@ -622,19 +539,17 @@ int PN532::erase_data_blocks() {
         case PICC_TYPE_MIFARE_4K:
             for (byte i = 1; i < 64; i++) {
                 if ((i + 1) % 4 == 0) continue;
-                blockWriteSuccess =
-                    write_mifare_classic_data_block(i, "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00");
+                blockWriteSuccess = write_mifare_classic_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
 
         case PICC_TYPE_MIFARE_UL:
-            // NDEF stardard
-            blockWriteSuccess = write_mifare_ultralight_data_block(4, "03 00 FE 00");
+            blockWriteSuccess = write_mifare_ultralight_data_block(4, emptyNdef);
             if (!blockWriteSuccess) return FAILURE;
 
             for (byte i = 5; i < 130; i++) {
-                blockWriteSuccess = write_mifare_ultralight_data_block(i, "00 00 00 00");
+                blockWriteSuccess = write_mifare_ultralight_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
@@ -9,6 +9,13 @@
 #include "RFIDInterface.h"
 #include <Adafruit_PN532.h>
 
+#define ULTRALIGHT_GET_VERSION 0x60
+#define ULTRALIGHT_FAST_READ 0x3A
+// Pages per FAST_READ, the answer has to fit the 64 byte packet buffer of the driver
+#ifndef PN532_FAST_READ_PAGES
+#define PN532_FAST_READ_PAGES 12
+#endif
+
 class PN532 : public RFIDInterface {
 public:
     enum CONNECTION_TYPE { I2C = 1, I2C_SPI = 2, SPI = 3 };
@@ -56,10 +63,8 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
     // Converters
     /////////////////////////////////////////////////////////////////////////////////////
-    void format_data();
-    void format_data_felica(uint8_t idm[8], uint8_t pmm[8], uint16_t sys_code);
-    void parse_data();
     void set_uid();
+    void set_uid_felica(uint8_t idm[8], uint8_t pmm[8], uint16_t sys_code);
 
     /////////////////////////////////////////////////////////////////////////////////////
     // PICC Helpers
@@ -69,16 +74,19 @@ private:
     int read_mifare_classic_data_blocks();
     int read_mifare_classic_data_sector(byte sector);
     int authenticate_mifare_classic(byte block);
+    bool ultralight_get_version(uint8_t version[8]);
+    bool ultralight_fast_read(uint8_t startPage, uint8_t endPage, uint8_t *buffer);
+    int ultralight_total_pages(bool *fastRead);
     int read_mifare_ultralight_data_blocks();
 
     int write_data_blocks();
-    bool write_mifare_classic_data_block(int block, String data);
-    bool write_mifare_ultralight_data_block(int block, String data);
+    bool write_mifare_classic_data_block(int block, const uint8_t *data);
+    bool write_mifare_ultralight_data_block(int block, const uint8_t *data);
 
     int read_felica_data();
 
     int erase_data_blocks();
     int write_ndef_blocks();
 
-    int write_felica_data_block(int block, String data);
+    int write_felica_data_block(int block, const uint8_t *data);
 };
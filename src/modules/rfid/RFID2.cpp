@@ -42,14 +42,10 @@ bool RFID2::PICC_IsNewCardPresent() {
     byte result = mfrc522.PICC_RequestA(bufferATQA, &bufferSize);
     bool bl_result =
         (result == MFRC522::StatusCode::STATUS_OK || result == MFRC522::StatusCode::STATUS_COLLISION);
-    if (bl_result) {
-        printableUID.atqa = "";
-        for (byte i = 0; i < bufferSize; i++) {
-            printableUID.atqa += bufferATQA[i] < 0x10 ? " 0" : " ";
-            printableUID.atqa += String(bufferATQA[i], HEX);
-        }
-        printableUID.atqa.trim();
-        printableUID.atqa.toUpperCase();
+    if (bl_result && bufferSize == 2) {
+        // ATQA comes LSB first
+        uid.atqaByte[0] = bufferATQA[1];
+        uid.atqaByte[1] = bufferATQA[0];
     }
     return bl_result;
 }
@@ -59,11 +55,13 @@ int RFID2::read(int cardBaudRate) {
 
     if (!PICC_IsNewCardPresent() || !mfrc522.PICC_ReadCardSerial()) return TAG_NOT_PRESENT;
 
+    set_uid();
     displayInfo("Reading data blocks...");
+    uint32_t readStart = millis();
     pageReadStatus = read_data_blocks();
+    dump.readMs = millis() - readStart;
     pageReadSuccess = pageReadStatus == SUCCESS;
-    format_data();
-    set_uid();
+    format_printable_uid();
     return SUCCESS;
 }
 
@@ -122,29 +120,12 @@ int RFID2::load() {
 
     if (!file) { return FAILURE; }
 
-    String line;
-    String strData;
-    strAllPages = "";
-    pageReadSuccess = true;
-
-    while (file.available()) {
-        line = file.readStringUntil('\n');
-        strData = line.substring(line.indexOf(":") + 1);
-        strData.trim();
-        if (line.startsWith("Device type:")) printableUID.picc_type = strData;
-        if (line.startsWith("UID:")) printableUID.uid = strData;
-        if (line.startsWith("SAK:")) printableUID.sak = strData;
-        if (line.startsWith("ATQA:")) printableUID.atqa = strData;
-        if (line.startsWith("Pages total:")) dataPages = strData.toInt();
-        if (line.startsWith("Pages read:")) pageReadSuccess = false;
-        if (line.startsWith("Page ")) strAllPages += line + "\n";
-    }
+    int status = load_dump(file);
 
     file.close();
     delay(100);
-    parse_data();
 
-    return SUCCESS;
+    return status;
 }
 
 int RFID2::save(String filename) {
@@ -162,21 +143,11 @@ int RFID2::save(String filename) {
 
     if (!file) { return FAILURE; }
 
-    file.println("Filetype: Bruce RFID File");
-    file.println("Version 1");
-    file.println("Device type: " + printableUID.picc_type);
-    file.println("# UID, ATQA and SAK are common for all formats");
-    file.println("UID: " + printableUID.uid);
-    file.println("SAK: " + printableUID.sak);
-    file.println("ATQA: " + printableUID.atqa);
-    file.println("# Memory dump");
-    file.println("Pages total: " + String(dataPages));
-    if (!pageReadSuccess) file.println("Pages read: " + String(dataPages));
-    file.print(strAllPages);
+    int status = save_dump(file);
 
     file.close();
     delay(100);
-    return SUCCESS;
+    return status;
 }
 
 String RFID2::get_tag_type() {
@@ -184,7 +155,7 @@ String RFID2::get_tag_type() {
     String tag_type = mfrc522.PICC_GetTypeName(piccType);
 
     if (piccType == MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL) {
-        switch (totalPages) {
+        switch (dump.totalPages) {
             case 45: tag_type = "NTAG213"; break;
             case 135: tag_type = "NTAG215"; break;
             case 231: tag_type = "NTAG216"; break;
@@ -200,57 +171,13 @@ void RFID2::set_uid() {
     uid.size = mfrc522.uid.size;
 
     for (byte i = 0; i < mfrc522.uid.size; i++) { uid.uidByte[i] = mfrc522.uid.uidByte[i]; }
-}
-
-void RFID2::format_data() {
-    byte bcc = 0;
-
-    printableUID.picc_type = get_tag_type();
-
-    printableUID.sak = mfrc522.uid.sak < 0x10 ? "0" : "";
-    printableUID.sak += String(mfrc522.uid.sak, HEX);
-    printableUID.sak.toUpperCase();
-
-    // UID
-    printableUID.uid = "";
-    for (byte i = 0; i < mfrc522.uid.size; i++) {
-        printableUID.uid += mfrc522.uid.uidByte[i] < 0x10 ? " 0" : " ";
-        printableUID.uid += String(mfrc522.uid.uidByte[i], HEX);
-        bcc = bcc ^ mfrc522.uid.uidByte[i];
-    }
-    printableUID.uid.trim();
-    printableUID.uid.toUpperCase();
-
-    // BCC
-    printableUID.bcc = bcc < 0x10 ? "0" : "";
-    printableUID.bcc += String(bcc, HEX);
-    printableUID.bcc.toUpperCase();
-
-    // ATQA
-    String atqaPart1 = printableUID.atqa.substring(0, 2);
-    String atqaPart2 = printableUID.atqa.substring(3, 5);
-    printableUID.atqa = atqaPart2 + " " + atqaPart1;
-}
-
-void RFID2::parse_data() {
-    String strUID = printableUID.uid;
-    strUID.trim();
-    strUID.replace(" ", "");
-    uid.size = strUID.length() / 2;
-    for (size_t i = 0; i < strUID.length(); i += 2) {
-        uid.uidByte[i / 2] = strtoul(strUID.substring(i, i + 2).c_str(), NULL, 16);
-    }
 
-    printableUID.sak.trim();
-    uid.sak = strtoul(printableUID.sak.c_str(), NULL, 16);
+    dump.reset();
 }
 
 int RFID2::read_data_blocks() {
-    dataPages = 0;
-    totalPages = 0;
     int readStatus = FAILURE;
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
-    strAllPages = "";
 
     switch (piccType) {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
@@ -261,13 +188,12 @@ int RFID2::read_data_blocks() {
 
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL:
             readStatus = read_mifare_ultralight_data_blocks();
-            dataPages = (readStatus == SUCCESS && dataPages > 0) ? dataPages - 1 : dataPages;
-            if (totalPages == 0) totalPages = dataPages;
             break;
 
         default: break;
     }
 
+    dump.setType(get_tag_type().c_str());
     mfrc522.PICC_HaltA();
     return readStatus;
 }
@@ -279,17 +205,17 @@ int RFID2::read_mifare_classic_data_blocks(byte piccType) {
     switch (piccType) {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
             no_of_sectors = 5;
-            totalPages = 20; // 320 bytes / 16 bytes per page
+            dump.reset(20, 16); // 320 bytes / 16 bytes per page
             break;
 
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_1K:
             no_of_sectors = 16;
-            totalPages = 64; // 1024 bytes / 16 bytes per page
+            dump.reset(64, 16); // 1024 bytes / 16 bytes per page
             break;
 
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_4K:
             no_of_sectors = 40;
-            totalPages = 256; // 4096 bytes / 16 bytes per page
+            dump.reset(256, 16); // 4096 bytes / 16 bytes per page
             break;
 
         default: // Should not happen. Ignore.
@@ -325,29 +251,18 @@ int RFID2::read_mifare_classic_data_sector(byte sector) {
     byte byteCount;
     byte buffer[18];
     byte blockAddr;
-    String strPage;
 
     int authStatus = authenticate_mifare_classic(firstBlock);
     if (authStatus != SUCCESS) return authStatus;
 
     for (int8_t blockOffset = 0; blockOffset < no_of_blocks; blockOffset++) {
-        strPage = "";
         blockAddr = firstBlock + blockOffset;
         byteCount = sizeof(buffer);
 
         status = mfrc522.MIFARE_Read(blockAddr, buffer, &byteCount);
         if (status != MFRC522::StatusCode::STATUS_OK) { return FAILURE; }
 
-        for (byte index = 0; index < 16; index++) {
-            strPage += buffer[index] < 0x10 ? F(" 0") : F(" ");
-            strPage += String(buffer[index], HEX);
-        }
-
-        strPage.trim();
-        strPage.toUpperCase();
-
-        strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
-        dataPages++;
+        dump.setPage(blockAddr, buffer);
     }
 
     return SUCCESS;
@@ -421,40 +336,33 @@ int RFID2::read_mifare_ultralight_data_blocks() {
     byte status;
     byte byteCount;
     byte buffer[18];
-    byte i;
-    byte cc;
-    String strPage = "";
+    // Read until the capability container tells the size, or until the tag NACKs
+    int pages = NFC_DUMP_MAX_PAGES;
 
-    for (byte page = 0; page <= 252; page += 4) {
+    dump.reset(0, 4);
+
+    // READ returns 4 pages per command
+    for (int page = 0; page < pages; page += 4) {
         byteCount = sizeof(buffer);
         status = mfrc522.MIFARE_Read(page, buffer, &byteCount);
         if (status != MFRC522::StatusCode::STATUS_OK) {
             return status == MFRC522::StatusCode::STATUS_MIFARE_NACK ? SUCCESS : FAILURE;
         }
-        for (byte offset = 0; offset < 4; offset++) {
-            strPage = "";
-            if (page + offset == 3) {
-                cc = buffer[4 * offset + 2];
-                switch (cc) {
-                    // NTAG213
-                    case 0x12: totalPages = 45; break;
-                    // NTAG215
-                    case 0x3E: totalPages = 135; break;
-                    // NTAG216
-                    case 0x6D: totalPages = 231; break;
-                    default: break;
-                }
-            }
-            for (byte index = 0; index < 4; index++) {
-                i = 4 * offset + index;
-                strPage += buffer[i] < 0x10 ? F(" 0") : F(" ");
-                strPage += String(buffer[i], HEX);
+        if (page == 0) {
+            // Capability container, byte 2 of page 3
+            switch (buffer[14]) {
+                // NTAG213
+                case 0x12: pages = 45; break;
+                // NTAG215
+                case 0x3E: pages = 135; break;
+                // NTAG216
+                case 0x6D: pages = 231; break;
+                default: break;
             }
-            strPage.trim();
-            strPage.toUpperCase();
-
-            strAllPages += "Page " + String(dataPages) + ": " + strPage + "\n";
-            dataPages++;
+            if (pages < NFC_DUMP_MAX_PAGES) dump.totalPages = pages;
+        }
+        for (int offset = 0; offset < 4 && page + offset < pages; offset++) {
+            dump.setPage(page + offset, buffer + 4 * offset);
         }
     }
 
@@ -463,35 +371,23 @@ int RFID2::read_mifare_ultralight_data_blocks() {
 
 int RFID2::write_data_blocks() {
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
-    String pageLine = "";
-    String strBytes = "";
-    int lineBreakIndex;
-    int pageIndex;
     bool blockWriteSuccess;
-    int totalSize = strAllPages.length();
-
-    while (strAllPages.length() > 0) {
-        lineBreakIndex = strAllPages.indexOf("\n");
-        pageLine = strAllPages.substring(0, lineBreakIndex);
-        strAllPages = strAllPages.substring(lineBreakIndex + 1);
+    const int pages = dump.totalPages;
 
-        pageIndex = pageLine.substring(5, pageLine.indexOf(":")).toInt();
-        strBytes = pageLine.substring(pageLine.indexOf(":") + 1);
-        strBytes.trim();
-
-        if (pageIndex == 0) continue;
+    for (int pageIndex = 1; pageIndex < pages; pageIndex++) {
+        if (!dump.hasPage(pageIndex)) continue;
 
         switch (piccType) {
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_1K:
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_4K:
-                if (pageIndex == 0 || (pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
-                blockWriteSuccess = write_mifare_classic_data_block(pageIndex, strBytes);
+                if ((pageIndex + 1) % 4 == 0) continue; // Data blocks for MIFARE Classic
+                blockWriteSuccess = write_mifare_classic_data_block(pageIndex, dump.page(pageIndex));
                 break;
 
             case MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL:
-                if (pageIndex < 4 || pageIndex >= dataPages - 5) continue; // Data blocks for NTAG21X
-                blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, strBytes);
+                if (pageIndex < 4 || pageIndex >= pages - 5) continue; // Data blocks for NTAG21X
+                blockWriteSuccess = write_mifare_ultralight_data_block(pageIndex, dump.page(pageIndex));
                 break;
 
             default: blockWriteSuccess = false; break;
@@ -499,39 +395,29 @@ int RFID2::write_data_blocks() {
 
         if (!blockWriteSuccess) return FAILURE;
 
-        progressHandler(totalSize - strAllPages.length(), totalSize, "Writing data blocks...");
+        progressHandler(pageIndex + 1, pages, "Writing data blocks...");
     }
 
     return SUCCESS;
 }
 
-bool RFID2::write_mifare_classic_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool RFID2::write_mifare_classic_data_block(int block, const uint8_t *data) {
+    byte buffer[16];
+    memcpy(buffer, data, sizeof(buffer));
 
     if (authenticate_mifare_classic(block) != SUCCESS) return false;
 
-    byte status = mfrc522.MIFARE_Write((byte)block, buffer, size);
+    byte status = mfrc522.MIFARE_Write((byte)block, buffer, sizeof(buffer));
     if (status != MFRC522::StatusCode::STATUS_OK) return false;
 
     return true;
 }
 
-bool RFID2::write_mifare_ultralight_data_block(int block, String data) {
-    data.replace(" ", "");
-    byte size = data.length() / 2;
-    byte buffer[size];
-
-    for (size_t i = 0; i < data.length(); i += 2) {
-        buffer[i / 2] = strtoul(data.substring(i, i + 2).c_str(), NULL, 16);
-    }
+bool RFID2::write_mifare_ultralight_data_block(int block, const uint8_t *data) {
+    byte buffer[4];
+    memcpy(buffer, data, sizeof(buffer));
 
-    byte status = mfrc522.MIFARE_Ultralight_Write((byte)block, buffer, size);
+    byte status = mfrc522.MIFARE_Ultralight_Write((byte)block, buffer, sizeof(buffer));
     if (status != MFRC522::StatusCode::STATUS_OK) return false;
 
     return true;
@@ -540,6 +426,9 @@ bool RFID2::write_mifare_ultralight_data_block(int block, String data) {
 int RFID2::erase_data_blocks() {
     byte piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
     bool blockWriteSuccess;
+    const uint8_t empty[16] = {0};
+    // NDEF stardard
+    const uint8_t emptyNdef[4] = {0x03, 0x00, 0xFE, 0x00};
 
     switch (piccType) {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_MINI:
@@ -547,19 +436,17 @@ int RFID2::erase_data_blocks() {
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_4K:
             for (byte i = 1; i < 64; i++) {
                 if ((i + 1) % 4 == 0) continue;
-                blockWriteSuccess =
-                    write_mifare_classic_data_block(i, "00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00");
+                blockWriteSuccess = write_mifare_classic_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
 
         case MFRC522::PICC_Type::PICC_TYPE_MIFARE_UL:
-            // NDEF stardard
-            blockWriteSuccess = write_mifare_ultralight_data_block(4, "03 00 FE 00");
+            blockWriteSuccess = write_mifare_ultralight_data_block(4, emptyNdef);
             if (!blockWriteSuccess) return FAILURE;
 
             for (byte i = 5; i < 130; i++) {
-                blockWriteSuccess = write_mifare_ultralight_data_block(i, "00 00 00 00");
+                blockWriteSuccess = write_mifare_ultralight_data_block(i, empty);
                 if (!blockWriteSuccess) return FAILURE;
             }
             break;
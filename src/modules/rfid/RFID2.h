@@ -45,8 +45,6 @@ private:
     /////////////////////////////////////////////////////////////////////////////////////
     // Converters
     /////////////////////////////////////////////////////////////////////////////////////
-    void format_data();
-    void parse_data();
     void set_uid();
 
     /////////////////////////////////////////////////////////////////////////////////////
@@ -62,8 +60,8 @@ private:
     int read_mifare_ultralight_data_blocks();
 
     int write_data_blocks();
-    bool write_mifare_classic_data_block(int block, String data);
-    bool write_mifare_ultralight_data_block(int block, String data);
+    bool write_mifare_classic_data_block(int block, const uint8_t *data);
+    bool write_mifare_ultralight_data_block(int block, const uint8_t *data);
 
     int erase_data_blocks();
     int write_ndef_blocks();
@@ -9,16 +9,12 @@
 #ifndef __RFID_INTERFACE_H__
 #define __RFID_INTERFACE_H__
 
+#include "nfc_dump.h"
 #include <globals.h>
 
 class RFIDInterface {
 public:
-    typedef struct {
-        byte size;
-        byte uidByte[10];
-        byte sak;
-        byte atqaByte[2];
-    } Uid;
+    typedef NfcUid Uid;
 
     typedef struct {
         String uid;
@@ -71,9 +67,7 @@ public:
     Uid uid;
     PrintableUID printableUID;
     NdefMessage ndefMessage;
-    String strAllPages = "";
-    int totalPages = 0;
-    int dataPages = 0;
+    NfcDump dump;
     bool pageReadSuccess = false;
     int pageReadStatus = FAILURE;
 
@@ -95,6 +89,58 @@ public:
     virtual int load() = 0;
     virtual int save(String filename) = 0;
 
+    /////////////////////////////////////////////////////////////////////////////////////
+    // Dump files
+    /////////////////////////////////////////////////////////////////////////////////////
+    // Parses a .rfid/.nfc file into uid and dump, line by line
+    int load_dump(File &file) {
+        NfcDumpParser parser(uid, dump);
+        char line[NFC_DUMP_LINE_SIZE];
+        while (file.available()) {
+            size_t len = file.readBytesUntil('\n', line, sizeof(line) - 1);
+            line[len] = '\0';
+            parser.line(line);
+        }
+        if (!parser.finish()) return FAILURE;
+        pageReadSuccess = dump.complete();
+        format_printable_uid();
+        return SUCCESS;
+    }
+
+    int save_dump(File &file) {
+        NfcDumpWriter writer(uid, dump);
+        char line[NFC_DUMP_LINE_SIZE];
+        while (writer.next(line, sizeof(line) - 2)) {
+            size_t len = strlen(line);
+            line[len++] = '\n';
+            if (file.write((const uint8_t *)line, len) != len) return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+    // printableUID from uid and dump
+    void format_printable_uid() {
+        char hex[NFC_DUMP_LINE_SIZE];
+        printableUID.picc_type = dump.type;
+        nfcBytesToHex(uid.uidByte, uid.size, hex, sizeof(hex));
+        printableUID.uid = hex;
+        if (dump.felica) {
+            // Reuse uid-sak-atqa to save memory
+            nfcBytesToHex(dump.pmm, sizeof(dump.pmm), hex, sizeof(hex));
+            printableUID.sak = hex;
+            printableUID.atqa = String(dump.systemCode, HEX);
+            return;
+        }
+        byte bcc = 0;
+        for (byte i = 0; i < uid.size; i++) bcc ^= uid.uidByte[i];
+        nfcBytesToHex(&bcc, 1, hex, sizeof(hex));
+        printableUID.bcc = hex;
+        nfcBytesToHex(&uid.sak, 1, hex, sizeof(hex));
+        printableUID.sak = hex;
+        nfcBytesToHex(uid.atqaByte, 2, hex, sizeof(hex));
+        printableUID.atqa = hex;
+    }
+
     String statusMessage(int status) const {
         switch (status) {
             case SUCCESS: return String(F("Success"));
@@ -0,0 +1,206 @@
+/**
+ * @file nfc_dump.cpp
+ * @brief Binary image of an HF tag and its .rfid/.nfc text format
+ */
+
+#include "nfc_dump.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/////////////////////////////////////////////////////////////////////////////////////
+// NfcDump
+/////////////////////////////////////////////////////////////////////////////////////
+
+void NfcDump::reset(uint16_t pages, uint8_t bytesPerPage) {
+    type[0] = '\0';
+    felica = false;
+    memset(pmm, 0, sizeof(pmm));
+    systemCode = 0;
+    readMs = 0;
+    pageSize = bytesPerPage;
+    totalPages = pages > NFC_DUMP_MAX_PAGES ? NFC_DUMP_MAX_PAGES : pages;
+    memset(status, NFC_PAGE_UNREAD, sizeof(status));
+}
+
+void NfcDump::setType(const char *name) {
+    size_t len = strlen(name);
+    if (len >= sizeof(type)) len = sizeof(type) - 1;
+    memcpy(type, name, len);
+    type[len] = '\0';
+}
+
+bool NfcDump::setPage(uint16_t index, const uint8_t *bytes) {
+    if (!pageSize || index >= NFC_DUMP_MAX_PAGES || (index + 1) * pageSize > NFC_DUMP_MAX_BYTES) return false;
+    memcpy(page(index), bytes, pageSize);
+    status[index] = NFC_PAGE_READ;
+    if (index >= totalPages) totalPages = index + 1;
+    return true;
+}
+
+uint16_t NfcDump::pagesRead() const {
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < totalPages; i++) count += status[i] == NFC_PAGE_READ;
+    return count;
+}
+
+bool NfcDump::sameData(const NfcDump &other) const {
+    if (pageSize != other.pageSize || totalPages != other.totalPages) return false;
+    for (uint16_t i = 0; i < totalPages; i++) {
+        if (status[i] != other.status[i]) return false;
+        if (status[i] == NFC_PAGE_READ && memcmp(page(i), other.page(i), pageSize) != 0) return false;
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Hex helpers
+/////////////////////////////////////////////////////////////////////////////////////
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+int nfcHexToBytes(const char *text, uint8_t *out, size_t max) {
+    size_t count = 0;
+    while (*text) {
+        if (*text == ' ' || *text == '\t' || *text == '\r' || *text == '\n') {
+            text++;
+            continue;
+        }
+        const int hi = hexDigit(text[0]);
+        const int lo = hi < 0 ? -1 : hexDigit(text[1]);
+        if (lo < 0 || count >= max) return -1;
+        out[count++] = (hi << 4) | lo;
+        text += 2;
+    }
+    return count;
+}
+
+void nfcBytesToHex(const uint8_t *bytes, size_t len, char *out, size_t size) {
+    static const char digits[] = "0123456789ABCDEF";
+    size_t pos = 0;
+    for (size_t i = 0; i < len && pos + 3 < size; i++) {
+        if (i) out[pos++] = ' ';
+        out[pos++] = digits[bytes[i] >> 4];
+        out[pos++] = digits[bytes[i] & 0x0F];
+    }
+    if (size) out[pos] = '\0';
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// NfcDumpWriter
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool NfcDumpWriter::next(char *line, size_t size) {
+    char hex[NFC_DUMP_LINE_SIZE];
+    // Header lines, steps that have nothing to say for this tag fall through to the next
+    while (_step < 10) {
+        switch (_step++) {
+            case 0: snprintf(line, size, "Filetype: Bruce RFID File"); return true;
+            case 1: snprintf(line, size, "Version 1"); return true;
+            case 2: snprintf(line, size, "Device type: %s", _dump.type); return true;
+            case 3: snprintf(line, size, "# UID, ATQA and SAK are common for all formats"); return true;
+            case 4:
+                nfcBytesToHex(_uid.uidByte, _uid.size, hex, sizeof(hex));
+                snprintf(line, size, "UID: %s", hex);
+                return true;
+            case 5:
+                if (_dump.felica) {
+                    nfcBytesToHex(_dump.pmm, sizeof(_dump.pmm), hex, sizeof(hex));
+                    snprintf(line, size, "Manufacture id: %s", hex);
+                } else {
+                    snprintf(line, size, "SAK: %02X", _uid.sak);
+                }
+                return true;
+            case 6:
+                if (_dump.felica) snprintf(line, size, "Blocks total: %u", _dump.totalPages);
+                else snprintf(line, size, "ATQA: %02X %02X", _uid.atqaByte[0], _uid.atqaByte[1]);
+                return true;
+            case 7:
+                if (_dump.felica) snprintf(line, size, "Blocks read: %u", _dump.pagesRead());
+                else snprintf(line, size, "# Memory dump");
+                return true;
+            case 8:
+                if (_dump.felica) break;
+                snprintf(line, size, "Pages total: %u", _dump.totalPages);
+                return true;
+            case 9:
+                if (_dump.felica || _dump.complete()) break;
+                snprintf(line, size, "Pages read: %u", _dump.pagesRead());
+                return true;
+        }
+    }
+    while (_page < _dump.totalPages && !_dump.hasPage(_page)) _page++;
+    if (_page >= _dump.totalPages) return false;
+    nfcBytesToHex(_dump.page(_page), _dump.pageSize, hex, sizeof(hex));
+    snprintf(line, size, "%s %u: %s", _dump.felica ? "Block" : "Page", _page, hex);
+    _page++;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// NfcDumpParser
+/////////////////////////////////////////////////////////////////////////////////////
+
+NfcDumpParser::NfcDumpParser(NfcUid &uid, NfcDump &dump) : _uid(uid), _dump(dump) {
+    memset(&_uid, 0, sizeof(_uid));
+    _dump.reset();
+}
+
+// Value of "key: value" when line starts with key, nullptr otherwise
+static const char *valueOf(const char *line, const char *key) {
+    const size_t len = strlen(key);
+    if (strncmp(line, key, len) != 0 || line[len] != ':') return nullptr;
+    line += len + 1;
+    while (*line == ' ') line++;
+    return line;
+}
+
+void NfcDumpParser::line(const char *text) {
+    const char *value;
+    uint8_t bytes[16];
+    int n;
+
+    if ((value = valueOf(text, "Device type"))) {
+        char name[sizeof(_dump.type)];
+        size_t len = strcspn(value, "\r\n");
+        if (len >= sizeof(name)) len = sizeof(name) - 1;
+        memcpy(name, value, len);
+        name[len] = '\0';
+        _dump.setType(name);
+        _dump.felica = strcmp(_dump.type, "FeliCa") == 0;
+    } else if ((value = valueOf(text, "UID"))) {
+        n = nfcHexToBytes(value, _uid.uidByte, sizeof(_uid.uidByte));
+        if (n > 0) {
+            _uid.size = n;
+            _hasUid = true;
+        }
+    } else if ((value = valueOf(text, "SAK"))) {
+        if (nfcHexToBytes(value, bytes, 1) == 1) _uid.sak = bytes[0];
+    } else if ((value = valueOf(text, "ATQA"))) {
+        if (nfcHexToBytes(value, bytes, 2) == 2) memcpy(_uid.atqaByte, bytes, 2);
+    } else if ((value = valueOf(text, "Manufacture id"))) {
+        if (nfcHexToBytes(value, bytes, sizeof(_dump.pmm)) == sizeof(_dump.pmm))
+            memcpy(_dump.pmm, bytes, sizeof(_dump.pmm));
+    } else if ((value = valueOf(text, "Pages total")) || (value = valueOf(text, "Blocks total"))) {
+        _declaredPages = atoi(value);
+    } else if (!strncmp(text, "Page ", 5) || !strncmp(text, "Block ", 6)) {
+        char *end;
+        long index = strtol(strchr(text, ' ') + 1, &end, 10);
+        if (end == text || *end != ':' || index < 0 || index >= NFC_DUMP_MAX_PAGES) return;
+        n = nfcHexToBytes(end + 1, bytes, sizeof(bytes));
+        if (n != 4 && n != 16) return; // "??" bytes, the page stays unread
+        if (!_dump.pageSize) _dump.pageSize = n;
+        if (n == _dump.pageSize) _dump.setPage(index, bytes);
+    }
+}
+
+bool NfcDumpParser::finish() {
+    if (_declaredPages > _dump.totalPages)
+        _dump.totalPages = _declaredPages > NFC_DUMP_MAX_PAGES ? NFC_DUMP_MAX_PAGES : _declaredPages;
+    return _hasUid;
+}
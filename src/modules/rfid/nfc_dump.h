@@ -0,0 +1,123 @@
+/**
+ * @file nfc_dump.h
+ * @brief Binary image of an HF tag and its .rfid/.nfc text format
+ *
+ * The RFID backends read into an NfcDump and write from it. The text
+ * format is generated and parsed one line at a time, so a dump never
+ * exists as one big String. No Arduino dependencies, builds on the host.
+ */
+
+#ifndef __NFC_DUMP_H__
+#define __NFC_DUMP_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+// MIFARE Classic 4K: 256 blocks of 16 bytes. NTAG216 has 231 pages of 4
+#define NFC_DUMP_MAX_PAGES 256
+#define NFC_DUMP_MAX_BYTES 4096
+// Longest line of the text format, a 16 byte page is about 60
+#define NFC_DUMP_LINE_SIZE 96
+
+struct NfcUid {
+    uint8_t size;
+    uint8_t uidByte[10];
+    uint8_t sak;
+    uint8_t atqaByte[2]; // as printed, atqaByte[0] is the high byte
+};
+
+enum NfcPageStatus : uint8_t {
+    NFC_PAGE_UNREAD = 0,
+    NFC_PAGE_READ = 1,
+};
+
+/*********************************************************************
+**  Struct: NfcDump
+**  Tag type, memory layout and a copy of every page that was read.
+**  Pages are 4 bytes on Ultralight/NTAG, 16 on MIFARE Classic and
+**  FeliCa. FeliCa keeps its IDm in the NfcUid, PMm and system code
+**  here.
+**********************************************************************/
+struct NfcDump {
+    char type[40] = "";      // "NTAG215", "MIFARE 1KB", "FeliCa"...
+    bool felica = false;
+    uint8_t pmm[8] = {};
+    uint16_t systemCode = 0;
+    uint8_t pageSize = 0;    // bytes per page
+    uint16_t totalPages = 0; // pages on the tag, read or not
+    uint32_t readMs = 0;     // time the last read took
+    uint8_t data[NFC_DUMP_MAX_BYTES];
+    uint8_t status[NFC_DUMP_MAX_PAGES];
+
+    // Empties the image for a tag of pages pages of pageSize bytes
+    void reset(uint16_t pages = 0, uint8_t bytesPerPage = 0);
+    // Copies the type name, cut to fit
+    void setType(const char *name);
+    uint8_t *page(uint16_t index) { return data + index * pageSize; }
+    const uint8_t *page(uint16_t index) const { return data + index * pageSize; }
+    bool hasPage(uint16_t index) const { return index < totalPages && status[index] == NFC_PAGE_READ; }
+    // Stores a page, grows totalPages when needed. False when it does not fit
+    bool setPage(uint16_t index, const uint8_t *bytes);
+    uint16_t pagesRead() const;
+    bool complete() const { return totalPages && pagesRead() == totalPages; }
+    // Same layout, same pages read, same content
+    bool sameData(const NfcDump &other) const;
+};
+
+/*********************************************************************
+**  Class: NfcDumpWriter
+**  Produces the text format one line at a time:
+**    Filetype, Version, Device type, UID, SAK, ATQA (FeliCa:
+**    Manufacture id), Pages total, Pages read when incomplete, then
+**    "Page N: XX XX .." (FeliCa: "Block N:") for every page read.
+**********************************************************************/
+class NfcDumpWriter {
+public:
+    NfcDumpWriter(const NfcUid &uid, const NfcDump &dump) : _uid(uid), _dump(dump) {}
+
+    // Next line without the line break, false when done
+    bool next(char *line, size_t size);
+
+private:
+    const NfcUid &_uid;
+    const NfcDump &_dump;
+    uint16_t _step = 0;
+    uint16_t _page = 0;
+};
+
+/*********************************************************************
+**  Class: NfcDumpParser
+**  Reads the text format line by line into a dump. Accepts Bruce
+**  .rfid files and Flipper .nfc files: "Page" and "Block" lines,
+**  and "??" bytes, which leave the page unread.
+**********************************************************************/
+class NfcDumpParser {
+public:
+    NfcDumpParser(NfcUid &uid, NfcDump &dump);
+
+    // One line, with or without its line break
+    void line(const char *text);
+    // True when a UID and at least the layout were found
+    bool finish();
+
+private:
+    NfcUid &_uid;
+    NfcDump &_dump;
+    uint16_t _declaredPages = 0;
+    bool _hasUid = false;
+};
+
+/*********************************************************************
+**  Function: nfcHexToBytes
+**  "04 A1 B2" or "04A1B2" to bytes, returns the count, -1 on "??"
+**  or on anything that is not hex
+**********************************************************************/
+int nfcHexToBytes(const char *text, uint8_t *out, size_t max);
+
+/*********************************************************************
+**  Function: nfcBytesToHex
+**  Bytes to "04 A1 B2"
+**********************************************************************/
+void nfcBytesToHex(const uint8_t *bytes, size_t len, char *out, size_t size);
+
+#endif
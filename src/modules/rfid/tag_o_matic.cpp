@@ -35,6 +35,7 @@ TagOMatic::~TagOMatic() {
         _scanned_set.clear();
         _scanned_tags.clear();
     }
+    delete _sourceDump;
     delete _rfid; // Deallocate memory for _rfid object
 }
 
@@ -114,7 +115,8 @@ void TagOMatic::set_state(RFID_State state) {
         _scanned_tags.clear();
     }
     _sourceUID = "";
-    _sourcePages = "";
+    delete _sourceDump;
+    _sourceDump = nullptr;
 
     switch (state) {
         case READ_MODE:
@@ -125,7 +127,7 @@ void TagOMatic::set_state(RFID_State state) {
             break;
         case CHECK_MODE:
             _sourceUID = _rfid->printableUID.uid;
-            _sourcePages = _rfid->strAllPages;
+            _sourceDump = new NfcDump(_rfid->dump);
             padprintln("Source UID: " + _sourceUID);
             padprintln("");
             break;
@@ -136,7 +138,7 @@ void TagOMatic::set_state(RFID_State state) {
             break;
         case WRITE_MODE:
             if (!_rfid->pageReadSuccess) padprintln("[!] Data blocks are incomplete");
-            padprintln(String(_rfid->dataPages) + " pages of data to write");
+            padprintln(String(_rfid->dump.pagesRead()) + " pages of data to write");
             padprintln("");
             break;
         case WRITE_NDEF_MODE: _ndef_created = false; break;
@@ -184,6 +186,7 @@ void TagOMatic::dump_card_details() {
     }
     if (_rfid->pageReadStatus != RFIDInterface::SUCCESS)
         padprintln("[!] " + _rfid->statusMessage(_rfid->pageReadStatus));
+    else if (_rfid->dump.readMs) padprintln("Read time: " + String(_rfid->dump.readMs) + " ms");
 }
 
 void TagOMatic::dump_check_details() {
@@ -191,7 +194,8 @@ void TagOMatic::dump_check_details() {
     padprintln("");
 
     padprintln("UID: " + String(_sourceUID == _rfid->printableUID.uid ? "OK" : "NOT OK"));
-    padprintln("Data: " + String(_sourcePages == _rfid->strAllPages ? "OK" : "NOT OK"));
+    bool sameData = _sourceDump && _sourceDump->sameData(_rfid->dump);
+    padprintln("Data: " + String(sameData ? "OK" : "NOT OK"));
     padprintln("");
 
     if (_rfid->pageReadStatus != RFIDInterface::SUCCESS)
@@ -231,6 +235,12 @@ void TagOMatic::read_card() {
 
     Serial.print("Tag read status: ");
     Serial.println(_rfid->statusMessage(_rfid->pageReadStatus));
+    Serial.printf(
+        "%u/%u pages read in %lu ms\n",
+        _rfid->dump.pagesRead(),
+        _rfid->dump.totalPages,
+        (unsigned long)_rfid->dump.readMs
+    );
 
     display_banner();
     dump_card_details();
@@ -51,7 +51,7 @@ private:
     std::set<String> _scanned_set;
     std::vector<String> _scanned_tags;
     String _sourceUID;
-    String _sourcePages;
+    NfcDump *_sourceDump = nullptr; // copy of the dump being checked, ~4 KB
 
     /////////////////////////////////////////////////////////////////////////////////////
     // Display functions
@@ -272,7 +272,7 @@ void ssh_loop(void *pvParameters) {
             for (int i = 0; i < nbytes; ++i) {
                 msg += char(buffer[i]);
                 if (buffer[i] == '\r') continue; // Ignore carriage return
-                tft.write(buffer[i]);
+                tft.print((char)buffer[i]);
                 if (tft.getCursorY() > tftHeight) {
                     tft.fillScreen(bruceConfig.bgColor);
                     tft.setCursor(0, 0);
@@ -0,0 +1,300 @@
+#include "pcap_writer.h"
+#include <algorithm>
+#include <esp_heap_caps.h>
+
+#define PCAP_LINKTYPE_IEEE802_11 105
+
+struct PcapFileHeader {
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t network;
+};
+
+struct PcapRecordHeader {
+    uint32_t tsSec;
+    uint32_t tsUsec;
+    uint32_t inclLen;
+    uint32_t origLen;
+};
+
+bool PcapWriter::begin(FS &fs, const String &prefix, const PcapRotation &rotation) {
+    end();
+    _fs = &fs;
+    _prefix = prefix;
+    _rotation = rotation;
+
+    uint32_t ringSize = PCAP_WRITER_RING_SRAM;
+    if (psramFound()) {
+        _ring = (uint8_t *)ps_malloc(PCAP_WRITER_RING_PSRAM);
+        if (_ring) ringSize = PCAP_WRITER_RING_PSRAM;
+    }
+    if (!_ring) _ring = (uint8_t *)malloc(PCAP_WRITER_RING_SRAM);
+    // SD and flash drivers bounce PSRAM buffers, keep the block in internal RAM
+    _block = (uint8_t *)heap_caps_malloc(PCAP_WRITER_BLOCK, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!_ring || !_block) {
+        log_e("pcap: out of memory for the capture buffers");
+        end();
+        return false;
+    }
+    _ringMask = ringSize - 1;
+    _ringSize = ringSize;
+    _head = 0;
+    _tail = 0;
+    _recordLeft = 0;
+    _blockFill = 0;
+    _rotateRequest = false;
+    resetStats();
+    _files = 0;
+
+    _index = 0;
+    while (_fs->exists(_prefix + String(_index) + ".pcap")) _index++;
+    _firstIndex = _index;
+    if (!openNext()) {
+        end();
+        return false;
+    }
+
+    _running = true;
+#if SOC_CPU_CORES_NUM > 1
+    BaseType_t res = xTaskCreatePinnedToCore(taskFunc, "pcap_writer", 4096, this, 4, &_task, 1);
+#else
+    BaseType_t res = xTaskCreate(taskFunc, "pcap_writer", 4096, this, 4, &_task);
+#endif
+    if (res != pdPASS) {
+        _running = false;
+        _task = NULL;
+        end();
+        return false;
+    }
+    return true;
+}
+
+void PcapWriter::end() {
+    _running = false;
+    // a push() that saw _running may still be copying in the ring
+    while (_pushing) taskYIELD();
+    if (_task) {
+        xTaskNotifyGive(_task);
+        while (_task) vTaskDelay(pdMS_TO_TICKS(10));
+    } else {
+        closeFile();
+    }
+    free(_ring);
+    heap_caps_free(_block);
+    _ring = nullptr;
+    _block = nullptr;
+}
+
+bool PcapWriter::push(uint32_t tsSec, uint32_t tsUsec, const uint8_t *data, uint32_t len) {
+    _pushing = true;
+    if (!_running) {
+        _pushing = false;
+        return false;
+    }
+    PcapRecordHeader header;
+    header.tsSec = tsSec;
+    header.tsUsec = tsUsec;
+    header.inclLen = std::min<uint32_t>(len, PCAP_SNAPLEN);
+    header.origLen = len;
+    const uint32_t need = sizeof(header) + header.inclLen;
+
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t used = head - _tail.load(std::memory_order_acquire);
+    if (used + need > _ringMask + 1) {
+        _drops++;
+        _pushing = false;
+        return false;
+    }
+    copyToRing(head, &header, sizeof(header));
+    copyToRing(head + sizeof(header), data, header.inclLen);
+    _head.store(head + need, std::memory_order_release);
+    _frames++;
+
+    used += need;
+    if (used > _ringPeak) _ringPeak = used;
+    // wake the writer when a block is ready, it polls for the rest
+    if (used >= PCAP_WRITER_BLOCK && used - need < PCAP_WRITER_BLOCK && _task) xTaskNotifyGive(_task);
+    _pushing = false;
+    return true;
+}
+
+void PcapWriter::rotate() {
+    _rotateRequest = true;
+    if (_task) xTaskNotifyGive(_task);
+}
+
+String PcapWriter::path() {
+    char path[sizeof(_path)];
+    portENTER_CRITICAL(&_statsMux);
+    memcpy(path, _path, sizeof(path));
+    portEXIT_CRITICAL(&_statsMux);
+    return String(path);
+}
+
+PcapWriterStats PcapWriter::stats() {
+    PcapWriterStats s;
+    portENTER_CRITICAL(&_statsMux);
+    s.frames = _frames;
+    s.drops = _drops;
+    s.bytes = _bytes;
+    s.bytesPerSec = _bytesPerSec;
+    s.framesPerSec = _framesPerSec;
+    s.ringSize = _ringSize;
+    s.ringPeak = _ringPeak;
+    s.files = _files;
+    s.writeErrors = _writeErrors;
+    portEXIT_CRITICAL(&_statsMux);
+    return s;
+}
+
+void PcapWriter::resetStats() {
+    portENTER_CRITICAL(&_statsMux);
+    _frames = 0;
+    _drops = 0;
+    _bytes = 0;
+    _bytesPerSec = 0;
+    _framesPerSec = 0;
+    _ringPeak = 0;
+    _writeErrors = 0;
+    portEXIT_CRITICAL(&_statsMux);
+}
+
+bool PcapWriter::openNext() {
+    closeFile();
+    String path = _prefix + String(_index) + ".pcap";
+    while (_fs->exists(path)) path = _prefix + String(++_index) + ".pcap";
+    _file = _fs->open(path, FILE_WRITE);
+    if (!_file) {
+        log_e("pcap: cannot open %s", path.c_str());
+        return false;
+    }
+    portENTER_CRITICAL(&_statsMux);
+    strncpy(_path, path.c_str(), sizeof(_path) - 1);
+    _files++;
+    portEXIT_CRITICAL(&_statsMux);
+
+    // The global header starts the first block, so it costs no write of its own
+    PcapFileHeader header = {0xa1b2c3d4, 2, 4, 0, 0, PCAP_SNAPLEN, PCAP_LINKTYPE_IEEE802_11};
+    memcpy(_block, &header, sizeof(header));
+    _blockFill = sizeof(header);
+    _fileBytes = 0;
+    _fileOpened = millis();
+    _lastWrite = _fileOpened;
+
+    if (_rotation.keepFiles && _index - _rotation.keepFiles >= _firstIndex) {
+        String old = _prefix + String(_index - _rotation.keepFiles) + ".pcap";
+        if (_fs->exists(old)) _fs->remove(old);
+    }
+    _index++;
+    return true;
+}
+
+void PcapWriter::closeFile() {
+    if (!_file) return;
+    writeBlock();
+    _file.close();
+}
+
+void PcapWriter::copyToRing(uint32_t pos, const void *src, uint32_t len) {
+    uint32_t at = pos & _ringMask;
+    uint32_t first = std::min(len, _ringMask + 1 - at);
+    memcpy(_ring + at, src, first);
+    memcpy(_ring, (const uint8_t *)src + first, len - first);
+}
+
+void PcapWriter::copyFromRing(uint32_t pos, void *dst, uint32_t len) {
+    uint32_t at = pos & _ringMask;
+    uint32_t first = std::min(len, _ringMask + 1 - at);
+    memcpy(dst, _ring + at, first);
+    memcpy((uint8_t *)dst + first, _ring, len - first);
+}
+
+void PcapWriter::writeBlock() {
+    if (_blockFill == 0) return;
+    size_t n = _file ? _file.write(_block, _blockFill) : 0;
+    portENTER_CRITICAL(&_statsMux);
+    _bytes += n;
+    if (n != _blockFill) _writeErrors++;
+    portEXIT_CRITICAL(&_statsMux);
+    _fileBytes += _blockFill;
+    _blockFill = 0;
+    _lastWrite = millis();
+}
+
+bool PcapWriter::rotationDue(uint32_t now) {
+    if (_rotateRequest) return true;
+    if (_rotation.maxBytes && _fileBytes + _blockFill >= _rotation.maxBytes) return true;
+    return _rotation.maxSeconds && now - _fileOpened >= _rotation.maxSeconds * 1000;
+}
+
+void PcapWriter::drain() {
+    const uint32_t head = _head.load(std::memory_order_acquire);
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    const uint32_t now = millis();
+    while (tail != head) {
+        if (_recordLeft == 0) {
+            // records never straddle two files
+            if (rotationDue(now)) {
+                _rotateRequest = false;
+                openNext();
+            }
+            PcapRecordHeader header;
+            copyFromRing(tail, &header, sizeof(header));
+            _recordLeft = sizeof(header) + header.inclLen;
+        }
+        // after a partial write the block ends early, so the next writes are aligned again
+        uint32_t blockEnd = PCAP_WRITER_BLOCK - _fileBytes % PCAP_WRITER_BLOCK;
+        uint32_t n = std::min(std::min(head - tail, _recordLeft), blockEnd - _blockFill);
+        copyFromRing(tail, _block + _blockFill, n);
+        _blockFill += n;
+        _recordLeft -= n;
+        tail += n;
+        _tail.store(tail, std::memory_order_release);
+        if (_blockFill == blockEnd) writeBlock();
+    }
+}
+
+void PcapWriter::taskFunc(void *param) {
+    PcapWriter *writer = (PcapWriter *)param;
+    uint32_t rateStart = millis();
+    uint64_t rateBytes = 0;
+    uint32_t rateFrames = 0;
+    while (writer->_running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        writer->drain();
+
+        uint32_t now = millis();
+        if (writer->_rotateRequest && writer->_recordLeft == 0) {
+            writer->_rotateRequest = false;
+            writer->openNext();
+        }
+        if (writer->_blockFill > 0 && now - writer->_lastWrite > PCAP_WRITER_FLUSH_MS) {
+            writer->writeBlock();
+            if (writer->_file) writer->_file.flush();
+        }
+        if (now - rateStart >= 1000) {
+            portENTER_CRITICAL(&writer->_statsMux);
+            // counters may have been reset meanwhile
+            uint64_t bytes = writer->_bytes >= rateBytes ? writer->_bytes - rateBytes : writer->_bytes;
+            uint32_t frames = writer->_frames >= rateFrames ? writer->_frames - rateFrames : writer->_frames;
+            writer->_bytesPerSec = bytes * 1000 / (now - rateStart);
+            writer->_framesPerSec = (uint64_t)frames * 1000 / (now - rateStart);
+            rateBytes = writer->_bytes;
+            rateFrames = writer->_frames;
+            portEXIT_CRITICAL(&writer->_statsMux);
+            rateStart = now;
+        }
+    }
+    writer->drain();
+    writer->closeFile();
+    portENTER_CRITICAL(&writer->_statsMux);
+    writer->_bytesPerSec = 0;
+    writer->_framesPerSec = 0;
+    portEXIT_CRITICAL(&writer->_statsMux);
+    writer->_task = NULL;
+    vTaskDelete(NULL);
+}
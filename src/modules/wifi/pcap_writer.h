@@ -0,0 +1,116 @@
+#ifndef __PCAP_WRITER_H__
+#define __PCAP_WRITER_H__
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+
+// File writes are whole blocks at block-aligned offsets, a multiple of the SD and flash sectors
+#ifndef PCAP_WRITER_BLOCK
+#define PCAP_WRITER_BLOCK 4096
+#endif
+// Ring sizes, powers of two. The small one is used when there is no PSRAM
+#ifndef PCAP_WRITER_RING_PSRAM
+#define PCAP_WRITER_RING_PSRAM (128 * 1024)
+#endif
+#ifndef PCAP_WRITER_RING_SRAM
+#define PCAP_WRITER_RING_SRAM (16 * 1024)
+#endif
+// A partial block is written when the last write is older than this
+#ifndef PCAP_WRITER_FLUSH_MS
+#define PCAP_WRITER_FLUSH_MS 2000
+#endif
+#define PCAP_SNAPLEN 2500
+
+struct PcapRotation {
+    uint32_t maxBytes = 0;   // start a new file past this size, 0 for no limit
+    uint32_t maxSeconds = 0; // start a new file after this long, 0 for no limit
+    uint16_t keepFiles = 0;  // files of the session kept, older ones are deleted. 0 keeps all
+};
+
+struct PcapWriterStats {
+    uint32_t frames;       // frames taken in the ring
+    uint32_t drops;        // frames lost because the ring was full
+    uint64_t bytes;        // bytes written to the files
+    uint32_t bytesPerSec;  // write rate over the last second
+    uint32_t framesPerSec; // frames over the last second
+    uint32_t ringSize;
+    uint32_t ringPeak; // highest ring fill in bytes
+    uint32_t files;    // files opened in the session
+    uint32_t writeErrors;
+};
+
+/*********************************************************************
+**  Class: PcapWriter
+**  Capture file fed from the promiscuous callback. push() copies the
+**  record in a preallocated ring and never blocks, a task moves the
+**  ring to the file in PCAP_WRITER_BLOCK writes and rotates the file
+**  by size or time, keeping the last rotation.keepFiles files.
+**  Files are named prefix + index + ".pcap".
+**********************************************************************/
+class PcapWriter {
+public:
+    ~PcapWriter() { end(); }
+
+    bool begin(FS &fs, const String &prefix, const PcapRotation &rotation = PcapRotation());
+    // Writes what is left in the ring and closes the file. stats() and path() keep the session's figures
+    void end();
+    bool isOpen() const { return _task != NULL; }
+
+    // Single producer, call it from the WiFi callback only
+    bool push(uint32_t tsSec, uint32_t tsUsec, const uint8_t *data, uint32_t len);
+    // Closes the file at the next frame boundary and starts the next one
+    void rotate();
+
+    String path();
+    PcapWriterStats stats();
+    void resetStats();
+
+private:
+    FS *_fs = nullptr;
+    File _file;
+    String _prefix;
+    PcapRotation _rotation;
+    int _firstIndex = 0;
+    int _index = 0;
+    char _path[64] = {0};
+    uint32_t _fileBytes = 0;
+    uint32_t _fileOpened = 0;
+
+    uint8_t *_ring = nullptr;
+    uint32_t _ringMask = 0;
+    uint32_t _ringSize = 0; // of the last session, kept for stats() after end()
+    std::atomic<uint32_t> _head{0}; // written by push()
+    std::atomic<uint32_t> _tail{0}; // written by the task
+    uint32_t _recordLeft = 0;       // bytes of the record being copied
+
+    uint8_t *_block = nullptr;
+    uint32_t _blockFill = 0;
+    uint32_t _lastWrite = 0;
+
+    TaskHandle_t _task = NULL;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _pushing{false}; // push() is between its _running check and its return
+    volatile bool _rotateRequest = false;
+
+    volatile uint32_t _frames = 0;
+    volatile uint32_t _drops = 0;
+    uint32_t _ringPeak = 0;
+    uint64_t _bytes = 0;
+    uint32_t _files = 0;
+    uint32_t _writeErrors = 0;
+    uint32_t _bytesPerSec = 0;
+    uint32_t _framesPerSec = 0;
+    portMUX_TYPE _statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+    bool openNext();
+    void closeFile();
+    void drain();
+    void copyFromRing(uint32_t pos, void *dst, uint32_t len);
+    void copyToRing(uint32_t pos, const void *src, uint32_t len);
+    void writeBlock();
+    bool rotationDue(uint32_t now);
+    static void taskFunc(void *param);
+};
+
+#endif
@@ -41,6 +41,7 @@
 #include <SdFat.h>
 #endif
 #include "modules/wifi/wifi_atks.h" // to use deauth frames and cmds
+#include "pcap_writer.h"
 
 //===== SETTINGS =====//
 #define FILENAME "raw_"
@@ -49,13 +50,28 @@
 #define HOP_INTERVAL 214            // in ms (only necessary if channelHopping is true)
 #define DEAUTH_INTERVAL (15 * 1000) // Send deauth packets every ms
 #define EAPOL_ONLY true
+// Raw and deauth captures start a new file past the size or the time, the session keeps the last files
+#ifndef SNIFFER_ROTATE_SD_KB
+#define SNIFFER_ROTATE_SD_KB (16 * 1024)
+#endif
+#ifndef SNIFFER_ROTATE_LITTLEFS_KB
+#define SNIFFER_ROTATE_LITTLEFS_KB 128
+#endif
+#ifndef SNIFFER_ROTATE_SECONDS
+#define SNIFFER_ROTATE_SECONDS (15 * 60)
+#endif
+#ifndef SNIFFER_KEEP_SD_FILES
+#define SNIFFER_KEEP_SD_FILES 32
+#endif
+#ifndef SNIFFER_KEEP_LITTLEFS_FILES
+#define SNIFFER_KEEP_LITTLEFS_FILES 4
+#endif
 
 //===== Run-Time variables =====//
 unsigned long lastTime = 0;
 unsigned long lastChannelChange = 0;
 uint32_t lastRedraw = 0;
 uint8_t ch = 0;
-bool rawFileOpen = false;
 bool isLittleFS = true;
 bool littleFsWasFull = false; // true when we exit because LittleFS ran out
 volatile bool littleFsSpaceAvailable = true;
@@ -67,24 +83,17 @@ uint32_t beacon_frames = 0;
 uint32_t start_time = 0;
 long deauth_tmp = 0;
 
-File _pcap_file;
-File _deauth_file;
-bool deauthFileOpen = false;
+PcapWriter pcapWriter;
+uint32_t snifferQueueDrops = 0; // handshake frames lost on a full queue
 SnifferMode currentMode = SnifferMode::HandshakesOnly;
 bool sdDetected = false;
 FS *activeFs = &LittleFS;
-SemaphoreHandle_t fileMutex = nullptr;
 QueueHandle_t snifferQueue = nullptr;
 TaskHandle_t snifferWriterHandle = nullptr;
-StaticSemaphore_t fileMutexBuffer;
 SemaphoreHandle_t handshakeMutex = nullptr;
 StaticSemaphore_t handshakeMutexBuffer;
 std::set<BeaconList> registeredBeacons;
 std::set<String> SavedHS; // Saves the MAC of beacon HS detected in the session
-String filename = "/BrucePCAP/" + (String)FILENAME + ".pcap";
-String deauthFilename = "/BrucePCAP/deauth_0.pcap";
-int deauthFileIndex = 0;
-int rawFileIndex = 0;
 std::map<uint64_t, String> beaconSsidCache;
 const size_t MAX_CAPTURE_SSID_LEN = 32;
 const size_t SNIFFER_QUEUE_DEPTH = 48;
@@ -97,18 +106,12 @@ std::map<uint64_t, uint32_t> beaconLastSeen; // key = macToKey(mac) -> last seen
 const uint32_t BEACON_TIMEOUT_MS = 120000;   // 2 minutes
 unsigned long lastBeaconCleanup = 0;
 
+// Handshake frames only, raw and deauth captures go through pcapWriter
 struct SnifferQueueItem {
     wifi_promiscuous_pkt_t *packet = nullptr;
-    uint32_t ts_sec = 0;
-    uint32_t ts_usec = 0;
-    uint16_t raw_len = 0;
     wifi_promiscuous_pkt_type_t type = WIFI_PKT_MISC;
     bool isBeacon = false;
     bool isHandshakeFrame = false;
-    bool isDeauthFrame = false;
-    bool saveRaw = false;
-    bool saveHandshake = false;
-    bool saveDeauth = false;
     uint8_t bssid[6] = {0};
     char ssid[MAX_CAPTURE_SSID_LEN + 1] = {0};
 };
@@ -145,10 +148,7 @@ static void registerHandshakeBeacon(uint64_t key);
 static void resetHandshakeBeaconCache();
 static void ensureDirectories(FS &Fs);
 static void openDeauthFile(FS &Fs);
-static void closeRawFile();
-static void closeDeauthFile();
-static bool lockFileMutex(TickType_t ticks = portMAX_DELAY);
-static void unlockFileMutex();
+static void closeCaptureFile();
 static String currentModeString();
 static bool rawCaptureEnabled();
 static bool handshakeCaptureEnabled();
@@ -557,64 +557,33 @@ static void releasePacketCopy(wifi_promiscuous_pkt_t *packet) {
     heap_caps_free(packet);
 }
 
-static bool lockFileMutex(TickType_t ticks) {
-    if (!fileMutex) return true;
-    return xSemaphoreTake(fileMutex, ticks) == pdTRUE;
-}
-
-static void unlockFileMutex() {
-    if (!fileMutex) return;
-    xSemaphoreGive(fileMutex);
-}
-
 static void ensureDirectories(FS &Fs) {
     if (!Fs.exists("/BrucePCAP")) { Fs.mkdir("/BrucePCAP"); }
     if (!Fs.exists("/BrucePCAP/handshakes")) { Fs.mkdir("/BrucePCAP/handshakes"); }
 }
 
-static void openDeauthFile(FS &Fs) {
-    ensureDirectories(Fs);
-    closeDeauthFile();
-    deauthFilename = "/BrucePCAP/deauth_" + String(deauthFileIndex) + ".pcap";
-    while (Fs.exists(deauthFilename)) {
-        deauthFileIndex++;
-        deauthFilename = "/BrucePCAP/deauth_" + String(deauthFileIndex) + ".pcap";
-    }
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        _deauth_file = Fs.open(deauthFilename, FILE_WRITE);
-        deauthFileOpen = _deauth_file && writeHeader(_deauth_file);
-        unlockFileMutex();
-        if (!deauthFileOpen) { Serial.println("Fail opening deauth capture file"); }
-    }
+static PcapRotation captureRotation(FS &Fs) {
+    PcapRotation rotation;
+    bool littleFs = &Fs == &LittleFS;
+    rotation.maxBytes = (littleFs ? SNIFFER_ROTATE_LITTLEFS_KB : SNIFFER_ROTATE_SD_KB) * 1024;
+    rotation.maxSeconds = SNIFFER_ROTATE_SECONDS;
+    rotation.keepFiles = littleFs ? SNIFFER_KEEP_LITTLEFS_FILES : SNIFFER_KEEP_SD_FILES;
+    return rotation;
 }
 
-static void closeRawFile() {
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        if (_pcap_file) {
-            _pcap_file.flush();
-            _pcap_file.close();
-        }
-        rawFileOpen = false;
-        unlockFileMutex();
+static void openDeauthFile(FS &Fs) {
+    ensureDirectories(Fs);
+    closeCaptureFile();
+    if (!pcapWriter.begin(Fs, "/BrucePCAP/deauth_", captureRotation(Fs))) {
+        Serial.println("Fail opening deauth capture file");
     }
 }
 
-static void closeDeauthFile() {
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        if (_deauth_file) {
-            _deauth_file.flush();
-            _deauth_file.close();
-        }
-        deauthFileOpen = false;
-        unlockFileMutex();
-    }
-}
+static void closeCaptureFile() { pcapWriter.end(); }
 
-static bool rawCaptureEnabled() { return currentMode == SnifferMode::Full && rawFileOpen && _pcap_file; }
+static bool rawCaptureEnabled() { return currentMode == SnifferMode::Full && pcapWriter.isOpen(); }
 static bool handshakeCaptureEnabled() { return currentMode != SnifferMode::DeauthOnly; }
-static bool deauthCaptureEnabled() {
-    return currentMode == SnifferMode::DeauthOnly && deauthFileOpen && _deauth_file;
-}
+static bool deauthCaptureEnabled() { return currentMode == SnifferMode::DeauthOnly && pcapWriter.isOpen(); }
 
 static String currentModeString() {
     switch (currentMode) {
@@ -625,7 +594,6 @@ static String currentModeString() {
 }
 
 static bool ensureSnifferBackend() {
-    if (!fileMutex) { fileMutex = xSemaphoreCreateMutexStatic(&fileMutexBuffer); }
     if (!handshakeMutex) { handshakeMutex = xSemaphoreCreateMutexStatic(&handshakeMutexBuffer); }
     if (!snifferQueue) { snifferQueue = xQueueCreate(SNIFFER_QUEUE_DEPTH, sizeof(SnifferQueueItem)); }
     if (!snifferQueue) { return false; }
@@ -643,35 +611,17 @@ static bool ensureSnifferBackend() {
     return snifferWriterHandle != nullptr;
 }
 
-static void handleRawWrite(const SnifferQueueItem &item) {
-    if (!rawCaptureEnabled() || !item.packet) { return; }
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        newPacketSD(item.ts_sec, item.ts_usec, item.raw_len, item.packet->payload, _pcap_file);
-        unlockFileMutex();
-    }
-}
-
 static void handleHandshakeWrite(const SnifferQueueItem &item) {
     if (!handshakeCaptureEnabled() || !item.packet) { return; }
     saveHandshake(item.packet, item.isBeacon, *activeFs, item.ssid);
 }
 
-static void handleDeauthWrite(const SnifferQueueItem &item) {
-    if (!deauthCaptureEnabled() || !item.packet) { return; }
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        newPacketSD(item.ts_sec, item.ts_usec, item.raw_len, item.packet->payload, _deauth_file);
-        unlockFileMutex();
-    }
-}
-
 static void snifferWriterTask(void *param) {
     (void)param;
     SnifferQueueItem item;
     while (true) {
         if (xQueueReceive(snifferQueue, &item, portMAX_DELAY) == pdTRUE) {
-            if (item.saveRaw) { handleRawWrite(item); }
-            if (item.saveHandshake) { handleHandshakeWrite(item); }
-            if (item.saveDeauth) { handleDeauthWrite(item); }
+            handleHandshakeWrite(item);
             releasePacketCopy(item.packet);
         }
     }
@@ -694,16 +644,12 @@ void sniffer_set_mode(SnifferMode mode) {
     if (mode == SnifferMode::Full && !sdDetected) { mode = SnifferMode::HandshakesOnly; }
     if (mode == currentMode) { return; }
     sniffer_wait_for_flush(500);
-    if (currentMode == SnifferMode::Full) { closeRawFile(); }
-    if (currentMode == SnifferMode::DeauthOnly) { closeDeauthFile(); }
+    closeCaptureFile();
     currentMode = mode;
     if (currentMode == SnifferMode::Full) {
         openFile(*activeFs);
     } else if (currentMode == SnifferMode::DeauthOnly) {
         openDeauthFile(*activeFs);
-    } else {
-        closeRawFile();
-        closeDeauthFile();
     }
 }
 
@@ -733,6 +679,23 @@ void sniffer_reset_handshake_cache() {
     resetHandshakeBeaconCache();
 }
 
+String sniffer_stats_report() {
+    PcapWriterStats stats = pcapWriter.stats();
+    // after a session the counters of its last file are still reported
+    String file = pcapWriter.path();
+    if (file.isEmpty()) file = "none";
+    else if (!pcapWriter.isOpen()) file += " (closed)";
+    String report = "Capture file: " + file + "\n";
+    report += "Packets seen: " + String(packet_counter) + "\n";
+    report += "Frames: " + String(stats.frames) + " captured, " + String(stats.drops) +
+              " dropped (ring full), " + String(snifferQueueDrops) + " handshake frames dropped\n";
+    report += "Written: " + String((uint32_t)(stats.bytes / 1024)) + " KB in " + String(stats.files) +
+              " files, " + String(stats.writeErrors) + " write errors\n";
+    report += "Rate: " + String(stats.bytesPerSec) + " B/s, " + String(stats.framesPerSec) + " frames/s\n";
+    report += "Ring: peak " + String(stats.ringPeak) + " of " + String(stats.ringSize) + " bytes";
+    return report;
+}
+
 void printAddress(const uint8_t *addr) {
     for (int i = 0; i < 6; i++) {
         Serial.printf("%02X", addr[i]);
@@ -812,30 +775,33 @@ void sniffer(void *buf, wifi_promiscuous_pkt_type_t type) {
 
     if (!saveRaw && !saveHandshake && !saveDeauth) { return; }
 
+    if (saveRaw || saveDeauth) {
+        // copied straight in the capture ring, no allocation per frame
+        uint32_t rawLen = ctrl.sig_len;
+        if (type == WIFI_PKT_MGMT && rawLen >= 4) { rawLen -= 4; }
+        pcapWriter.push(ctrl.timestamp / 1000000ULL, ctrl.timestamp % 1000000ULL, pkt->payload, rawLen);
+    }
+    if (!saveHandshake) { return; }
+
     wifi_promiscuous_pkt_t *copy = duplicatePacket(pkt, ctrl.sig_len);
-    if (!copy) { return; }
+    if (!copy) {
+        snifferQueueDrops++;
+        return;
+    }
     if (frameInfo.isBeacon && copy->rx_ctrl.sig_len >= 4) { copy->rx_ctrl.sig_len -= 4; }
 
     SnifferQueueItem item;
     item.packet = copy;
-    uint64_t pktTimestamp = copy->rx_ctrl.timestamp;
-    item.ts_sec = pktTimestamp / 1000000ULL;
-    item.ts_usec = pktTimestamp % 1000000ULL;
-    item.raw_len = ctrl.sig_len;
-    if (type == WIFI_PKT_MGMT && item.raw_len >= 4) { item.raw_len -= 4; }
     item.type = type;
     item.isBeacon = frameInfo.isBeacon;
     item.isHandshakeFrame = frameInfo.isEapol;
-    item.isDeauthFrame = frameInfo.isDeauth;
-    item.saveRaw = saveRaw;
-    item.saveHandshake = saveHandshake;
-    item.saveDeauth = saveDeauth;
     copyMac(item.bssid, frameInfo.apAddr);
     String ssidLabel = frameInfo.ssid.length() == 0 ? "UNKNOWN" : frameInfo.ssid;
     copySsidToBuffer(ssidLabel, item.ssid, sizeof(item.ssid));
 
     BaseType_t taskWoken = pdFALSE;
     if (xQueueSendFromISR(snifferQueue, &item, &taskWoken) != pdTRUE) {
+        snifferQueueDrops++;
         releasePacketCopy(copy);
     } else if (taskWoken) {
         portYIELD_FROM_ISR();
@@ -863,17 +829,9 @@ void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, voi
 
 void openFile(FS &Fs) {
     ensureDirectories(Fs);
-    closeRawFile();
-    filename = "/BrucePCAP/" + (String)FILENAME + String(rawFileIndex) + ".pcap";
-    while (Fs.exists(filename)) {
-        rawFileIndex++;
-        filename = "/BrucePCAP/" + (String)FILENAME + String(rawFileIndex) + ".pcap";
-    }
-    if (lockFileMutex(pdMS_TO_TICKS(200))) {
-        _pcap_file = Fs.open(filename, FILE_WRITE);
-        rawFileOpen = _pcap_file && writeHeader(_pcap_file);
-        unlockFileMutex();
-        if (!rawFileOpen) { Serial.println("Fail opening the file"); }
+    closeCaptureFile();
+    if (!pcapWriter.begin(Fs, "/BrucePCAP/" FILENAME, captureRotation(Fs))) {
+        Serial.println("Fail opening the file");
     }
 }
 
@@ -965,8 +923,6 @@ void sniffer_setup() {
         isLittleFS = true;
     }
 
-    rawFileIndex = 0;
-    deauthFileIndex = 0;
     if (!sniffer_prepare_storage(Fs, !isLittleFS)) {
         displayError("Sniffer queue error", true);
         return;
@@ -1080,7 +1036,6 @@ void sniffer_setup() {
             }
             if (millis() - _tmp > 700) { // longpress detected to exit
                 returnToMenu = true;
-                _pcap_file.close();
                 break;
             }
 #endif
@@ -1102,24 +1057,13 @@ void sniffer_setup() {
         // T-Embed has a different btn for Escape, different from StickCs that uses Previous btn
         if (check(EscPress)) {
             returnToMenu = true;
-            _pcap_file.close();
             break;
         }
 #endif
 
         if (check(SelPress)) { // pressed ok - show menu
             options = {
-                {"New File",
-                 [=]() {
-                     sniffer_wait_for_flush(1000);
-                     if (sniffer_get_mode() == SnifferMode::Full) {
-                         rawFileIndex++;
-                         openFile(*Fs);
-                     } else if (sniffer_get_mode() == SnifferMode::DeauthOnly) {
-                         deauthFileIndex++;
-                         openDeauthFile(*Fs);
-                     }
-                 }                                                                                        },
+                {"New File",                                                [=]() { pcapWriter.rotate(); }},
                 {"Capture Mode",
                  [&]() {
                      std::vector<Option> modeOptions;
@@ -1149,6 +1093,8 @@ void sniffer_setup() {
                      beaconSsidCache.clear();
                      sniffer_reset_handshake_cache();
                      deauth_tmp = millis();
+                     pcapWriter.resetStats();
+                     snifferQueueDrops = 0;
                  }                                                                                        },
                 {"Exit Sniffer",                                            [&]() { returnToMenu = true; }},
             };
@@ -1174,10 +1120,8 @@ void sniffer_setup() {
             tft.setTextSize(FP);
             tft.setTextColor(bruceConfig.priColor, bruceConfig.bgColor);
             String activeFile = "File: ";
-            if (sniffer_get_mode() == SnifferMode::Full && rawCaptureEnabled()) {
-                activeFile += FileSys + ":" + filename;
-            } else if (sniffer_get_mode() == SnifferMode::DeauthOnly && deauthCaptureEnabled()) {
-                activeFile += FileSys + ":" + deauthFilename;
+            if (rawCaptureEnabled() || deauthCaptureEnabled()) {
+                activeFile += FileSys + ":" + pcapWriter.path();
             } else {
                 activeFile += "handshake pcaps";
             }
@@ -1194,6 +1138,13 @@ void sniffer_setup() {
             } else padprintln("Silent mode.");
 
             padprintln("Run time " + String(runtime / 60) + ":" + String(runtime % 60));
+            if (rawCaptureEnabled() || deauthCaptureEnabled()) {
+                PcapWriterStats stats = pcapWriter.stats();
+                padprintln(
+                    "Write " + String(stats.bytesPerSec / 1024.0, 1) + "KB/s, " + String(stats.framesPerSec) +
+                    " fr/s, dropped " + String(stats.drops + snifferQueueDrops)
+                );
+            }
 
             // New: show beacon counts and recent SSIDs
             size_t activeOnChannel = countActiveBeaconsOnChannel(all_wifi_channels[ch]);
@@ -1233,15 +1184,9 @@ void sniffer_setup() {
             tft.drawCentreString("Packets " + String(packet_counter), tftWidth / 2, tftHeight - 26, 1);
         }
 
-        if (currentTime - lastTime > 100) tft.drawPixel(0, 0, 0);
-
-        if ((rawCaptureEnabled() || deauthCaptureEnabled()) && currentTime - lastTime > 1000) {
-            if (lockFileMutex(pdMS_TO_TICKS(50))) {
-                if (rawCaptureEnabled()) { _pcap_file.flush(); }
-                if (deauthCaptureEnabled()) { _deauth_file.flush(); }
-                unlockFileMutex();
-            }
-            lastTime = currentTime; // update time
+        if (currentTime - lastTime > 100) {
+            tft.drawPixel(0, 0, 0);
+            lastTime = currentTime;
         }
 
         if (deauth && (millis() - deauth_tmp) > DEAUTH_INTERVAL) {
@@ -1296,8 +1241,7 @@ Exit:
     esp_wifi_set_promiscuous_rx_cb(NULL);
     esp_wifi_deinit();
     sniffer_wait_for_flush(1000);
-    closeRawFile();
-    closeDeauthFile();
+    closeCaptureFile();
     wifiDisconnect();
     vTaskDelay(1 / portTICK_RATE_MS);
 }
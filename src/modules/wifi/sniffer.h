@@ -60,6 +60,8 @@ bool sniffer_prepare_storage(FS *fs, bool sdDetected);
 void sniffer_wait_for_flush(uint32_t timeoutMs = 2000);
 void sniffer_reset_handshake_cache();
 void markHandshakeReady(uint64_t key);
+// Capture counters of the running or last session, for the serial CLI
+String sniffer_stats_report();
 
 extern std::set<BeaconList> registeredBeacons;
 extern std::set<String> SavedHS;
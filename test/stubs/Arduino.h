@@ -0,0 +1,115 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the few Arduino pieces the tested modules use
+ */
+
+#ifndef __TEST_ARDUINO_H__
+#define __TEST_ARDUINO_H__
+
+#include <algorithm>
+#include <ctype.h>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <time.h>
+
+using std::max;
+using std::min;
+
+#define log_e(fmt, ...) fprintf(stderr, "E: " fmt "\n", ##__VA_ARGS__)
+#define log_w(fmt, ...) fprintf(stderr, "W: " fmt "\n", ##__VA_ARGS__)
+#define log_i(fmt, ...)
+#define log_d(fmt, ...)
+
+class String {
+public:
+    String(const char *s = "") : _s(s ? s : "") {}
+    String(const std::string &s) : _s(s) {}
+    explicit String(unsigned long n) : _s(std::to_string(n)) {}
+
+    String &operator=(const char *s) {
+        _s = s ? s : "";
+        return *this;
+    }
+    String &operator+=(char c) {
+        _s += c;
+        return *this;
+    }
+    String &operator+=(const char *s) {
+        _s += s;
+        return *this;
+    }
+    bool operator==(const char *s) const { return _s == s; }
+    bool operator!=(const char *s) const { return _s != s; }
+    bool operator==(const String &s) const { return _s == s._s; }
+    friend String operator+(const String &a, const String &b) { return a._s + b._s; }
+    friend String operator+(const String &a, const char *b) { return a._s + b; }
+    friend String operator+(const char *a, const String &b) { return a + b._s; }
+
+    void trim() {
+        size_t a = _s.find_first_not_of(" \t\r\n");
+        size_t b = _s.find_last_not_of(" \t\r\n");
+        _s = a == std::string::npos ? "" : _s.substr(a, b - a + 1);
+    }
+    void toLowerCase() {
+        for (char &c : _s) c = tolower((unsigned char)c);
+    }
+    void reserve(size_t size) { _s.reserve(size); }
+    const char *c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); } // unsigned int, as on the device
+    long toInt() const { return atol(_s.c_str()); }
+    int indexOf(char c, unsigned from = 0) const {
+        size_t i = _s.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    int lastIndexOf(char c) const {
+        size_t i = _s.rfind(c);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    bool endsWith(const char *s) const {
+        size_t n = strlen(s);
+        return _s.size() >= n && _s.compare(_s.size() - n, n, s) == 0;
+    }
+    String substring(unsigned from, unsigned to) const { return _s.substr(from, to - from); }
+    String substring(unsigned from) const { return _s.substr(from); }
+
+private:
+    std::string _s;
+};
+
+inline unsigned long millis() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// One tick is a millisecond, as on the device
+inline void vTaskDelay(uint32_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t *buf, size_t len) = 0;
+    size_t write(uint8_t c) { return write(&c, 1); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual size_t readBytes(uint8_t *buf, size_t len) = 0;
+};
+
+struct HostSerial {
+    void println(const String &s) {}
+};
+inline HostSerial Serial;
+
+static inline bool psramFound() { return false; }
+static inline void *ps_realloc(void *p, size_t size) { return realloc(p, size); }
+
+#endif
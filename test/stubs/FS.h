@@ -0,0 +1,122 @@
+/**
+ * @file FS.h
+ * @brief Host File backed by a string, enough for the stream readers and writers
+ */
+
+#ifndef __TEST_FS_H__
+#define __TEST_FS_H__
+
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+class File {
+public:
+    std::string data;
+    size_t pos = 0;
+    size_t readCalls = 0;
+    size_t writeCalls = 0;
+    bool failWrites = false;
+    bool valid = true;
+    bool directory = false;
+    time_t lastWrite = 0;
+    std::string *backing = nullptr; // the FS copy, written back on flush and close
+    std::vector<std::pair<std::string, bool>> entries; // path and isDir of a directory's files
+    size_t nextEntry = 0;
+
+    File() {}
+    explicit File(const std::string &content) : data(content) {}
+
+    int read(uint8_t *buf, size_t len) {
+        readCalls++;
+        if (pos >= data.size()) return 0;
+        size_t n = data.size() - pos < len ? data.size() - pos : len;
+        memcpy(buf, data.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    int read() {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t write(const uint8_t *buf, size_t len) {
+        writeCalls++;
+        if (failWrites) return 0;
+        if (pos > data.size()) data.resize(pos);
+        data.replace(pos, len < data.size() - pos ? len : data.size() - pos, (const char *)buf, len);
+        pos += len;
+        return len;
+    }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    bool seek(uint32_t offset) {
+        if (offset > data.size()) return false;
+        pos = offset;
+        return true;
+    }
+    size_t position() const { return pos; }
+    size_t size() const { return data.size(); }
+    int available() const { return pos < data.size() ? data.size() - pos : 0; }
+    void flush() {
+        if (backing && valid) *backing = data;
+    }
+    void close() {
+        flush();
+        valid = false;
+    }
+    bool isDirectory() const { return directory; }
+    String getNextFileName(bool *isDir) {
+        if (nextEntry >= entries.size()) return "";
+        *isDir = entries[nextEntry].second;
+        return entries[nextEntry++].first;
+    }
+    time_t getLastWrite() const { return lastWrite; }
+    explicit operator bool() const { return valid; }
+};
+
+// Files by path, opening a missing one for reading gives an invalid File. A File opened to read
+// is a copy taken at open, one opened to write or append goes back to the FS on flush and close
+class FS {
+public:
+    std::map<std::string, File> files;
+
+    File open(const String &path, const char *mode = "r") {
+        const std::string p = path.c_str();
+        auto it = files.find(p);
+        if (strcmp(mode, FILE_READ) != 0) {
+            if (it == files.end()) it = files.emplace(p, File()).first;
+            if (strcmp(mode, FILE_WRITE) == 0) it->second.data.clear();
+            File file = it->second;
+            file.backing = &it->second.data;
+            file.pos = file.data.size();
+            return file;
+        }
+        if (it == files.end()) {
+            File missing;
+            missing.valid = false;
+            return missing;
+        }
+        File file = it->second;
+        if (file.directory) {
+            const std::string prefix = p + "/";
+            for (const auto &f : files) {
+                const std::string &name = f.first;
+                if (name.compare(0, prefix.size(), prefix) != 0) continue;
+                if (name.find('/', prefix.size()) != std::string::npos) continue;
+                file.entries.push_back({name, f.second.directory});
+            }
+        }
+        return file;
+    }
+    bool exists(const String &path) const { return files.count(path.c_str()) > 0; }
+    bool mkdir(const String &path) {
+        files[path.c_str()].directory = true;
+        return true;
+    }
+    bool remove(const String &path) { return files.erase(path.c_str()) > 0; }
+};
+
+#endif
@@ -0,0 +1,11 @@
+/**
+ * @file LittleFS.h
+ * @brief Empty host stand-in, the tested modules only need the FS.h types
+ */
+
+#ifndef __TEST_LITTLEFS_H__
+#define __TEST_LITTLEFS_H__
+
+#include "FS.h"
+
+#endif
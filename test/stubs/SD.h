@@ -0,0 +1,11 @@
+/**
+ * @file SD.h
+ * @brief Empty host stand-in, the tested modules only need the FS.h types
+ */
+
+#ifndef __TEST_SD_H__
+#define __TEST_SD_H__
+
+#include "FS.h"
+
+#endif
@@ -0,0 +1,9 @@
+/**
+ * @file SPI.h
+ * @brief Empty host stand-in
+ */
+
+#ifndef __TEST_SPI_H__
+#define __TEST_SPI_H__
+
+#endif
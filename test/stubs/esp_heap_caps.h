@@ -0,0 +1,18 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host heap_caps_malloc, every capability is plain malloc
+ */
+
+#ifndef __TEST_ESP_HEAP_CAPS_H__
+#define __TEST_ESP_HEAP_CAPS_H__
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void *heap_caps_malloc(size_t size, uint32_t caps) { return malloc(size); }
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * @file esp_rom_crc.h
+ * @brief Host version of the ROM CRC-32, same results as zlib crc32()
+ */
+
+#ifndef __TEST_ESP_ROM_CRC_H__
+#define __TEST_ESP_ROM_CRC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+    return ~crc;
+}
+
+#endif
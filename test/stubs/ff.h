@@ -0,0 +1,11 @@
+/**
+ * @file ff.h
+ * @brief Host stand-in for FatFs, DirReader only keeps a pointer to the directory object
+ */
+
+#ifndef __TEST_FF_H__
+#define __TEST_FF_H__
+
+typedef struct FF_DIR FF_DIR;
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file md5.h
+ * @brief Host mbedtls_md5_* on top of OpenSSL EVP
+ */
+
+#ifndef __TEST_MBEDTLS_MD5_H__
+#define __TEST_MBEDTLS_MD5_H__
+
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct mbedtls_md5_context {
+    EVP_MD_CTX *md;
+};
+
+inline void mbedtls_md5_init(mbedtls_md5_context *ctx) { ctx->md = EVP_MD_CTX_new(); }
+inline void mbedtls_md5_free(mbedtls_md5_context *ctx) { EVP_MD_CTX_free(ctx->md); }
+inline int mbedtls_md5_starts(mbedtls_md5_context *ctx) {
+    return !EVP_DigestInit_ex(ctx->md, EVP_md5(), nullptr);
+}
+inline int mbedtls_md5_update(mbedtls_md5_context *ctx, const unsigned char *data, size_t len) {
+    return !EVP_DigestUpdate(ctx->md, data, len);
+}
+inline int mbedtls_md5_finish(mbedtls_md5_context *ctx, unsigned char *out) {
+    return !EVP_DigestFinal_ex(ctx->md, out, nullptr);
+}
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file sha1.h
+ * @brief Host mbedtls_sha1_* on top of OpenSSL EVP
+ */
+
+#ifndef __TEST_MBEDTLS_SHA1_H__
+#define __TEST_MBEDTLS_SHA1_H__
+
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct mbedtls_sha1_context {
+    EVP_MD_CTX *md;
+};
+
+inline void mbedtls_sha1_init(mbedtls_sha1_context *ctx) { ctx->md = EVP_MD_CTX_new(); }
+inline void mbedtls_sha1_free(mbedtls_sha1_context *ctx) { EVP_MD_CTX_free(ctx->md); }
+inline int mbedtls_sha1_starts(mbedtls_sha1_context *ctx) {
+    return !EVP_DigestInit_ex(ctx->md, EVP_sha1(), nullptr);
+}
+inline int mbedtls_sha1_update(mbedtls_sha1_context *ctx, const unsigned char *data, size_t len) {
+    return !EVP_DigestUpdate(ctx->md, data, len);
+}
+inline int mbedtls_sha1_finish(mbedtls_sha1_context *ctx, unsigned char *out) {
+    return !EVP_DigestFinal_ex(ctx->md, out, nullptr);
+}
+
+#endif
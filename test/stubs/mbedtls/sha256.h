@@ -0,0 +1,29 @@
+/**
+ * @file sha256.h
+ * @brief Host mbedtls_sha256_* on top of OpenSSL EVP
+ */
+
+#ifndef __TEST_MBEDTLS_SHA256_H__
+#define __TEST_MBEDTLS_SHA256_H__
+
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct mbedtls_sha256_context {
+    EVP_MD_CTX *md;
+};
+
+inline void mbedtls_sha256_init(mbedtls_sha256_context *ctx) { ctx->md = EVP_MD_CTX_new(); }
+inline void mbedtls_sha256_free(mbedtls_sha256_context *ctx) { EVP_MD_CTX_free(ctx->md); }
+inline int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224) {
+    return is224 ? -1 : !EVP_DigestInit_ex(ctx->md, EVP_sha256(), nullptr);
+}
+inline int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *data, size_t len) {
+    return !EVP_DigestUpdate(ctx->md, data, len);
+}
+inline int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char *out) {
+    return !EVP_DigestFinal_ex(ctx->md, out, nullptr);
+}
+
+#endif
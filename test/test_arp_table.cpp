@@ -0,0 +1,136 @@
+#include "modules/ethernet/arp_table.h"
+#include "test_common.h"
+#include <vector>
+
+static const uint32_t LAN = 0xC0A80100; // 192.168.1.0
+
+static void makeMac(uint32_t n, uint8_t mac[6]) {
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = n >> 24;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+static void testInsert() {
+    ArpTable table;
+    uint8_t mac[6];
+    CHECK_EQ(table.indexOf(LAN + 1), -1); // nothing allocated yet
+    CHECK(!table.insert(LAN + 1, mac));
+    CHECK(table.allocate(254));
+    CHECK_EQ(table.slots(), 512);
+
+    for (uint32_t n = 1; n <= 254; n++) {
+        makeMac(n, mac);
+        CHECK(table.insert(LAN + n, mac));
+    }
+    CHECK_EQ(table.count(), 254);
+    for (uint32_t n = 1; n <= 254; n++) {
+        const int32_t i = table.indexOf(LAN + n);
+        CHECK_EQ(i, (int32_t)n - 1); // in the order found
+        CHECK_EQ(table.host(i).mac[5], (uint8_t)n);
+    }
+    CHECK_EQ(table.indexOf(LAN + 255), -1);
+
+    // kept in network order, like ip4_addr_t
+    const uint8_t *ip = (const uint8_t *)&table.host(0).ip;
+    CHECK(ip[0] == 192 && ip[1] == 168 && ip[2] == 1 && ip[3] == 1);
+
+    // a host answering twice is one host, the first MAC stays
+    uint8_t other[6] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+    CHECK(!table.insert(LAN + 7, other));
+    CHECK_EQ(table.count(), 254);
+    CHECK_EQ(table.host(table.indexOf(LAN + 7)).mac[5], 7);
+    CHECK_EQ(table.dropped(), 0);
+}
+
+// Past maxHosts new hosts are counted and dropped, the known ones are still found
+static void testFull() {
+    ArpTable table;
+    uint8_t mac[6];
+    CHECK(table.allocate(10));
+    for (uint32_t n = 1; n <= 10; n++) {
+        makeMac(n, mac);
+        CHECK(table.insert(LAN + n, mac));
+    }
+    makeMac(11, mac);
+    CHECK(!table.insert(LAN + 11, mac));
+    CHECK(!table.insert(LAN + 12, mac));
+    CHECK_EQ(table.dropped(), 2);
+    CHECK_EQ(table.count(), 10);
+    CHECK(!table.insert(LAN + 3, mac)); // a duplicate is not a drop
+    CHECK_EQ(table.dropped(), 2);
+    CHECK_EQ(table.indexOf(LAN + 11), -1);
+    for (uint32_t n = 1; n <= 10; n++) CHECK_EQ(table.indexOf(LAN + n), (int32_t)n - 1);
+
+    // allocate starts over
+    CHECK(table.allocate(4));
+    CHECK_EQ(table.count(), 0);
+    CHECK_EQ(table.dropped(), 0);
+    CHECK_EQ(table.indexOf(LAN + 1), -1);
+}
+
+// Addresses that all start their probe at the last slot wrap around to the first ones
+static void testWraparound() {
+    ArpTable table;
+    CHECK(table.allocate(8));
+    const uint32_t last = table.slots() - 1;
+    std::vector<uint32_t> colliding;
+    uint32_t first = 0;
+    for (uint32_t ip = LAN; colliding.size() < 4; ip++) {
+        if (table.home(ip) == last) colliding.push_back(ip);
+    }
+    for (uint32_t ip = LAN; !first; ip++) {
+        if (table.home(ip) == 0) first = ip;
+    }
+
+    uint8_t mac[6];
+    makeMac(100, mac);
+    CHECK(table.insert(first, mac)); // takes slot 0, the wrapped probes have to step over it
+    for (uint32_t i = 0; i < colliding.size(); i++) {
+        makeMac(i, mac);
+        CHECK(table.insert(colliding[i], mac));
+    }
+    CHECK_EQ(table.count(), 5);
+    CHECK_EQ(table.indexOf(first), 0);
+    for (uint32_t i = 0; i < colliding.size(); i++) {
+        CHECK_EQ(table.indexOf(colliding[i]), (int32_t)i + 1);
+        CHECK(!table.insert(colliding[i], mac));
+    }
+    // an unknown address with the same start probes past all of them to a free slot
+    for (uint32_t ip = colliding.back() + 1;; ip++) {
+        if (table.home(ip) != last) continue;
+        CHECK_EQ(table.indexOf(ip), -1);
+        break;
+    }
+}
+
+static void testRange() {
+    uint32_t first, last;
+    CHECK(arpSweepRange(LAN + 37, 0xFFFFFF00, first, last));
+    CHECK_EQ(first, LAN + 1);
+    CHECK_EQ(last, LAN + 254);
+
+    // a /8 is narrowed to the /16 around us
+    CHECK(arpSweepRange(0x0A141E28, 0xFF000000, first, last)); // 10.20.30.40
+    CHECK_EQ(first, 0x0A140001u);
+    CHECK_EQ(last, 0x0A14FFFEu);
+    CHECK(arpSweepRange(0x0A141E28, 0, first, last));
+    CHECK_EQ(last - first + 1, 65534);
+    CHECK(arpSweepRange(0xAC100005, 0xFFFF0000, first, last)); // a /16 as it is
+    CHECK_EQ(first, 0xAC100001u);
+
+    CHECK(arpSweepRange(LAN + 1, 0xFFFFFFFC, first, last)); // /30, one other host
+    CHECK_EQ(last - first, 1);
+    CHECK(!arpSweepRange(LAN + 1, 0xFFFFFFFE, first, last)); // /31
+    CHECK(!arpSweepRange(LAN + 1, 0xFFFFFFFF, first, last)); // /32
+}
+
+int main() {
+    testInsert();
+    testFull();
+    testWraparound();
+    testRange();
+    return testResult("arp_table");
+}
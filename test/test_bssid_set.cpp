@@ -0,0 +1,123 @@
+#include "modules/gps/bssid_set.h"
+#include "test_common.h"
+#include <set>
+#include <vector>
+
+static void makeMac(uint32_t n, uint8_t mac[6]) {
+    // one vendor prefix, like a city full of the same routers
+    mac[0] = 0xDC;
+    mac[1] = 0xA6;
+    mac[2] = 0x32;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+static void testUpdate() {
+    BssidSet set;
+    uint8_t a[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+    uint8_t b[6] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x56};
+    CHECK(!set.contains(a));
+    CHECK_EQ(set.update(a, -80, 5), BSSID_NEW);
+    CHECK(set.contains(a));
+    CHECK(!set.contains(b));
+    CHECK_EQ(set.update(a, -77, 5), BSSID_SEEN);     // not stronger by the margin
+    CHECK_EQ(set.update(a, -75, 5), BSSID_STRONGER); // -80 + 5
+    CHECK_EQ(set.update(a, -72, 5), BSSID_SEEN);     // compared with -75 now
+    CHECK_EQ(set.update(a, -90, 5), BSSID_SEEN);
+    CHECK_EQ(set.update(b, 10, 5), BSSID_NEW);
+    CHECK_EQ(set.update(b, 15, 5), BSSID_STRONGER); // positive RSSI survives the packing
+    CHECK_EQ(set.size(), 2);
+
+    // the all zero and all ones MACs are keys like any other
+    uint8_t zero[6] = {};
+    uint8_t ones[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    CHECK_EQ(set.update(zero, -50, 5), BSSID_NEW);
+    CHECK_EQ(set.update(ones, -50, 5), BSSID_NEW);
+    CHECK(set.contains(zero));
+    CHECK(set.contains(ones));
+
+    set.clear();
+    CHECK_EQ(set.size(), 0);
+    CHECK_EQ(set.bytes(), 0);
+    CHECK(!set.contains(a));
+    CHECK_EQ(set.update(a, -80, 5), BSSID_NEW);
+}
+
+// Doubles at 3/4 load, and every MAC is still there after each move
+static void testGrowth() {
+    BssidSet set(BSSID_SET_MAX_PSRAM);
+    uint8_t mac[6];
+    for (uint32_t n = 0; n < 10000; n++) {
+        makeMac(n, mac);
+        CHECK_EQ(set.update(mac, -60, 5), BSSID_NEW);
+        CHECK(set.size() * 4 <= set.slots() * 3);
+    }
+    CHECK_EQ(set.slots(), 16384);
+    CHECK_EQ(set.bytes(), 16384 * 8);
+    for (uint32_t n = 0; n < 10000; n++) {
+        makeMac(n, mac);
+        if (!set.contains(mac)) {
+            CHECK(false);
+            break;
+        }
+    }
+    makeMac(10000, mac);
+    CHECK(!set.contains(mac));
+}
+
+// A table at its max takes 15/16 of it, then reports untracked without losing what it has
+static void testFull() {
+    BssidSet set(BSSID_SET_INITIAL);
+    uint8_t mac[6];
+    uint32_t n = 0;
+    for (; n < BSSID_SET_INITIAL; n++) {
+        makeMac(n, mac);
+        if (set.update(mac, -60, 5) != BSSID_NEW) break;
+    }
+    CHECK_EQ(n, BSSID_SET_INITIAL * 15 / 16);
+    CHECK_EQ(set.slots(), BSSID_SET_INITIAL);
+    CHECK_EQ(set.update(mac, -60, 5), BSSID_UNTRACKED);
+    CHECK_EQ(set.untracked(), 2);
+
+    makeMac(0, mac);
+    CHECK_EQ(set.update(mac, -50, 5), BSSID_STRONGER); // known MACs still update
+    CHECK_EQ(set.size(), BSSID_SET_INITIAL * 15 / 16);
+}
+
+// Random MACs against std::set, then the timing of a wardriving session
+static void benchmark() {
+    const uint32_t count = 60000;
+    std::vector<uint64_t> macs;
+    uint64_t seed = 11;
+    for (uint32_t i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        macs.push_back(seed >> 16);
+    }
+
+    BssidSet set(BSSID_SET_MAX_PSRAM);
+    std::set<uint64_t> reference;
+    uint32_t news = 0;
+    const double start = testMillis();
+    for (int pass = 0; pass < 4; pass++) {
+        for (uint64_t m : macs) {
+            uint8_t mac[6];
+            for (int i = 0; i < 6; i++) mac[i] = m >> (40 - 8 * i);
+            news += set.update(mac, -90 + pass, 5) == BSSID_NEW;
+        }
+    }
+    const double ms = testMillis() - start;
+    for (uint64_t m : macs) reference.insert(m & 0xFFFFFFFFFFFFULL);
+    CHECK_EQ(news, reference.size());
+    CHECK_EQ(set.size(), reference.size());
+    const double ns = ms * 1e6 / (4.0 * count);
+    printf("%u networks in %zu KB, %.0f ns per update\n", set.size(), set.bytes() / 1024, ns);
+}
+
+int main() {
+    testUpdate();
+    testGrowth();
+    testFull();
+    benchmark();
+    return testResult("bssid_set");
+}
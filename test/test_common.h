@@ -0,0 +1,51 @@
+/**
+ * @file test_common.h
+ * @brief Minimal checks for the host tests, no framework needed
+ */
+
+#ifndef __TEST_COMMON_H__
+#define __TEST_COMMON_H__
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+static int testFailures = 0;
+
+#define CHECK(cond)                                                                                          \
+    do {                                                                                                     \
+        if (!(cond)) {                                                                                       \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                                  \
+            testFailures++;                                                                                  \
+        }                                                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                                       \
+    do {                                                                                                     \
+        long long _a = (long long)(a), _b = (long long)(b);                                                  \
+        if (_a != _b) {                                                                                      \
+            printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #a, _a, _b);                    \
+            testFailures++;                                                                                  \
+        }                                                                                                    \
+    } while (0)
+
+#define CHECK_STR(a, b)                                                                                      \
+    do {                                                                                                     \
+        if (strcmp((a), (b)) != 0) {                                                                         \
+            printf("%s:%d: %s == \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #a, (a), (b));              \
+            testFailures++;                                                                                  \
+        }                                                                                                    \
+    } while (0)
+
+// Milliseconds since the first call, for the benchmarks
+static inline double testMillis() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static inline int testResult(const char *name) {
+    printf("%s: %s\n", name, testFailures ? "FAILED" : "passed");
+    return testFailures ? 1 : 0;
+}
+
+#endif
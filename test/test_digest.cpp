@@ -0,0 +1,104 @@
+#include "core/digest.h"
+#include "test_common.h"
+#include <string>
+
+static const uint8_t ALL = DIGEST_MD5 | DIGEST_CRC32 | DIGEST_SHA1 | DIGEST_SHA256;
+
+static void digestString(FileDigest &digest, const std::string &data, size_t chunk) {
+    for (size_t i = 0; i < data.size(); i += chunk) {
+        digest.update((const uint8_t *)data.data() + i, min(chunk, data.size() - i));
+    }
+    digest.finish();
+}
+
+// RFC 1321, FIPS 180 and the usual CRC-32 check value
+static void testVectors() {
+    struct Vector {
+        const char *input;
+        const char *md5;
+        const char *crc32;
+        const char *sha1;
+        const char *sha256;
+    } vectors[] = {
+        {"",
+         "d41d8cd98f00b204e9800998ecf8427e",
+         "00000000",
+         "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+         "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abc",
+         "900150983cd24fb0d6963f7d28e17f72",
+         "352441C2",
+         "a9993e364706816aba3e25717850c26c9cd0d89d",
+         "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"123456789",
+         "25f9e794323b453885f5181f1b624d0b",
+         "CBF43926",
+         "f7c3bc1d808e04732adf679965ccc34ca7ae3441",
+         "15e2b0d3c33891ebb0f1ef609ec419420c20e320ce94c65fbc8c3312448eb225"},
+    };
+    for (const Vector &v : vectors) {
+        for (size_t chunk : {1, 2, 64, 1000}) {
+            FileDigest digest(ALL);
+            digestString(digest, v.input, chunk);
+            CHECK_STR(digest.hex(DIGEST_MD5).c_str(), v.md5);
+            CHECK_STR(digest.hex(DIGEST_CRC32).c_str(), v.crc32);
+            CHECK_STR(digest.hex(DIGEST_SHA1).c_str(), v.sha1);
+            CHECK_STR(digest.hex(DIGEST_SHA256).c_str(), v.sha256);
+            CHECK_EQ(digest.bytes(), strlen(v.input));
+        }
+    }
+}
+
+// Algorithms that weren't asked for stay empty
+static void testSelection() {
+    FileDigest digest(DIGEST_SHA256);
+    digestString(digest, "abc", 3);
+    CHECK_STR(digest.hex(DIGEST_MD5).c_str(), "00000000000000000000000000000000");
+    CHECK_STR(
+        digest.hex(DIGEST_SHA256).c_str(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+    );
+}
+
+static void testParseAlgos() {
+    CHECK_EQ(FileDigest::parseAlgos("md5"), DIGEST_MD5);
+    CHECK_EQ(FileDigest::parseAlgos(" SHA256, crc32 "), DIGEST_SHA256 | DIGEST_CRC32);
+    CHECK_EQ(FileDigest::parseAlgos("md5,sha1,sha256,crc32"), ALL);
+    CHECK_EQ(FileDigest::parseAlgos("md5,sha512"), 0);
+    CHECK_EQ(FileDigest::parseAlgos(""), 0);
+    CHECK_STR(FileDigest::name(DIGEST_SHA1), "sha1");
+}
+
+// A file bigger than the read block gives the same digests as one update over all of it
+static void testFile() {
+    std::string data(5 * 1024 * 1024 + 123, 0);
+    uint32_t seed = 9;
+    for (char &c : data) {
+        seed = seed * 1103515245 + 12345;
+        c = seed >> 16;
+    }
+    FS fs;
+    fs.files["/big.bin"] = File(data);
+
+    FileDigest whole(ALL);
+    digestString(whole, data, data.size());
+    FileDigest streamed(ALL);
+    const double start = testMillis();
+    CHECK(streamed.digestFile(fs, "/big.bin"));
+    const double ms = testMillis() - start;
+    for (uint8_t algo = DIGEST_MD5; algo <= DIGEST_SHA256; algo <<= 1) {
+        CHECK_STR(streamed.hex(algo).c_str(), whole.hex(algo).c_str());
+    }
+    CHECK_EQ(streamed.bytes(), data.size());
+    printf("4 digests over %zu KB in one pass: %.1f ms\n", data.size() / 1024, ms);
+
+    FileDigest missing(DIGEST_MD5);
+    CHECK(!missing.digestFile(fs, "/none.bin"));
+}
+
+int main() {
+    testVectors();
+    testSelection();
+    testParseAlgos();
+    testFile();
+    return testResult("digest");
+}
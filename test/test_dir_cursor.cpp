@@ -0,0 +1,169 @@
+#include "core/dir_cursor.h"
+#include "core/dir_reader.h"
+#include "test_common.h"
+#include <map>
+#include <vector>
+
+// DirReader over in-memory folders, the real one needs FatFs or the VFS
+static std::map<std::string, std::vector<DirEntry>> folders;
+static std::map<const DirReader *, size_t> readPos;
+static int folderReads = 0;
+
+bool DirReader::open(FS &fs, const String &folder) {
+    if (!folders.count(folder.c_str())) return false;
+    _fs = &fs;
+    _folder = folder;
+    readPos[this] = 0;
+    folderReads++;
+    return true;
+}
+
+bool DirReader::next(DirEntry &entry) {
+    const std::vector<DirEntry> &entries = folders[_folder.c_str()];
+    size_t &pos = readPos[this];
+    if (pos >= entries.size()) return false;
+    entry = entries[pos++];
+    return true;
+}
+
+bool DirReader::rewind() {
+    readPos[this] = 0;
+    return true;
+}
+
+void DirReader::close() { readPos.erase(this); }
+
+static void addFolder(FS &fs, const std::string &path, const std::vector<std::string> &names, time_t mtime) {
+    std::vector<DirEntry> entries;
+    for (const std::string &n : names) {
+        DirEntry e = {};
+        bool isDir = n.back() == '/';
+        snprintf(e.name, sizeof(e.name), "%s", n.substr(0, n.size() - isDir).c_str());
+        e.isDir = isDir;
+        entries.push_back(e);
+    }
+    folders[path] = entries;
+    File dir;
+    dir.directory = true;
+    dir.lastWrite = mtime;
+    fs.files[path] = dir;
+}
+
+static std::vector<std::string> listed(DirCursor &cursor) {
+    std::vector<std::string> names;
+    for (int i = 0; i < cursor.count(); i++) names.push_back(cursor.name(i));
+    return names;
+}
+
+static void testOrderAndFilter() {
+    FS fs;
+    addFolder(fs, "/ir", {"b.ir", "Zeta/", "a.IR", "notes.txt", "alpha/", "C.ir", "noext"}, 1);
+    DirCursor cursor;
+    CHECK(cursor.open(fs, "/ir", "ir|sub"));
+    // folders first, then names without regard to case, "> Back" last
+    CHECK(listed(cursor) == std::vector<std::string>({"alpha", "Zeta", "a.IR", "b.ir", "C.ir", "> Back"}));
+    CHECK(cursor.isFolder(1));
+    CHECK(!cursor.isFolder(2));
+    CHECK(cursor.isOperation(cursor.count() - 1));
+
+    CHECK(cursor.open(fs, "/ir"));
+    CHECK_EQ(cursor.count(), 8);
+    CHECK(!cursor.open(fs, "/missing"));
+    CHECK_EQ(cursor.count(), 1);
+}
+
+static void testWindow() {
+    FS fs;
+    std::vector<std::string> names;
+    for (int i = 0; i < 25; i++) names.push_back("f" + std::to_string(100 + i));
+    addFolder(fs, "/w", names, 1);
+    DirCursor cursor;
+    CHECK(cursor.open(fs, "/w"));
+
+    const std::vector<FileList> &page = cursor.window(20, 10);
+    CHECK_EQ(page.size(), 6); // 5 files and "> Back"
+    CHECK_STR(page[0].filename.c_str(), "f120");
+    CHECK(page[5].operation);
+    CHECK_EQ(cursor.window(-3, 2).size(), 2);
+    CHECK_STR(cursor.window(0, 2)[1].filename.c_str(), "f101");
+}
+
+static void testCache() {
+    FS fs;
+    for (int i = 0; i < 4; i++) addFolder(fs, "/d" + std::to_string(i), {"x", "y/"}, 1);
+    DirCursor cursor;
+    folderReads = 0;
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK(cursor.open(fs, "/d1"));
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK_EQ(folderReads, 2); // going back uses the cached listing
+
+    fs.files["/d0"].lastWrite = 2; // changed folder
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK_EQ(folderReads, 3);
+
+    cursor.invalidate(); // FAT keeps the mtime, the browser drops the listing itself
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK_EQ(folderReads, 4);
+
+    // DIR_CURSOR_CACHE_FOLDERS listings, the least recently used one goes
+    CHECK(cursor.open(fs, "/d2"));
+    CHECK(cursor.open(fs, "/d3"));
+    CHECK_EQ(folderReads, 6);
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK_EQ(folderReads, 6);
+    CHECK(cursor.open(fs, "/d1"));
+    CHECK_EQ(folderReads, 7);
+
+    cursor.clear();
+    CHECK(cursor.open(fs, "/d0"));
+    CHECK_EQ(folderReads, 8);
+}
+
+// A folder of 10k entries, read, sorted and paged the way loopSD does it
+static void benchmark() {
+    FS fs;
+    std::vector<std::string> names;
+    unsigned seed = 7;
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 1103515245 + 12345;
+        names.push_back("Capture_" + std::to_string(seed % 1000000) + "_" + std::to_string(i) + ".sub");
+        if (i % 50 == 0) names.back() = "Folder_" + std::to_string(i) + "/";
+    }
+    addFolder(fs, "/big", names, 1);
+
+    DirCursor cursor;
+    double start = testMillis();
+    CHECK(cursor.open(fs, "/big", "sub"));
+    const double readMs = testMillis() - start;
+    CHECK_EQ(cursor.count(), 10001);
+    for (int i = 1; i < cursor.count() - 1; i++) {
+        bool sameKind = cursor.isFolder(i) == cursor.isFolder(i - 1);
+        if (sameKind && strcasecmp(cursor.name(i - 1), cursor.name(i)) > 0) {
+            CHECK(false);
+            break;
+        }
+    }
+
+    start = testMillis();
+    for (int first = 0; first < cursor.count(); first += 8) cursor.window(first, 8);
+    const double pageMs = testMillis() - start;
+    start = testMillis();
+    cursor.open(fs, "/big", "sub");
+    const double cachedMs = testMillis() - start;
+    printf(
+        "%d entries: read and sort %.2f ms, all pages %.2f ms, cached open %.3f ms\n",
+        cursor.count() - 1,
+        readMs,
+        pageMs,
+        cachedMs
+    );
+}
+
+int main() {
+    testOrderAndFilter();
+    testWindow();
+    testCache();
+    benchmark();
+    return testResult("dir_cursor");
+}
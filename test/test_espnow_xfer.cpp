@@ -0,0 +1,244 @@
+#include "core/connect/espnow_xfer.h"
+#include "test_common.h"
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Packets between the two state machines with loss, duplicates and reordering, on a simulated clock
+struct Air {
+    struct Packet {
+        uint32_t at;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Packet> queue;
+    int dropPercent = 0;
+    int dupPercent = 0;
+    uint32_t jitterMs = 0;
+    bool corruptNextData = false;
+    uint32_t *now = nullptr;
+    uint32_t seed = 1;
+
+    uint32_t random() {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 16;
+    }
+
+    void push(const uint8_t *packet, size_t len) {
+        if ((int)(random() % 100) < dropPercent) return;
+        std::vector<uint8_t> data(packet, packet + len);
+        if (corruptNextData && packet[1] == ESPNOW_XFER_DATA && len > ESPNOW_XFER_HEADER) {
+            data[ESPNOW_XFER_HEADER] ^= 0x01;
+            corruptNextData = false;
+        }
+        const int copies = (int)(random() % 100) < dupPercent ? 2 : 1;
+        for (int i = 0; i < copies; i++) queue.push_back({*now + 1 + random() % (jitterMs + 1), data});
+    }
+
+    // Packets due now, in no particular order when the jitter reorders them
+    std::vector<Packet> due() {
+        std::vector<Packet> out, keep;
+        for (Packet &p : queue) (p.at <= *now ? out : keep).push_back(p);
+        queue.swap(keep);
+        return out;
+    }
+};
+
+struct SenderLink : EspXferLink {
+    Air *air;
+    const std::vector<uint8_t> *file;
+
+    bool send(const uint8_t *packet, size_t len) override {
+        air->push(packet, len);
+        return true;
+    }
+    size_t read(uint32_t offset, uint8_t *buffer, size_t len) override {
+        memcpy(buffer, file->data() + offset, len);
+        return len;
+    }
+};
+
+struct ReceiverLink : EspXferLink {
+    Air *air;
+    std::string path;
+    std::vector<uint8_t> file;
+    bool closed = false;
+    bool ok = false;
+
+    bool send(const uint8_t *packet, size_t len) override {
+        air->push(packet, len);
+        return true;
+    }
+    bool open(const char *folder, const char *name, uint32_t size) override {
+        path = std::string(folder) + "/" + name;
+        file.clear();
+        return true;
+    }
+    bool write(const uint8_t *data, size_t len) override {
+        file.insert(file.end(), data, data + len);
+        return true;
+    }
+    void close(bool success) override {
+        closed = true;
+        ok = success;
+    }
+};
+
+struct Run {
+    uint32_t size = 0;
+    int dropPercent = 0;
+    int dupPercent = 0;
+    uint32_t jitterMs = 0;
+    uint16_t senderPacket = ESPNOW_XFER_MAX_PACKET;
+    uint16_t receiverPacket = ESPNOW_XFER_MAX_PACKET;
+    uint32_t seed = 1;
+    bool corrupt = false;
+    uint32_t abortAtMs = 0; // receiver gives up this long after the start, 0 never
+
+    std::vector<uint8_t> file;
+    SenderLink senderLink;
+    ReceiverLink receiverLink;
+    EspXferSender sender{senderLink};
+    EspXferReceiver receiver{receiverLink};
+    uint32_t ms = 0;
+
+    bool transfer() {
+        uint32_t now = 1000;
+        Air toReceiver, toSender;
+        toReceiver.now = toSender.now = &now;
+        toReceiver.dropPercent = toSender.dropPercent = dropPercent;
+        toReceiver.dupPercent = toSender.dupPercent = dupPercent;
+        toReceiver.jitterMs = toSender.jitterMs = jitterMs;
+        toReceiver.seed = seed;
+        toSender.seed = seed * 7 + 3;
+        toReceiver.corruptNextData = corrupt;
+
+        file.resize(size);
+        uint32_t fill = seed;
+        for (uint8_t &c : file) {
+            fill = fill * 1103515245 + 12345;
+            c = fill >> 16;
+        }
+        senderLink.air = &toReceiver;
+        senderLink.file = &file;
+        receiverLink.air = &toSender;
+
+        receiver.begin(receiverPacket);
+        CHECK(sender.begin("/BruceFiles", "capture.bin", size, senderPacket, now));
+        const uint32_t start = now;
+        for (int step = 0; step < 600000; step++) {
+            now++;
+            for (Air::Packet &p : toReceiver.due()) receiver.onPacket(p.data.data(), p.data.size(), now);
+            for (Air::Packet &p : toSender.due()) sender.onPacket(p.data.data(), p.data.size(), now);
+            sender.poll(now);
+            receiver.poll(now);
+            if (abortAtMs && now - start == abortAtMs) receiver.abort();
+            const bool ended = sender.state() >= ESPNOW_XFER_DONE && receiver.state() >= ESPNOW_XFER_DONE;
+            if (ended && toReceiver.queue.empty() && toSender.queue.empty()) break;
+        }
+        ms = now - start;
+        return sender.state() == ESPNOW_XFER_DONE && receiver.state() == ESPNOW_XFER_DONE &&
+               receiverLink.ok && receiverLink.file == file;
+    }
+};
+
+static void testCrc() {
+    const char *check = "123456789";
+    CHECK_EQ(espXferCrc32(0, (const uint8_t *)check, 9), 0xCBF43926);
+    uint32_t chained = espXferCrc32(0, (const uint8_t *)check, 4);
+    CHECK_EQ(espXferCrc32(chained, (const uint8_t *)check + 4, 5), 0xCBF43926);
+}
+
+static void testCleanLink() {
+    for (uint32_t size : {0u, 1u, 1462u, 1463u, 100000u}) {
+        Run run;
+        run.size = size;
+        run.jitterMs = 2;
+        CHECK(run.transfer());
+        CHECK_EQ(run.sender.retransmits(), 0);
+        CHECK_EQ(run.receiver.bytesReceived(), size);
+        CHECK(run.receiverLink.path == "/BruceFiles/capture.bin");
+    }
+
+    // the smaller packet of the two ends sets the chunk size
+    Run small;
+    small.size = 5000;
+    small.receiverPacket = 250;
+    CHECK(small.transfer());
+    CHECK_EQ(small.sender.chunkSize(), 250 - ESPNOW_XFER_HEADER);
+}
+
+static void testLossyLink() {
+    Run runs[4];
+    runs[0].size = 100000, runs[0].dropPercent = 10, runs[0].dupPercent = 5, runs[0].jitterMs = 20;
+    runs[1].size = 100000, runs[1].dropPercent = 30, runs[1].dupPercent = 10, runs[1].jitterMs = 40;
+    runs[1].senderPacket = 250;
+    runs[2].size = 262144, runs[2].dropPercent = 20, runs[2].dupPercent = 20, runs[2].jitterMs = 80;
+    runs[3].size = 50000, runs[3].dropPercent = 50, runs[3].jitterMs = 10;
+    for (int i = 0; i < 4; i++) {
+        Run &run = runs[i];
+        run.seed = i + 2;
+        CHECK(run.transfer());
+        CHECK(run.sender.retransmits() > 0);
+        printf(
+            "%u%% lost, %u%% doubled: %u KB, %u packets, %u resent, %u duplicates, %u ms simulated\n",
+            run.dropPercent,
+            run.dupPercent,
+            run.size / 1024,
+            run.sender.packetsSent(),
+            run.sender.retransmits(),
+            run.receiver.duplicates(),
+            run.ms
+        );
+    }
+
+    // random mixes of everything
+    int failed = 0;
+    for (uint32_t seed = 10; seed < 50; seed++) {
+        Run run;
+        run.seed = seed;
+        run.size = seed * 2749 % 30000;
+        run.dropPercent = seed * 7 % 35;
+        run.dupPercent = seed * 3 % 20;
+        run.jitterMs = seed * 13 % 60;
+        run.receiverPacket = seed % 2 ? ESPNOW_XFER_MAX_PACKET : 250;
+        failed += !run.transfer();
+    }
+    CHECK_EQ(failed, 0);
+}
+
+static void testBrokenTransfers() {
+    // a damaged chunk is caught by the CRC of the end packet
+    Run corrupt;
+    corrupt.size = 20000;
+    corrupt.corrupt = true;
+    CHECK(!corrupt.transfer());
+    CHECK_EQ(corrupt.receiver.error(), ESPNOW_XFER_CORRUPT);
+    CHECK(corrupt.receiverLink.closed);
+    CHECK(!corrupt.receiverLink.ok);
+
+    // nobody answers
+    Run dead;
+    dead.size = 20000;
+    dead.dropPercent = 100;
+    CHECK(!dead.transfer());
+    CHECK_EQ(dead.sender.state(), ESPNOW_XFER_FAILED);
+    CHECK_EQ(dead.sender.error(), ESPNOW_XFER_TIMEOUT);
+
+    // the receiver cancels halfway
+    Run cancelled;
+    cancelled.size = 1000000;
+    cancelled.jitterMs = 5;
+    cancelled.abortAtMs = 100;
+    CHECK(!cancelled.transfer());
+    CHECK_EQ(cancelled.sender.error(), ESPNOW_XFER_CANCELLED);
+    CHECK(cancelled.receiverLink.closed);
+    CHECK(!cancelled.receiverLink.ok);
+}
+
+int main() {
+    testCrc();
+    testCleanLink();
+    testLossyLink();
+    testBrokenTransfers();
+    return testResult("espnow_xfer");
+}
@@ -0,0 +1,200 @@
+#include "core/serial_commands/file_transfer.h"
+#include "test_common.h"
+#include <atomic>
+#include <esp_rom_crc.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+// Stream over the device end of a pty, like the USB CDC port
+class PtyStream : public Stream {
+public:
+    explicit PtyStream(int fd) : _fd(fd) {}
+
+    int available() override {
+        int n = 0;
+        return ioctl(_fd, FIONREAD, &n) == 0 ? n : 0;
+    }
+    int read() override {
+        uint8_t c;
+        return ::read(_fd, &c, 1) == 1 ? c : -1;
+    }
+    size_t readBytes(uint8_t *buf, size_t len) override {
+        ssize_t n = ::read(_fd, buf, len);
+        return n > 0 ? n : 0;
+    }
+    using Print::write;
+    size_t write(const uint8_t *buf, size_t len) override {
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::write(_fd, buf + done, len - done);
+            if (n <= 0) break;
+            done += n;
+        }
+        return done;
+    }
+
+private:
+    int _fd;
+};
+
+struct Pty {
+    int master = -1;
+    int slave = -1;
+
+    Pty() {
+        struct termios tio;
+        memset(&tio, 0, sizeof(tio));
+        cfmakeraw(&tio);
+        CHECK(openpty(&master, &slave, nullptr, &tio, nullptr) == 0);
+    }
+    ~Pty() {
+        close(master);
+        close(slave);
+    }
+};
+
+// Moves bytes between the two ptys, damaging or dropping damagePercent of the reads (up to 1 KB)
+struct Link {
+    Pty sender;
+    Pty receiver;
+    int damagePercent = 0;
+    uint32_t seed = 1;
+    uint32_t damaged = 0;
+
+    void relay(std::atomic<int> &running, const std::string &toSender = "") {
+        if (!toSender.empty()) write(sender.master, toSender.data(), toSender.size());
+        struct pollfd fds[2] = {{sender.master, POLLIN, 0}, {receiver.master, POLLIN, 0}};
+        uint8_t buf[1024];
+        while (running > 0) {
+            if (poll(fds, 2, 10) <= 0) continue;
+            for (int i = 0; i < 2; i++) {
+                if (!(fds[i].revents & POLLIN)) continue;
+                ssize_t n = read(fds[i].fd, buf, sizeof(buf));
+                if (n <= 0) continue;
+                seed = seed * 1103515245 + 12345;
+                if ((int)((seed >> 16) % 100) < damagePercent) {
+                    damaged++;
+                    if (seed & 0x80000000u) continue;   // dropped
+                    buf[(seed >> 8) % n] ^= 0x10;      // one bad byte
+                }
+                int to = i == 0 ? receiver.master : sender.master;
+                for (ssize_t done = 0; done < n;) done += write(to, buf + done, n - done);
+            }
+        }
+    }
+};
+
+static std::string makeData(size_t size) {
+    std::string data(size, 0);
+    uint32_t seed = size;
+    for (char &c : data) {
+        seed = seed * 1103515245 + 12345;
+        c = seed >> 16;
+    }
+    return data;
+}
+
+struct Result {
+    bool sent = false;
+    bool received = false;
+    XferStats sendStats;
+    XferStats recvStats;
+    double ms = 0;
+};
+
+static Result
+transfer(Link &link, File &source, File &dest, uint32_t offset, const std::string &toSender = "") {
+    Result res;
+    std::atomic<int> running(2);
+    PtyStream senderIo(link.sender.slave);
+    PtyStream receiverIo(link.receiver.slave);
+    const double start = testMillis();
+    std::thread sender([&] {
+        res.sent = xferSendFile(senderIo, source, offset, res.sendStats);
+        running--;
+    });
+    std::thread receiver([&] {
+        res.received = xferReceiveFile(receiverIo, dest, offset, source.size(), res.recvStats);
+        running--;
+    });
+    link.relay(running, toSender);
+    sender.join();
+    receiver.join();
+    res.ms = testMillis() - start;
+    return res;
+}
+
+static void testCleanLink() {
+    Link link;
+    File source(makeData(300 * 1024 + 17));
+    File dest;
+    Result res = transfer(link, source, dest, 0);
+    CHECK(res.sent);
+    CHECK(res.received);
+    CHECK(dest.data == source.data);
+    CHECK_EQ(res.sendStats.retries, 0);
+    CHECK_EQ(res.recvStats.bytes, source.size());
+    printf("clean pty: %zu KB in %.0f ms, %.0f KB/s\n", source.size() / 1024, res.ms, source.size() / res.ms);
+}
+
+static void testLossyLink() {
+    Link link;
+    link.damagePercent = 5;
+    File source(makeData(200 * 1024 + 3));
+    File dest;
+    Result res = transfer(link, source, dest, 0);
+    CHECK(res.sent);
+    CHECK(res.received);
+    CHECK(dest.data == source.data);
+    CHECK(link.damaged > 0);
+    CHECK(res.sendStats.retries > 0);
+    printf(
+        "5%% damaged: %u chunks hit, %u resends, %zu KB in %.0f ms\n",
+        link.damaged,
+        res.sendStats.retries,
+        source.size() / 1024,
+        res.ms
+    );
+}
+
+static void testResume() {
+    Link link;
+    File source(makeData(50 * 1024));
+    const uint32_t offset = 20000;
+    File dest(source.data.substr(0, offset));
+    dest.seek(offset);
+    Result res = transfer(link, source, dest, offset);
+    CHECK(res.received);
+    CHECK(dest.data == source.data);
+    CHECK_EQ(res.recvStats.bytes, source.size() - offset);
+}
+
+// An ack that claims more payload than the sender's reply buffer holds is dropped, not read
+static void testOversizedReply() {
+    uint8_t frame[9 + 600 + 4] = {0xB5, 0x62, 'A'};
+    frame[3] = 600 & 0xFF;
+    frame[4] = 600 >> 8;
+    memset(frame + 9, 0xEE, 600);
+    uint32_t crc = esp_rom_crc32_le(0, frame + 2, 7 + 600);
+    memcpy(frame + 9 + 600, &crc, 4);
+
+    Link link;
+    File source(makeData(10 * 1024));
+    File dest;
+    Result res = transfer(link, source, dest, 0, std::string((const char *)frame, sizeof(frame)));
+    CHECK(res.sent);
+    CHECK(res.received);
+    CHECK(dest.data == source.data);
+}
+
+int main() {
+    testCleanLink();
+    testLossyLink();
+    testResume();
+    testOversizedReply();
+    return testResult("file_transfer");
+}
@@ -0,0 +1,134 @@
+#include "modules/ir/ir_file_parser.h"
+#include "test_common.h"
+#include <string>
+#include <vector>
+
+static const char *SAMPLE = "Filetype: IR signals file\n"
+                            "Version: 1\n"
+                            "# \n"
+                            "name: Power\n"
+                            "type: parsed\n"
+                            "protocol: NECext\n"
+                            "address: 04 00 00 00\n"
+                            "command: 08 F7 00 00\n"
+                            "# \n"
+                            "name: Vol_up\n"
+                            "type: raw\n"
+                            "frequency: 36000\n"
+                            "duty_cycle: 0.330000\n"
+                            "data: 9024 4512 579 552 579  \n"
+                            "#\n"
+                            "name: Mute\n"
+                            "type: raw\n"
+                            "data: 100 200 300";
+
+static std::vector<IrIndexEntry> parse(const std::string &text, size_t chunk) {
+    std::vector<IrIndexEntry> codes;
+    IrFileParser parser([&](const IrIndexEntry &entry) { codes.push_back(entry); });
+    for (size_t i = 0; i < text.size(); i += chunk) {
+        parser.feed(text.data() + i, text.size() - i < chunk ? text.size() - i : chunk);
+    }
+    parser.finish();
+    CHECK_EQ(parser.count(), codes.size());
+    return codes;
+}
+
+static std::string dataOf(const std::string &text, const IrIndexEntry &entry) {
+    return text.substr(entry.dataOffset, entry.dataLen);
+}
+
+static void testSample() {
+    const std::string text = SAMPLE;
+    std::vector<IrIndexEntry> codes = parse(text, text.size());
+    CHECK_EQ(codes.size(), 3);
+    if (codes.size() != 3) return;
+
+    CHECK_STR(codes[0].name, "Power");
+    CHECK_EQ(codes[0].type, IR_TYPE_PARSED);
+    CHECK_STR(codes[0].protocol, "NECext");
+    CHECK_STR(codes[0].address, "04 00 00 00");
+    CHECK_STR(codes[0].command, "08 F7 00 00");
+    CHECK_EQ(codes[0].bits, 32);
+
+    CHECK_STR(codes[1].name, "Vol_up");
+    CHECK_EQ(codes[1].type, IR_TYPE_RAW);
+    CHECK_EQ(codes[1].frequency, 36000);
+    CHECK(dataOf(text, codes[1]) == "9024 4512 579 552 579"); // trailing blanks trimmed
+
+    // Last code without a trailing newline, default frequency
+    CHECK_STR(codes[2].name, "Mute");
+    CHECK_EQ(codes[2].frequency, 38000);
+    CHECK(dataOf(text, codes[2]) == "100 200 300");
+}
+
+// Chunk boundaries must not change anything, the file is fed 512 bytes at a time on the device
+static void testChunking() {
+    const std::string text = SAMPLE;
+    std::vector<IrIndexEntry> whole = parse(text, text.size());
+    for (size_t chunk = 1; chunk < text.size(); chunk++) {
+        std::vector<IrIndexEntry> split = parse(text, chunk);
+        CHECK_EQ(split.size(), whole.size());
+        for (size_t i = 0; i < split.size() && i < whole.size(); i++) {
+            CHECK(memcmp(&split[i], &whole[i], sizeof(IrIndexEntry)) == 0);
+        }
+    }
+}
+
+static void testCrlfAndNoNames() {
+    // Old files have no "name:" lines, every "type:" starts a code
+    const std::string text = "type: parsed\r\nprotocol: NEC\r\n"
+                             "address: 01 00 00 00\r\ncommand: 02 00 00 00\r\n"
+                             "type: parsed\r\nprotocol: Samsung32\r\nbits: 16\r\n"
+                             "type: raw\r\n"; // raw without data is dropped
+    std::vector<IrIndexEntry> codes = parse(text, 7);
+    CHECK_EQ(codes.size(), 2);
+    if (codes.size() != 2) return;
+    CHECK_STR(codes[0].protocol, "NEC");
+    CHECK_STR(codes[0].command, "02 00 00 00");
+    CHECK_STR(codes[1].protocol, "Samsung32");
+    CHECK_EQ(codes[1].bits, 16);
+}
+
+static void testLongFields() {
+    std::string name(100, 'n');
+    std::string text = "name: " + name + "\ntype: parsed\nprotocol: RC5\n";
+    std::vector<IrIndexEntry> codes = parse(text, 5);
+    CHECK_EQ(codes.size(), 1);
+    if (codes.size() == 1) CHECK_EQ(strlen(codes[0].name), sizeof(codes[0].name) - 1);
+}
+
+// A large TV-B-Gone style file, parsed the way IrFileIndex does it
+static void benchmark() {
+    std::string text = "Filetype: IR signals file\nVersion: 1\n";
+    for (int i = 0; i < 5000; i++) {
+        text += "# \nname: Code_" + std::to_string(i) + "\n";
+        if (i % 2) {
+            text += "type: parsed\nprotocol: NEC\naddress: 04 00 00 00\ncommand: 08 00 00 00\n";
+        } else {
+            text += "type: raw\nfrequency: 38000\nduty_cycle: 0.330000\ndata:";
+            for (int s = 0; s < 67; s++) text += " " + std::to_string(500 + (s * 37 + i) % 9000);
+            text += "\n";
+        }
+    }
+
+    const double start = testMillis();
+    std::vector<IrIndexEntry> codes = parse(text, 512);
+    const double ms = testMillis() - start;
+    CHECK_EQ(codes.size(), 5000);
+    printf(
+        "parsed %zu codes, %zu KB in %.2f ms (%.1f MB/s)\n",
+        codes.size(),
+        text.size() / 1024,
+        ms,
+        text.size() / 1000.0 / (ms > 0 ? ms : 1)
+    );
+}
+
+int main() {
+    testSample();
+    testChunking();
+    testCrlfAndNoNames();
+    testLongFields();
+    benchmark();
+    return testResult("ir_file_parser");
+}
@@ -0,0 +1,166 @@
+#include "modules/lora/lora_log.h"
+#include "test_common.h"
+#include <vector>
+
+// Built with LORA_LOG_SEGMENT_BYTES 256 and LORA_LOG_SEGMENTS 3: the records of message() are
+// 27 bytes, 9 to a segment, and the log keeps the newest 3 segments
+#define PER_SEGMENT 9
+
+static LoraLogRecord message(int n) {
+    char text[8];
+    snprintf(text, sizeof(text), "msg %03d", n);
+    LoraLogRecord rec;
+    rec.time = 1732106096 + n;
+    rec.sender = "node";
+    rec.text = text;
+    return rec;
+}
+
+static int number(const LoraLogRecord &rec) { return atoi(rec.text.c_str() + 4); }
+
+static std::vector<int> walkBack(LoraLog &log) {
+    std::vector<int> seen;
+    LoraLogPos pos = log.tail();
+    LoraLogRecord rec;
+    while (log.readBefore(pos, rec)) seen.push_back(number(rec));
+    return seen;
+}
+
+static std::vector<int> walkForward(LoraLog &log) {
+    std::vector<int> seen;
+    LoraLogPos pos;
+    LoraLogRecord rec;
+    while (log.readAfter(pos, rec)) seen.push_back(number(rec));
+    return seen;
+}
+
+static std::vector<int> range(int from, int to, int step = 1) {
+    std::vector<int> out;
+    for (int n = from; n != to + step; n += step) out.push_back(n);
+    return out;
+}
+
+static void testRecords() {
+    FS fs;
+    LoraLog log;
+    CHECK(log.begin(fs));
+    CHECK(fs.exists(LORA_LOG_DIR));
+    CHECK(log.empty());
+    LoraLogPos pos = log.tail();
+    LoraLogRecord rec;
+    CHECK(!log.readBefore(pos, rec));
+    CHECK(!log.readAfter(pos, rec));
+
+    LoraLogRecord sent;
+    sent.time = 1732106096;
+    sent.rssi10 = -1234;
+    sent.snr4 = -38;
+    sent.flags = LORA_MSG_SENT;
+    sent.sender = std::string(300, 's'); // cut to 255
+    sent.text = std::string(600, 't');   // cut to LORA_LOG_MAX_TEXT
+    LoraLogPos start, end;
+    CHECK(log.append(sent, &start, &end));
+    CHECK_EQ(start.segment, 1);
+    CHECK_EQ(start.offset, 0);
+    CHECK_EQ(end.offset, 16 + 255 + LORA_LOG_MAX_TEXT);
+    CHECK(!log.empty());
+    CHECK(fs.exists(LORA_LOG_DIR "/00001.bin"));
+
+    pos = log.tail();
+    CHECK(log.readBefore(pos, rec));
+    CHECK_EQ(pos.offset, 0);
+    CHECK_EQ(rec.time, 1732106096);
+    CHECK_EQ(rec.rssi10, -1234);
+    CHECK_EQ(rec.snr4, -38);
+    CHECK_EQ(rec.flags, LORA_MSG_SENT);
+    CHECK_EQ(rec.sender.length(), 255);
+    CHECK_EQ(rec.text.length(), LORA_LOG_MAX_TEXT);
+    CHECK(!log.readBefore(pos, rec));
+    CHECK(log.readAfter(pos, rec));
+    CHECK_EQ(pos.offset, end.offset);
+
+    // the next record does not fit, it starts segment 2
+    CHECK(log.append(message(1)));
+    CHECK_EQ(log.tail().segment, 2);
+    CHECK(log.readAfter(pos, rec));
+    CHECK_EQ(number(rec), 1);
+    CHECK(!log.readAfter(pos, rec));
+
+    // a record written after a reader reached the end is still found
+    CHECK(log.append(message(2)));
+    CHECK(log.readAfter(pos, rec));
+    CHECK_EQ(number(rec), 2);
+    CHECK(!log.readAfter(pos, rec));
+}
+
+// Walks across segments both ways, and the oldest segments go once there are more than LORA_LOG_SEGMENTS
+static void testRotation() {
+    FS fs;
+    LoraLog log;
+    CHECK(log.begin(fs));
+    for (int n = 0; n < 2 * PER_SEGMENT; n++) CHECK(log.append(message(n)));
+    CHECK_EQ(log.tail().segment, 2);
+    CHECK(walkBack(log) == range(2 * PER_SEGMENT - 1, 0, -1));
+    CHECK(walkForward(log) == range(0, 2 * PER_SEGMENT - 1));
+
+    // 40 records take 5 segments, the first two are gone
+    for (int n = 2 * PER_SEGMENT; n < 40; n++) CHECK(log.append(message(n)));
+    CHECK_EQ(log.tail().segment, 5);
+    CHECK(!fs.exists(LORA_LOG_DIR "/00001.bin"));
+    CHECK(!fs.exists(LORA_LOG_DIR "/00002.bin"));
+    CHECK(fs.exists(LORA_LOG_DIR "/00003.bin"));
+    CHECK(walkBack(log) == range(39, 2 * PER_SEGMENT, -1));
+    CHECK(walkForward(log) == range(2 * PER_SEGMENT, 39));
+
+    // opened again, the segments are found from the file names and appends go to the newest
+    log.end();
+    LoraLog again;
+    CHECK(again.begin(fs));
+    CHECK_EQ(again.tail().segment, 5);
+    CHECK(again.append(message(40)));
+    CHECK(walkBack(again) == range(40, 2 * PER_SEGMENT, -1));
+}
+
+// A reader inside the oldest segment when append() deletes it moves on to the new oldest one,
+// and does not keep reading the deleted file from the handle it had open
+static void testSegmentDeletedWhileReading() {
+    FS fs;
+    LoraLog log;
+    CHECK(log.begin(fs));
+    int next = 0;
+    for (; next < 3 * PER_SEGMENT; next++) CHECK(log.append(message(next)));
+
+    // one walk backwards stopped in segment 2
+    LoraLogPos backward = {2, 2 * 27};
+    LoraLogRecord rec;
+    CHECK(log.readBefore(backward, rec));
+    CHECK_EQ(number(rec), PER_SEGMENT + 1);
+
+    // one walk forwards in segment 1, the file the log has open to read
+    LoraLogPos forward;
+    for (int n = 0; n < 3; n++) CHECK(log.readAfter(forward, rec));
+    CHECK_EQ(number(rec), 2);
+    CHECK_EQ(forward.segment, 1);
+
+    // segment 4 is started and segment 1 deleted, under the open reader
+    CHECK(log.append(message(next++)));
+    CHECK(!fs.exists(LORA_LOG_DIR "/00001.bin"));
+    CHECK(log.readAfter(forward, rec));
+    CHECK_EQ(number(rec), PER_SEGMENT);
+    CHECK_EQ(forward.segment, 2);
+
+    // segment 2 goes too while open: going back from it ends, going forward jumps to segment 3
+    for (int n = 0; n < PER_SEGMENT; n++) CHECK(log.append(message(next++)));
+    CHECK(!fs.exists(LORA_LOG_DIR "/00002.bin"));
+    CHECK(!log.readBefore(backward, rec));
+    CHECK(log.readAfter(forward, rec));
+    CHECK_EQ(number(rec), 2 * PER_SEGMENT);
+    CHECK_EQ(forward.segment, 3);
+}
+
+int main() {
+    testRecords();
+    testRotation();
+    testSegmentDeletedWhileReading();
+    return testResult("lora_log");
+}
@@ -0,0 +1,123 @@
+#include "modules/others/mic_dsp.h"
+#include "test_common.h"
+#include <math.h>
+#include <vector>
+
+static std::vector<int16_t> tone(uint16_t size, float bin, float amplitude) {
+    std::vector<int16_t> samples(size);
+    for (uint16_t i = 0; i < size; i++) {
+        samples[i] = (int16_t)lrintf(amplitude * 32767.0f * sinf(2.0f * (float)M_PI * bin * i / size));
+    }
+    return samples;
+}
+
+static int peakBin(const uint8_t *levels, uint16_t bins) {
+    int peak = 0;
+    for (uint16_t i = 1; i < bins; i++) {
+        if (levels[i] > levels[peak]) peak = i;
+    }
+    return peak + 1; // levels[0] is bin 1
+}
+
+static void testBegin() {
+    SpectrumDsp dsp;
+    CHECK(!dsp.begin(0));
+    CHECK(!dsp.begin(100));
+    CHECK(dsp.begin(256));
+    CHECK_EQ(dsp.size(), 256);
+    CHECK(dsp.begin(1024)); // a new size replaces the plan
+    CHECK_EQ(dsp.size(), 1024);
+}
+
+// A full scale sine on a bin peaks at 1.0 and level 255, Hann puts a quarter in each neighbour
+static void testTones() {
+    const uint16_t size = 512;
+    SpectrumDsp dsp;
+    CHECK(dsp.begin(size));
+    uint8_t levels[size / 2];
+    for (uint16_t bin : {3, 40, 128, 250}) {
+        std::vector<int16_t> samples = tone(size, bin, 1.0f);
+        dsp.process(samples.data(), levels, size / 2 - 1);
+        CHECK_EQ(peakBin(levels, size / 2 - 1), bin);
+        CHECK(fabsf(dsp.power(bin) - 1.0f) < 0.01f);
+        CHECK(fabsf(dsp.power(bin + 1) - 0.25f) < 0.01f);
+        CHECK(levels[bin - 1] >= 254);
+        // two bins away Hann leaves almost nothing
+        if (bin + 3 < size / 2) CHECK(dsp.power(bin + 3) < 1e-4f);
+    }
+
+    // half the amplitude is 6 dB down
+    std::vector<int16_t> half = tone(size, 64, 0.5f);
+    dsp.process(half.data(), levels, size / 2 - 1);
+    const float db = 10.0f * log10f(dsp.power(64));
+    CHECK(fabsf(db + 6.02f) < 0.1f);
+    const int expected = (int)((db - MIC_SPECTRUM_FLOOR_DB) * 255.0f / -MIC_SPECTRUM_FLOOR_DB);
+    CHECK(abs(levels[63] - expected) <= 1);
+
+    // between two bins both get the tone, scalloping stays under 1.5 dB
+    std::vector<int16_t> between = tone(size, 100.5f, 1.0f);
+    dsp.process(between.data(), levels, size / 2 - 1);
+    CHECK(10.0f * log10f(dsp.power(100)) > -1.5f);
+    CHECK(10.0f * log10f(dsp.power(101)) > -1.5f);
+}
+
+static void testSilenceAndClamp() {
+    SpectrumDsp dsp;
+    CHECK(dsp.begin(256));
+    std::vector<int16_t> silence(256, 0);
+    uint8_t levels[200];
+    memset(levels, 0xAA, sizeof(levels));
+    dsp.process(silence.data(), levels, 200); // clamped to 127 bins
+    for (int i = 0; i < 127; i++) CHECK_EQ(levels[i], 0);
+    CHECK_EQ(levels[127], 0xAA);
+}
+
+// The transform against a direct DFT of the windowed frame
+static void testAgainstDft() {
+    const uint16_t size = 128;
+    std::vector<int16_t> samples(size);
+    uint32_t seed = 5;
+    for (int16_t &s : samples) {
+        seed = seed * 1103515245 + 12345;
+        s = (int16_t)(seed >> 16);
+    }
+    SpectrumDsp dsp;
+    CHECK(dsp.begin(size));
+    uint8_t levels[size / 2];
+    dsp.process(samples.data(), levels, size / 2 - 1);
+
+    for (uint16_t k = 0; k < size / 2; k++) {
+        double re = 0, im = 0;
+        for (uint16_t i = 0; i < size; i++) {
+            double w = 4.0 / size / 32768.0 * 0.5 * (1.0 - cos(2.0 * M_PI * i / size));
+            re += samples[i] * w * cos(2.0 * M_PI * k * i / size);
+            im -= samples[i] * w * sin(2.0 * M_PI * k * i / size);
+        }
+        double power = re * re + im * im;
+        CHECK(fabs(dsp.power(k) - power) <= 1e-4 * (power + 1e-6));
+    }
+}
+
+// Frames per second for the sizes the spectrum screen uses
+static void benchmark() {
+    for (uint16_t size : {256, 512, 1024}) {
+        SpectrumDsp dsp;
+        CHECK(dsp.begin(size));
+        std::vector<int16_t> samples = tone(size, 17, 0.7f);
+        std::vector<uint8_t> levels(size / 2);
+        const int frames = 2000;
+        const double start = testMillis();
+        for (int f = 0; f < frames; f++) dsp.process(samples.data(), levels.data(), size / 2 - 1);
+        const double ms = testMillis() - start;
+        printf("%u point frames: %.1f us each\n", size, ms * 1000.0 / frames);
+    }
+}
+
+int main() {
+    testBegin();
+    testTones();
+    testSilenceAndClamp();
+    testAgainstDft();
+    benchmark();
+    return testResult("mic_dsp");
+}
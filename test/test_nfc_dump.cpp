@@ -0,0 +1,200 @@
+#include "modules/rfid/nfc_dump.h"
+#include "test_common.h"
+#include <string>
+#include <vector>
+
+static std::vector<std::string> writeLines(const NfcUid &uid, const NfcDump &dump) {
+    std::vector<std::string> lines;
+    NfcDumpWriter writer(uid, dump);
+    char line[NFC_DUMP_LINE_SIZE];
+    while (writer.next(line, sizeof(line))) lines.push_back(line);
+    return lines;
+}
+
+static bool parseLines(const std::vector<std::string> &lines, NfcUid &uid, NfcDump &dump) {
+    NfcDumpParser parser(uid, dump);
+    for (const std::string &l : lines) parser.line(l.c_str());
+    return parser.finish();
+}
+
+static void fillTag(NfcDump &dump, uint16_t pages, uint8_t pageSize, uint16_t skip = 0xFFFF) {
+    dump.reset(pages, pageSize);
+    uint8_t bytes[16];
+    for (uint16_t p = 0; p < pages; p++) {
+        if (p == skip) continue;
+        for (uint8_t i = 0; i < pageSize; i++) bytes[i] = p * 7 + i;
+        CHECK(dump.setPage(p, bytes));
+    }
+}
+
+static void testHex() {
+    uint8_t bytes[4];
+    CHECK_EQ(nfcHexToBytes("04 A1 b2", bytes, 4), 3);
+    CHECK_EQ(bytes[1], 0xA1);
+    CHECK_EQ(bytes[2], 0xB2);
+    CHECK_EQ(nfcHexToBytes("04A1B2FF\r\n", bytes, 4), 4);
+    CHECK_EQ(nfcHexToBytes("", bytes, 4), 0);
+    CHECK_EQ(nfcHexToBytes("04 ?? 00", bytes, 4), -1);
+    CHECK_EQ(nfcHexToBytes("04 A", bytes, 4), -1);
+    CHECK_EQ(nfcHexToBytes("01 02 03 04 05", bytes, 4), -1); // more than max
+
+    char text[8];
+    const uint8_t in[] = {0x04, 0xA1, 0xB2, 0x0F};
+    nfcBytesToHex(in, 2, text, sizeof(text));
+    CHECK_STR(text, "04 A1");
+    nfcBytesToHex(in, 4, text, sizeof(text)); // cut to whole bytes
+    CHECK_STR(text, "04 A1");
+}
+
+static void testWriter() {
+    NfcUid uid = {7, {0x04, 0x5A, 0x6B, 0x12, 0x34, 0x56, 0x80}, 0x00, {0x00, 0x44}};
+    NfcDump dump;
+    fillTag(dump, 3, 4, 1);
+    dump.setType("NTAG213");
+    const std::vector<std::string> expected = {
+        "Filetype: Bruce RFID File",
+        "Version 1",
+        "Device type: NTAG213",
+        "# UID, ATQA and SAK are common for all formats",
+        "UID: 04 5A 6B 12 34 56 80",
+        "SAK: 00",
+        "ATQA: 00 44",
+        "# Memory dump",
+        "Pages total: 3",
+        "Pages read: 2",
+        "Page 0: 00 01 02 03",
+        "Page 2: 0E 0F 10 11",
+    };
+    CHECK(writeLines(uid, dump) == expected);
+}
+
+// Written and parsed back, every tag family gives the same image
+static void testRoundTrip() {
+    struct Tag {
+        const char *type;
+        uint16_t pages;
+        uint8_t pageSize;
+        uint16_t skip;
+        bool felica;
+    } tags[] = {
+        {"NTAG215", 135, 4, 0xFFFF, false},
+        {"MIFARE 1KB", 64, 16, 3, false},
+        {"MIFARE 4KB", 256, 16, 0xFFFF, false},
+        {"FeliCa", 14, 16, 0xFFFF, true},
+    };
+    for (const Tag &t : tags) {
+        NfcUid uid = {4, {0xDE, 0xAD, 0xBE, 0xEF}, 0x08, {0x00, 0x04}};
+        static NfcDump dump, back;
+        fillTag(dump, t.pages, t.pageSize, t.skip);
+        dump.setType(t.type);
+        dump.felica = t.felica;
+        if (t.felica) {
+            const uint8_t pmm[8] = {0x01, 0x20, 0x22, 0x04, 0x27, 0x67, 0x4E, 0xFF};
+            memcpy(dump.pmm, pmm, sizeof(pmm));
+        }
+
+        NfcUid uidBack;
+        CHECK(parseLines(writeLines(uid, dump), uidBack, back));
+        CHECK(back.sameData(dump));
+        CHECK_STR(back.type, t.type);
+        CHECK_EQ(back.felica, t.felica);
+        CHECK(memcmp(back.pmm, dump.pmm, sizeof(dump.pmm)) == 0);
+        CHECK_EQ(uidBack.size, 4);
+        CHECK(memcmp(uidBack.uidByte, uid.uidByte, 4) == 0);
+        if (!t.felica) {
+            CHECK_EQ(uidBack.sak, 0x08);
+            CHECK_EQ(uidBack.atqaByte[1], 0x04);
+        }
+        CHECK_EQ(back.complete(), t.skip == 0xFFFF);
+    }
+}
+
+// A Flipper .nfc: unknown keys are skipped, "??" pages stay unread, the layout comes from Pages total
+static void testFlipper() {
+    const char *lines[] = {
+        "Filetype: Flipper NFC device\r\n",
+        "Version: 4\r\n",
+        "Device type: NTAG213\r\n",
+        "UID: 04 85 92 8A A0 61 81\r\n",
+        "ATQA: 00 44\r\n",
+        "SAK: 00\r\n",
+        "Signature: 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00\r\n",
+        "Pages total: 45\r\n",
+        "Pages read: 45\r\n",
+        "Page 0: 04 85 92 9B\r\n",
+        "Page 1: 8A A0 61 81\r\n",
+        "Page 2: CA 48 00 00\r\n",
+        "Page 3: ?? ?? ?? ??\r\n",
+        "Page 4: 03 00 FE 00\r\n",
+        "Page 65540: 01 02 03 04\r\n", // out of range, not page 4
+        "Page x: 01 02 03 04\r\n",
+    };
+    NfcUid uid;
+    static NfcDump dump;
+    NfcDumpParser parser(uid, dump);
+    for (const char *l : lines) parser.line(l);
+    CHECK(parser.finish());
+    CHECK_STR(dump.type, "NTAG213");
+    CHECK_EQ(uid.size, 7);
+    CHECK_EQ(dump.pageSize, 4);
+    CHECK_EQ(dump.totalPages, 45);
+    CHECK_EQ(dump.pagesRead(), 4);
+    CHECK(!dump.hasPage(3));
+    CHECK_EQ(dump.page(4)[0], 0x03);
+    CHECK_EQ(dump.page(4)[2], 0xFE);
+
+    // no UID, no dump
+    NfcDumpParser empty(uid, dump);
+    empty.line("Pages total: 45");
+    CHECK(!empty.finish());
+}
+
+static void testLimits() {
+    static NfcDump dump;
+    uint8_t bytes[16] = {};
+    dump.reset(0, 16);
+    CHECK(dump.setPage(255, bytes));
+    CHECK_EQ(dump.totalPages, 256);
+    CHECK(!dump.setPage(256, bytes));
+    dump.reset(1000, 4);
+    CHECK_EQ(dump.totalPages, NFC_DUMP_MAX_PAGES);
+    dump.reset(0, 0);
+    CHECK(!dump.setPage(0, bytes)); // no layout yet
+    dump.setType("A very long tag type name that does not fit at all");
+    CHECK_EQ(strlen(dump.type), sizeof(dump.type) - 1);
+}
+
+// A MIFARE 4K dump written and parsed the way save and load stream it
+static void benchmark() {
+    NfcUid uid = {4, {0xDE, 0xAD, 0xBE, 0xEF}, 0x18, {0x00, 0x02}};
+    static NfcDump dump, back;
+    fillTag(dump, 256, 16);
+    dump.setType("MIFARE 4KB");
+    const int runs = 200;
+    size_t bytes = 0;
+    const double start = testMillis();
+    for (int r = 0; r < runs; r++) {
+        NfcDumpWriter writer(uid, dump);
+        NfcUid uidBack;
+        NfcDumpParser parser(uidBack, back);
+        char line[NFC_DUMP_LINE_SIZE];
+        while (writer.next(line, sizeof(line))) {
+            bytes += strlen(line) + 1;
+            parser.line(line);
+        }
+        CHECK(parser.finish());
+    }
+    const double ms = testMillis() - start;
+    CHECK(back.sameData(dump));
+    printf("MIFARE 4K, %zu byte file: write and parse %.1f us\n", bytes / runs, ms * 1000 / runs);
+}
+
+int main() {
+    testHex();
+    testWriter();
+    testRoundTrip();
+    testFlipper();
+    testLimits();
+    benchmark();
+    return testResult("nfc_dump");
+}
@@ -0,0 +1,61 @@
+#include "modules/rf/rf_tuning.h"
+#include "test_common.h"
+#include <math.h>
+
+// FREQ words from the CC1101 datasheet and SmartRF Studio, 26 MHz crystal
+static void testKnownWords() {
+    CHECK_EQ(cc1101FreqWord(433.92f), 0x10B071);
+    CHECK_EQ(cc1101FreqWord(315.0f), 0x0C1D8A);
+    CHECK_EQ(cc1101FreqWord(868.0f), 0x216276);
+    CHECK_EQ(cc1101FreqWord(915.0f), 0x23313B);
+    CHECK_EQ(cc1101FreqWord(0), 0);
+}
+
+// The word is the nearest one: the carrier it gives is within half a step (~198 Hz) over the bands
+static void testRounding() {
+    const double stepMHz = CC1101_XOSC_MHZ / 65536.0;
+    double worst = 0;
+    uint32_t previous = 0;
+    for (float mhz = 280.0f; mhz <= 928.0f; mhz += 0.0137f) {
+        uint32_t word = cc1101FreqWord(mhz);
+        double error = fabs(cc1101WordMHz(word) - (double)mhz);
+        if (error > worst) worst = error;
+        CHECK(word >= previous);
+        previous = word;
+    }
+    // float carriers add a few Hz to the half step
+    CHECK(worst <= stepMHz / 2 + 0.0001);
+    printf("worst FREQ word error %.1f Hz, step %.1f Hz\n", worst * 1e6, stepMHz * 1e6);
+
+    for (uint32_t word : {0x0C1D8Au, 0x10B071u, 0x23313Bu}) {
+        CHECK_EQ(cc1101FreqWord(cc1101WordMHz(word)), word);
+    }
+}
+
+// A 10 kHz scan wider than the cache keeps its range, with fewer channels
+static void testSpread() {
+    float step = 0.01f;
+    uint16_t count = 100;
+    rfSweepSpread(step, count);
+    CHECK_EQ(count, 100);
+    CHECK(step == 0.01f);
+
+    step = 0.01f;
+    count = (uint16_t)((348.0f - 300.0f) / 0.01f + 0.5f) + 1; // 4801
+    rfSweepSpread(step, count);
+    CHECK_EQ(count, RF_TUNING_MAX_CHANNELS);
+    CHECK(fabsf(300.0f + (count - 1) * step - 348.0f) < 0.001f);
+
+    step = 0.01f;
+    count = RF_TUNING_MAX_CHANNELS + 1;
+    rfSweepSpread(step, count);
+    CHECK_EQ(count, RF_TUNING_MAX_CHANNELS);
+    CHECK(step > 0.01f);
+}
+
+int main() {
+    testKnownWords();
+    testRounding();
+    testSpread();
+    return testResult("rf_tuning");
+}
@@ -0,0 +1,147 @@
+#include "modules/rf/sub_file.h"
+#include "test_common.h"
+#include <vector>
+
+static std::vector<int> makeSignal(size_t count, unsigned seed) {
+    std::vector<int> values;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        int duration = 50 + (seed >> 16) % 20000;
+        values.push_back(i % 2 ? -duration : duration);
+    }
+    return values;
+}
+
+static std::vector<int> readAll(File &file, size_t step) {
+    SubFileReader reader(file);
+    std::vector<int> values;
+    std::vector<int> buf(step);
+    size_t n;
+    while ((n = reader.readRaw(buf.data(), step)) > 0) {
+        values.insert(values.end(), buf.begin(), buf.begin() + n);
+    }
+    return values;
+}
+
+static void testRoundTrip() {
+    const std::vector<int> signal = makeSignal(1300, 1);
+    File file;
+    {
+        SubFileWriter writer(file);
+        writer.writeHeader(433920000, "FuriHalSubGhzPresetOok650Async", "RAW");
+        for (int value : signal) writer.writeRaw(value);
+        writer.writeRaw(0); // dropped, 0 is not a duration
+        CHECK(writer.finish());
+    }
+
+    // Header, then the values split in lines of 512
+    SubFileReader reader(file);
+    file.seek(0);
+    char key[16];
+    String value;
+    CHECK(reader.nextKey(key, sizeof(key)));
+    CHECK_STR(key, "Filetype");
+    reader.readValue(value);
+    CHECK_STR(value.c_str(), "Bruce SubGhz File");
+    CHECK(reader.nextKey(key, sizeof(key)));
+    CHECK_STR(key, "Frequency");
+    reader.readValue(value);
+    CHECK_EQ(value.toInt(), 433920000);
+    CHECK(reader.nextKey(key, sizeof(key)));
+    CHECK_STR(key, "Preset");
+    CHECK(reader.nextKey(key, sizeof(key))); // value not read, the rest of the line is skipped
+    CHECK_STR(key, "Protocol");
+    int rawLines = 0;
+    while (reader.nextKey(key, sizeof(key))) rawLines += strcmp(key, "RAW_Data") == 0;
+    CHECK_EQ(rawLines, 3);
+
+    for (size_t step : {1, 7, 512, 4096}) {
+        file.seek(0);
+        CHECK(readAll(file, step) == signal);
+    }
+}
+
+static void testResplit() {
+    // Old scans kept everything in one line
+    std::string line;
+    const std::vector<int> signal = makeSignal(1100, 2);
+    for (int value : signal) line += std::to_string(value) + " ";
+
+    File file;
+    SubFileWriter writer(file);
+    CHECK_EQ(writer.writeRaw(line.c_str()), signal.size());
+    CHECK(writer.finish());
+
+    size_t lines = 0, pos = 0;
+    while ((pos = file.data.find("RAW_Data: ", pos)) != std::string::npos) {
+        lines++;
+        pos++;
+    }
+    CHECK_EQ(lines, 3);
+    file.seek(0);
+    CHECK(readAll(file, 100) == signal);
+}
+
+static void testReaderEdgeCases() {
+    File file("Filetype: Flipper SubGhz RAW File\r\n"
+              "Version 1\r\n"
+              "Protocol: RAW\r\n"
+              "RAW_Data: 100 -200   300\r\n"
+              "Comment: not raw 999\r\n"
+              "RAW_Data:-400 0 500"); // no trailing newline, 0 is skipped
+    CHECK(readAll(file, 2) == std::vector<int>({100, -200, 300, -400, 500}));
+
+    int values[8];
+    const char *end;
+    CHECK_EQ(SubFileReader::parseRaw("10 -20, x 30", values, 8, &end), 3);
+    CHECK_EQ(values[2], 30);
+    CHECK_EQ(SubFileReader::parseRaw("10 20 30", values, 2, &end), 2);
+    CHECK_STR(end, " 30");
+}
+
+static void testWriteFailure() {
+    File file;
+    file.failWrites = true;
+    SubFileWriter writer(file);
+    writer.writeHeader(315000000, "Ook270", "RAW");
+    CHECK(!writer.finish());
+}
+
+// A long recording, written and read back the way record and send do it
+static void benchmark() {
+    const std::vector<int> signal = makeSignal(200000, 3);
+    File file;
+    double start = testMillis();
+    {
+        SubFileWriter writer(file);
+        writer.writeHeader(433920000, "FuriHalSubGhzPresetOok650Async", "RAW");
+        for (int value : signal) writer.writeRaw(value);
+        CHECK(writer.finish());
+    }
+    const double writeMs = testMillis() - start;
+    const size_t writes = file.writeCalls;
+
+    file.seek(0);
+    start = testMillis();
+    std::vector<int> back = readAll(file, 2048);
+    const double readMs = testMillis() - start;
+    CHECK(back == signal);
+    printf(
+        "%zu values, %zu KB: write %.1f ms in %zu calls, read %.1f ms in %zu calls\n",
+        signal.size(),
+        file.size() / 1024,
+        writeMs,
+        writes,
+        readMs,
+        file.readCalls
+    );
+}
+
+int main() {
+    testRoundTrip();
+    testResplit();
+    testReaderEdgeCases();
+    testWriteFailure();
+    benchmark();
+    return testResult("sub_file");
+}
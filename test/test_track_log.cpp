@@ -0,0 +1,192 @@
+#include "modules/gps/track_log.h"
+#include "test_common.h"
+#include <math.h>
+#include <string>
+#include <vector>
+
+static void append(void *ctx, const char *text, size_t len) {
+    static_cast<std::string *>(ctx)->append(text, len);
+}
+
+static size_t countOf(const std::string &text, const char *what) {
+    size_t n = 0;
+    for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1)) n++;
+    return n;
+}
+
+static std::string exportPoints(TrackFormat format, const std::vector<TrackPoint> &points) {
+    std::string text;
+    TrackExporter exporter(format, append, &text);
+    exporter.begin("Walk");
+    for (const TrackPoint &p : points) exporter.point(p);
+    exporter.end();
+    return text;
+}
+
+static void testRecords() {
+    CHECK_EQ(trackUnixTime(2024, 11, 20, 12, 34, 56), 1732106096);
+    CHECK_EQ(trackUnixTime(2000, 2, 29, 0, 0, 0), 951782400);
+    CHECK_EQ(trackUnixTime(1969, 12, 31, 23, 59, 59), 0);
+    CHECK_EQ(trackUnixTime(2024, 13, 1, 0, 0, 0), 0);
+
+    char buf[24];
+    for (uint32_t time : {0u, 951782400u, 1732106096u, 4294967295u}) {
+        int y, mo, d, h, mi, s;
+        trackFormatTime(time, buf, sizeof(buf));
+        CHECK(sscanf(buf, "%d-%d-%dT%d:%d:%dZ", &y, &mo, &d, &h, &mi, &s) == 6);
+        if (time) CHECK_EQ(trackUnixTime(y, mo, d, h, mi, s), time);
+    }
+    trackFormatTime(1732106096, buf, sizeof(buf));
+    CHECK_STR(buf, "2024-11-20T12:34:56Z");
+
+    trackFormatCoord(-1234567, buf, sizeof(buf));
+    CHECK_STR(buf, "-0.1234567");
+    trackFormatCoord(1800000000, buf, sizeof(buf));
+    CHECK_STR(buf, "180.0000000");
+    trackFormatCoord(INT32_MIN, buf, sizeof(buf));
+    CHECK_STR(buf, "-214.7483648");
+
+    TrackPoint p = trackPoint(1, -23.5505199, -46.6333094, 40000, 30.0, 200);
+    CHECK_EQ(p.lat, -235505199);
+    CHECK_EQ(p.lon, -466333094);
+    CHECK_EQ(p.alt, 32767);
+    CHECK_EQ(p.hdop, 255);
+    CHECK_EQ(p.info, TRACK_INFO_SATS);
+    p = trackPoint(1, 0, 0, -12.6, 1.24, 9);
+    CHECK_EQ(p.alt, -13);
+    CHECK_EQ(p.hdop, 12);
+    CHECK_EQ(p.info, 9);
+}
+
+static std::vector<TrackPoint> simplify(const std::vector<TrackPoint> &points, float tolerance) {
+    TrackSimplifier simplifier(tolerance);
+    std::vector<TrackPoint> kept;
+    TrackPoint out[2];
+    for (const TrackPoint &p : points) {
+        uint8_t n = simplifier.push(p, out);
+        kept.insert(kept.end(), out, out + n);
+    }
+    kept.insert(kept.end(), out, out + simplifier.finish(out));
+    return kept;
+}
+
+// Walking north at about 1.1 m/s, then east, with a fix every second
+static std::vector<TrackPoint> walk(int north, int east) {
+    std::vector<TrackPoint> points;
+    uint32_t time = 1732106096;
+    for (int i = 0; i <= north; i++) points.push_back(trackPoint(time++, 38.7 + i * 1e-5, -9.1, 10, 0.9, 8));
+    for (int i = 1; i <= east; i++) {
+        points.push_back(trackPoint(time++, 38.7 + north * 1e-5, -9.1 + i * 1e-5, 10, 0.9, 8));
+    }
+    return points;
+}
+
+static void testSimplifier() {
+    // two straight legs: the ends and a point at the corner, a couple of meters past it at most
+    std::vector<TrackPoint> points = walk(20, 20);
+    std::vector<TrackPoint> kept = simplify(points, TRACK_SIMPLIFY_M);
+    CHECK_EQ(kept.size(), 3);
+    CHECK_EQ(kept[0].lat, points[0].lat);
+    CHECK(kept[1].time >= points[20].time && kept[1].time <= points[22].time);
+    CHECK_EQ(kept[2].time, points.back().time);
+
+    kept = simplify(walk(100, 0), TRACK_SIMPLIFY_M);
+    CHECK_EQ(kept.size(), 5); // 0, 31, 62, 93 and 100
+    for (size_t i = 1; i < kept.size(); i++) CHECK(kept[i].time - kept[i - 1].time < TRACK_SIMPLIFY_WINDOW);
+
+    // standing still for 5 minutes still leaves a point every TRACK_SIMPLIFY_MAX_SPAN_S
+    points.clear();
+    for (int i = 0; i <= 300; i++) points.push_back(trackPoint(1000 + i, 38.7, -9.1, 10, 0.9, 8));
+    kept = simplify(points, TRACK_SIMPLIFY_M);
+    for (size_t i = 1; i < kept.size(); i++) {
+        CHECK(kept[i].time - kept[i - 1].time <= TRACK_SIMPLIFY_MAX_SPAN_S);
+    }
+    CHECK_EQ(kept.back().time, 1300);
+
+    // a fix loss keeps both ends of the gap
+    points = walk(10, 0);
+    points[6].info |= TRACK_INFO_SEGMENT;
+    kept = simplify(points, TRACK_SIMPLIFY_M);
+    CHECK_EQ(kept.size(), 4);
+    CHECK_EQ(kept[1].time, points[5].time);
+    CHECK(kept[2].info & TRACK_INFO_SEGMENT);
+
+    CHECK_EQ(simplify(walk(10, 10), 0).size(), 21);
+}
+
+static void testExport() {
+    std::vector<TrackPoint> points = {
+        trackPoint(1732106096, 38.7223342, -9.1393366, 45, 0.8, 11),
+        trackPoint(1732106097, 38.7223500, -9.1393000, 46, 1.2, 10),
+        trackPoint(0, 38.7224000, -9.1392000, -3, 25.5, 4),
+    };
+    points[2].info |= TRACK_INFO_SEGMENT;
+
+    CHECK_STR(
+        exportPoints(TRACK_CSV, points).c_str(),
+        "time,latitude,longitude,altitude,hdop,satellites,segment\n"
+        "2024-11-20T12:34:56Z,38.7223342,-9.1393366,45,0.8,11,0\n"
+        "2024-11-20T12:34:57Z,38.7223500,-9.1393000,46,1.2,10,0\n"
+        ",38.7224000,-9.1392000,-3,25.5,4,1\n"
+    );
+
+    const std::string kml = exportPoints(TRACK_KML, points);
+    CHECK_EQ(countOf(kml, "<Placemark>"), 2);
+    CHECK_EQ(countOf(kml, "</Placemark>"), 2);
+    CHECK(kml.find("<name>Walk</name>") != std::string::npos);
+    CHECK(kml.find("          -9.1393366,38.7223342,45\n") != std::string::npos);
+    CHECK(kml.compare(kml.size() - 7, 7, "</kml>\n") == 0);
+
+    const std::string gpx = exportPoints(TRACK_GPX, points);
+    CHECK_EQ(countOf(gpx, "<trkseg>"), 2);
+    CHECK_EQ(countOf(gpx, "</trkseg>"), 2);
+    CHECK_EQ(countOf(gpx, "<trkpt "), 3);
+    CHECK_EQ(countOf(gpx, "<time>"), 2); // the point without a time has none
+    CHECK(gpx.find("<trkpt lat=\"38.7223342\" lon=\"-9.1393366\">") != std::string::npos);
+    CHECK(gpx.find("<hdop>25.5</hdop>") != std::string::npos);
+    CHECK(gpx.compare(gpx.size() - 7, 7, "</gpx>\n") == 0);
+
+    // an empty track is still a valid document
+    CHECK_EQ(countOf(exportPoints(TRACK_GPX, {}), "<trkseg>"), 0);
+    CHECK_STR(TrackExporter::extension(TRACK_KML), ".kml");
+}
+
+// A day of fixes at 1 Hz, simplified and exported the way the logger and exportTrack do it
+static void benchmark() {
+    std::vector<TrackPoint> points;
+    double lat = 38.7, lon = -9.1, heading = 0;
+    uint32_t seed = 3;
+    for (uint32_t i = 0; i < 86400; i++) {
+        seed = seed * 1103515245 + 12345;
+        heading += ((int)(seed >> 16) % 200 - 100) * 0.0005;
+        lat += 1e-5 * cos(heading);
+        lon += 1e-5 * sin(heading);
+        points.push_back(trackPoint(1732106096 + i, lat, lon, 10, 0.9, 8));
+    }
+    double start = testMillis();
+    std::vector<TrackPoint> kept = simplify(points, TRACK_SIMPLIFY_M);
+    const double simplifyMs = testMillis() - start;
+    CHECK(kept.size() < points.size() / 4);
+
+    start = testMillis();
+    const std::string gpx = exportPoints(TRACK_GPX, kept);
+    const double gpxMs = testMillis() - start;
+    CHECK_EQ(countOf(gpx, "<trkpt "), kept.size());
+    printf(
+        "%zu fixes: %zu kept (%zu KB of .trk) in %.1f ms, GPX %zu KB in %.1f ms\n",
+        points.size(),
+        kept.size(),
+        kept.size() * sizeof(TrackPoint) / 1024,
+        simplifyMs,
+        gpx.size() / 1024,
+        gpxMs
+    );
+}
+
+int main() {
+    testRecords();
+    testSimplifier();
+    testExport();
+    benchmark();
+    return testResult("track_log");
+}
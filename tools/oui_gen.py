@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Builds the offline MAC vendor database (oui.bin) read by src/core/oui_db.cpp.
+
+    oui_gen.py oui.csv mam.csv oui36.csv -o oui.bin
+    oui_gen.py oui.csv mam.csv oui36.csv -o oui.bin --bench 100000
+
+The CSV files are the IEEE registries, download them from
+https://standards-oui.ieee.org/oui/oui.csv, .../oui28/mam.csv and
+.../oui36/oui36.csv. Copy oui.bin to the root of the SD card or LittleFS.
+
+--bench runs random lookups against the written file with the same page
+index and binary search as the firmware, checks every answer against the
+CSV data and prints lookups per second and bytes read per lookup.
+"""
+import argparse
+import csv
+import os
+import random
+import struct
+import sys
+import time
+
+MAGIC = b"OUI1"
+HEADER = struct.Struct("<4s7I")
+BITS = {"MA-L": 24, "MA-M": 28, "MA-S": 36}
+TABLES = ("MA-L", "MA-M", "MA-S")
+SPLIT_FLAG = 0x800000
+ENTRY = 8
+KEY = 5
+NAME_MAX = 96  # the firmware reads at most this many bytes of a name
+
+
+def key_of(assignment, bits):
+    return int(assignment, 16) << (40 - bits)
+
+
+def read_registry(path):
+    """Returns {(table, key): name} for one IEEE CSV file."""
+    entries = {}
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            table = row["Registry"].strip()
+            if table not in BITS:
+                continue
+            name = " ".join(row["Organization Name"].split())
+            entries[(table, key_of(row["Assignment"].strip(), BITS[table]))] = name
+    return entries
+
+
+def build(entries, page, max_name):
+    tables = {t: {} for t in TABLES}
+    for (table, key), name in entries.items():
+        tables[table][key] = name[:max_name] if max_name else name
+
+    # OUIs split into MA-M / MA-S blocks are flagged so the firmware only searches those tables for them
+    split = {key & ~((1 << 16) - 1) for t in ("MA-M", "MA-S") for key in tables[t]}
+    for key in split:
+        tables["MA-L"].setdefault(key, "IEEE Registration Authority")
+
+    strings = bytearray()
+    offsets = {}
+
+    def name_offset(name):
+        if name not in offsets:
+            offsets[name] = len(strings)
+            strings.extend(name.encode("utf-8")[: NAME_MAX - 1] + b"\0")
+        return offsets[name]
+
+    index = bytearray()
+    body = bytearray()
+    counts = []
+    for table in TABLES:
+        keys = sorted(tables[table])
+        counts.append(len(keys))
+        for i, key in enumerate(keys):
+            if i % page == 0:
+                index += key.to_bytes(KEY, "big")
+            off = name_offset(tables[table][key])
+            if table == "MA-L" and key in split:
+                off |= SPLIT_FLAG
+            body += key.to_bytes(KEY, "big") + off.to_bytes(3, "little")
+    if len(strings) >= SPLIT_FLAG:
+        sys.exit("string table too large, use --max-name")
+
+    strings_offset = HEADER.size + len(index) + len(body)
+    header = HEADER.pack(MAGIC, *counts, page, strings_offset, len(strings), 0)
+    return header + index + body + strings, counts
+
+
+class Reader:
+    """Mirror of OuiDb::lookup without the cache, counts the bytes it reads."""
+
+    def __init__(self, path):
+        self.f = open(path, "rb")
+        magic, *counts, self.page, self.strings, self.strings_size, _ = HEADER.unpack(
+            self.f.read(HEADER.size)
+        )
+        assert magic == MAGIC
+        self.tables = []
+        pages = [(c + self.page - 1) // self.page for c in counts]
+        index = self.f.read(sum(pages) * KEY)
+        offset = HEADER.size + len(index)
+        for count, npages in zip(counts, pages):
+            keys = [int.from_bytes(index[i * KEY : (i + 1) * KEY], "big") for i in range(npages)]
+            index = index[npages * KEY :]
+            self.tables.append((count, offset, keys))
+            offset += count * ENTRY
+        self.bytes_read = 0
+
+    def find(self, table, key):
+        count, offset, pages = self.tables[table]
+        lo, hi, page = 0, len(pages) - 1, -1
+        while lo <= hi:
+            mid = (lo + hi) // 2
+            if pages[mid] <= key:
+                page, lo = mid, mid + 1
+            else:
+                hi = mid - 1
+        if page < 0:
+            return None
+        entries = min(self.page, count - page * self.page)
+        self.f.seek(offset + page * self.page * ENTRY)
+        buf = self.f.read(entries * ENTRY)
+        self.bytes_read += len(buf)
+        lo, hi = 0, entries - 1
+        while lo <= hi:
+            mid = (lo + hi) // 2
+            k = int.from_bytes(buf[mid * ENTRY : mid * ENTRY + KEY], "big")
+            if k == key:
+                return int.from_bytes(buf[mid * ENTRY + KEY : (mid + 1) * ENTRY], "little")
+            if k < key:
+                lo = mid + 1
+            else:
+                hi = mid - 1
+        return None
+
+    def name(self, offset):
+        self.f.seek(self.strings + offset)
+        raw = self.f.read(min(NAME_MAX, self.strings_size - offset))
+        self.bytes_read += len(raw)
+        return raw.split(b"\0", 1)[0].decode("utf-8", errors="replace")
+
+    def lookup(self, mac40):
+        off = self.find(0, mac40 & ~((1 << 16) - 1))
+        if off is None:
+            return ""
+        if off & SPLIT_FLAG:
+            sub = self.find(1, mac40 & ~((1 << 12) - 1))
+            if sub is None:
+                sub = self.find(2, mac40 & ~((1 << 4) - 1))
+            if sub is not None:
+                off = sub
+        return self.name(off & ~SPLIT_FLAG)
+
+
+def expected(entries, mac40, max_name):
+    for table in ("MA-M", "MA-S", "MA-L"):
+        bits = BITS[table]
+        name = entries.get((table, mac40 & ~((1 << (40 - bits)) - 1)))
+        if name is not None:
+            name = name[:max_name] if max_name else name
+            return name.encode("utf-8")[: NAME_MAX - 1].decode("utf-8", errors="ignore")
+    return None
+
+
+def bench(path, entries, count, max_name):
+    reader = Reader(path)
+    prefixes = list(entries)
+    macs = []
+    for _ in range(count):
+        # mostly registered prefixes with random low bits, some random addresses
+        if random.random() < 0.9:
+            table, key = random.choice(prefixes)
+            mac40 = key | random.getrandbits(40 - BITS[table])
+        else:
+            mac40 = random.getrandbits(40) & ~(0x02 << 32)
+        macs.append(mac40)
+
+    started = time.perf_counter()
+    answers = [reader.lookup(mac40) for mac40 in macs]
+    elapsed = time.perf_counter() - started
+
+    wrong = 0
+    for mac40, answer in zip(macs, answers):
+        want = expected(entries, mac40, max_name)
+        if want is not None and answer != want:
+            wrong += 1
+    print(
+        "%d lookups, %.0f lookups/s on the host, %.0f bytes read per lookup, %d mismatches"
+        % (count, count / elapsed, reader.bytes_read / count, wrong)
+    )
+    return wrong == 0
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("csv", nargs="+", help="IEEE registry CSV files (MA-L, MA-M, MA-S)")
+    parser.add_argument("-o", "--output", default="oui.bin")
+    parser.add_argument("--page", type=int, default=64, help="entries per index page (max 128)")
+    parser.add_argument("--max-name", type=int, default=0, help="truncate vendor names, 0 keeps them")
+    parser.add_argument("--bench", type=int, default=0, metavar="N", help="run N random lookups")
+    args = parser.parse_args()
+    if not 1 <= args.page <= 128:
+        sys.exit("--page must be between 1 and 128")
+
+    entries = {}
+    for path in args.csv:
+        entries.update(read_registry(path))
+    data, counts = build(entries, args.page, args.max_name)
+    with open(args.output, "wb") as f:
+        f.write(data)
+    print(
+        "%s: %d MA-L, %d MA-M, %d MA-S, %d bytes"
+        % (args.output, counts[0], counts[1], counts[2], os.path.getsize(args.output))
+    )
+    if args.bench and not bench(args.output, entries, args.bench, args.max_name):
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Host side of "storage get" / "storage put" over USB serial.
+
+    serial_transfer.py PORT get /BrucePCAP/raw_0.pcap [local] [--resume]
+    serial_transfer.py PORT put local.bin /remote.bin [--resume]
+
+Frames and flow control match src/core/serial_commands/file_transfer.h.
+Needs pyserial (pip install pyserial, it comes with esptool and PlatformIO).
+"""
+import argparse
+import os
+import struct
+import sys
+import time
+import zlib
+
+import serial
+
+MAGIC = b"\xb5\x62"
+HEADER = struct.Struct("<BHI")  # type, len, offset
+TIMEOUT = 1.0
+MAX_RETRIES = 10
+
+
+class Link:
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+        self.text = bytearray()  # bytes skipped between frames, the device log lines
+
+    def send(self, ftype, offset, payload=b""):
+        body = HEADER.pack(ord(ftype), len(payload), offset) + payload
+        self.port.write(MAGIC + body + struct.pack("<I", zlib.crc32(body)))
+
+    def _fill(self, deadline):
+        while True:
+            waiting = self.port.in_waiting
+            if waiting:
+                self.buf += self.port.read(waiting)
+                return True
+            if time.monotonic() >= deadline:
+                return False
+            time.sleep(0.001)
+
+    def recv(self, wait):
+        """Returns (type, offset, payload), None on timeout, False on a damaged frame."""
+        deadline = time.monotonic() + wait
+        while True:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                keep = 1 if self.buf.endswith(MAGIC[:1]) else 0
+                self.text += self.buf[: len(self.buf) - keep]
+                del self.buf[: len(self.buf) - keep]
+            else:
+                self.text += self.buf[:start]
+                del self.buf[:start]
+                if len(self.buf) >= 2 + HEADER.size:
+                    ftype, length, offset = HEADER.unpack_from(self.buf, 2)
+                    if length > 4096:
+                        del self.buf[:2]
+                        return False
+                    end = 2 + HEADER.size + length + 4
+                    if len(self.buf) >= end:
+                        body = bytes(self.buf[2 : end - 4])
+                        (crc,) = struct.unpack_from("<I", self.buf, end - 4)
+                        if crc != zlib.crc32(body):
+                            del self.buf[:2]
+                            return False
+                        del self.buf[:end]
+                        return chr(ftype), offset, body[HEADER.size :]
+            if not self._fill(deadline):
+                return None if start < 0 else False
+            deadline = max(deadline, time.monotonic() + TIMEOUT)
+
+    def readline(self, wait=5.0):
+        deadline = time.monotonic() + wait
+        self.buf = self.text + self.buf
+        self.text = bytearray()
+        while b"\n" not in self.buf:
+            if not self._fill(deadline):
+                return None
+        line, _, rest = bytes(self.buf).partition(b"\n")
+        self.buf = bytearray(rest)
+        return line.decode(errors="replace").strip()
+
+
+def command(link, text):
+    link.port.write(text.encode() + b"\n")
+    while True:
+        line = link.readline()
+        if line is None:
+            sys.exit("no answer from the device")
+        if line.startswith("READY "):
+            return [int(v) for v in line.split()[2:]]
+        if line.startswith("ERROR"):
+            sys.exit(line)
+
+
+def receive(link, out, offset, size):
+    expected, nak_sent, timeouts = offset, False, 0
+    while True:
+        frame = link.recv(TIMEOUT)
+        if frame is None:
+            timeouts += 1
+            if timeouts > MAX_RETRIES:
+                link.send("X", expected, b"timeout")
+                return False
+            link.send("N", expected)
+            nak_sent = True
+            continue
+        timeouts = 0
+        if frame is False or (frame[0] == "D" and frame[1] > expected):
+            if not nak_sent:
+                link.send("N", expected)
+                nak_sent = True
+            continue
+        ftype, foffset, payload = frame
+        if ftype == "D":
+            if foffset == expected:
+                out.write(payload)
+                expected += len(payload)
+                nak_sent = False
+                progress(expected, size)
+            link.send("A", expected)
+        elif ftype == "E":
+            if foffset == expected == size:
+                link.send("E", size)
+                # answer repeated ends in case the echo got lost
+                while link.recv(TIMEOUT / 2) is not None:
+                    link.send("E", size)
+                return True
+            link.send("N", expected)
+        elif ftype == "X":
+            print("\ndevice aborted:", payload.decode(errors="replace"))
+            return False
+
+
+def send(link, src, offset, size, chunk, window):
+    acked = next_off = offset
+    retries, end_sent = 0, False
+    while True:
+        window_open = next_off < size and next_off - acked < window * chunk
+        if window_open:
+            src.seek(next_off)
+            data = src.read(min(chunk, size - next_off))
+            link.send("D", next_off, data)
+            next_off += len(data)
+        elif acked == size and not end_sent:
+            link.send("E", size)
+            end_sent = True
+
+        while True:
+            frame = link.recv(0 if window_open else TIMEOUT)
+            if not frame:
+                break
+            ftype, foffset, payload = frame
+            if ftype == "A" and acked < foffset <= next_off:
+                acked, retries = foffset, 0
+                progress(acked, size)
+            elif ftype == "N" and acked <= foffset <= next_off:
+                acked = next_off = foffset
+            elif ftype == "E" and foffset == size and end_sent:
+                return True
+            elif ftype == "X":
+                print("\ndevice aborted:", payload.decode(errors="replace"))
+                return False
+            if not window_open:
+                break
+        if frame is None and not window_open:
+            retries += 1
+            if retries > MAX_RETRIES:
+                link.send("X", acked, b"timeout")
+                return False
+            next_off, end_sent = acked, False
+
+
+last_progress = 0.0
+
+
+def progress(done, size):
+    global last_progress
+    now = time.monotonic()
+    if now - last_progress < 0.2 and done < size:
+        return
+    last_progress = now
+    sys.stdout.write("\r%d / %d bytes" % (done, size))
+    sys.stdout.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("port")
+    parser.add_argument("action", choices=["get", "put"])
+    parser.add_argument("src")
+    parser.add_argument("dst", nargs="?")
+    parser.add_argument("--resume", action="store_true", help="continue a partial transfer")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    port = serial.Serial(args.port, args.baud, timeout=0)
+    link = Link(port)
+    port.reset_input_buffer()
+    started = time.monotonic()
+
+    if args.action == "get":
+        local = args.dst or os.path.basename(args.src)
+        offset = os.path.getsize(local) if args.resume and os.path.exists(local) else 0
+        with open(local, "ab" if offset else "wb") as out:
+            size, offset, _, _ = command(link, "storage get %s %d" % (args.src, offset))
+            ok = receive(link, out, offset, size)
+    else:
+        remote = args.dst or "/" + os.path.basename(args.src)
+        size = os.path.getsize(args.src)
+        line = "storage put %s %d%s" % (remote, size, " -resume" if args.resume else "")
+        with open(args.src, "rb") as src:
+            _, offset, chunk, window = command(link, line)
+            ok = offset == size or send(link, src, offset, size, chunk, window)
+
+    elapsed = time.monotonic() - started
+    if ok:
+        moved = size - offset
+        print("\ndone: %d bytes in %.1f s, %.1f KB/s" % (moved, elapsed, moved / 1024 / elapsed))
+    else:
+        print("\nfailed, run again with --resume to continue")
+    # the device prints its own summary, the log lines before it may hold damaged frames
+    line = link.readline(3.0)
+    while line is not None:
+        if line.startswith(("GET ", "PUT ")):
+            print("device:", line)
+            break
+        line = link.readline(3.0)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
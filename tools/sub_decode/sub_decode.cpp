@@ -0,0 +1,197 @@
+/*
+ * sub_decode.cpp
+ *
+ * Host side of "subghz decode": splits RAW .sub files into pulse trains with
+ * the firmware's PulseTrainSplitter (src/modules/rf/pulse_train.h) and runs
+ * them through rtl_433. Also a regression / throughput check of the decoder
+ * pipeline, it reports trains/s and the decode hit rate.
+ *
+ * Usage:
+ *   sub_decode [-o out] [-q] <file.sub | folder>...
+ *
+ * Built against rtl_433 (https://github.com/merbanan/rtl_433, cmake build),
+ * every decoded message is a JSON line of out (default decoded.jsonl):
+ *   g++ -std=c++17 -O2 -DHAVE_RTL433 -Isrc/modules/rf -I$RTL433/include \
+ *       tools/sub_decode/sub_decode.cpp $RTL433/build/src/libr_433.a -lm -o sub_decode
+ *
+ * Without rtl_433 the trains are written as an rtl_433 pulse file instead
+ * (default trains.ook), to be decoded with: rtl_433 -r trains.ook -F json
+ *   g++ -std=c++17 -O2 -Isrc/modules/rf tools/sub_decode/sub_decode.cpp -o sub_decode
+ */
+
+#include "pulse_train.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_RTL433
+extern "C" {
+#include "pulse_data.h"
+#include "r_api.h"
+#include "r_private.h"
+}
+static r_cfg_t cfg;
+static pulse_data_t pd;
+#endif
+
+namespace fs = std::filesystem;
+
+struct Stats {
+    unsigned files = 0;
+    unsigned skipped = 0; // not RAW
+    unsigned trains = 0;
+    unsigned hits = 0;
+    unsigned messages = 0;
+    double seconds = 0;
+};
+
+static Stats stats;
+static RawTrain train;
+static FILE *out = nullptr;
+
+static void decodeTrain(uint32_t freqHz) {
+    stats.trains++;
+#ifdef HAVE_RTL433
+    memset(&pd, 0, sizeof(pd));
+    pd.num_pulses = train.num_pulses;
+    for (int i = 0; i < train.num_pulses; i++) {
+        pd.pulse[i] = train.pulse[i];
+        pd.gap[i] = train.gap[i];
+    }
+    pd.sample_rate = 1000000; // µs durations, as in buildPulseData()
+    pd.freq1_hz = freqHz;
+    int events = run_ook_demods(&cfg.demod->r_devs, &pd);
+    if (events > 0) {
+        stats.hits++;
+        stats.messages += events;
+    }
+#else
+    fprintf(out, ";pulse data\n;version 1\n;timescale 1us\n;freq1 %u\n", freqHz);
+    for (int i = 0; i < train.num_pulses; i++) fprintf(out, "%d %d\n", train.pulse[i], train.gap[i]);
+    fputs(";end\n", out);
+#endif
+}
+
+static bool decodeFile(const fs::path &path) {
+    FILE *f = fopen(path.string().c_str(), "r");
+    if (!f) return false;
+
+    PulseTrainSplitter splitter(train);
+    uint32_t freqHz = 433920000;
+    bool raw = false;
+    std::string line;
+    char buf[4096];
+    // RAW_Data lines hold up to 512 values, longer than buf, so lines are rebuilt
+    while (fgets(buf, sizeof(buf), f)) {
+        line += buf;
+        if (line.back() != '\n' && !feof(f)) continue;
+
+        const char *p = line.c_str();
+        if (!strncmp(p, "Frequency:", 10)) {
+            freqHz = strtoul(p + 10, nullptr, 10);
+        } else if (!strncmp(p, "Protocol:", 9)) {
+            raw = strstr(p + 9, "RAW") != nullptr;
+            if (!raw) break;
+        } else if (raw && !strncmp(p, "RAW_Data:", 9)) {
+            char *end;
+            p += 9;
+            for (long v = strtol(p, &end, 10); end != p; v = strtol(p, &end, 10)) {
+                p = end;
+                if (splitter.push((int)v)) decodeTrain(freqHz);
+            }
+        }
+        line.clear();
+    }
+    fclose(f);
+    if (!raw) {
+        stats.skipped++;
+        return false;
+    }
+    if (splitter.finish()) decodeTrain(freqHz);
+    stats.files++;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::vector<fs::path> inputs;
+    const char *outPath = nullptr;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc) outPath = argv[++i];
+        else if (!strcmp(argv[i], "-q")) quiet = true;
+        else inputs.emplace_back(argv[i]);
+    }
+    if (inputs.empty()) {
+        fprintf(stderr, "usage: %s [-o out] [-q] <file.sub | folder>...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<fs::path> files;
+    for (const fs::path &in : inputs) {
+        if (fs::is_directory(in)) {
+            for (const auto &e : fs::recursive_directory_iterator(in)) {
+                if (e.is_regular_file() && e.path().extension() == ".sub") files.push_back(e.path());
+            }
+        } else {
+            files.push_back(in);
+        }
+    }
+
+#ifdef HAVE_RTL433
+    r_init_cfg(&cfg);
+    register_all_protocols(&cfg, 0);
+    add_json_output(&cfg, (char *)(outPath ? outPath : "decoded.jsonl"));
+    start_outputs(&cfg, NULL);
+#else
+    out = fopen(outPath ? outPath : "trains.ook", "w");
+    if (!out) {
+        perror("output");
+        return 1;
+    }
+#endif
+
+    auto start = std::chrono::steady_clock::now();
+    for (const fs::path &f : files) {
+        unsigned before = stats.trains;
+        bool ok = decodeFile(f);
+        if (!quiet) {
+            fprintf(
+                stderr,
+                "%s: %s\n",
+                f.string().c_str(),
+                ok ? (std::to_string(stats.trains - before) + " trains").c_str() : "not RAW"
+            );
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+#ifdef HAVE_RTL433
+    r_free_cfg(&cfg);
+#else
+    fclose(out);
+#endif
+
+    fprintf(
+        stderr,
+        "%u files (%u not RAW), %u trains in %.3f s, %.0f trains/s\n",
+        stats.files,
+        stats.skipped,
+        stats.trains,
+        stats.seconds,
+        stats.seconds > 0 ? stats.trains / stats.seconds : 0.0
+    );
+#ifdef HAVE_RTL433
+    fprintf(
+        stderr,
+        "%u decoded (%.1f%%), %u messages\n",
+        stats.hits,
+        stats.trains ? 100.0 * stats.hits / stats.trains : 0.0,
+        stats.messages
+    );
+#endif
+    return stats.files ? 0 : 1;
+}